@@ -0,0 +1,179 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+// Measures what the software mixer costs per voice at every kernel level, and
+// checks every supported level mixes exactly what the scalar one does.
+
+#include "AudioMixer.hpp"
+#include "MixKernels.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using Level = MixKernels::Level;
+
+static const uint32_t OUTPUT_RATE = 48000;
+static const size_t BLOCK = 512;
+
+/**
+ * Makes a clip without a file, like the ones the game plays
+ */
+static MixerClip * MakeClip(uint32_t rate, uint32_t channels, double seconds, std::mt19937 & rng) {
+    std::uniform_real_distribution<float> noise(-0.25f, 0.25f);
+
+    MixerClip * clip = new MixerClip();
+
+    clip->rate = rate;
+    clip->channels = channels;
+    clip->frames = static_cast<size_t> (rate * seconds);
+
+    clip->left.assign(clip->frames + 2, 0.0f);
+
+    if (channels > 1) {
+        clip->right.assign(clip->frames + 2, 0.0f);
+    }
+
+    for (size_t i = 0; i < clip->frames; i++) {
+        float tone = 0.5f * std::sin(i * 2 * 3.14159265f * 440.0f / rate);
+
+        clip->left[i] = tone + noise(rng);
+
+        if (channels > 1) {
+            clip->right[i] = tone - noise(rng);
+        }
+    }
+
+    return clip;
+}
+
+/**
+ * Starts the same voices on a mixer every time, spread over the clips
+ */
+static void StartVoices(SoftwareMixer & mixer, const std::vector<std::unique_ptr<MixerClip>> & clips, size_t count) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> pitch(0.8f, 1.25f), pos(-1.5f, 1.5f);
+
+    for (size_t i = 0; i < count; i++) {
+        struct AudioVoiceParams params;
+
+        params.volume = 1.0f / count;
+        params.pitch = pitch(rng);
+        params.looped = true;
+        params.positional = i % 2 == 0;
+        params.x = pos(rng);
+        params.y = pos(rng);
+
+        mixer.play(clips[i % clips.size()].get(), params, i);
+    }
+}
+
+/**
+ * Mixes for a while
+ * @param out Every block mixed, if not null
+ * @return The average time per block in microseconds
+ */
+static double Mix(const std::vector<std::unique_ptr<MixerClip>> & clips, size_t voices, size_t blocks,
+        std::vector<float> * out) {
+
+    SoftwareMixer mixer(OUTPUT_RATE);
+
+    StartVoices(mixer, clips, voices);
+
+    std::vector<float> block(BLOCK * 2);
+    std::vector<uint64_t> finished;
+
+    if (out) {
+        out->clear();
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (size_t i = 0; i < blocks; i++) {
+        mixer.mix(block.data(), BLOCK, finished);
+
+        if (out) {
+            out->insert(out->end(), block.begin(), block.end());
+        }
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1e3 / blocks;
+}
+
+int main(int argc, char ** argv) {
+    const double seconds = argc > 1 ? std::stod(argv[1]) : 10;
+    const size_t maxVoices = argc > 2 ? std::stoul(argv[2]) : 256;
+
+    const size_t blocks = static_cast<size_t> (seconds * OUTPUT_RATE / BLOCK);
+
+    std::mt19937 rng(1234);
+
+    // the clips cover no resampling, upsampling, and stereo
+    std::vector<std::unique_ptr<MixerClip>> clips;
+    clips.emplace_back(MakeClip(48000, 1, 0.5, rng));
+    clips.emplace_back(MakeClip(44100, 1, 1.0, rng));
+    clips.emplace_back(MakeClip(22050, 2, 2.0, rng));
+
+    std::vector<Level> levels = {Level::eScalar};
+
+    Level supported = MixKernels::GetSupportedLevel();
+
+    if (supported == Level::eNEON) {
+        levels.push_back(Level::eNEON);
+    } else {
+        for (Level level : {Level::eSSE2, Level::eAVX2}) {
+            if (level <= supported) {
+                levels.push_back(level);
+            }
+        }
+    }
+
+    printf("%.1f seconds of %u Hz stereo per run, %zu frame blocks\n\n", seconds, OUTPUT_RATE, BLOCK);
+
+    // every level has to mix the same samples as the scalar one
+    const size_t checkBlocks = 64;
+
+    std::vector<float> reference, output;
+
+    MixKernels::SetLevel(Level::eScalar);
+    Mix(clips, 64, checkBlocks, &reference);
+
+    bool identical = true;
+
+    for (Level level : levels) {
+        MixKernels::SetLevel(level);
+        Mix(clips, 64, checkBlocks, &output);
+
+        if (memcmp(output.data(), reference.data(), reference.size() * sizeof (float)) != 0) {
+            printf("%s doesn't match the scalar mix!\n", MixKernels::GetLevelName(level));
+            identical = false;
+        }
+    }
+
+    printf("%-8s %8s %14s %16s %14s\n", "level", "voices", "us per block", "ns per voice*fr", "x real time");
+
+    for (Level level : levels) {
+        MixKernels::SetLevel(level);
+
+        for (size_t voices = 1; voices <= maxVoices; voices *= 2) {
+            double us = Mix(clips, voices, blocks, nullptr);
+
+            double blockUs = BLOCK * 1e6 / OUTPUT_RATE;
+
+            printf("%-8s %8zu %14.2f %16.3f %14.1f\n", MixKernels::GetLevelName(level), voices, us,
+                    us * 1e3 / (voices * BLOCK), blockUs / us);
+        }
+    }
+
+    return identical ? 0 : 1;
+}
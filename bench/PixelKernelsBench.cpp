@@ -0,0 +1,179 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+// Compares the pixel kernels against the per-pixel loops they replaced, and
+// checks every supported level produces the same output as the scalar one.
+
+#include "PixelKernels.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+using Level = PixelKernels::Level;
+
+// the RGB -> RGBA loop Texture::loadImageData used to run
+static void LegacyExpand(const uint8_t * buffer, uint8_t * data, size_t count, int channels) {
+    for (size_t i = 0; i < count; i++) {
+        memset(data + i * 4, 0xFF, 4);
+        memcpy(data + i * 4, buffer + i * channels, channels);
+    }
+}
+
+// the chroma key shader's math, one pixel at a time, like the first load-time pass
+static void LegacyChromaKey(uint8_t * pixels, size_t count, const PixelKernels::ChromaKeyParams & key) {
+    for (size_t i = 0; i < count; i++) {
+        uint8_t * px = pixels + i * 4;
+        float tex[4], d2 = 0;
+
+        for (int c = 0; c < 4; c++) {
+            tex[c] = px[c] / 255.0f;
+            d2 += (tex[c] - key.search[c]) * (tex[c] - key.search[c]);
+        }
+
+        float a = std::min(std::max(std::sqrt(d2) - key.epsilon1, 0.0f) / (key.epsilon2 - key.epsilon1), 1.0f);
+
+        for (int c = 0; c < 4; c++) {
+            float v = std::min(std::max(tex[c] + (key.replace[c] - key.search[c]) * (1 - a), 0.0f), 1.0f);
+            px[c] = static_cast<uint8_t> (v * 255.0f + 0.5f);
+        }
+    }
+}
+
+/**
+ * Runs a function enough times to get a stable time
+ * @return The average time per call in microseconds
+ */
+static double Time(const std::function<void()> & fn, int iterations) {
+    fn();
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < iterations; i++) {
+        fn();
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1e3 / iterations;
+}
+
+int main(int argc, char ** argv) {
+    const size_t width = argc > 1 ? std::stoul(argv[1]) : 1024;
+    const size_t height = argc > 2 ? std::stoul(argv[2]) : 768;
+    const int iterations = argc > 3 ? std::stoi(argv[3]) : 50;
+
+    const size_t count = width * height;
+
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    std::vector<uint8_t> rgb(count * 3), rgba(count * 4), out(count * 4), scratch(count * 4);
+
+    for (auto & b : rgb) {
+        b = static_cast<uint8_t> (byte(rng));
+    }
+    for (auto & b : rgba) {
+        b = static_cast<uint8_t> (byte(rng));
+    }
+
+    // a green key, like the sprites use
+    PixelKernels::ChromaKeyParams key = {
+        {0, 1, 0, 1},
+        {0, 0, 0, 0}, 0.25f, 0.75f
+    };
+
+    std::vector<Level> levels{Level::eScalar, Level::eSSE2, Level::eSSSE3, Level::eAVX2, Level::eNEON};
+
+    printf("%zux%zu pixels, %d iterations, best level %s\n\n", width, height, iterations,
+            PixelKernels::GetLevelName(PixelKernels::GetSupportedLevel()));
+
+    printf("%-12s %-8s %12s %10s  %s\n", "kernel", "level", "us/call", "speedup", "matches scalar");
+
+    std::vector<uint8_t> reference(count * 4);
+
+    struct Kernel {
+        const char * name;
+        std::function<void()> legacy;
+        std::function<void()> run;
+        // the kernels which work in place start from a fresh copy
+        bool inplace;
+    };
+
+    std::vector<Kernel> kernels{
+        {"expand rgb", [&]() {
+                LegacyExpand(rgb.data(), out.data(), count, 3);
+            }, [&]() {
+                PixelKernels::ExpandRGBToRGBA(rgb.data(), out.data(), count);
+            }, false},
+        {"expand bgr", nullptr, [&]() {
+                PixelKernels::ExpandBGRToRGBA(rgb.data(), out.data(), count);
+            }, false},
+        {"swizzle", nullptr, [&]() {
+                PixelKernels::SwizzleBGRA(out.data(), count);
+            }, true},
+        {"premultiply", nullptr, [&]() {
+                PixelKernels::PremultiplyAlpha(out.data(), count);
+            }, true},
+        {"chroma key", [&]() {
+                memcpy(out.data(), rgba.data(), out.size());
+                LegacyChromaKey(out.data(), count, key);
+            }, [&]() {
+                PixelKernels::ChromaKeyAlpha(out.data(), count, key);
+            }, true},
+    };
+
+    int failures = 0;
+
+    for (auto & kernel : kernels) {
+        double baseline = 0;
+
+        if (kernel.legacy) {
+            baseline = Time(kernel.legacy, iterations);
+            printf("%-12s %-8s %12.1f %10s  %s\n", kernel.name, "legacy", baseline, "1.00x", "-");
+        }
+
+        for (Level level : levels) {
+            if (PixelKernels::SetLevel(level) != level) {
+                continue;
+            }
+
+            // in place kernels are timed including the copy, the copy is the same for every level
+            std::function<void()> fn = kernel.inplace ? std::function<void()>([&]() {
+                memcpy(out.data(), rgba.data(), out.size());
+                kernel.run();
+            }) : kernel.run;
+
+            double time = Time(fn, iterations);
+
+            fn();
+
+            bool matches = true;
+            if (level == Level::eScalar) {
+                reference = out;
+                if (baseline == 0) {
+                    baseline = time;
+                }
+            } else {
+                matches = memcmp(reference.data(), out.data(), out.size()) == 0;
+                failures += matches ? 0 : 1;
+            }
+
+            printf("%-12s %-8s %12.1f %9.2fx  %s\n", kernel.name, PixelKernels::GetLevelName(level),
+                    time, baseline / time, matches ? "yes" : "NO");
+        }
+
+        printf("\n");
+    }
+
+    PixelKernels::SetLevel(PixelKernels::GetSupportedLevel());
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
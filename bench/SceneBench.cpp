@@ -0,0 +1,776 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+// Stress tests the scene with a growing number of objects, rendering offscreen
+// so it runs without a window. Every scenario is run once per object count,
+// and the per-frame timings of each phase are written as json. Scenarios which
+// can render wrongly check their output, and fail the run if it's wrong:
+//
+//     vulkan_bench [--scenario name] [--counts 10,100,1000] [--frames 300]
+//                  [--warmup 30] [--out scene_bench.json]
+
+#include "VulkanHeadless.hpp"
+
+#include "game/scene.hpp"
+#include "game/SceneControllers.hpp"
+#include "game/ShipControllers.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+const uint32_t WIDTH = 1024;
+const uint32_t HEIGHT = WIDTH * 9 / 16;
+
+const int SHIP_LAYER = 3;
+const int SHIP_EFFECT_LAYER = 2;
+const int PLANET_LAYER = 1;
+
+const glm::vec2 CELL_SIZE(0.2f, 0.2f);
+
+// instance slots for each of the gpu planet batches
+const uint32_t GPU_BATCH_CAPACITY = 20000;
+
+// the most particles alive in the particles scenario
+const uint32_t PARTICLE_CAPACITY = 1 << 18;
+
+// the simulation always steps by the same amount, so runs are repeatable
+const double FRAME_DELTA = 1.0 / 60;
+
+// <editor-fold defaultstate="collapsed" desc="Allocation Counting">
+
+static std::atomic<size_t> allocations(0);
+
+void * operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+
+    void * ptr = malloc(size > 0 ? size : 1);
+
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+
+    return ptr;
+}
+
+void operator delete(void * ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void * ptr, size_t size) noexcept {
+    free(ptr);
+}
+
+// </editor-fold>
+
+struct BenchMaterial {
+    TextureSamplerPrototype texture;
+    MaterialPrototype prototype;
+    Material * material = nullptr;
+
+    BenchMaterial(const std::string & name) :
+    texture(0, nullptr, 1, vk::ShaderStageFlagBits::eFragment) {
+        prototype.name = name;
+    }
+};
+
+// Everything the scenarios share, created once
+struct BenchAssets {
+    std::vector<GameObjectPrototype*> planets;
+    GameObjectPrototype * ship;
+    GameObjectPrototype * projectile;
+    GameObjectPrototype * target;
+
+    // the same planets, culled and drawn by the gpu
+    VulkanCullPass * cullPass;
+    std::vector<GameObjectPrototype*> gpuPlanets;
+
+    VulkanParticleSystem * particles;
+
+    VulkanCamera * camera;
+};
+
+// Moves an object around a circle, so whatever chases it never arrives
+class CircleMover : public SceneDecorator {
+private:
+
+    ObjectHandle object;
+    double angle = 0, radius, speed;
+
+public:
+
+    CircleMover(ObjectHandle object, double radius, double speed) :
+    object(object), radius(radius), speed(speed) {
+
+    }
+
+    virtual void Apply(Scene * scene, double deltat) override {
+        angle += speed * deltat;
+
+        (*scene)[object].setPosition(glm::vec2(cos(angle) * radius, sin(angle) * radius));
+    }
+
+};
+
+// Replaces every projectile which asks to be cleaned up with a new one, so
+// the count stays fixed while objects are created and destroyed
+class ProjectileSpawner : public SceneDecorator, public EventHandler {
+private:
+
+    GameObjectPrototype * prototype;
+    Event oncleanuprequest;
+    ObjectHandle target;
+
+    std::vector<ObjectHandle> expired;
+    std::mt19937 random;
+
+public:
+
+    ProjectileSpawner(GameObjectPrototype * prototype, Event oncleanuprequest, ObjectHandle target) :
+    prototype(prototype), oncleanuprequest(oncleanuprequest), target(target), random(1234) {
+
+    }
+
+    virtual void RegisterHooks(EventManager * events) override {
+        events->addHandler(oncleanuprequest, this);
+    }
+
+    virtual void OnEvent(EventManager * manager, Event id, const std::shared_ptr<void> argument) override {
+        expired.push_back(*reinterpret_cast<ObjectHandle*> (argument.get()));
+    }
+
+    virtual void Apply(Scene * scene, double deltat) override {
+        for (ObjectHandle handle : expired) {
+            scene->removeObject(handle);
+            spawn(scene);
+        }
+
+        expired.clear();
+    }
+
+    void spawn(Scene * scene) {
+        std::uniform_real_distribution<float> position(-1, 1), angle(0, (float) (M_PI * 2));
+
+        float theta = angle(random);
+
+        ObjectHandle projectile = scene->addObject(*prototype, SHIP_EFFECT_LAYER);
+
+        scene->addDecorator(projectile, new PlasmaBallController(glm::vec2(cos(theta), sin(theta)), oncleanuprequest, target));
+
+        (*scene)[projectile].setPosition(glm::vec2(position(random), position(random)));
+    }
+
+};
+
+// Emits enough particles to keep a fixed number alive, from a few emitters
+// circling the middle of the screen
+class ParticleFountain : public SceneDecorator {
+private:
+
+    int alive;
+    double owed = 0, angle = 0;
+
+    static constexpr float LIFE = 1;
+    static constexpr uint32_t EMITTERS = 8;
+
+public:
+
+    ParticleFountain(int alive) : alive(alive) {
+
+    }
+
+    virtual void Apply(Scene * scene, double deltat) override {
+        owed += alive / LIFE * deltat;
+        angle += deltat;
+
+        uint32_t total = static_cast<uint32_t> (owed);
+
+        owed -= total;
+
+        for (uint32_t i = 0; i < EMITTERS; i++) {
+            float theta = (float) angle + i * (float) (M_PI * 2) / EMITTERS;
+
+            ParticleEmitter emitter;
+
+            emitter.position = glm::vec2(cos(theta), sin(theta)) * 0.5f;
+            emitter.color = {1.0f, 0.8f, 0.3f, 1.0f};
+            emitter.endColor = {1.0f, 0.1f, 0.0f, 0.0f};
+            emitter.speed = 0.4f;
+            emitter.life = LIFE;
+            emitter.size = 0.02f;
+            emitter.count = total / EMITTERS + (i < total % EMITTERS ? 1 : 0);
+
+            scene->emitParticles(emitter);
+        }
+    }
+
+};
+
+// <editor-fold defaultstate="collapsed" desc="Scenarios">
+
+using ScenarioSetup = std::function<void(Scene&, BenchAssets&, int, std::mt19937&)>;
+
+// checks what the scenario renders once it's been run, throws if it's wrong
+using ScenarioCheck = std::function<void(VulkanHeadlessController&, Scene&, BenchAssets&)>;
+
+struct Scenario {
+    std::string name;
+    ScenarioSetup setup;
+    ScenarioCheck check;
+};
+
+static glm::vec2 RandomPosition(std::mt19937 & random) {
+    std::uniform_real_distribution<float> position(-1, 1);
+
+    return glm::vec2(position(random), position(random));
+}
+
+static void AddPlanets(Scene & scene, BenchAssets & assets, int count, std::mt19937 & random, bool rotating, bool gpu = false) {
+    std::vector<GameObjectPrototype*> & planets = gpu ? assets.gpuPlanets : assets.planets;
+
+    if (gpu) {
+        scene.setCullPass(assets.cullPass);
+    }
+
+    for (int i = 0; i < count; i++) {
+        ObjectHandle planet = scene.addObject(*planets[i % planets.size()], PLANET_LAYER);
+
+        scene[planet].setPosition(RandomPosition(random));
+
+        if (rotating) {
+            scene.addDecorator(planet, new GameObjectRotator(0.1 + (i % 10) * 0.05));
+        }
+    }
+}
+
+static void AddProjectiles(Scene & scene, BenchAssets & assets, int count) {
+    ObjectHandle target = scene.addObject(*assets.target, SHIP_LAYER);
+
+    ProjectileSpawner * spawner = new ProjectileSpawner(assets.projectile, scene.createEventId(), target);
+
+    scene.addDecorator(spawner);
+
+    for (int i = 0; i < count; i++) {
+        spawner->spawn(&scene);
+    }
+}
+
+static void AddShips(Scene & scene, BenchAssets & assets, int count, std::mt19937 & random) {
+    ObjectHandle player = scene.addObject(*assets.target, SHIP_LAYER);
+
+    scene.addDecorator(new CircleMover(player, 0.5, 0.5));
+
+    Event playerstatechange = scene.createEventId();
+
+    for (int i = 0; i < count; i++) {
+        ObjectHandle ship = scene.addObject(*assets.ship, SHIP_LAYER);
+
+        scene[ship].setPosition(RandomPosition(random));
+
+        scene.addDecorator(ship, new AIShipController(playerstatechange, player));
+    }
+
+    // the ai only chases a moving player
+    scene.dispatchEvent(playerstatechange, ShipStateChangeArguments(nullptr, PlayerState::eMoving, false));
+}
+
+/**
+ * Renders one frame without moving anything
+ */
+static void RenderStill(VulkanHeadlessController & controller, Scene & scene) {
+    std::vector<vk::CommandBuffer> buffers;
+
+    controller.startRender();
+
+    size_t frame = controller.getFrameIndex();
+
+    scene.updateObjects(frame, 0);
+    scene.record(frame);
+    scene.getbuffers(buffers, frame);
+
+    controller.submitSecondaries(buffers);
+}
+
+/**
+ * Checks nothing the main view draws shows through the minimap, by comparing
+ * the minimap's pixels with a frame where the main view sees nothing
+ */
+static void CheckMinimapOnTop(VulkanHeadlessController & controller, Scene & scene, BenchAssets & assets) {
+    std::vector<uint8_t> both, alone;
+
+    RenderStill(controller, scene);
+    controller.readPixels(both);
+
+    glm::vec2 pan = assets.camera->getView(0).pan;
+
+    // far past the world, so only the minimap draws anything
+    assets.camera->setPan(glm::vec2(100, 100));
+
+    RenderStill(controller, scene);
+    controller.readPixels(alone);
+
+    assets.camera->setPan(pan);
+
+    const glm::vec4 & rect = assets.camera->getView(1).rect;
+
+    uint32_t x0 = static_cast<uint32_t> (rect.x * WIDTH), x1 = static_cast<uint32_t> ((rect.x + rect.z) * WIDTH);
+    uint32_t y0 = static_cast<uint32_t> (rect.y * HEIGHT), y1 = static_cast<uint32_t> ((rect.y + rect.w) * HEIGHT);
+
+    size_t drawn = 0, covered = 0;
+
+    for (uint32_t y = y0; y < y1; y++) {
+        for (uint32_t x = x0; x < x1; x++) {
+            size_t i = (static_cast<size_t> (y) * WIDTH + x) * 4;
+
+            // only where the minimap drew, the main view can show through where it didn't
+            if (alone[i + 3] == 0) {
+                continue;
+            }
+
+            drawn++;
+
+            if (memcmp(&both[i], &alone[i], 4) != 0) {
+                covered++;
+            }
+        }
+    }
+
+    if (drawn == 0) {
+        throw std::runtime_error("planets_minimap: the minimap drew nothing");
+    }
+
+    if (covered > 0) {
+        throw std::runtime_error("planets_minimap: the main view drew over " + std::to_string(covered)
+                + " of the minimap's " + std::to_string(drawn) + " pixels");
+    }
+}
+
+static std::vector<Scenario> CreateScenarios() {
+    std::vector<Scenario> scenarios;
+
+    scenarios.push_back({"static_planets", [](Scene & scene, BenchAssets & assets, int count, std::mt19937 & random) {
+        AddPlanets(scene, assets, count, random, false);
+    }});
+
+    scenarios.push_back({"rotating_planets", [](Scene & scene, BenchAssets & assets, int count, std::mt19937 & random) {
+        AddPlanets(scene, assets, count, random, true);
+    }});
+
+    // every draw is repeated for the second view
+    scenarios.push_back({"planets_minimap", [](Scene & scene, BenchAssets & assets, int count, std::mt19937 & random) {
+        CameraView minimap;
+
+        minimap.zoom = 0.5f;
+        minimap.rect = {0.75f, 0.0f, 0.25f, 0.25f};
+
+        assets.camera->addView(minimap);
+
+        AddPlanets(scene, assets, count, random, true);
+    }, CheckMinimapOnTop});
+
+    // recording stays one draw per batch, however many planets there are
+    scenarios.push_back({"gpu_planets", [](Scene & scene, BenchAssets & assets, int count, std::mt19937 & random) {
+        AddPlanets(scene, assets, count, random, true, true);
+    }});
+
+    // the count is how many particles stay alive, only the emitters touch the cpu
+    scenarios.push_back({"particles", [](Scene & scene, BenchAssets & assets, int count, std::mt19937 & random) {
+        assets.particles->clear();
+
+        scene.setParticles(assets.particles);
+        scene.addDecorator(new ParticleFountain(count));
+    }});
+
+    scenarios.push_back({"projectiles", [](Scene & scene, BenchAssets & assets, int count, std::mt19937 & random) {
+        AddProjectiles(scene, assets, count);
+    }});
+
+    scenarios.push_back({"ai_ships", [](Scene & scene, BenchAssets & assets, int count, std::mt19937 & random) {
+        AddShips(scene, assets, count, random);
+    }});
+
+    // roughly what a busy sector looks like
+    scenarios.push_back({"mixed", [](Scene & scene, BenchAssets & assets, int count, std::mt19937 & random) {
+        AddPlanets(scene, assets, count / 2, random, true);
+        AddProjectiles(scene, assets, count / 4);
+        AddShips(scene, assets, count - count / 2 - count / 4, random);
+    }});
+
+    return scenarios;
+}
+
+// </editor-fold>
+
+// <editor-fold defaultstate="collapsed" desc="Results">
+
+struct PhaseTimes {
+    std::vector<double> update, record, submit, total;
+    std::vector<double> allocations;
+};
+
+/**
+ * Gets a percentile with the nearest rank method
+ * @param samples The samples, sorted
+ * @param percentile The percentile, from 0 to 100
+ * @return The percentile
+ */
+static double Percentile(const std::vector<double> & samples, double percentile) {
+    if (samples.empty()) {
+        return 0;
+    }
+
+    size_t rank = static_cast<size_t> (std::ceil(percentile / 100 * samples.size()));
+
+    return samples[std::min(std::max<size_t>(rank, 1), samples.size()) - 1];
+}
+
+static void WriteStats(std::ostream & out, const std::string & name, std::vector<double> & samples) {
+    std::sort(samples.begin(), samples.end());
+
+    double total = 0;
+
+    for (double sample : samples) {
+        total += sample;
+    }
+
+    double mean = samples.empty() ? 0 : total / samples.size();
+    double max = samples.empty() ? 0 : samples.back();
+
+    out << "\"" << name << "\":{\"mean\":" << mean
+            << ",\"p50\":" << Percentile(samples, 50)
+            << ",\"p95\":" << Percentile(samples, 95)
+            << ",\"p99\":" << Percentile(samples, 99)
+            << ",\"max\":" << max << "}";
+}
+
+static void WriteRun(std::ostream & out, const std::string & scenario, int count, int draws, PhaseTimes & times) {
+    out << "{\"scenario\":\"" << scenario << "\",\"count\":" << count << ",\"draws\":" << draws
+            << ",\"frames\":" << times.total.size() << ",\"unit\":\"ms\",";
+
+    WriteStats(out, "update", times.update);
+    out << ",";
+    WriteStats(out, "record", times.record);
+    out << ",";
+    WriteStats(out, "submit", times.submit);
+    out << ",";
+    WriteStats(out, "frame", times.total);
+    out << ",";
+    WriteStats(out, "allocations", times.allocations);
+    out << "}";
+}
+
+// </editor-fold>
+
+static double Milliseconds(std::chrono::high_resolution_clock::time_point start, std::chrono::high_resolution_clock::time_point end) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1e6;
+}
+
+/**
+ * Runs one scenario at one size
+ * @return The number of draws in the last frame
+ */
+static int RunScenario(VulkanHeadlessController & controller, BenchAssets & assets,
+        const Scenario & scenario, int count, int warmup, int frames, PhaseTimes & times) {
+
+    std::mt19937 random(42);
+
+    Scene scene;
+
+    assets.camera->clearViews();
+
+    scenario.setup(scene, assets, count, random);
+
+    std::vector<vk::CommandBuffer> buffers;
+    int draws = 0;
+
+    for (int i = 0; i < warmup + frames; i++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        size_t allocStart = allocations.load(std::memory_order_relaxed);
+
+        controller.startRender();
+
+        size_t frame = controller.getFrameIndex();
+
+        auto update = std::chrono::high_resolution_clock::now();
+
+        scene.updateObjects(frame, FRAME_DELTA);
+
+        auto record = std::chrono::high_resolution_clock::now();
+
+        scene.record(frame);
+
+        buffers.clear();
+        scene.getbuffers(buffers, frame);
+
+        auto submit = std::chrono::high_resolution_clock::now();
+
+        controller.submitSecondaries(buffers);
+
+        auto end = std::chrono::high_resolution_clock::now();
+        size_t allocEnd = allocations.load(std::memory_order_relaxed);
+
+        draws = static_cast<int> (buffers.size());
+
+        if (i < warmup) {
+            continue;
+        }
+
+        times.update.push_back(Milliseconds(update, record));
+        times.record.push_back(Milliseconds(record, submit));
+        times.submit.push_back(Milliseconds(start, update) + Milliseconds(submit, end));
+        times.total.push_back(Milliseconds(start, end));
+        times.allocations.push_back(static_cast<double> (allocEnd - allocStart));
+    }
+
+    if (scenario.check) {
+        scenario.check(controller, scene, assets);
+    }
+
+    // the scene's renderers are freed here, before the next scenario's are made
+    return draws;
+}
+
+static std::vector<int> ParseCounts(const std::string & list) {
+    std::vector<int> counts;
+    std::stringstream ss(list);
+    std::string item;
+
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) {
+            counts.push_back(std::stoi(item));
+        }
+    }
+
+    return counts;
+}
+
+int run(int argc, char ** argv) {
+    std::string only, outPath = "scene_bench.json";
+    std::vector<int> counts{10, 100, 1000};
+    int frames = 300, warmup = 30;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i], value = argv[i + 1];
+
+        if (arg == "--scenario") {
+            only = value;
+        } else if (arg == "--counts") {
+            counts = ParseCounts(value);
+        } else if (arg == "--frames") {
+            frames = std::stoi(value);
+        } else if (arg == "--warmup") {
+            warmup = std::stoi(value);
+        } else if (arg == "--out") {
+            outPath = value;
+        } else {
+            std::cerr << "Unknown argument " << arg << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    VulkanHeadlessController controller("vulkan_bench", WIDTH, HEIGHT);
+
+    // <editor-fold defaultstate="collapsed" desc="Material Setup">
+
+    const ChromaKey greenKey(glm::vec4(0, 1.0f, 0, 1.0f));
+    const ChromaKey blueKey(glm::vec4(0, 0, 1.0f, 1.0f));
+    const ChromaKey blackKey(glm::vec4(0, 0, 0, 1.0f));
+
+    // every sprite is the same quad, stored once in device local memory
+    VulkanGeometryStore * geometry = controller.getGeometry();
+
+    VulkanIndexBuffer & indices = *geometry->addIndices({0, 1, 2, 3, 2, 0});
+
+    BenchMaterial planet1("planet1"), planet2("planet2"), planet3("planet3"),
+            enemyship("enemyship"), playerweapon("playerweapon"), shipbase("shipbase");
+
+    ImageManager * images = controller.getImageManager();
+
+    planet1.texture.texture = images->getImage("sprites/Planet1.bmp", &greenKey);
+    planet2.texture.texture = images->getImage("sprites/Planet2.bmp", &greenKey);
+    planet3.texture.texture = images->getImage("sprites/Planet3.bmp", &greenKey);
+    enemyship.texture.texture = images->getImage("sprites/EnemyShip.bmp", &blueKey);
+    playerweapon.texture.texture = images->getImage("sprites/player_attack.png", &blackKey);
+    shipbase.texture.texture = images->getImage("sprites/ShipBase.bmp", &greenKey);
+
+    ShaderPrototype frag = {"shader/shader.frag.spv", vk::ShaderStageFlagBits::eFragment};
+    ShaderPrototype vert = {"shader/shader.vert.spv", vk::ShaderStageFlagBits::eVertex};
+
+    PushConstantPrototype pcproto = {0, 0, sizeof (GameObjectPushConstant), vk::ShaderStageFlagBits::eVertex};
+
+    std::vector<VulkanVertexObject> quad(4);
+
+    quad[0].position = {-0.5, -0.5};
+    quad[1].position = {0.5, -0.5};
+    quad[2].position = {0.5, 0.5};
+    quad[3].position = {-0.5, 0.5};
+
+    quad[0].uv = {1.0, 0.0};
+    quad[1].uv = {0.0, 0.0};
+    quad[2].uv = {0.0, 1.0};
+    quad[3].uv = {1.0, 1.0};
+
+    VulkanVertexBufferDefault & vertexBuffer = *geometry->addVertices(0, quad);
+
+    playerweapon.prototype.transparent = true;
+
+    std::vector<BenchMaterial*> materials{&planet1, &planet2, &planet3, &enemyship, &playerweapon, &shipbase};
+
+    for (BenchMaterial * info : materials) {
+        info->prototype.samplers.push_back(info->texture);
+        info->prototype.vertexDescriptors.push_back({&vertexBuffer, &vertexBuffer});
+        info->prototype.shaders.push_back(frag);
+        info->prototype.shaders.push_back(vert);
+        info->prototype.pushConstants.push_back(pcproto);
+
+        info->material = controller.createMaterial(info->prototype);
+    }
+
+    VulkanCullPass * cullPass = controller.createCullPass(GPU_BATCH_CAPACITY * 3);
+
+    BenchMaterial gpuplanet1("gpuplanet1"), gpuplanet2("gpuplanet2"), gpuplanet3("gpuplanet3");
+
+    gpuplanet1.texture.texture = planet1.texture.texture;
+    gpuplanet2.texture.texture = planet2.texture.texture;
+    gpuplanet3.texture.texture = planet3.texture.texture;
+
+    std::vector<BenchMaterial*> gpuMaterials{&gpuplanet1, &gpuplanet2, &gpuplanet3};
+
+    for (BenchMaterial * info : gpuMaterials) {
+        info->prototype.samplers.push_back(info->texture);
+        info->prototype.vertexDescriptors.push_back({&vertexBuffer, &vertexBuffer});
+        info->prototype.shaders.push_back(frag);
+
+        cullPass->prepareMaterial(info->prototype);
+
+        info->material = controller.createMaterial(info->prototype);
+
+        materials.push_back(info);
+    }
+
+    // </editor-fold>
+
+    // <editor-fold defaultstate="collapsed" desc="GameObject Prototype Setup">
+
+    GameObjectPrototype planet1Proto(glm::vec2(0, 0), CELL_SIZE, 0, pcproto.id);
+    planet1Proto.addMesh(0, &controller, planet1.material, &indices);
+
+    GameObjectPrototype planet2Proto(glm::vec2(0, 0), CELL_SIZE, 0, pcproto.id);
+    planet2Proto.addMesh(0, &controller, planet2.material, &indices);
+
+    GameObjectPrototype planet3Proto(glm::vec2(0, 0), CELL_SIZE, 0, pcproto.id);
+    planet3Proto.addMesh(0, &controller, planet3.material, &indices);
+
+    GameObjectPrototype shipProto(glm::vec2(0, 0), CELL_SIZE, 0, pcproto.id);
+    shipProto.addMesh(0, &controller, enemyship.material, &indices);
+
+    GameObjectPrototype projectileProto(glm::vec2(0, 0), glm::vec2(0, 0), 0, pcproto.id);
+    projectileProto.addMesh(0, &controller, playerweapon.material, &indices);
+
+    GameObjectPrototype targetProto(glm::vec2(0, 0), CELL_SIZE, 0, pcproto.id);
+    targetProto.addMesh(0, &controller, shipbase.material, &indices);
+
+    int planetOrder = DepthLayers::Order(PLANET_LAYER, 0);
+
+    VulkanParticleSystem * particleSystem = controller.createParticleSystem(PARTICLE_CAPACITY);
+
+    BenchMaterial particles("particles");
+
+    particles.prototype.vertexDescriptors.push_back({&vertexBuffer, &vertexBuffer});
+    particleSystem->prepareMaterial(particles.prototype);
+
+    particles.material = controller.createMaterial(particles.prototype);
+    materials.push_back(&particles);
+
+    int effectOrder = DepthLayers::Order(SHIP_EFFECT_LAYER, 0);
+
+    particleSystem->setMaterial(particles.material, &indices, effectOrder, DepthLayers::ToDepth(effectOrder));
+
+    GameObjectPrototype gpuPlanet1Proto(glm::vec2(0, 0), CELL_SIZE, 0);
+    gpuPlanet1Proto.addInstance(0, cullPass->addBatch(gpuplanet1.material, &indices, GPU_BATCH_CAPACITY, planetOrder));
+
+    GameObjectPrototype gpuPlanet2Proto(glm::vec2(0, 0), CELL_SIZE, 0);
+    gpuPlanet2Proto.addInstance(0, cullPass->addBatch(gpuplanet2.material, &indices, GPU_BATCH_CAPACITY, planetOrder));
+
+    GameObjectPrototype gpuPlanet3Proto(glm::vec2(0, 0), CELL_SIZE, 0);
+    gpuPlanet3Proto.addInstance(0, cullPass->addBatch(gpuplanet3.material, &indices, GPU_BATCH_CAPACITY, planetOrder));
+
+    BenchAssets assets;
+
+    assets.planets = {&planet1Proto, &planet2Proto, &planet3Proto};
+    assets.ship = &shipProto;
+    assets.projectile = &projectileProto;
+    assets.target = &targetProto;
+    assets.cullPass = cullPass;
+    assets.gpuPlanets = {&gpuPlanet1Proto, &gpuPlanet2Proto, &gpuPlanet3Proto};
+    assets.particles = particleSystem;
+    assets.camera = controller.getCamera();
+
+    // </editor-fold>
+
+    std::ofstream out(outPath);
+
+    if (!out.is_open()) {
+        std::cerr << "Could not open " << outPath << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    out << "{\"device\":\"" << controller.getDevice()->getProperties().deviceName
+            << "\",\"width\":" << WIDTH << ",\"height\":" << HEIGHT << ",\"runs\":[";
+
+    bool first = true;
+
+    for (const Scenario & scenario : CreateScenarios()) {
+        if (!only.empty() && scenario.name != only) {
+            continue;
+        }
+
+        for (int count : counts) {
+            PhaseTimes times;
+
+            int draws = RunScenario(controller, assets, scenario, count, warmup, frames, times);
+
+            out << (first ? "\n" : ",\n");
+            WriteRun(out, scenario.name, count, draws, times);
+
+            first = false;
+
+            // the samples were sorted when they were written
+            fprintf(stderr, "%-18s %6d objects: frame p50 %.3f ms, p99 %.3f ms\n", scenario.name.c_str(), count,
+                    Percentile(times.total, 50), Percentile(times.total, 99));
+        }
+    }
+
+    out << "\n]}" << std::endl;
+
+    for (BenchMaterial * info : materials) {
+        delete info->material;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char ** argv) {
+    try {
+        return run(argc, argv);
+    } catch (std::exception & ex) {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,160 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   AudioBackend.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 3:20 AM
+ */
+
+#ifndef AUDIOBACKEND_HPP
+#define AUDIOBACKEND_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+/**
+ * How a voice is played
+ */
+struct AudioVoiceParams {
+    float volume = 1;
+
+    // 2 plays an octave up, and twice as fast
+    float pitch = 1;
+
+    bool looped = false;
+
+    // positional voices are panned and attenuated by their distance to the listener
+    bool positional = false;
+    float x = 0, y = 0;
+};
+
+// A sound loaded by a backend, which any number of voices can play. Short
+// clips are decoded up front, long ones are streamed from their file.
+class AudioClip {
+public:
+
+    virtual ~AudioClip() {
+
+    }
+
+    /**
+     * @return The bytes the clip keeps resident, for a streamed clip what
+     * each of its voices buffers
+     */
+    virtual size_t getSize(void) const = 0;
+
+    /**
+     * @return The clip's length, in seconds
+     */
+    virtual double getLength(void) const = 0;
+
+    /**
+     * @return Whether the clip is read from its file while it plays
+     */
+    virtual bool isStreamed(void) const = 0;
+
+};
+
+// Told when a voice stops on its own, possibly from the backend's thread
+class AudioStopListener {
+public:
+
+    virtual ~AudioStopListener() {
+
+    }
+
+    /**
+     * @param id The voice's id, from AudioBackend::play
+     */
+    virtual void OnVoiceStopped(uint64_t id) = 0;
+
+};
+
+// Where sounds are decoded and played. Everything but the stop listener is
+// called from one thread, which owns the clips and voices.
+class AudioBackend {
+protected:
+
+    std::atomic<AudioStopListener*> stopListener;
+
+public:
+
+    AudioBackend() : stopListener(nullptr) {
+
+    }
+
+    virtual ~AudioBackend() {
+
+    }
+
+    /**
+     * Creates a backend by name
+     * @param name 'irrklang', 'mixer' (the software mixer with no output), a
+     * path ending in '.wav' (the software mixer, written to the file), or
+     * empty for irrklang, falling back to the mixer without a sound device
+     * @return The backend
+     */
+    static AudioBackend * Create(const std::string & name);
+
+    /**
+     * Only set before any voice is playing
+     * @param listener Told when voices stop on their own
+     */
+    void setStopListener(AudioStopListener * listener) {
+        stopListener.store(listener);
+    }
+
+    virtual const char * getName(void) const = 0;
+
+    /**
+     * Loads a file. Files up to the threshold are decoded now, anything
+     * longer is streamed in chunks while it plays, which only starts once
+     * the first chunk is read.
+     * @param path The file
+     * @param streamThreshold The longest file which is decoded now, in seconds
+     * @return The clip, which has to be unloaded
+     */
+    virtual AudioClip * loadClip(const std::string & path,
+            double streamThreshold = std::numeric_limits<double>::infinity()) = 0;
+
+    /**
+     * Frees a clip, which no voice can be playing
+     * @param clip The clip
+     */
+    virtual void unloadClip(AudioClip * clip) = 0;
+
+    /**
+     * Starts a voice. Unless it's stopped first, the stop listener is told
+     * when it ends.
+     * @param clip The clip
+     * @param params How the clip is played
+     * @param id The voice's id, which isn't used by any other voice
+     * @return Whether the voice could start
+     */
+    virtual bool play(AudioClip * clip, const struct AudioVoiceParams & params, uint64_t id) = 0;
+
+    /**
+     * Stops a voice, if it's still playing, and frees it. Every voice which
+     * started has to be stopped, including ones the listener was told about.
+     * The listener isn't told about this stop.
+     * @param id The voice's id
+     */
+    virtual void stop(uint64_t id) = 0;
+
+    /**
+     * @param x The listener's x position
+     * @param y The listener's y position
+     */
+    virtual void setListener(float x, float y) = 0;
+
+};
+
+#endif /* AUDIOBACKEND_HPP */
@@ -0,0 +1,414 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   AudioMixer.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 4:35 AM
+ */
+
+#ifndef AUDIOMIXER_HPP
+#define AUDIOMIXER_HPP
+
+#include "AudioBackend.hpp"
+#include "SpscQueue.hpp"
+#include "WavFile.hpp"
+
+#include <atomic>
+#include <limits>
+#include <list>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// A clip for the software mixer, with each channel stored separately. Long
+// clips aren't decoded, each of their voices streams the file instead.
+class MixerClip : public AudioClip {
+public:
+
+    uint32_t rate = 0, channels = 0;
+
+    size_t frames = 0;
+
+    // two silent samples past the clip's frames, so interpolating the last
+    // frame never reads past the end, even when its position rounds up.
+    // streamed clips leave these empty.
+    std::vector<float> left, right;
+
+    std::string path;
+    bool streamed = false;
+
+    /**
+     * Decodes a wav file, or only reads its header if it's streamed. Anything
+     * past two channels is dropped.
+     * @param path The file
+     * @param streamThreshold The longest file which is decoded, in seconds
+     * @return The clip
+     */
+    static MixerClip * Load(const std::string & path,
+            double streamThreshold = std::numeric_limits<double>::infinity());
+
+    size_t getSize(void) const override;
+
+    double getLength(void) const override {
+        return static_cast<double> (frames) / rate;
+    }
+
+    bool isStreamed(void) const override {
+        return streamed;
+    }
+
+    bool isStereo(void) const {
+        return channels > 1;
+    }
+
+};
+
+// One voice's stream of a clip. A streaming thread decodes the file a chunk at
+// a time into a ring buffer, which the mixing thread reads from. Frames are
+// numbered from the start of the stream, and keep counting up through loops.
+class MixerStream {
+private:
+
+    // copied from the clip, which can be unloaded while the stream is being freed
+    std::string path;
+    bool stereo, looped;
+
+    // opened by the first fill, so the file isn't touched by the thread starting the voice
+    std::unique_ptr<WavReader> reader;
+
+    std::vector<float> left, right;
+    std::vector<float> interleaved;
+
+    // written is only set by the streaming thread, released only by the mixing
+    // thread. They're padded onto their own cache lines rather than aligned,
+    // so streams can still be made with new
+    char before_written[64];
+    std::atomic<uint64_t> written;
+    char before_released[64 - sizeof (std::atomic<uint64_t>)];
+    std::atomic<uint64_t> released;
+    char after_released[64 - sizeof (std::atomic<uint64_t>)];
+
+    std::atomic<bool> ended, closed;
+
+public:
+
+    // the frames in the ring, and how many are decoded at once
+    static constexpr size_t CAPACITY = 1 << 16;
+    static constexpr size_t CHUNK_FRAMES = 1 << 13;
+
+    // silent frames after the end of the file, for interpolating the last one
+    static constexpr size_t PADDING = 4;
+
+    MixerStream(const MixerClip * clip, bool looped);
+
+    MixerStream(const MixerStream & other) = delete;
+
+    /**
+     * Decodes a chunk if there's room for it. Only called by the streaming thread.
+     * @return Whether anything was written
+     */
+    bool fill(void);
+
+    /**
+     * @return Whether the first chunk is in, or the stream ended without one
+     */
+    bool isReady(void) const {
+        return written.load(std::memory_order_acquire) > 0 || isEnded();
+    }
+
+    /**
+     * @return Whether every frame, and the padding, has been written
+     */
+    bool isEnded(void) const {
+        return ended.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @return The frame after the last one written
+     */
+    uint64_t getWritten(void) const {
+        return written.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Copies written frames which haven't been released
+     * @param first The first frame
+     * @param count The number of frames
+     * @param left The left channel's output
+     * @param right The right channel's output, only written for stereo clips
+     */
+    void copy(uint64_t first, size_t count, float * left, float * right) const;
+
+    /**
+     * @param frame Every frame before this one can be overwritten
+     */
+    void release(uint64_t frame) {
+        released.store(frame, std::memory_order_release);
+    }
+
+    /**
+     * Tells the streaming thread to free the stream, which can't be touched after
+     */
+    void close(void) {
+        closed.store(true, std::memory_order_release);
+    }
+
+    bool isClosed(void) const {
+        return closed.load(std::memory_order_acquire);
+    }
+
+};
+
+// Mixes voices into interleaved stereo. Each voice is resampled to the
+// mixer's rate, panned and added in blocks, with the vectorized mix kernels
+// doing all of the per sample work.
+class SoftwareMixer {
+private:
+
+    struct Voice {
+        uint64_t id;
+        const MixerClip * clip;
+
+        // only for streamed clips, where the position is in the stream's frames
+        MixerStream * stream;
+
+        // in the clip's frames
+        double position;
+        float step;
+
+        struct AudioVoiceParams params;
+    };
+
+    uint32_t rate;
+
+    float listenerX = 0, listenerY = 0;
+
+    std::vector<struct Voice> voices;
+
+    std::vector<float> scratchLeft, scratchRight;
+
+    // the part of a stream being resampled
+    std::vector<float> windowLeft, windowRight;
+
+    size_t underruns = 0;
+
+public:
+
+    // the most frames each voice is resampled at once
+    static constexpr size_t BLOCK_FRAMES = 256;
+
+    /**
+     * @param rate The output's sample rate
+     */
+    SoftwareMixer(uint32_t rate);
+
+    SoftwareMixer(const SoftwareMixer & other) = delete;
+
+    ~SoftwareMixer();
+
+    uint32_t getSampleRate(void) const {
+        return rate;
+    }
+
+    /**
+     * Starts a voice. A streamed clip's voice is silent until its stream is ready.
+     * @param clip The clip
+     * @param params How the clip is played
+     * @param id The voice's id
+     * @param stream The voice's stream, which is closed when the voice stops,
+     * for streamed clips
+     */
+    void play(const MixerClip * clip, const struct AudioVoiceParams & params, uint64_t id,
+            MixerStream * stream = nullptr);
+
+    /**
+     * @param id The voice's id
+     * @return Whether the voice was playing
+     */
+    bool stop(uint64_t id);
+
+    /**
+     * Stops every voice
+     */
+    void clear(void);
+
+    void setListener(float x, float y) {
+        listenerX = x;
+        listenerY = y;
+    }
+
+    size_t getVoiceCount(void) const {
+        return voices.size();
+    }
+
+    /**
+     * @return The number of times a stream didn't have the frames a block needed
+     */
+    size_t getUnderruns(void) const {
+        return underruns;
+    }
+
+    /**
+     * Mixes every voice
+     * @param out The interleaved stereo output, which is overwritten
+     * @param frames The number of frames
+     * @param finished The ids of voices which ended are added to this
+     */
+    void mix(float * out, size_t frames, std::vector<uint64_t> & finished);
+
+private:
+
+    /**
+     * @return Whether the voice ended
+     */
+    bool mixVoice(struct Voice & voice, float * out, size_t frames);
+
+    /**
+     * @return Whether the voice ended
+     */
+    bool mixStream(struct Voice & voice, float * out, size_t frames, float leftGain, float rightGain);
+
+    void remove(size_t index);
+
+};
+
+// Where the software mixer's output goes
+class AudioOutput {
+public:
+
+    virtual ~AudioOutput() {
+
+    }
+
+    /**
+     * @param samples Interleaved stereo
+     * @param frames The number of frames
+     */
+    virtual void write(const float * samples, size_t frames) = 0;
+
+};
+
+// Throws the output away, for running without a sound device
+class NullAudioOutput : public AudioOutput {
+public:
+
+    void write(const float * samples, size_t frames) override {
+
+    }
+
+};
+
+// Writes the output to a 16 bit wav file
+class WavAudioOutput : public AudioOutput {
+private:
+
+    WavWriter writer;
+
+    std::vector<int16_t> converted;
+
+public:
+
+    WavAudioOutput(const std::string & path, uint32_t rate) : writer(path, rate, 2) {
+
+    }
+
+    void write(const float * samples, size_t frames) override;
+
+};
+
+// The software mixer as a backend. A mixing thread renders a block at a time
+// into the output, paced to real time, and the backend's thread talks to it
+// through a lock-free queue of commands. A streaming thread keeps the streamed
+// voices' buffers full.
+class MixerBackend : public AudioBackend {
+private:
+
+    struct Command {
+
+        enum class Type {
+            ePlay, eStop, eListener, eUnload
+        };
+
+        Type type;
+        uint64_t id;
+        MixerClip * clip;
+        MixerStream * stream;
+        struct AudioVoiceParams params;
+    };
+
+    SoftwareMixer mixer;
+
+    std::unique_ptr<AudioOutput> output;
+
+    size_t blockFrames;
+
+    SpscQueue<struct Command> commands;
+
+    std::atomic<bool> running;
+
+    std::thread thread;
+
+    // new streams, from the backend's thread to the streaming thread
+    SpscQueue<MixerStream*> newStreams;
+
+    // only touched by the streaming thread
+    std::list<MixerStream*> streams;
+
+    std::atomic<bool> streaming;
+
+    std::thread streamThread;
+
+public:
+
+    static constexpr size_t COMMAND_QUEUE_SIZE = 1024;
+
+    // how long the streaming thread sleeps when every stream is full
+    static constexpr int STREAM_IDLE_MILLISECONDS = 5;
+
+    /**
+     * Starts the mixing thread
+     * @param output Where the mix goes
+     * @param rate The output's sample rate
+     * @param blockFrames The frames mixed at once, which is also the latency
+     */
+    MixerBackend(AudioOutput * output, uint32_t rate = 48000, size_t blockFrames = 512);
+
+    MixerBackend(const MixerBackend & other) = delete;
+
+    ~MixerBackend();
+
+    const char * getName(void) const override {
+        return "mixer";
+    }
+
+    AudioClip * loadClip(const std::string & path, double streamThreshold) override;
+
+    void unloadClip(AudioClip * clip) override;
+
+    bool play(AudioClip * clip, const struct AudioVoiceParams & params, uint64_t id) override;
+
+    void stop(uint64_t id) override;
+
+    void setListener(float x, float y) override;
+
+private:
+
+    void Run(void);
+
+    void RunStreams(void);
+
+    /**
+     * Queues a command which can't be dropped, waiting for room
+     */
+    void push(const struct Command & command);
+
+    void execute(const struct Command & command);
+
+};
+
+#endif /* AUDIOMIXER_HPP */
@@ -0,0 +1,86 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   FileWatcher.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 9:05 AM
+ */
+
+#ifndef FILEWATCHER_HPP
+#define FILEWATCHER_HPP
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <experimental/filesystem>
+
+// Watches files for changes on a thread of its own. On linux the files'
+// folders are watched with inotify, so a file counts as changed once it's
+// closed after writing or moved into place, never while it's half written.
+// Elsewhere the files' modification times are polled. Paths are compared as
+// they're given, so a file has to be watched under the name it's used by.
+class FileWatcher {
+private:
+
+    // how long the thread waits before checking whether it should stop
+    static constexpr int POLL_MILLISECONDS = 250;
+
+    std::mutex lock;
+
+    // the watched files, as generic paths
+    std::set<std::string> files;
+
+    // the files which changed since the last poll
+    std::set<std::string> changed;
+
+#ifdef __linux__
+    int inotify = -1;
+
+    // each watched folder, by its watch descriptor
+    std::map<int, std::string> folders;
+#else
+    std::map<std::string, std::experimental::filesystem::file_time_type> modified;
+#endif
+
+    std::atomic<bool> running;
+
+    std::thread thread;
+
+    static void Run(FileWatcher * watcher);
+
+    /**
+     * Checks for changes once, waiting up to POLL_MILLISECONDS for one
+     */
+    void check(void);
+
+public:
+
+    FileWatcher();
+
+    FileWatcher(const FileWatcher & other) = delete;
+
+    ~FileWatcher();
+
+    /**
+     * Starts watching a file, watching one twice does nothing
+     * @param path The file, which doesn't have to exist yet
+     */
+    void watch(const std::string & path);
+
+    /**
+     * @return The files which changed since the last poll, as generic paths
+     */
+    std::vector<std::string> poll(void);
+
+};
+
+#endif /* FILEWATCHER_HPP */
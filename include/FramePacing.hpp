@@ -0,0 +1,132 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   FramePacing.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 3:05 PM
+ */
+
+#ifndef FRAMEPACING_HPP
+#define FRAMEPACING_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// How frames are handed to the presentation engine
+enum class PresentPolicy {
+    // FIFO with as few images as possible, input is sampled after the acquire
+    eLowLatency,
+    // mailbox or immediate with extra images, renders as fast as possible
+    eMaxThroughput,
+    // the cpu limits the frame rate, presents without waiting for vblank if it can
+    eCappedRate
+};
+
+struct PresentSettings {
+    PresentPolicy policy = PresentPolicy::eMaxThroughput;
+
+    // images on top of the surface's minimum, for eMaxThroughput
+    uint32_t extraImages = 1;
+
+    // frames per second, for eCappedRate
+    double targetRate = 60.0;
+
+    PresentSettings() {
+    }
+
+    PresentSettings(PresentPolicy policy, double targetRate = 60.0, uint32_t extraImages = 1) :
+    policy(policy), extraImages(extraImages), targetRate(targetRate) {
+    }
+};
+
+// Limits the frame rate on the cpu. Sleeps for most of the frame, then spins
+// for the last part since sleeps are too coarse to hit the deadline.
+class FramePacer {
+private:
+    using clock = std::chrono::steady_clock;
+
+    clock::duration period;
+    clock::duration spinThreshold;
+
+    clock::time_point deadline;
+    bool started = false;
+
+public:
+
+    /**
+     * @param targetRate The frames per second, 0 disables the limiter
+     * @param spinThreshold How long before the deadline to stop sleeping
+     */
+    FramePacer(double targetRate = 0, std::chrono::microseconds spinThreshold = std::chrono::microseconds(2000));
+
+    void setTargetRate(double targetRate);
+
+    double getTargetRate() const;
+
+    /**
+     * Blocks until the next frame should start. If the frame took longer than
+     * the period, the schedule restarts from now instead of rushing to catch up.
+     */
+    void wait();
+
+};
+
+// Measures the time between the input being sampled and the frame which used
+// it being presented, over a rolling window of frames
+class LatencyTracker {
+private:
+    using clock = std::chrono::steady_clock;
+
+    clock::time_point sampled;
+    bool hasSample = false;
+
+    std::vector<double> samples;
+    size_t next = 0, count = 0;
+
+public:
+
+    /**
+     * @param window The number of frames the statistics cover
+     */
+    LatencyTracker(size_t window = 120);
+
+    /**
+     * Marks the input as sampled. Only the last sample before a present counts.
+     */
+    void markInputSampled();
+
+    /**
+     * Marks the frame as presented and records its latency
+     */
+    void markPresented();
+
+    /**
+     * @return The latest latency in milliseconds
+     */
+    double getLatest() const;
+
+    /**
+     * @return The average latency in milliseconds
+     */
+    double getAverage() const;
+
+    /**
+     * @param percentile The percentile, between 0 and 1
+     * @return The latency in milliseconds which that many frames are under
+     */
+    double getPercentile(double percentile) const;
+
+    size_t getSampleCount() const {
+        return count;
+    }
+
+};
+
+#endif /* FRAMEPACING_HPP */
@@ -0,0 +1,44 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   GpuStruct.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 11:20 AM
+ */
+
+#ifndef GPUSTRUCT_HPP
+#define GPUSTRUCT_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// An array element padded out to the array's stride, for the std140 arrays
+// whose elements are further apart than their size. It's used like the value.
+template<typename T, size_t STRIDE>
+struct Padded {
+    static_assert(STRIDE > sizeof (T), "an element which fills its stride doesn't need padding");
+
+    T value;
+    uint8_t padding[STRIDE - sizeof (T)];
+
+    Padded & operator=(const T & other) {
+        value = other;
+        return *this;
+    }
+
+    operator T&() {
+        return value;
+    }
+
+    operator const T&() const {
+        return value;
+    }
+
+};
+
+#endif /* GPUSTRUCT_HPP */
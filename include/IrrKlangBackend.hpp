@@ -0,0 +1,83 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   IrrKlangBackend.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 3:30 AM
+ */
+
+#ifndef IRRKLANGBACKEND_HPP
+#define IRRKLANGBACKEND_HPP
+
+#include "AudioBackend.hpp"
+
+#include <irrklang/irrKlang.h>
+
+#include <unordered_map>
+
+// Plays sounds through irrKlang, which needs a sound device
+class IrrKlangBackend : public AudioBackend, public irrklang::ISoundStopEventReceiver {
+private:
+
+    class Clip : public AudioClip {
+    public:
+        irrklang::ISoundSource * source;
+        size_t size;
+        bool streamed;
+
+        size_t getSize(void) const override {
+            return size;
+        }
+
+        double getLength(void) const override {
+            // getplaylength returns milliseconds
+            return source->getPlayLength() / 1000.0;
+        }
+
+        bool isStreamed(void) const override {
+            return streamed;
+        }
+    };
+
+    irrklang::ISoundEngine * engine;
+
+    std::unordered_map<uint64_t, irrklang::ISound*> voices;
+
+public:
+
+    /**
+     * Creates the engine, throwing if there's no sound device
+     */
+    IrrKlangBackend();
+
+    IrrKlangBackend(const IrrKlangBackend & other) = delete;
+
+    ~IrrKlangBackend();
+
+    const char * getName(void) const override {
+        return "irrklang";
+    }
+
+    AudioClip * loadClip(const std::string & path, double streamThreshold) override;
+
+    void unloadClip(AudioClip * clip) override;
+
+    bool play(AudioClip * clip, const struct AudioVoiceParams & params, uint64_t id) override;
+
+    void stop(uint64_t id) override;
+
+    void setListener(float x, float y) override;
+
+    /**
+     * Called by the engine, usually from its own thread
+     */
+    void OnSoundStopped(irrklang::ISound* sound, irrklang::E_STOP_EVENT_CAUSE reason, void* userData) override;
+
+};
+
+#endif /* IRRKLANGBACKEND_HPP */
@@ -0,0 +1,58 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   MappedFile.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 6:05 AM
+ */
+
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// A whole file mapped read-only into memory. The operating system pages it in
+// as it's read, so nothing is copied and opening it costs the same for any size.
+class MappedFile {
+private:
+
+    const uint8_t * data = nullptr;
+    size_t size = 0;
+
+#ifdef _WIN32
+    void * file = nullptr, * mapping = nullptr;
+#endif
+
+public:
+
+    /**
+     * Maps a file, throwing if it can't be opened
+     * @param path The file
+     */
+    MappedFile(const std::string & path);
+
+    MappedFile(const MappedFile & other) = delete;
+
+    ~MappedFile();
+
+    /**
+     * @return The file's contents, which are page aligned
+     */
+    const uint8_t * getData(void) const {
+        return data;
+    }
+
+    size_t getSize(void) const {
+        return size;
+    }
+
+};
+
+#endif /* MAPPEDFILE_HPP */
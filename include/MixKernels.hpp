@@ -0,0 +1,93 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   MixKernels.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 3:40 AM
+ */
+
+#ifndef MIXKERNELS_HPP
+#define MIXKERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Vectorized sample kernels for the software mixer. Like the pixel kernels,
+// every kernel has a scalar fallback, the best implementation the cpu supports
+// is picked the first time a kernel is called, and all paths produce
+// identical output.
+class MixKernels {
+public:
+
+    enum class Level {
+        eScalar, eSSE2, eAVX2, eNEON
+    };
+
+    /**
+     * @return The best level the cpu supports
+     */
+    static Level GetSupportedLevel();
+
+    /**
+     * @return The level the kernels currently dispatch to
+     */
+    static Level GetLevel();
+
+    /**
+     * Forces the kernels to a specific level, for benchmarks and comparisons.
+     * Levels the cpu doesn't support fall back to the best supported one.
+     * @param level The level
+     * @return The level which was actually selected
+     */
+    static Level SetLevel(Level level);
+
+    static const char * GetLevelName(Level level);
+
+    /**
+     * Resamples one channel with linear interpolation. Sample i of the output
+     * is the input at position + i * step.
+     * @param src The input, which must have a readable sample after the last
+     * position read
+     * @param position Where the first output sample is, in input samples
+     * @param step How far apart the output samples are, in input samples
+     * @param dst The output, must not overlap src
+     * @param count The number of output samples
+     */
+    static void Resample(const float * src, double position, float step, float * dst, size_t count);
+
+    /**
+     * Adds two channels, each with their own gain, to interleaved stereo
+     * @param left The left channel
+     * @param right The right channel, which can be the left one for mono
+     * @param leftGain The left channel's gain
+     * @param rightGain The right channel's gain
+     * @param dst The interleaved stereo being mixed into, must not overlap the channels
+     * @param count The number of frames
+     */
+    static void MixStereo(const float * left, const float * right, float leftGain, float rightGain,
+            float * dst, size_t count);
+
+    /**
+     * Multiplies samples by a gain in place
+     * @param samples The samples
+     * @param count The number of samples
+     * @param gain The gain
+     */
+    static void Scale(float * samples, size_t count, float gain);
+
+    /**
+     * Converts samples to 16 bit, clipping anything outside of -1 to 1
+     * @param src The samples
+     * @param dst The output
+     * @param count The number of samples
+     */
+    static void ToInt16(const float * src, int16_t * dst, size_t count);
+
+};
+
+#endif /* MIXKERNELS_HPP */
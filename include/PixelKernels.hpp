@@ -0,0 +1,96 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   PixelKernels.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 1:12 PM
+ */
+
+#ifndef PIXELKERNELS_HPP
+#define PIXELKERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Vectorized pixel conversions for the asset loading path. Every kernel has a
+// scalar fallback, and the best implementation the cpu supports is picked the
+// first time a kernel is called. All paths produce identical output.
+class PixelKernels {
+public:
+
+    enum class Level {
+        eScalar, eSSE2, eSSSE3, eAVX2, eNEON
+    };
+
+    // Mirrors the ChromaKey parameters, without depending on glm
+    struct ChromaKeyParams {
+        float search[4], replace[4];
+        float epsilon1, epsilon2;
+    };
+
+    /**
+     * @return The best level the cpu supports
+     */
+    static Level GetSupportedLevel();
+
+    /**
+     * @return The level the kernels currently dispatch to
+     */
+    static Level GetLevel();
+
+    /**
+     * Forces the kernels to a specific level, for benchmarks and comparisons.
+     * Levels the cpu doesn't support fall back to the best supported one.
+     * @param level The level
+     * @return The level which was actually selected
+     */
+    static Level SetLevel(Level level);
+
+    static const char * GetLevelName(Level level);
+
+    /**
+     * Expands tightly packed RGB pixels to RGBA with an opaque alpha
+     * @param src The RGB pixels
+     * @param dst The RGBA output, must not overlap src
+     * @param count The number of pixels
+     */
+    static void ExpandRGBToRGBA(const uint8_t * src, uint8_t * dst, size_t count);
+
+    /**
+     * Expands tightly packed BGR pixels to RGBA with an opaque alpha
+     * @param src The BGR pixels
+     * @param dst The RGBA output, must not overlap src
+     * @param count The number of pixels
+     */
+    static void ExpandBGRToRGBA(const uint8_t * src, uint8_t * dst, size_t count);
+
+    /**
+     * Swaps the red and blue channels of 4 channel pixels in place (BGRA <-> RGBA)
+     * @param pixels The pixels
+     * @param count The number of pixels
+     */
+    static void SwizzleBGRA(uint8_t * pixels, size_t count);
+
+    /**
+     * Multiplies the colour channels of RGBA pixels by their alpha, in place
+     * @param pixels The pixels
+     * @param count The number of pixels
+     */
+    static void PremultiplyAlpha(uint8_t * pixels, size_t count);
+
+    /**
+     * Applies a chroma key to RGBA pixels in place, writing the alpha channel
+     * @param pixels The pixels
+     * @param count The number of pixels
+     * @param key The chroma key
+     */
+    static void ChromaKeyAlpha(uint8_t * pixels, size_t count, const ChromaKeyParams & key);
+
+};
+
+#endif /* PIXELKERNELS_HPP */
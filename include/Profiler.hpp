@@ -0,0 +1,113 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   Profiler.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 5:02 PM
+ */
+
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+// Scoped cpu zones, exported as Chrome trace json (chrome://tracing, or
+// ui.perfetto.dev). Everything compiles to nothing unless ENABLE_PROFILER is
+// defined, which the build only does outside of release builds.
+//
+//     PROFILE_FUNCTION();                 zone named after the function
+//     PROFILE_SCOPE("Scene::record");     zone with a fixed name
+//     PROFILE_SCOPE_DYNAMIC(path);        zone with a runtime name, interned
+//     PROFILE_SCOPE_TYPE(*decorator);     zone named after the dynamic type
+//     PROFILE_FRAME();                    marks the end of a frame, for hitch detection
+
+#ifdef ENABLE_PROFILER
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <typeinfo>
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#define PROFILE_SCOPE(name) Profiler::Zone PROFILE_CONCAT(_profile_zone_, __COUNTER__)(name)
+#define PROFILE_SCOPE_DYNAMIC(name) Profiler::Zone PROFILE_CONCAT(_profile_zone_, __COUNTER__)(Profiler::Intern(name))
+#define PROFILE_SCOPE_TYPE(object) Profiler::Zone PROFILE_CONCAT(_profile_zone_, __COUNTER__)(typeid(object).name(), true)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#define PROFILE_FRAME() Profiler::EndFrame()
+
+class Profiler {
+public:
+
+    // Times the scope it lives in. The name must outlive the profiler.
+    class Zone {
+    private:
+        const char * name;
+        uint64_t start;
+        bool mangled;
+
+    public:
+
+        Zone(const char * name, bool mangled = false);
+
+        ~Zone();
+
+        Zone(const Zone & other) = delete;
+    };
+
+    /**
+     * Makes a copy of a name which lives as long as the program, so a zone
+     * can use it. Each distinct name is only stored once.
+     * @param name The name
+     * @return The stored name
+     */
+    static const char * Intern(const std::string & name);
+
+    /**
+     * Names the calling thread in the trace
+     * @param name The name
+     */
+    static void SetThreadName(const std::string & name);
+
+    /**
+     * Marks the end of a frame. If the frame took longer than the hitch
+     * threshold, the recent history is written to a trace file.
+     */
+    static void EndFrame();
+
+    /**
+     * @param milliseconds The frame time which counts as a hitch, 0 disables the dumps
+     * @param prefix The path prefix of the dumped traces
+     */
+    static void SetHitchThreshold(double milliseconds, const std::string & prefix = "hitch");
+
+    /**
+     * Writes every thread's recent zones as a Chrome trace. Doesn't stop the
+     * threads from recording, and doesn't clear anything.
+     * @param out The stream
+     */
+    static void WriteTrace(std::ostream & out);
+
+    /**
+     * @param path The file to write
+     * @return Whether the file could be written
+     */
+    static bool WriteTrace(const std::string & path);
+
+};
+
+#else
+
+#define PROFILE_SCOPE(name) do { } while (0)
+#define PROFILE_SCOPE_DYNAMIC(name) do { } while (0)
+#define PROFILE_SCOPE_TYPE(object) do { } while (0)
+#define PROFILE_FUNCTION() do { } while (0)
+#define PROFILE_FRAME() do { } while (0)
+
+#endif
+
+#endif /* PROFILER_HPP */
@@ -0,0 +1,117 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   SpscQueue.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 2:05 AM
+ */
+
+#ifndef SPSCQUEUE_HPP
+#define SPSCQUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+// A bounded, lock-free queue between exactly one producer thread and one
+// consumer thread. Neither side ever blocks or allocates; pushing to a full
+// queue fails instead. Each index is only written by one side, and they're
+// padded onto separate cache lines so the threads don't fight over them. It's
+// padded rather than aligned, so its owners can still be allocated with new.
+template<typename T>
+class SpscQueue {
+private:
+
+    static constexpr size_t CACHE_LINE = 64;
+
+    std::vector<T> slots;
+
+    size_t mask;
+
+    // keeps head off the line the fields before it are on
+    char before_head[CACHE_LINE];
+
+    // the next slot the consumer reads, only written by the consumer
+    std::atomic<size_t> head;
+
+    char before_tail[CACHE_LINE - sizeof (std::atomic<size_t>)];
+
+    // the next slot the producer writes, only written by the producer
+    std::atomic<size_t> tail;
+
+    // keeps tail off the line the owner's next fields are on
+    char after_tail[CACHE_LINE - sizeof (std::atomic<size_t>)];
+
+public:
+
+    /**
+     * @param capacity The most items queued at once, a power of two
+     */
+    SpscQueue(size_t capacity) : slots(capacity), mask(capacity - 1), head(0), tail(0) {
+        if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+            throw std::runtime_error("Queue capacity must be a power of two");
+        }
+    }
+
+    SpscQueue(const SpscQueue & other) = delete;
+
+    /**
+     * Only called from the producer thread
+     * @param item The item, copied
+     * @return Whether there was room for it
+     */
+    bool push(const T & item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+
+        if (t - head.load(std::memory_order_acquire) == slots.size()) {
+            return false;
+        }
+
+        slots[t & mask] = item;
+
+        // publishes the slot to the consumer
+        tail.store(t + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /**
+     * Only called from the consumer thread
+     * @param item Set to the oldest item
+     * @return Whether there was an item
+     */
+    bool pop(T & item) {
+        size_t h = head.load(std::memory_order_relaxed);
+
+        if (h == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        item = slots[h & mask];
+
+        // hands the slot back to the producer
+        head.store(h + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /**
+     * @return The number of queued items. Only exact when neither side is busy.
+     */
+    size_t size(void) const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    size_t capacity(void) const {
+        return slots.size();
+    }
+
+};
+
+#endif /* SPSCQUEUE_HPP */
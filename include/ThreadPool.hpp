@@ -0,0 +1,89 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   ThreadPool.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 8:10 AM
+ */
+
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// A fixed set of worker threads which run tasks in the order they're
+// submitted. Each task's result, or the exception it threw, comes back
+// through its future. The workers finish every queued task before the pool
+// is destroyed.
+class ThreadPool {
+private:
+
+    std::vector<std::thread> workers;
+
+    std::deque<std::function<void()>> tasks;
+
+    std::mutex lock;
+
+    std::condition_variable available;
+
+    bool stopping = false;
+
+    static void Run(ThreadPool * pool);
+
+public:
+
+    /**
+     * @param threads The number of workers, or 0 for one per hardware thread
+     */
+    ThreadPool(unsigned threads = 0);
+
+    ThreadPool(const ThreadPool & other) = delete;
+
+    ~ThreadPool();
+
+    size_t size() const {
+        return workers.size();
+    }
+
+    /**
+     * Queues a task for the next free worker
+     * @param task Any callable without arguments
+     * @return The task's result
+     */
+    template<typename F>
+    std::future<typename std::result_of<F()>::type> submit(F task) {
+        typedef typename std::result_of<F()>::type R;
+
+        // std::function has to be copyable, so the task is shared
+        std::shared_ptr<std::packaged_task<R()>> packaged = std::make_shared<std::packaged_task<R()>>(std::move(task));
+
+        std::future<R> result = packaged->get_future();
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            tasks.push_back([packaged]() {
+                (*packaged)();
+            });
+        }
+
+        available.notify_one();
+
+        return result;
+    }
+
+};
+
+#endif /* THREADPOOL_HPP */
@@ -32,6 +32,9 @@ public:
         this->memory = memory;
     }
 
+    virtual ~VulkanBufferHolder() {
+    }
+
     virtual vk::Buffer getBuffer(void) {
         return buffer;
     }
@@ -112,6 +115,25 @@ public:
 
     }
 
+    /**
+     * A range of a buffer which is owned somewhere else. There's no host copy,
+     * so update does nothing.
+     * @param holder The holder, which is deleted with this buffer
+     * @param device The device
+     * @param offset The range's offset into the holder's buffer
+     * @param size The range's size in bytes
+     */
+    VulkanBuffer(VulkanBufferHolder * holder, VulkanDevice * device, vk::DeviceSize offset, size_t size) :
+    holder(holder) {
+
+        this->device = device;
+        this->offset = offset;
+
+        data = nullptr;
+        this->size = size;
+
+    }
+
     virtual ~VulkanBuffer() {
         delete[] data;
     }
@@ -130,6 +152,10 @@ public:
         return holder->getBuffer();
     }
 
+    vk::DeviceSize getOffset(void) {
+        return offset;
+    }
+
     void * getData(void) {
         return data;
     }
@@ -148,6 +174,8 @@ protected:
 
     size_t size;
 
+    vk::DeviceSize offset = 0;
+
     VulkanDevice * device;
 
     void obj2buf(void * data, size_t count) {
@@ -200,6 +228,11 @@ public:
         count = n;
     }
 
+    VulkanObjectBuffer(VulkanBufferHolder * holder, VulkanDevice * device, vk::DeviceSize offset, int n) :
+    VulkanBuffer(holder, device, offset, n * sizeof (T)) {
+        count = n;
+    }
+
 };
 
 // Controls updatable resources
@@ -0,0 +1,175 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   VulkanCamera.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 11:50 PM
+ */
+
+#ifndef VULKANCAMERA_HPP
+#define VULKANCAMERA_HPP
+
+#include "VulkanDevice.hpp"
+#include "VulkanCommandBuffer.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/**
+ * What the shaders see of a view (std140), at set 1 binding 0
+ */
+struct CameraUniform {
+    glm::mat4 viewProjection;
+};
+
+/**
+ * One view of the world, drawn into part of the framebuffer
+ */
+struct CameraView {
+    // the world point at the view's centre
+    glm::vec2 pan = {0, 0};
+
+    // 1 fits the world square (-1 to 1) into the view
+    float zoom = 1;
+
+    // x, y, width and height, as fractions of the framebuffer
+    glm::vec4 rect = {0, 0, 1, 1};
+};
+
+// Turns world space into clip space for every view, on the gpu. Each frame in
+// flight has one uniform buffer holding every view, which draws select with a
+// dynamic offset. Moving the camera only changes a few matrices, so objects
+// never have to be touched.
+class VulkanCamera {
+private:
+
+    // views past this can't be added
+    static constexpr uint32_t MAX_VIEWS = 8;
+
+    struct FrameResources {
+        vk::Buffer buffer;
+        vk::DeviceMemory memory;
+
+        void * mapped;
+
+        vk::DescriptorSet set;
+    };
+
+    VulkanDevice & device;
+    VulkanFrameCommandPools * pools;
+    VulkanViewport * viewport;
+
+    // each view's uniform starts on the device's offset alignment
+    vk::DeviceSize stride;
+
+    std::vector<struct CameraView> views;
+
+    std::vector<struct FrameResources> frames;
+
+    vk::DescriptorSetLayout layout;
+    vk::DescriptorPool descriptorPool;
+
+public:
+
+    /**
+     * Creates a camera with one view, which covers the whole framebuffer
+     * @param device The device
+     * @param pools The frame pools, the camera keeps one buffer per frame
+     * @param viewport The framebuffer's viewport, which the views are fractions of
+     */
+    VulkanCamera(VulkanDevice & device, VulkanFrameCommandPools * pools, VulkanViewport * viewport);
+
+    VulkanCamera(const VulkanCamera & other) = delete;
+
+    ~VulkanCamera();
+
+    /**
+     * Adds a view, such as a minimap, which is drawn over the earlier views.
+     * Each view is given a nearer part of the depth range than the views
+     * before it.
+     * @param view The view
+     * @return The view's index
+     */
+    uint32_t addView(const struct CameraView & view);
+
+    /**
+     * Removes every view after the first
+     */
+    void clearViews(void) {
+        views.resize(1);
+    }
+
+    struct CameraView & getView(uint32_t view = 0) {
+        return views.at(view);
+    }
+
+    uint32_t viewCount(void) const {
+        return static_cast<uint32_t> (views.size());
+    }
+
+    void setPan(glm::vec2 pan, uint32_t view = 0) {
+        views.at(view).pan = pan;
+    }
+
+    void setZoom(float zoom, uint32_t view = 0) {
+        views.at(view).zoom = zoom;
+    }
+
+    /**
+     * @param view The view
+     * @return The world to clip space scale, which keeps the world square square
+     */
+    glm::vec2 getScale(uint32_t view = 0) const;
+
+    /**
+     * @param view The view
+     * @return The view's world to clip space transform
+     */
+    glm::mat4 getViewProjection(uint32_t view = 0) const;
+
+    /**
+     * @return The world space area any view can see, as min x, min y, max x and max y
+     */
+    glm::vec4 getWorldBounds(void) const;
+
+    /**
+     * Translates a point on the framebuffer to world space, through the
+     * topmost view which contains it
+     * @param point The point, from -1 to 1 across the framebuffer
+     * @param world Set to the world space point
+     * @return Whether any view contains the point
+     */
+    bool screenToWorld(glm::vec2 point, glm::vec2 & world) const;
+
+    /**
+     * Writes every view into the current frame's buffer. Called once per
+     * frame, after the camera's last change and before the frame is submitted.
+     */
+    void update(void);
+
+    /**
+     * Sets the viewport, with the view's part of the depth range, and the
+     * scissor to a view and binds its uniform
+     * @param buffer The buffer being recorded
+     * @param layout The pipeline's layout, which has the camera at set 1
+     * @param view The view
+     */
+    void bind(vk::CommandBuffer buffer, vk::PipelineLayout layout, uint32_t view);
+
+    vk::DescriptorSetLayout getSetLayout(void) {
+        return layout;
+    }
+
+private:
+
+    vk::Viewport getPixels(uint32_t view) const;
+
+};
+
+#endif /* VULKANCAMERA_HPP */
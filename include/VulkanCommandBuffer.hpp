@@ -6,6 +6,18 @@
 
 #include <vector>
 
+class VulkanCommandBufferPool;
+
+// Counts the buffers a pool has handed out
+struct CommandBufferStats {
+    // handed out and not yet given back
+    size_t live = 0;
+    // allocated from vulkan, but not handed out
+    size_t free = 0;
+    // times a buffer was handed out again instead of allocating a new one
+    size_t recycled = 0;
+};
+
 // Represents a vulkan command buffer
 // Can be allocated or deallocated depending on the current buffer groups
 class VulkanCommandBuffer {
@@ -15,6 +27,9 @@ private:
     int allocation = -1;
     bool primary;
 
+    // how many groups have owned this buffer
+    size_t uses = 0;
+
 public:
 
     VulkanCommandBuffer(vk::CommandBuffer buffer, bool primary = true);
@@ -31,6 +46,10 @@ public:
 
     void deallocate(void);
 
+    size_t getUses(void) const {
+        return uses;
+    }
+
     vk::CommandBuffer* operator->(void);
 
     vk::CommandBuffer& get(void);
@@ -46,9 +65,11 @@ private:
     std::vector<VulkanCommandBuffer*> buffers;
     bool primary = true;
 
+    VulkanCommandBufferPool * owner;
+
 public:
 
-    VulkanCommandBufferGroup(int id, std::vector<VulkanCommandBuffer*> buffers, bool primary);
+    VulkanCommandBufferGroup(int id, std::vector<VulkanCommandBuffer*> buffers, bool primary, VulkanCommandBufferPool * owner);
 
     ~VulkanCommandBufferGroup();
 
@@ -76,6 +97,11 @@ private:
 
     std::vector<VulkanCommandBuffer*> pbuffers, sbuffers;
 
+    // the buffers which aren't in a group, taken from the back
+    std::vector<VulkanCommandBuffer*> pfree, sfree;
+
+    size_t recycled = 0;
+
     int nextgroup = 0;
 
     VulkanDevice & device;
@@ -94,8 +120,23 @@ public:
 		return device->allocateCommandBuffers(allocInfo)[0];
 	}
 
+    /**
+     * Takes buffers from the free list, allocating more only when it runs out
+     * @param count The number of buffers
+     * @param level The buffers' level
+     * @return The group, which gives the buffers back when deleted
+     */
     VulkanCommandBufferGroup * allocateGroup(size_t count, vk::CommandBufferLevel level = vk::CommandBufferLevel::ePrimary);
 
+    /**
+     * Puts a group's buffers back on the free list. Called by the group.
+     * @param buffers The buffers
+     * @param primary Whether they're primary buffers
+     */
+    void release(std::vector<VulkanCommandBuffer*> & buffers, bool primary);
+
+    struct CommandBufferStats getStats(vk::CommandBufferLevel level) const;
+
     operator vk::CommandPool&(void);
 
     vk::CommandPool & get(void) {
@@ -103,13 +144,67 @@ public:
     }
     
 private:
-    void allocatePrimaryBuffers(size_t count);
 
-    void addMorePrimaryBuffers(size_t extra);
+    void addBuffers(size_t count, vk::CommandBufferLevel level);
+
+};
+
+// Command pools which are reset all at once, one per frame in flight. A
+// buffer acquired during a frame stays valid until that frame's pool is reset
+// the next time it comes around, so nothing is ever freed or reset one by one.
+class VulkanFrameCommandPools {
+private:
+
+    struct FramePool {
+        vk::CommandPool pool;
+
+        std::vector<vk::CommandBuffer> primary, secondary;
 
-    void allocateSecondaryBuffers(size_t count);
+        // the next unused buffer of each level
+        size_t nextPrimary = 0, nextSecondary = 0;
+    };
+
+    VulkanDevice & device;
+
+    std::vector<struct FramePool> frames;
+
+    size_t current = 0, recycled = 0;
+
+public:
+
+    /**
+     * @param device The device
+     * @param framesInFlight The number of frames which may be recorded or executing at once
+     */
+    VulkanFrameCommandPools(VulkanDevice & device, size_t framesInFlight);
+
+    VulkanFrameCommandPools(const VulkanFrameCommandPools & other) = delete;
+
+    ~VulkanFrameCommandPools();
+
+    /**
+     * Resets a frame's pool and makes it the current one. The frame's last
+     * submit must have finished.
+     * @param frame The frame in flight
+     */
+    void beginFrame(size_t frame);
+
+    /**
+     * Gets a buffer from the current frame's pool, ready to begin
+     * @param level The buffer's level
+     * @return The buffer
+     */
+    vk::CommandBuffer acquire(vk::CommandBufferLevel level = vk::CommandBufferLevel::eSecondary);
+
+    size_t frameCount(void) const {
+        return frames.size();
+    }
+
+    size_t getCurrentFrame(void) const {
+        return current;
+    }
 
-    void addMoreSecondaryBuffers(size_t extra);
+    struct CommandBufferStats getStats(void) const;
 
 };
 
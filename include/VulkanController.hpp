@@ -14,41 +14,34 @@
 #ifndef VULKANCONTROLLER_HPP
 #define VULKANCONTROLLER_HPP
 
-#include "VulkanInst.hpp"
-#include "VulkanDevice.hpp"
+#include "VulkanControllerBase.hpp"
 #include "VulkanSwap.hpp"
-#include "VulkanDepthBuffer.hpp"
 #include "VulkanRenderPipeline.hpp"
-#include "VulkanCommandBuffer.hpp"
 #include "VulkanDescriptor.hpp"
-#include "VulkanRenderer.hpp"
 #include "VulkanSingleCommand.hpp"
-
-#include "VulkanImage.hpp"
+#include "VulkanHotReload.hpp"
 
 // Controls the initialization and deinitialization of various vulkan objects
-class VulkanController : public MaterialRendererBuilder {
+class VulkanController : public VulkanControllerBase {
 private:
 
     Window * window;
-    VulkanInstance * instance;
-    VulkanDevice * device;
     VulkanSwapchain * swapchain;
-    VulkanDepthBuffer * depthBuffer;
-    VulkanRenderPass * renderPass;
-    VulkanCommandBufferPool * cmdpool;
-    VulkanQueue * queue;
-    VulkanViewport * viewport;
     VulkanScreenBufferController * screenController;
 
-    ImageManager * images;
-
     vk::Fence acquire_fence;
-    vk::CommandBuffer pBuffer;
+
+    bool resizePending = false;
+
+    FramePacer pacer;
+    LatencyTracker latency;
+
+    // only created when asked for, it watches files on a thread of its own
+    VulkanHotReload * reloader = nullptr;
 
 public:
 
-    VulkanController(Window & wnd) {
+    VulkanController(Window & wnd, const PresentSettings & settings = PresentSettings()) {
         window = &wnd;
         instance = new VulkanInstance(wnd.getTitle());
 
@@ -56,21 +49,17 @@ public:
 
         device = new VulkanDevice(*instance, wnd);
 
-        cmdpool = new VulkanCommandBufferPool(*device);
-
-        queue = new VulkanQueue(*device);
-
-        depthBuffer = new VulkanDepthBuffer(*device, *viewport);
+        createDeviceObjects();
 
         renderPass = new VulkanRenderPass(*device, *depthBuffer);
 
-        swapchain = new VulkanSwapchain(*device, *viewport, *renderPass);
+        swapchain = new VulkanSwapchain(*device, *viewport, *renderPass, *depthBuffer, settings);
 
-        screenController = new VulkanScreenBufferController(*device, *swapchain);
+        pacer.setTargetRate(settings.policy == PresentPolicy::eCappedRate ? settings.targetRate : 0);
 
-        images = new ImageManager(device, cmdpool, queue);
+        screenController = new VulkanScreenBufferController(*device, *swapchain);
 
-        pBuffer = cmdpool->create(vk::CommandBufferLevel::ePrimary);
+        createFrameObjects(swapchain, screenController->getMaxFrames());
 
         acquire_fence = (*device)->createFence(vk::FenceCreateInfo());
     }
@@ -78,87 +67,201 @@ public:
     VulkanController(const VulkanController& other) = delete;
 
     virtual ~VulkanController() {
+        (*device)->waitIdle();
+
+        // its pipelines and textures have been swapped into the materials, which are freed by their owners
+        delete reloader;
+
+        swapchain->destroy(*device);
+
         (*device)->destroyFence(acquire_fence);
-        (*device)->freeCommandBuffers(*cmdpool,{pBuffer});
-        delete queue;
-        delete cmdpool;
-        delete depthBuffer;
+
+        releasePasses();
+
         delete swapchain;
-        delete renderPass;
-        delete device;
-        delete instance;
     }
 
-    void recreateSwapchain(void) {
-        // recreate the data without touching the pointers
+    /**
+     * Marks the swapchain for recreation at the start of the next frame. Safe
+     * to call from window callbacks.
+     */
+    void requestResize(void) {
+        resizePending = true;
+    }
 
-        (*device)->waitIdle();
+    /**
+     * Rebuilds everything which depends on the window's size. Only the frames
+     * in flight are waited on, the old swapchain stays alive until the
+     * presentation engine is done with it.
+     * @return Whether the swapchain was recreated, false if the window is minimized
+     */
+    bool recreateSwapchain(void) {
+        // recreate the data without touching the pointers
 
         viewport->reload(*window);
 
-        swapchain->destroy(*device);
+        // a minimized window has no surface to present to
+        if (viewport->getWidth() == 0 || viewport->getHeight() == 0) {
+            return false;
+        }
+
+        screenController->waitForFrames();
+
+        depthBuffer->resize(*device, viewport->getWidth(), viewport->getHeight());
 
-        device->recreateSurface(*instance, *window);
+        swapchain->recreateSwapchain(*device, *viewport, *renderPass, *depthBuffer, screenController->getMaxFrames());
 
-        swapchain->recreateSwapchain(*device, *viewport, *renderPass);
+        screenController->swapchainRecreated();
+
+        for (MaterialRenderer * renderer : renderers) {
+            renderer->swapchainRecreated();
+        }
 
-        queue->revalidateQueues(*device);
+        resizePending = false;
+
+        return true;
     }
 
-    VulkanDevice * getDevice(void) {
-        return device;
+    /**
+     * Switches the present policy. The swapchain is recreated at the start of
+     * the next frame.
+     * @param settings The new settings
+     */
+    void setPresentSettings(const PresentSettings & settings) {
+        swapchain->setPresentSettings(settings);
+
+        pacer.setTargetRate(settings.policy == PresentPolicy::eCappedRate ? settings.targetRate : 0);
+
+        requestResize();
     }
 
-    VulkanViewport * getViewport(void) {
-        return viewport;
+    const PresentSettings & getPresentSettings(void) {
+        return swapchain->getPresentSettings();
     }
 
-    ImageManager * getImageManager(void) {
-        return images;
+    /**
+     * @return The input to present latency of recent frames
+     */
+    const LatencyTracker & getLatency(void) {
+        return latency;
     }
 
-    VulkanSwapchain * getSwapchain(void) {
-        return swapchain;
+    /**
+     * Polls the window's events, and records when input was last sampled
+     */
+    void pollEvents(void) {
+        window->pollEvents();
+
+        latency.markInputSampled();
     }
 
-    VulkanRenderPass * getRenderPass(void) {
-        return renderPass;
+    /**
+     * Rebuilds materials and textures whenever their files change. Only the
+     * materials created after this are watched.
+     * @param gameFiles The game file ubo instances are read from, if any
+     */
+    void enableHotReload(const std::string & gameFiles = "") {
+        if (!reloader) {
+            reloader = new VulkanHotReload(*device, *viewport, *renderPass, *images);
+        }
+
+        if (!gameFiles.empty()) {
+            reloader->setGameFiles(gameFiles);
+        }
     }
 
-    VulkanQueue * getQueue(void) {
-        return queue;
+    /**
+     * @return The hot reloader, or null if it isn't enabled
+     */
+    VulkanHotReload * getHotReload(void) {
+        return reloader;
     }
 
-    VulkanCommandBufferPool * getBufferPool(void) {
-        return cmdpool;
+    VulkanSwapchain * getSwapchain(void) {
+        return swapchain;
     }
 
     size_t getFrameIndex(void) {
         return screenController->currentIndex();
     }
 
-    Material * createMaterial(MaterialPrototype & prototype, UBOMap * globals = nullptr) {
-        return new Material(*device, prototype, *viewport, *renderPass, *queue, globals);
-    }
+    /**
+     * Creates a material which draws through this controller's camera. The
+     * camera's set is bound at set 1, before the prototype's extra sets.
+     * @param prototype The material's prototype
+     * @param globals Uniform buffers shared with other materials
+     * @return The material
+     */
+    virtual Material * createMaterial(MaterialPrototype & prototype, UBOMap * globals = nullptr) override {
+        Material * material = VulkanControllerBase::createMaterial(prototype, globals);
 
-    virtual MaterialRenderer * createRenderer(Material * material, VulkanIndexBuffer * indexbuffer = nullptr) override {
-        return new MaterialRenderer(swapchain, renderPass, queue, cmdpool, viewport, material, indexbuffer);
+        if (reloader) {
+            reloader->addMaterial(material);
+        }
+
+        return material;
     }
 
     /**
-     * Acquires the next image
+     * Acquires the next image, recreating the swapchain first if it's stale
+     * @return Whether an image was acquired, the frame should be skipped if not
      */
-    void startRender(void) {
+    bool startRender(void) {
+        PROFILE_SCOPE("VulkanController::startRender");
+
+        pacer.wait();
+
+        swapchain->releaseRetired(*device);
+
+        profiler->newFrame();
+
+        // everything recorded the last time this frame was in flight is done, so its buffers can be reused
+        screenController->waitForCurrentFrame();
+        framePools->beginFrame(screenController->getFrameIndex());
+
+        // the store is only rewritten when it was marked, and never while a frame reads it
+        if (geometry->needsUpdate()) {
+            screenController->waitForFrames();
+            geometry->upload(*cmdpool, *queue);
+        }
+
+        // rebuilt off the render thread, and only swapped in once no frame uses the old objects
+        if (reloader && reloader->poll()) {
+            screenController->waitForFrames();
+            reloader->apply(*cmdpool, *queue);
+        }
+
+        if (resizePending || screenController->isOutOfDate()) {
+            if (!recreateSwapchain()) {
+                return false;
+            }
+        }
 
         (*device)->resetFences({acquire_fence});
 
         if (!screenController->acquireImage(acquire_fence)) {
-            printf("Warning: no image acquired");
-            return;
+            // the surface changed between the check and the acquire, try once more
+            if (!screenController->isOutOfDate() || !recreateSwapchain()) {
+                printf("Warning: no image acquired\n");
+                return false;
+            }
+
+            (*device)->resetFences({acquire_fence});
+
+            if (!screenController->acquireImage(acquire_fence)) {
+                printf("Warning: no image acquired\n");
+                return false;
+            }
         }
 
         (*device)->waitForFences({acquire_fence}, true, std::numeric_limits<uint64_t>::max());
 
+        // the acquire is where fifo blocks, so input read now is as fresh as it can be for this frame
+        if (swapchain->getPresentSettings().policy == PresentPolicy::eLowLatency) {
+            pollEvents();
+        }
+
+        return true;
     }
 
     /**
@@ -166,26 +269,13 @@ public:
      * @param secondaries The list of secondary buffers
      */
     void submitSecondaries(std::vector<vk::CommandBuffer> & secondaries) {
+        PROFILE_SCOPE("VulkanController::submitSecondaries");
 
-        pBuffer.reset(vk::CommandBufferResetFlags());
-
-        pBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
-
-        vk::ClearValue cclear;
-
-        cclear.color = std::array<float, 4>({0.0f, 0.0f, 0.0f, 0.0f});
-
-        vk::RenderPassBeginInfo info(renderPass->getRenderPass(), swapchain->getFrame(getFrameIndex()), viewport->getScissor(), 1, &cclear);
-
-        pBuffer.beginRenderPass(info, vk::SubpassContents::eSecondaryCommandBuffers);
-
-        pBuffer.executeCommands(secondaries.size(), secondaries.data());
-
-        pBuffer.endRenderPass();
-
-        pBuffer.end();
+        vk::CommandBuffer pBuffer = recordFrame(secondaries, getFrameIndex());
 
         screenController->queueDraw(*queue, pBuffer);
+
+        latency.markPresented();
     }
 
 };
@@ -0,0 +1,322 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   VulkanControllerBase.hpp
+ * Author: austin-z
+ *
+ * Created on October 19, 2026, 9:10 AM
+ */
+
+#ifndef VULKANCONTROLLERBASE_HPP
+#define VULKANCONTROLLERBASE_HPP
+
+#include "VulkanInst.hpp"
+#include "VulkanDevice.hpp"
+#include "VulkanDepthBuffer.hpp"
+#include "VulkanRenderPass.hpp"
+#include "VulkanCommandBuffer.hpp"
+#include "VulkanGeometry.hpp"
+#include "VulkanCamera.hpp"
+#include "VulkanIndirect.hpp"
+#include "VulkanParticles.hpp"
+#include "VulkanRenderer.hpp"
+#include "VulkanProfiler.hpp"
+#include "Profiler.hpp"
+
+#include "VulkanImage.hpp"
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <vector>
+
+// Everything VulkanController and VulkanHeadlessController share: the device
+// and its pools, the camera, the materials' renderers and the frame passes,
+// and recording a frame's primary buffer. The controllers only differ in what
+// they render into, and how frames are acquired, submitted and presented.
+class VulkanControllerBase : public MaterialRendererBuilder {
+protected:
+
+    VulkanInstance * instance = nullptr;
+    VulkanDevice * device = nullptr;
+    VulkanViewport * viewport = nullptr;
+    VulkanDepthBuffer * depthBuffer = nullptr;
+    VulkanRenderPass * renderPass = nullptr;
+    VulkanCommandBufferPool * cmdpool = nullptr;
+    VulkanQueue * queue = nullptr;
+    VulkanFrameCommandPools * framePools = nullptr;
+    VulkanCamera * camera = nullptr;
+    VulkanGeometryStore * geometry = nullptr;
+
+    ImageManager * images = nullptr;
+
+    // what the render pass draws into, owned by the controller which made it
+    VulkanFramebufferSource * frameTarget = nullptr;
+
+    // every renderer which records against the target's framebuffers
+    std::vector<MaterialRenderer*> renderers;
+
+    // recorded before the render pass, in the order they were added
+    std::vector<VulkanFramePass*> framePasses;
+
+    // passes the controller created, and deletes
+    std::vector<std::unique_ptr<VulkanFramePass>> ownedPasses;
+
+    VulkanGPUProfiler * profiler = nullptr;
+    bool profileMaterials = false;
+
+    VulkanControllerBase() {
+    }
+
+    /**
+     * Creates the command pool, queue and depth buffer. Called once the
+     * instance, viewport and device are created.
+     */
+    void createDeviceObjects(void) {
+        cmdpool = new VulkanCommandBufferPool(*device);
+
+        queue = new VulkanQueue(*device);
+
+        depthBuffer = new VulkanDepthBuffer(*device, *viewport);
+    }
+
+    /**
+     * Creates everything which records frames. Called once the render pass
+     * and the target are created.
+     * @param target What the render pass draws into
+     * @param frames The most frames in flight at once
+     */
+    void createFrameObjects(VulkanFramebufferSource * target, size_t frames) {
+        frameTarget = target;
+
+        images = new ImageManager(device, cmdpool, queue);
+
+        geometry = new VulkanGeometryStore(*device);
+
+        framePools = new VulkanFrameCommandPools(*device, frames);
+
+        camera = new VulkanCamera(*device, framePools, viewport);
+
+        profiler = new VulkanGPUProfiler(*device, frames);
+    }
+
+    /**
+     * Frees the passes, which draw into the target. Called once the device is
+     * idle, before the target is destroyed.
+     */
+    void releasePasses(void) {
+        framePasses.clear();
+        ownedPasses.clear();
+    }
+
+    /**
+     * Records the frame passes, and the render pass around the secondaries
+     * @param secondaries The secondary buffers to draw
+     * @param frame The target's framebuffer to draw into
+     * @return The primary buffer, ended and ready to submit
+     */
+    vk::CommandBuffer recordFrame(std::vector<vk::CommandBuffer> & secondaries, size_t frame) {
+        vk::CommandBuffer pBuffer = framePools->acquire(vk::CommandBufferLevel::ePrimary);
+
+        pBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+
+        profiler->recordReset(pBuffer);
+
+        // the camera's last change this frame has been made, and the passes cull against it
+        camera->update();
+
+        for (VulkanFramePass * pass : framePasses) {
+            pass->recordPrePass(pBuffer);
+        }
+
+        int region = profiler->begin(pBuffer, "render pass");
+
+        std::array<vk::ClearValue, 2> clears;
+
+        clears[0].color = std::array<float, 4>({0.0f, 0.0f, 0.0f, 0.0f});
+        clears[1].depthStencil = vk::ClearDepthStencilValue(1.0f, 0);
+
+        uint32_t clearCount = renderPass->hasAttachment("depth") ? 2 : 1;
+
+        vk::RenderPassBeginInfo info(renderPass->getRenderPass(), frameTarget->getFrame(frame), viewport->getScissor(), clearCount, clears.data());
+
+        pBuffer.beginRenderPass(info, vk::SubpassContents::eSecondaryCommandBuffers);
+
+        if (!secondaries.empty()) {
+            pBuffer.executeCommands(secondaries.size(), secondaries.data());
+        }
+
+        pBuffer.endRenderPass();
+
+        profiler->end(pBuffer, region);
+
+        pBuffer.end();
+
+        return pBuffer;
+    }
+
+public:
+
+    VulkanControllerBase(const VulkanControllerBase & other) = delete;
+
+    virtual ~VulkanControllerBase() {
+        if (device) {
+            (*device)->waitIdle();
+        }
+
+        // the renderers are owned by the scene, and may outlive the controller
+        for (MaterialRenderer * renderer : renderers) {
+            renderer->setOwner(nullptr);
+            renderer->setProfiler(nullptr);
+        }
+
+        delete profiler;
+        delete images;
+
+        releasePasses();
+
+        delete camera;
+        delete framePools;
+        delete geometry;
+        delete queue;
+        delete cmdpool;
+        delete depthBuffer;
+        delete renderPass;
+        delete viewport;
+        delete device;
+        delete instance;
+    }
+
+    VulkanGPUProfiler * getProfiler(void) {
+        return profiler;
+    }
+
+    /**
+     * Controls whether every material's draw is timed separately. The whole
+     * render pass is always timed.
+     * @param enabled Whether to time the materials
+     */
+    void setMaterialProfiling(bool enabled) {
+        profileMaterials = enabled;
+
+        for (MaterialRenderer * renderer : renderers) {
+            renderer->setProfiler(enabled ? profiler : nullptr);
+        }
+    }
+
+    VulkanDevice * getDevice(void) {
+        return device;
+    }
+
+    VulkanViewport * getViewport(void) {
+        return viewport;
+    }
+
+    ImageManager * getImageManager(void) {
+        return images;
+    }
+
+    VulkanRenderPass * getRenderPass(void) {
+        return renderPass;
+    }
+
+    VulkanQueue * getQueue(void) {
+        return queue;
+    }
+
+    VulkanCommandBufferPool * getBufferPool(void) {
+        return cmdpool;
+    }
+
+    VulkanFrameCommandPools * getFramePools(void) {
+        return framePools;
+    }
+
+    VulkanGeometryStore * getGeometry(void) {
+        return geometry;
+    }
+
+    VulkanCamera * getCamera(void) {
+        return camera;
+    }
+
+    /**
+     * Creates a material which draws through this controller's camera. The
+     * camera's set is bound at set 1, before the prototype's extra sets.
+     * @param prototype The material's prototype
+     * @param globals Uniform buffers shared with other materials
+     * @return The material
+     */
+    virtual Material * createMaterial(MaterialPrototype & prototype, UBOMap * globals = nullptr) {
+        MaterialPrototype withCamera = prototype;
+
+        withCamera.extraSets.insert(withCamera.extraSets.begin(), camera->getSetLayout());
+
+        return new Material(*device, withCamera, *viewport, *renderPass, *queue, globals);
+    }
+
+    virtual MaterialRenderer * createRenderer(Material * material, VulkanIndexBuffer * indexbuffer = nullptr) override {
+        MaterialRenderer * renderer = new MaterialRenderer(frameTarget, renderPass, queue, framePools, camera, material, indexbuffer);
+
+        renderer->setOwner(this);
+
+        if (profileMaterials) {
+            renderer->setProfiler(profiler);
+        }
+
+        renderers.push_back(renderer);
+
+        return renderer;
+    }
+
+    virtual void releaseRenderer(MaterialRenderer * renderer) override {
+        renderers.erase(std::remove(renderers.begin(), renderers.end(), renderer), renderers.end());
+    }
+
+    /**
+     * Records a pass at the start of every frame, before the render pass
+     * @param pass The pass, which must outlive its registration
+     */
+    void addFramePass(VulkanFramePass * pass) {
+        framePasses.push_back(pass);
+    }
+
+    void removeFramePass(VulkanFramePass * pass) {
+        framePasses.erase(std::remove(framePasses.begin(), framePasses.end(), pass), framePasses.end());
+    }
+
+    /**
+     * Creates a gpu culling pass which draws into this controller's frames
+     * @param capacity The number of instance slots
+     * @return The pass, owned by the controller and already added
+     */
+    VulkanCullPass * createCullPass(uint32_t capacity) {
+        VulkanCullPass * pass = new VulkanCullPass(*device, framePools, frameTarget, renderPass, camera, capacity);
+
+        ownedPasses.emplace_back(pass);
+        addFramePass(pass);
+
+        return pass;
+    }
+
+    /**
+     * Creates a gpu particle system which draws into this controller's frames
+     * @param capacity The number of particles alive at once
+     * @return The system, owned by the controller and already added
+     */
+    VulkanParticleSystem * createParticleSystem(uint32_t capacity) {
+        VulkanParticleSystem * particles = new VulkanParticleSystem(*device, framePools, frameTarget, renderPass, camera, capacity);
+
+        ownedPasses.emplace_back(particles);
+        addFramePass(particles);
+
+        return particles;
+    }
+
+};
+
+#endif /* VULKANCONTROLLERBASE_HPP */
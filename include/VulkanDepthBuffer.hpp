@@ -12,13 +12,37 @@ private:
     vk::UniqueImageView depthView;
 
     vk::Format depthFormat;
+    vk::ImageTiling tiling;
+
+    uint32_t width = 0, height = 0;
 
 public:
 
     VulkanDepthBuffer(VulkanDevice & device, VulkanViewport & viewport, const vk::Format depthFormat = vk::Format::eD16Unorm);
 
+    /**
+     * Recreates the image at a new size. The old image is destroyed
+     * immediately, so nothing in flight may still be using it.
+     * @param device The device
+     * @param width The new width
+     * @param height The new height
+     */
+    void resize(VulkanDevice & device, uint32_t width, uint32_t height);
+
     const vk::Format getBufferFormat(void) const;
 
+    vk::ImageView getView(void) const {
+        return depthView.get();
+    }
+
+    uint32_t getWidth(void) const {
+        return width;
+    }
+
+    uint32_t getHeight(void) const {
+        return height;
+    }
+
 private:
 
     vk::ImageTiling getImageTiling(VulkanDevice & device, const vk::Format depthFormat);
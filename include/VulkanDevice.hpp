@@ -24,6 +24,11 @@ private:
     size_t graphicsQueueFamilyIndex = 0;
     size_t presentQueueFamilyIndex = 0;
 
+    // a headless device has no surface, and doesn't need to present
+    bool headless = false;
+
+    std::vector<const char*> enabledExtensions;
+
 public:
 
     VulkanDevice(VulkanInstance & instance, Window & wnd, vk::QueueFlagBits reqProperties = vk::QueueFlagBits::eGraphics) {
@@ -31,6 +36,20 @@ public:
         findPhysicalDevice(instance, reqProperties);
     }
 
+    /**
+     * Creates a device without a surface, for offscreen rendering
+     * @param instance The instance, which should also be headless
+     * @param reqProperties The required queue properties
+     */
+    VulkanDevice(VulkanInstance & instance, vk::QueueFlagBits reqProperties = vk::QueueFlagBits::eGraphics) :
+    headless(true) {
+        findPhysicalDevice(instance, reqProperties);
+    }
+
+    bool isHeadless(void) const {
+        return headless;
+    }
+
     vk::SurfaceKHR & getSurface(void) {
         return surface;
     }
@@ -43,7 +62,14 @@ public:
         return presentQueueFamilyIndex;
     }
 
+    /**
+     * @return The surface's format, or the offscreen format if headless
+     */
     vk::Format getSurfaceFormat(void) {
+        if (headless) {
+            return vk::Format::eR8G8B8A8Unorm;
+        }
+
         return findSurfaceFormat(*physical_device);
     }
 
@@ -63,10 +89,32 @@ public:
         return physical_device->getMemoryProperties();
     }
 
+    vk::PhysicalDeviceProperties getProperties(void) {
+        return physical_device->getProperties();
+    }
+
+    std::vector<vk::QueueFamilyProperties> getQueueFamilyProperties(void) {
+        return physical_device->getQueueFamilyProperties();
+    }
+
     bool supportsAnisotropy(void) {
         return physical_device->getFeatures().samplerAnisotropy;
     }
 
+    /**
+     * @param name The extension's name
+     * @return Whether the extension was enabled when the device was created
+     */
+    bool hasExtension(const char * name) const {
+        for (const char * extension : enabledExtensions) {
+            if (strcmp(extension, name) == 0) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
     vk::Device const* operator->(void) const {
         return &logical_device;
     }
@@ -181,8 +229,26 @@ private:
         float queuePriority = 0.0f;
         deviceQueueCreateInfo = vk::DeviceQueueCreateInfo(vk::DeviceQueueCreateFlags(), static_cast<uint32_t> (graphicsQueueFamilyIndex), 1, &queuePriority);
 
-        dCreateInfo.enabledExtensionCount = static_cast<uint32_t> (deviceExtensions.size());
-        dCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        // there's no swapchain without a surface
+        enabledExtensions.clear();
+
+        if (!headless) {
+            enabledExtensions = deviceExtensions;
+        }
+
+        std::vector<vk::ExtensionProperties> availExtensions = device.enumerateDeviceExtensionProperties();
+
+        for (const char * optional : optionalDeviceExtensions) {
+            for (const auto & aext : availExtensions) {
+                if (strcmp(optional, aext.extensionName) == 0) {
+                    enabledExtensions.push_back(optional);
+                    break;
+                }
+            }
+        }
+
+        dCreateInfo.enabledExtensionCount = static_cast<uint32_t> (enabledExtensions.size());
+        dCreateInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
         dCreateInfo.enabledLayerCount = static_cast<uint32_t> (validation.size());
         dCreateInfo.ppEnabledLayerNames = validation.data();
@@ -249,6 +315,11 @@ private:
             return false;
         }
 
+        if (headless) {
+            *presentIndex = *graphicsIndex;
+            return true;
+        }
+
         //size_t presentQueueFamilyIndex = properties.size();
 
         bool presentFound = false;
@@ -341,10 +412,18 @@ public:
         reload(wnd);
     }
 
+    VulkanViewport(uint32_t width, uint32_t height) {
+        resize(width, height);
+    }
+
     void reload(Window & wnd) {
+        resize(wnd.getWidth(), wnd.getHeight());
+    }
+
+    void resize(uint32_t width, uint32_t height) {
 
-        width = wnd.getWidth();
-        height = wnd.getHeight();
+        this->width = width;
+        this->height = height;
 
         view.x = 0;
         view.y = 0;
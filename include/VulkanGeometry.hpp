@@ -0,0 +1,155 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   VulkanGeometry.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 8:40 PM
+ */
+
+#ifndef VULKANGEOMETRY_HPP
+#define VULKANGEOMETRY_HPP
+
+#include "VulkanDevice.hpp"
+#include "VulkanBuffer.hpp"
+#include "VulkanVertex.hpp"
+#include "VulkanCommandBuffer.hpp"
+
+#include <memory>
+#include <vector>
+
+// Geometry which rarely changes, packed into one device local buffer. Ranges
+// are handed out as vertex and index buffers with an offset, so everything
+// drawn from the store binds the same buffer. The host keeps a copy, which is
+// only uploaded (through a staging buffer) when the store is marked for update.
+class VulkanGeometryStore {
+private:
+
+    // every range starts on this, which covers the index and attribute alignments
+    static constexpr vk::DeviceSize RANGE_ALIGNMENT = 16;
+
+    // resolves to the store's current buffer, since it's replaced when the store grows
+    class RangeHolder : public VulkanBufferHolder {
+    private:
+        VulkanGeometryStore * store;
+
+    public:
+
+        RangeHolder(VulkanGeometryStore * store) : VulkanBufferHolder(nullptr), store(store) {
+        }
+
+        virtual vk::Buffer getBuffer(void) override {
+            return store->getBuffer();
+        }
+
+        virtual vk::DeviceMemory getMemory(void) override {
+            return nullptr;
+        }
+    };
+
+    VulkanDevice & device;
+
+    std::vector<char> data;
+
+    vk::Buffer buffer;
+    vk::DeviceMemory memory;
+    vk::DeviceSize capacity = 0;
+
+    bool dirty = true;
+
+    std::vector<std::unique_ptr<VulkanBuffer>> ranges;
+
+public:
+
+    VulkanGeometryStore(VulkanDevice & device);
+
+    VulkanGeometryStore(const VulkanGeometryStore & other) = delete;
+
+    ~VulkanGeometryStore();
+
+    /**
+     * Adds vertices to the store. They're uploaded with the next upload.
+     * @param binding The vertex binding
+     * @param vertices The vertices
+     * @return A vertex buffer over the range, owned by the store
+     */
+    template<class T>
+    VulkanVertexBuffer<T> * addVertices(int binding, const std::vector<T> & vertices) {
+        vk::DeviceSize offset = reserve(vertices.data(), vertices.size() * sizeof (T));
+
+        VulkanVertexBuffer<T> * range = new VulkanVertexBuffer<T>(new RangeHolder(this), &device, offset,
+                binding, static_cast<int> (vertices.size()));
+
+        ranges.emplace_back(range);
+
+        return range;
+    }
+
+    /**
+     * Adds indices to the store. They're uploaded with the next upload.
+     * @param indices The indices
+     * @return An index buffer over the range, owned by the store
+     */
+    VulkanIndexBuffer * addIndices(const std::vector<uint16_t> & indices);
+
+    /**
+     * Overwrites part of a range's host copy. It isn't uploaded until the
+     * store is marked for update.
+     * @param range A range from this store
+     * @param src The new data
+     * @param bytes The number of bytes, at most the range's size
+     * @param offset Where to start in the range
+     */
+    void write(VulkanBuffer & range, const void * src, size_t bytes, size_t offset = 0);
+
+    /**
+     * Uploads the host copy, even if it hasn't changed. Nothing may be reading
+     * the buffer.
+     * @param pool A command buffer pool
+     * @param queue A valid queue
+     */
+    void upload(VulkanCommandBufferPool & pool, VulkanQueue & queue);
+
+    /**
+     * Uploads the host copy if the store was marked for update
+     * @param pool A command buffer pool
+     * @param queue A valid queue
+     * @return Whether anything was uploaded
+     */
+    bool uploadIfNeeded(VulkanCommandBufferPool & pool, VulkanQueue & queue) {
+        if (!dirty) {
+            return false;
+        }
+
+        upload(pool, queue);
+
+        return true;
+    }
+
+    void markNeedsUpdate(void) {
+        dirty = true;
+    }
+
+    bool needsUpdate(void) const {
+        return dirty;
+    }
+
+    vk::Buffer getBuffer(void) const {
+        return buffer;
+    }
+
+    vk::DeviceSize getSize(void) const {
+        return data.size();
+    }
+
+private:
+
+    vk::DeviceSize reserve(const void * src, size_t bytes);
+
+};
+
+#endif /* VULKANGEOMETRY_HPP */
@@ -0,0 +1,132 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   VulkanHeadless.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 6:25 PM
+ */
+
+#ifndef VULKANHEADLESS_HPP
+#define VULKANHEADLESS_HPP
+
+#include "VulkanControllerBase.hpp"
+#include "VulkanOffscreen.hpp"
+
+// A VulkanController without a window. Renders into an offscreen image, one
+// frame at a time, so it works on software implementations like lavapipe.
+class VulkanHeadlessController : public VulkanControllerBase {
+private:
+
+    VulkanOffscreenTarget * target;
+
+    vk::Fence render_fence;
+
+public:
+
+    VulkanHeadlessController(const char * appName, uint32_t width, uint32_t height) {
+        instance = new VulkanInstance(appName, true);
+
+        viewport = new VulkanViewport(width, height);
+
+        device = new VulkanDevice(*instance);
+
+        createDeviceObjects();
+
+        renderPass = new VulkanRenderPass(*device, *depthBuffer, device->getSurfaceFormat(), vk::ImageLayout::eTransferSrcOptimal);
+
+        target = new VulkanOffscreenTarget(*device, *renderPass, *viewport, *depthBuffer, device->getSurfaceFormat());
+
+        // only one frame is ever in flight, every frame is waited on before the next starts
+        createFrameObjects(target, 1);
+
+        render_fence = (*device)->createFence(vk::FenceCreateInfo());
+    }
+
+    VulkanHeadlessController(const VulkanHeadlessController& other) = delete;
+
+    virtual ~VulkanHeadlessController() {
+        (*device)->waitIdle();
+
+        (*device)->destroyFence(render_fence);
+
+        releasePasses();
+
+        delete target;
+    }
+
+    VulkanOffscreenTarget * getTarget(void) {
+        return target;
+    }
+
+    size_t getFrameIndex(void) {
+        return 0;
+    }
+
+    /**
+     * Starts a frame. There's nothing to acquire, so this always succeeds.
+     * @return true
+     */
+    bool startRender(void) {
+        PROFILE_SCOPE("VulkanHeadlessController::startRender");
+
+        profiler->newFrame();
+
+        // the last frame was waited on in submitSecondaries
+        framePools->beginFrame(0);
+
+        geometry->uploadIfNeeded(*cmdpool, *queue);
+
+        return true;
+    }
+
+    /**
+     * Renders a list of secondary buffers and waits for them to finish
+     * @param secondaries The list of secondary buffers
+     */
+    void submitSecondaries(std::vector<vk::CommandBuffer> & secondaries) {
+        PROFILE_SCOPE("VulkanHeadlessController::submitSecondaries");
+
+        vk::CommandBuffer pBuffer = recordFrame(secondaries, 0);
+
+        (*device)->resetFences({render_fence});
+
+        vk::SubmitInfo submitInfo;
+
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &pBuffer;
+
+        queue->graphicsSubmit(submitInfo, render_fence);
+
+        (*device)->waitForFences({render_fence}, true, std::numeric_limits<uint64_t>::max());
+    }
+
+    /**
+     * Copies the last rendered frame to the host
+     * @param pixels Filled with RGBA pixels, top row first
+     */
+    void readPixels(std::vector<uint8_t> & pixels) {
+        target->readPixels(*cmdpool, *queue, pixels);
+    }
+
+    /**
+     * Writes the last rendered frame to a png
+     * @param path The file to write
+     * @return Whether the file could be written
+     */
+    bool saveImage(const std::string & path) {
+        std::vector<uint8_t> pixels;
+
+        readPixels(pixels);
+
+        return ImageWriter::WritePNG(path, pixels.data(), static_cast<int> (target->getWidth()),
+                static_cast<int> (target->getHeight()));
+    }
+
+};
+
+#endif /* VULKANHEADLESS_HPP */
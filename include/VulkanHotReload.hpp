@@ -0,0 +1,169 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   VulkanHotReload.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 9:40 AM
+ */
+
+#ifndef VULKANHOTRELOAD_HPP
+#define VULKANHOTRELOAD_HPP
+
+#include "VulkanDevice.hpp"
+#include "VulkanCommandBuffer.hpp"
+#include "VulkanDescriptor.hpp"
+#include "VulkanImage.hpp"
+#include "FileWatcher.hpp"
+#include "ThreadPool.hpp"
+
+namespace Game {
+    class GameContext;
+    class UBOInstance;
+}
+
+#include <future>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+// Rebuilds what depends on a file when it changes, while the game runs. A
+// shader only rebuilds the pipelines of the materials which use it, an image
+// is only loaded again into its own textures, and a game file only rewrites
+// the buffers bound to the ubo instances whose values changed. Everything is
+// loaded and built on a worker thread, and swapped in between frames, once
+// the device is done with the old objects. Files which fail to load are
+// reported and skipped, the old objects stay until the file is fixed.
+class VulkanHotReload {
+private:
+
+    struct ShaderRebuild {
+        Material * material;
+        std::vector<std::unique_ptr<VulkanShader>> shaders;
+        std::unique_ptr<VulkanPipeline> pipeline;
+    };
+
+    struct TextureReload {
+        Texture * texture;
+        std::unique_ptr<Texture> replacement;
+    };
+
+    struct BufferRewrite {
+        std::string instance;
+        std::vector<uint8_t> values;
+    };
+
+    // everything a worker needs, copied so it never touches this
+    struct Request {
+        // the viewport is dynamic state, its size only has to be valid
+        uint32_t width, height;
+        std::vector<Material*> materials;
+        std::vector<ImageManager::Entry> images;
+
+        // only set when a game file changed, nothing else touches it until the batch is applied
+        Game::GameContext * context = nullptr;
+        std::map<std::string, std::vector<uint8_t>> values;
+    };
+
+    struct Batch {
+        std::vector<ShaderRebuild> shaders;
+        std::vector<TextureReload> textures;
+        std::vector<BufferRewrite> buffers;
+
+        // every game file after the reload, which can reference new files
+        std::vector<std::string> gameFiles;
+    };
+
+    VulkanDevice & device;
+    VulkanViewport & viewport;
+    VulkanRenderPass & renderPass;
+    ImageManager & images;
+
+    FileWatcher watcher;
+
+    // one worker, so batches are built in order
+    ThreadPool pool;
+
+    std::vector<Material*> materials;
+
+    // the number of images already watched, new ones are watched as they're loaded
+    size_t watchedImages = 0;
+
+    std::unique_ptr<Game::GameContext> context;
+
+    // the files the context was read from, as generic paths
+    std::set<std::string> gameFiles;
+
+    // the buffers bound to each ubo instance, and every instance's current values
+    std::map<std::string, std::vector<VulkanUniformBuffer*>> buffers;
+    std::map<std::string, std::vector<uint8_t>> values;
+
+    // files which changed while a batch was being built
+    std::set<std::string> changed;
+
+    std::future<Batch> building;
+
+    static Batch Build(VulkanDevice & device, VulkanRenderPass & renderPass, Request request);
+
+    /**
+     * @return The instance's values, laid out as its buffer
+     */
+    static std::vector<uint8_t> ReadValues(const Game::UBOInstance & instance);
+
+    /**
+     * Writes an instance's current values into the buffers bound to it
+     */
+    void write(const std::string & instance);
+
+public:
+
+    VulkanHotReload(VulkanDevice & device, VulkanViewport & viewport, VulkanRenderPass & renderPass, ImageManager & images);
+
+    VulkanHotReload(const VulkanHotReload & other) = delete;
+
+    ~VulkanHotReload();
+
+    /**
+     * Rebuilds a material's pipeline when one of its shaders changes
+     * @param material The material, which must outlive this
+     */
+    void addMaterial(Material * material);
+
+    /**
+     * Reads a game file and the files it references, and watches them. Only
+     * the changed files are parsed again when they change.
+     * @param file The game file with the ubo instances to bind
+     */
+    void setGameFiles(const std::string & file);
+
+    /**
+     * Keeps a buffer's values the same as a ubo instance's in the game files.
+     * The values are written now, and whenever the instance changes.
+     * @param instance The ubo instance's name
+     * @param buffer The buffer, which must outlive this
+     */
+    void bindUBO(const std::string & instance, VulkanUniformBuffer * buffer);
+
+    /**
+     * Starts rebuilding anything whose files changed. Called once a frame,
+     * before the frame is recorded.
+     * @return Whether a rebuild is ready to be swapped in
+     */
+    bool poll(void);
+
+    /**
+     * Swaps in the rebuild. The device must not be using any frame's objects.
+     * @param pool The pool for uploading textures
+     * @param queue The queue for uploading textures
+     */
+    void apply(VulkanCommandBufferPool & pool, VulkanQueue & queue);
+
+};
+
+#endif /* VULKANHOTRELOAD_HPP */
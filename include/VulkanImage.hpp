@@ -19,6 +19,7 @@
 #include "VulkanDescriptor.hpp"
 #include "VulkanBuffer.hpp"
 #include "VulkanRenderPipeline.hpp"
+#include "Profiler.hpp"
 
 #define STB_TRUETYPE_IMPLEMENTATION
 #define STBTT_STATIC
@@ -26,8 +27,50 @@
 
 #include <string>
 #include <fstream>
+#include <sstream>
 #include <vector>
 
+// Describes a chroma key which is baked into a texture's alpha when it is loaded.
+// Pixels within epsilon1 of the search colour become fully transparent, pixels
+// further than epsilon2 are untouched, and the range in between is blended.
+struct ChromaKey {
+    glm::vec4 search, replace;
+    float epsilon1, epsilon2;
+
+    ChromaKey(glm::vec4 search, float epsilon1 = 0.25f, float epsilon2 = 0.75f,
+            glm::vec4 replace = glm::vec4(0)) :
+    search(search), replace(replace), epsilon1(epsilon1), epsilon2(epsilon2) {
+
+    }
+
+    /**
+     * Creates a string which uniquely identifies this key, for caching
+     * @return The key's id
+     */
+    std::string id() const {
+        std::stringstream ss;
+        ss << search.r << ',' << search.g << ',' << search.b << ',' << search.a << ';'
+                << replace.r << ',' << replace.g << ',' << replace.b << ',' << replace.a << ';'
+                << epsilon1 << ',' << epsilon2;
+        return ss.str();
+    }
+};
+
+// Writes host pixels to image files
+class ImageWriter {
+public:
+
+    /**
+     * @param path The file to write
+     * @param pixels The pixels, tightly packed, top row first
+     * @param width The width
+     * @param height The height
+     * @param channels The number of bytes per pixel
+     * @return Whether the file could be written
+     */
+    static bool WritePNG(const std::string & path, const uint8_t * pixels, int width, int height, int channels = 4);
+};
+
 // Controls a Vulkan image and loads it from a file or buffer
 class Texture {
 private:
@@ -46,7 +89,13 @@ private:
 
 public:
 
-    Texture(VulkanDevice & device, std::string path);
+    /**
+     * Loads a texture from an image file
+     * @param device The device
+     * @param path The image file
+     * @param key The chroma key to bake into the alpha channel, or null for none
+     */
+    Texture(VulkanDevice & device, std::string path, const ChromaKey * key = nullptr);
 
     Texture(VulkanDevice & device, unsigned char * buffer, int width, int height, int channels);
 
@@ -78,9 +127,30 @@ public:
         return height;
     }
 
+    const std::string & getPath(void) const {
+        return path;
+    }
+
+    /**
+     * Trades images with another texture of the same device, so everything
+     * pointing at this texture gets the other's image. Descriptors written with
+     * the old view have to be written again.
+     * @param other The other texture
+     */
+    void swap(Texture & other);
+
 private:
 
-    void loadImageData(std::string path);
+    void loadImageData(std::string path, const ChromaKey * key);
+
+    /**
+     * Applies a chroma key to an RGBA image. Uses the same math as the old
+     * chromakey.frag, so keyed sprites look the same as before.
+     * @param pixels The RGBA pixels
+     * @param count The number of pixels
+     * @param key The chroma key
+     */
+    static void applyChromaKey(unsigned char * pixels, size_t count, const ChromaKey & key);
 
     void loadImageData(unsigned char * buffer, int width, int height);
 
@@ -128,8 +198,18 @@ protected:
 
 // Loads textures and configures them to the current hardware
 class ImageManager {
+public:
+
+    // A loaded texture, and what it was loaded with
+    struct Entry {
+        Texture * texture;
+        std::string path;
+        // null if the texture wasn't keyed
+        std::shared_ptr<const ChromaKey> key;
+    };
+
 private:
-    std::map<std::string, Texture*> images;
+    std::map<std::string, Entry> images;
 
     VulkanDevice * device;
     VulkanCommandBufferPool * pool;
@@ -141,12 +221,23 @@ public:
     device(device), pool(pool), queue(queue) {
     }
 
-    Texture const * getImage(std::string path) {
+    /**
+     * Gets a texture, loading it if it hasn't been loaded yet. The same image
+     * loaded with different chroma keys are cached separately.
+     * @param path The image file
+     * @param key The chroma key to bake into the texture, or null for none
+     * @return The texture
+     */
+    Texture const * getImage(std::string path, const ChromaKey * key = nullptr) {
+        std::string name = key ? path + "#" + key->id() : path;
+
         try {
-            return images.at(path);
+            return images.at(name).texture;
         } catch (std::out_of_range oor) {
-            Texture * image = new Texture(*device, path);
-            images[path] = image;
+            PROFILE_SCOPE_DYNAMIC("load " + name);
+
+            Texture * image = new Texture(*device, path, key);
+            images[name] = Entry{image, path, key ? std::make_shared<ChromaKey>(*key) : nullptr};
 
             image->configureLayouts(*pool, *queue);
 
@@ -154,6 +245,23 @@ public:
         }
     }
 
+    size_t size(void) const {
+        return images.size();
+    }
+
+    /**
+     * @return Every texture loaded from a file
+     */
+    std::vector<Entry> getEntries(void) const {
+        std::vector<Entry> entries;
+
+        for (auto & image : images) {
+            entries.push_back(image.second);
+        }
+
+        return entries;
+    }
+
 };
 
 // Describes a texture sampler
@@ -239,6 +347,15 @@ struct MaterialPrototype {
     std::vector<struct VertexDescriptorInfo> vertexDescriptors;
     std::vector<struct ShaderPrototype> shaders;
     std::vector<struct PushConstantPrototype> pushConstants;
+
+    // layouts of sets bound after the material's own, which the material doesn't manage
+    std::vector<vk::DescriptorSetLayout> extraSets;
+
+    // used to label the material in profiles
+    std::string name;
+
+    // blended materials are drawn back to front after the opaque ones, and don't write depth
+    bool transparent = false;
 };
 
 // A uniform buffer map
@@ -261,6 +378,11 @@ private:
         VulkanUpdateManager updater;
 
         UBOMap * gbuffers = nullptr;
+
+        std::vector<vk::DescriptorSetLayout> extraSets;
+
+        std::string name;
+        bool transparent = false;
     };
 
     std::shared_ptr<struct MaterialInfo> info;
@@ -281,6 +403,9 @@ public:
 
         info->vertexDescriptors = prototype.vertexDescriptors;
         info->gbuffers = globals;
+        info->extraSets = prototype.extraSets;
+        info->name = prototype.name;
+        info->transparent = prototype.transparent;
 
         createDescriptorSet(owner);
         createPipeline(owner, viewport, renderPass, queue);
@@ -314,10 +439,33 @@ public:
         return buffers;
     }
 
+    /**
+     * Gets the vertex buffers and their offsets, in binding order
+     * @param buffers Filled with the buffers
+     * @param offsets Filled with the offsets into the buffers
+     */
+    void getVertexBindings(std::vector<vk::Buffer> & buffers, std::vector<vk::DeviceSize> & offsets) {
+        buffers.clear();
+        offsets.clear();
+
+        for (auto & v : info->vertexDescriptors) {
+            buffers.push_back(v.buffer->getBuffer());
+            offsets.push_back(v.buffer->getOffset());
+        }
+    }
+
     const vk::DescriptorSet & getDescriptorSet(void) const {
         return info->descriptorManager->getSet();
     }
 
+    const std::string & getName(void) const {
+        return info->name;
+    }
+
+    bool isTransparent(void) const {
+        return info->transparent;
+    }
+
     VulkanPipeline * getPipeline(void) {
         return info->pipeline.get();
     }
@@ -343,6 +491,106 @@ public:
         }
     }
 
+    /**
+     * @return The files the material's shaders were loaded from
+     */
+    std::vector<std::string> getShaderPaths(void) const {
+        std::vector<std::string> paths;
+
+        for (auto & shader : info->shaders) {
+            if (!shader->getPath().empty()) {
+                paths.push_back(shader->getPath());
+            }
+        }
+
+        return paths;
+    }
+
+    /**
+     * @param path A shader file
+     * @return Whether the material's pipeline was built with the shader
+     */
+    bool usesShader(const std::string & path) const {
+        for (auto & shader : info->shaders) {
+            if (shader->getPath() == path) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * Loads every shader the material uses from its file again. Only reads
+     * the material, so it can be called from another thread.
+     * @param owner The device
+     * @return The shaders, in the material's order
+     */
+    std::vector<std::unique_ptr<VulkanShader>> loadShaders(VulkanDevice & owner) const {
+        std::vector<std::unique_ptr<VulkanShader>> shaders;
+
+        for (auto & shader : info->shaders) {
+            if (shader->getPath().empty()) {
+                throw std::runtime_error("Material " + info->name + " has a shader which wasn't loaded from a file");
+            }
+
+            shaders.emplace_back(new VulkanShader(owner, shader->getPath(), shader->getStage()));
+        }
+
+        return shaders;
+    }
+
+    /**
+     * Builds a pipeline like the material's with other shaders. Only reads
+     * the material, so it can be called from another thread.
+     * @param shaders The shaders, which replace the material's
+     * @return The pipeline
+     */
+    VulkanPipeline * buildPipeline(VulkanDevice & owner, VulkanViewport & viewport,
+            VulkanRenderPass & renderPass, std::vector<std::unique_ptr<VulkanShader>> & shaders) const {
+        std::vector<vk::DescriptorSetLayout> sets{ info->descriptorManager->getLayout()};
+
+        sets.insert(sets.end(), info->extraSets.begin(), info->extraSets.end());
+
+        VulkanVertexInputState vertexInput;
+
+        for (auto & vertDescriptor : info->vertexDescriptors) {
+            vertexInput.addDescriptor(vertDescriptor.desc);
+        }
+
+        std::vector<vk::PushConstantRange> ranges;
+
+        for (auto & pc : info->pushConstants) {
+            ranges.push_back(vk::PushConstantRange(pc.second.stages, pc.second.offset, pc.second.size));
+        }
+
+        return VulkanPipelineFactory::create(owner, viewport, renderPass,
+                sets, vertexInput, shaders, ranges, info->transparent);
+    }
+
+    /**
+     * Swaps in shaders and the pipeline built with them. The device must
+     * not be using the old pipeline anymore.
+     * @param shaders The shaders
+     * @param pipeline The pipeline, from buildPipeline
+     */
+    void replacePipeline(std::vector<std::unique_ptr<VulkanShader>> && shaders, std::unique_ptr<VulkanPipeline> && pipeline) {
+        info->pipeline = std::move(pipeline);
+        info->shaders = std::move(shaders);
+    }
+
+    /**
+     * Writes the samplers which show a texture again, after its image changed
+     * @param texture The texture
+     */
+    void textureChanged(Texture const * texture) {
+        for (auto & sampler : info->samplers) {
+            if (sampler.second->getTexture() == texture) {
+                sampler.second->setTexture(texture);
+            }
+        }
+    }
+
     static UBOMap createubos(VulkanDevice & owner,
             std::vector<struct UniformBufferPrototype> && prototypes) {
         return createubos(owner, prototypes);
@@ -421,23 +669,8 @@ private:
 
     void createPipeline(VulkanDevice & owner, VulkanViewport & viewport,
             VulkanRenderPass & renderPass, VulkanQueue & queue) {
-        std::vector<vk::DescriptorSetLayout> sets{ info->descriptorManager->getLayout()};
-
-        VulkanVertexInputState vertexInput;
-
-        for (auto & vertDescriptor : info->vertexDescriptors) {
-            vertexInput.addDescriptor(vertDescriptor.desc);
-        }
-
-        std::vector<vk::PushConstantRange> ranges;
-
-        for (auto & pc : info->pushConstants) {
-            ranges.push_back(vk::PushConstantRange(pc.second.stages, pc.second.offset, pc.second.size));
-        }
-
         info->pipeline = std::move(std::unique_ptr<VulkanPipeline>(
-                VulkanPipelineFactory::create(owner, viewport, renderPass,
-                sets, vertexInput, info->shaders, ranges)));
+                buildPipeline(owner, viewport, renderPass, info->shaders)));
     }
 
 };
@@ -524,36 +757,52 @@ public:
 
 };
 
-// Controls a font file and renders text to a byte buffer
+// Controls a pixel font file and finds where its characters are
 class Font {
-private:
-    int width = 0, height = 0, channels = 0;
-
-    unsigned char * pixels;
+public:
 
     struct Character {
         int c, xoffset, width;
     };
 
+private:
+    int width = 0, height = 0, channels = 0;
+
+    unsigned char * pixels;
+
     std::vector<struct Character> characters;
 
 public:
 
     Font(const char * filename, bool alpha = false) {
+        PROFILE_SCOPE_DYNAMIC(std::string("load ") + filename);
+
         loadFontData(filename, alpha);
     }
 
+    Font(const Font & other) = delete;
+
     ~Font();
 
-    /**
-     * Renders text to a shared byte buffer
-     * @param text The text to render
-     * @param _width The image's width
-     * @param _height The image's height
-     * @param _channels The number of channels in the output image
-     * @return The byte buffer
-     */
-    std::shared_ptr<unsigned char> RenderImage(char const * text, int * _width, int * _height, int * _channels);
+    int getWidth() const {
+        return width;
+    }
+
+    int getHeight() const {
+        return height;
+    }
+
+    int getChannels() const {
+        return channels;
+    }
+
+    unsigned char * getPixels() const {
+        return pixels;
+    }
+
+    const std::vector<struct Character> & getCharacters() const {
+        return characters;
+    }
 
 private:
 
@@ -569,76 +818,4 @@ private:
 
 };
 
-// Controls a TextureSampler so it renders the provided text
-class TextImage {
-private:
-
-    Font * font;
-    char const * text = nullptr;
-
-    Texture * texture = nullptr;
-    TextureSampler * sampler;
-
-    int width, height, channels;
-
-    VulkanCommandBufferPool & pool;
-    VulkanQueue & queue;
-    VulkanDevice & device;
-
-    std::shared_ptr<unsigned char> image;
-
-public:
-
-    TextImage(VulkanDevice & device, TextureSampler * sampler, Font * font,
-            VulkanCommandBufferPool & pool, VulkanQueue & queue, char const * text = nullptr) :
-    font(font), sampler(sampler), pool(pool), queue(queue), device(device) {
-        if (text) {
-            setText(text);
-        }
-    }
-
-    void setText(const std::string & text) {
-        setText(text.c_str());
-    }
-
-    /**
-     * Releases the previous texture and renders a new texture for the text.
-     * VERY HEAVY OPERATION. Do not call every frame.
-     * @param text The text to show
-     */
-    void setText(char const * text) {
-        this->text = text;
-        if (text == nullptr) {
-            throw std::runtime_error("Text cannot be null");
-        }
-
-        if (texture) {
-            delete texture;
-        }
-
-        image = std::move(font->RenderImage(text, &width, &height, &channels));
-
-        texture = new Texture(device, image.get(), width, height, channels);
-
-        texture->configureLayouts(pool, queue);
-
-        if (sampler) {
-            sampler->setTexture(texture);
-        }
-    }
-
-    Texture const * getTexture() {
-        return texture;
-    }
-
-    int getWidth() {
-        return width;
-    }
-
-    int getHeight() {
-        return height;
-    }
-
-};
-
 #endif /* VULKANIMAGE_HPP */
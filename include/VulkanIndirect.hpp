@@ -0,0 +1,319 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   VulkanIndirect.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 9:30 PM
+ */
+
+#ifndef VULKANINDIRECT_HPP
+#define VULKANINDIRECT_HPP
+
+#include "VulkanDevice.hpp"
+#include "VulkanRenderPass.hpp"
+#include "VulkanRenderPipeline.hpp"
+#include "VulkanCommandBuffer.hpp"
+#include "VulkanRenderer.hpp"
+#include "VulkanImage.hpp"
+#include "VulkanCamera.hpp"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <vector>
+
+/**
+ * One instance as the shaders see it (std430)
+ */
+struct IndirectInstance {
+    glm::vec2 position;
+    glm::vec2 size;
+    float rotation;
+    float depth;
+    uint32_t batch;
+    uint32_t active;
+};
+
+/**
+ * A VkDrawIndexedIndirectCommand, followed by where the batch's visible list
+ * starts. The draw's stride skips the extra words.
+ */
+struct IndirectCommand {
+    uint32_t indexCount;
+    uint32_t instanceCount;
+    uint32_t firstIndex;
+    int32_t vertexOffset;
+    uint32_t firstInstance;
+
+    uint32_t first;
+    uint32_t padding[2];
+};
+
+/**
+ * The push constant instanced.vert reads, at offset 0
+ */
+struct IndirectPushConstant {
+    uint32_t first;
+};
+
+class VulkanCullPass;
+
+// Instances of one mesh and material, drawn with a single indirect draw. The
+// batch owns a fixed range of the pass' instance slots.
+class VulkanIndirectBatch {
+private:
+
+    VulkanCullPass * pass;
+
+    Material * material;
+    VulkanIndexBuffer * indexBuffer;
+
+    uint32_t id, first, capacity;
+
+    std::vector<uint32_t> freeSlots;
+
+    int order;
+
+    vk::CommandBuffer current;
+
+    std::vector<vk::Buffer> vBuffers;
+    std::vector<vk::DeviceSize> vOffsets;
+
+public:
+
+    VulkanIndirectBatch(VulkanCullPass * pass, Material * material, VulkanIndexBuffer * indexBuffer,
+            uint32_t id, uint32_t first, uint32_t capacity, int order);
+
+    VulkanIndirectBatch(const VulkanIndirectBatch & other) = delete;
+
+    /**
+     * Takes a free slot. It's inactive until it's written.
+     * @return The slot, which indexes the pass' instances
+     */
+    uint32_t acquire(void);
+
+    /**
+     * Gives a slot back and stops drawing it
+     * @param slot The slot
+     */
+    void release(uint32_t slot);
+
+    /**
+     * @param slot A slot from this batch
+     * @return The slot's instance
+     */
+    struct IndirectInstance & getInstance(uint32_t slot);
+
+    /**
+     * @return The number of slots in use
+     */
+    uint32_t count(void) const {
+        return capacity - static_cast<uint32_t> (freeSlots.size());
+    }
+
+    uint32_t getId(void) const {
+        return id;
+    }
+
+    uint32_t getFirst(void) const {
+        return first;
+    }
+
+    uint32_t getCapacity(void) const {
+        return capacity;
+    }
+
+    VulkanIndexBuffer * getIndexBuffer(void) {
+        return indexBuffer;
+    }
+
+    int getOrder(void) const {
+        return order;
+    }
+
+    bool isTransparent(void) const {
+        return material->isTransparent();
+    }
+
+    /**
+     * Records the batch's draw into a buffer from the current frame's pool
+     * @param frame The framebuffer to draw into
+     */
+    void recordFrame(size_t frame);
+
+    /**
+     * @return The buffer last recorded
+     */
+    vk::CommandBuffer getBuffer(void) {
+        return current;
+    }
+
+};
+
+// Culls instances on the gpu and draws the visible ones with one indirect
+// draw per batch. Every instance lives in a storage buffer, so recording a
+// frame costs the same however many instances there are. The compute pass
+// runs in the frame's primary buffer, before the render pass.
+class VulkanCullPass : public VulkanFramePass {
+private:
+
+    static constexpr uint32_t WORKGROUP_SIZE = 64;
+
+    // commands are reset with vkCmdUpdateBuffer, which is limited to 64KB
+    static constexpr uint32_t MAX_BATCHES = 65536 / sizeof (IndirectCommand);
+
+    struct FrameResources {
+        vk::Buffer instances, visible, commands, counts;
+        vk::DeviceMemory instanceMemory, visibleMemory, commandMemory, countMemory;
+
+        void * mapped;
+
+        vk::DescriptorSet set;
+    };
+
+    VulkanDevice & device;
+    VulkanFrameCommandPools * pools;
+    VulkanFramebufferSource * target;
+    VulkanRenderPass * renderPass;
+    VulkanCamera * camera;
+
+    uint32_t capacity, used = 0;
+
+    std::vector<struct IndirectInstance> instances;
+    std::vector<struct IndirectCommand> commands;
+    std::vector<std::unique_ptr<VulkanIndirectBatch>> batches;
+
+    std::vector<struct FrameResources> frames;
+
+    vk::DescriptorSetLayout layout;
+    vk::DescriptorPool descriptorPool;
+
+    std::unique_ptr<VulkanShader> shader;
+    std::unique_ptr<VulkanPipeline> pipeline;
+
+    // null unless VK_KHR_draw_indirect_count is enabled
+    PFN_vkCmdDrawIndexedIndirectCountKHR drawIndexedIndirectCount = nullptr;
+
+public:
+
+    /**
+     * @param device The device
+     * @param pools The frame pools, the pass keeps one copy of its buffers per frame
+     * @param target The framebuffers the batches draw into
+     * @param renderPass The render pass
+     * @param camera The camera, instances outside of every view are culled
+     * @param capacity The number of instance slots, shared by every batch
+     * @param cullShader The compiled cull.comp
+     */
+    VulkanCullPass(VulkanDevice & device, VulkanFrameCommandPools * pools, VulkanFramebufferSource * target,
+            VulkanRenderPass * renderPass, VulkanCamera * camera, uint32_t capacity,
+            const std::string & cullShader = "shader/cull.comp.spv");
+
+    VulkanCullPass(const VulkanCullPass & other) = delete;
+
+    ~VulkanCullPass();
+
+    /**
+     * Adds the instance set, push constant and vertex shader a batch's
+     * material needs. The instance set is bound after the camera's, at set 2. The prototype should have a fragment shader and the
+     * usual vertex descriptors.
+     * @param prototype The material's prototype
+     * @param vertexShader The compiled instanced.vert
+     */
+    void prepareMaterial(MaterialPrototype & prototype, const std::string & vertexShader = "shader/instanced.vert.spv");
+
+    /**
+     * Creates a batch
+     * @param material A material from a prepared prototype
+     * @param indexBuffer The mesh's indices
+     * @param capacity The most instances the batch holds
+     * @param order Where the batch sorts against other draws
+     * @return The batch, owned by the pass
+     */
+    VulkanIndirectBatch * addBatch(Material * material, VulkanIndexBuffer * indexBuffer, uint32_t capacity, int order = 0);
+
+    /**
+     * @param slot A slot from one of the batches
+     * @return The slot's instance, which is uploaded with the next frame
+     */
+    struct IndirectInstance & getInstance(uint32_t slot) {
+        return instances[slot];
+    }
+
+    vk::DescriptorSetLayout getSetLayout(void) {
+        return layout;
+    }
+
+    /**
+     * @return The instance set of the current frame
+     */
+    vk::DescriptorSet getSet(void) {
+        return frames[pools->getCurrentFrame()].set;
+    }
+
+    /**
+     * @param batch A batch
+     * @return The batch's command's offset into the current frame's command buffer
+     */
+    vk::DeviceSize getCommandOffset(VulkanIndirectBatch & batch) const {
+        return batch.getId() * sizeof (struct IndirectCommand);
+    }
+
+    vk::Buffer getCommandBuffer(void) {
+        return frames[pools->getCurrentFrame()].commands;
+    }
+
+    vk::Buffer getCountBuffer(void) {
+        return frames[pools->getCurrentFrame()].counts;
+    }
+
+    PFN_vkCmdDrawIndexedIndirectCountKHR getDrawCountFunction(void) {
+        return drawIndexedIndirectCount;
+    }
+
+    VulkanFrameCommandPools * getPools(void) {
+        return pools;
+    }
+
+    VulkanFramebufferSource * getTarget(void) {
+        return target;
+    }
+
+    VulkanRenderPass * getRenderPass(void) {
+        return renderPass;
+    }
+
+    VulkanCamera * getCamera(void) {
+        return camera;
+    }
+
+    const std::vector<std::unique_ptr<VulkanIndirectBatch>> & getBatches(void) {
+        return batches;
+    }
+
+    /**
+     * Uploads the instances, resets the commands and culls
+     * @param buffer The frame's primary buffer, outside of the render pass
+     */
+    virtual void recordPrePass(vk::CommandBuffer buffer) override;
+
+    /**
+     * Records every batch which has instances
+     * @param frame The framebuffer to draw into
+     */
+    void record(size_t frame);
+
+private:
+
+    void createFrame(struct FrameResources & frame);
+
+    void destroyFrame(struct FrameResources & frame);
+
+};
+
+#endif /* VULKANINDIRECT_HPP */
@@ -23,6 +23,11 @@ const std::vector<const char*> deviceExtensions = {
     VK_KHR_SWAPCHAIN_EXTENSION_NAME
 };
 
+// enabled when the device has them, callers check VulkanDevice::hasExtension
+const std::vector<const char*> optionalDeviceExtensions = {
+    "VK_KHR_draw_indirect_count"
+};
+
 // Controls vulkan's validation layers
 class VulkanValidation {
 private:
@@ -97,12 +102,16 @@ private:
 
     bool requestValidationLayers = true;
 
+    // a headless instance doesn't ask glfw for the surface extensions
+    bool headless;
+
     VulkanValidation enabledLayers;
 
 public:
 
-    VulkanInstance(const char * appName) {
+    VulkanInstance(const char * appName, bool headless = false) {
         this->appName = appName;
+        this->headless = headless;
 
         createInstance();
 
@@ -200,6 +209,10 @@ private:
     }
 
     std::vector<const char*> getRequiredExtensions() {
+        if (headless) {
+            return std::vector<const char*>();
+        }
+
         uint32_t glfwExtensionCount = 0;
         const char** glfwExtensions;
         glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
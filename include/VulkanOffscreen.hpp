@@ -0,0 +1,95 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   VulkanOffscreen.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 6:10 PM
+ */
+
+#ifndef VULKANOFFSCREEN_HPP
+#define VULKANOFFSCREEN_HPP
+
+#include "VulkanDevice.hpp"
+#include "VulkanDepthBuffer.hpp"
+#include "VulkanRenderPass.hpp"
+#include "VulkanCommandBuffer.hpp"
+
+#include <vector>
+
+// A color image to render into instead of the swapchain, which can be read
+// back to the host. Uses the depth buffer too, if the render pass has one.
+class VulkanOffscreenTarget : public VulkanFramebufferSource {
+private:
+
+    VulkanDevice & device;
+
+    vk::Format format;
+    uint32_t width, height;
+
+    vk::UniqueImage image;
+    vk::UniqueDeviceMemory memory;
+    vk::UniqueImageView view;
+
+    vk::UniqueFramebuffer framebuffer;
+
+    // host visible copy of the image, created the first time it's read
+    vk::Buffer readback;
+    vk::DeviceMemory readbackMemory;
+
+public:
+
+    /**
+     * @param device The device
+     * @param renderPass The render pass, which must output in the transfer source layout
+     * @param viewport The viewport, which sets the size
+     * @param depthBuffer The depth buffer, the same size as the viewport
+     * @param format The color format
+     */
+    VulkanOffscreenTarget(VulkanDevice & device, VulkanRenderPass & renderPass, VulkanViewport & viewport,
+            VulkanDepthBuffer & depthBuffer, vk::Format format = vk::Format::eR8G8B8A8Unorm);
+
+    VulkanOffscreenTarget(const VulkanOffscreenTarget & other) = delete;
+
+    ~VulkanOffscreenTarget();
+
+    virtual vk::Framebuffer getFrame(size_t i) override {
+        return framebuffer.get();
+    }
+
+    virtual size_t frameCount() override {
+        return 1;
+    }
+
+    vk::Image getImage(void) {
+        return image.get();
+    }
+
+    vk::Format getFormat(void) const {
+        return format;
+    }
+
+    uint32_t getWidth(void) const {
+        return width;
+    }
+
+    uint32_t getHeight(void) const {
+        return height;
+    }
+
+    /**
+     * Copies the last rendered frame to the host. Nothing may be rendering to
+     * the target.
+     * @param pool A command buffer pool
+     * @param queue A valid queue
+     * @param pixels Filled with tightly packed pixels, top row first
+     */
+    void readPixels(VulkanCommandBufferPool & pool, VulkanQueue & queue, std::vector<uint8_t> & pixels);
+
+};
+
+#endif /* VULKANOFFSCREEN_HPP */
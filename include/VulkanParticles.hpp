@@ -0,0 +1,263 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   VulkanParticles.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 10:45 PM
+ */
+
+#ifndef VULKANPARTICLES_HPP
+#define VULKANPARTICLES_HPP
+
+#include "VulkanDevice.hpp"
+#include "VulkanRenderPass.hpp"
+#include "VulkanRenderPipeline.hpp"
+#include "VulkanCommandBuffer.hpp"
+#include "VulkanRenderer.hpp"
+#include "VulkanImage.hpp"
+#include "VulkanCamera.hpp"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <vector>
+
+/**
+ * What gameplay pushes to spawn particles. Also how the shaders see it (std430).
+ */
+struct ParticleEmitter {
+    // where the particles start, in world space
+    glm::vec2 position = {0, 0};
+
+    // every particle's base velocity
+    glm::vec2 velocity = {0, 0};
+
+    glm::vec4 color = {1, 1, 1, 1};
+
+    // what the colour fades to by the end of the particle's life
+    glm::vec4 endColor = {1, 1, 1, 0};
+
+    // the most speed added in a random direction
+    float speed = 0;
+
+    // the angle the random direction is picked from, around the base velocity.
+    // A full circle makes a burst.
+    float spread = 6.2831853f;
+
+    // in seconds
+    float life = 1;
+
+    float size = 0.02f, endSize = 0;
+
+    // the fraction of velocity lost every second
+    float drag = 0;
+
+    uint32_t count = 0;
+
+    // set by the particle system, where the emitter's particles start in the frame's spawn
+    uint32_t first = 0;
+};
+
+/**
+ * One particle as the shaders see it (std430)
+ */
+struct Particle {
+    glm::vec2 position;
+    glm::vec2 velocity;
+    glm::vec4 color;
+    glm::vec4 endColor;
+    float age;
+    float life;
+    float size;
+    float endSize;
+    float drag;
+    float padding[3];
+};
+
+/**
+ * The push constant particle.vert reads, at offset 0
+ */
+struct ParticlePushConstant {
+    float depth;
+};
+
+// Particles which live entirely on the gpu. Emitters spawn into a ring of
+// particles in a storage buffer, which a compute pass integrates and culls
+// every frame. The survivors are drawn with one instanced indirect draw, so
+// the cpu only ever sees emitters. The compute pass runs in the frame's
+// primary buffer, before the render pass.
+class VulkanParticleSystem : public VulkanFramePass {
+private:
+
+    static constexpr uint32_t WORKGROUP_SIZE = 64;
+
+    // emitters past this are dropped until the next frame
+    static constexpr uint32_t MAX_EMITTERS = 256;
+
+    // the emitters are per frame, since the host writes them while older frames are in flight
+    struct FrameResources {
+        vk::Buffer emitters;
+        vk::DeviceMemory emitterMemory;
+
+        void * mapped;
+
+        vk::DescriptorSet set;
+    };
+
+    VulkanDevice & device;
+    VulkanFrameCommandPools * pools;
+    VulkanFramebufferSource * target;
+    VulkanRenderPass * renderPass;
+    VulkanCamera * camera;
+
+    uint32_t capacity, head = 0;
+
+    // the simulation carries over between frames, so there's one copy
+    vk::Buffer particles, visible, command;
+    vk::DeviceMemory particleMemory, visibleMemory, commandMemory;
+
+    std::vector<struct FrameResources> frames;
+
+    std::vector<struct ParticleEmitter> emitters;
+    uint32_t spawnCount = 0;
+
+    vk::DescriptorSetLayout layout;
+    vk::DescriptorPool descriptorPool;
+
+    std::unique_ptr<VulkanShader> shader;
+    std::unique_ptr<VulkanPipeline> pipeline;
+
+    Material * material = nullptr;
+    VulkanIndexBuffer * indexBuffer = nullptr;
+    int order = 0;
+    float depth = 0;
+
+    vk::CommandBuffer current;
+
+    std::vector<vk::Buffer> vBuffers;
+    std::vector<vk::DeviceSize> vOffsets;
+
+    // time which hasn't been simulated yet, and when the last particle spawned so far dies
+    double pending = 0, time = 0, aliveUntil = 0;
+
+    uint32_t seed = 0;
+
+    bool cleared = false;
+
+public:
+
+    /**
+     * @param device The device
+     * @param pools The frame pools, the system keeps one emitter buffer per frame
+     * @param target The framebuffers the particles draw into
+     * @param renderPass The render pass
+     * @param camera The camera, particles outside of every view aren't drawn
+     * @param capacity The number of particles alive at once. The oldest are replaced first.
+     * @param particleShader The compiled particles.comp
+     */
+    VulkanParticleSystem(VulkanDevice & device, VulkanFrameCommandPools * pools, VulkanFramebufferSource * target,
+            VulkanRenderPass * renderPass, VulkanCamera * camera, uint32_t capacity,
+            const std::string & particleShader = "shader/particles.comp.spv");
+
+    VulkanParticleSystem(const VulkanParticleSystem & other) = delete;
+
+    ~VulkanParticleSystem();
+
+    /**
+     * Adds the particle set, push constant and shaders the particles' material
+     * needs. The prototype only needs the usual vertex descriptors. The
+     * particle set is bound after the camera's, at set 2.
+     * @param prototype The material's prototype
+     * @param vertexShader The compiled particle.vert
+     * @param fragmentShader The compiled particle.frag
+     */
+    void prepareMaterial(MaterialPrototype & prototype, const std::string & vertexShader = "shader/particle.vert.spv",
+            const std::string & fragmentShader = "shader/particle.frag.spv");
+
+    /**
+     * Sets what every particle is drawn with
+     * @param material A material from a prepared prototype
+     * @param indexBuffer The particle's mesh, usually a quad
+     * @param order Where the particles sort against other draws
+     * @param depth The particles' depth, from 1 (far) to 0 (near)
+     */
+    void setMaterial(Material * material, VulkanIndexBuffer * indexBuffer, int order = 0, float depth = 0);
+
+    /**
+     * Spawns particles with the next frame. Emitters past the particle
+     * capacity or the emitter limit are dropped.
+     * @param emitter The emitter, copied
+     */
+    void emit(const struct ParticleEmitter & emitter);
+
+    /**
+     * Advances the simulation, which runs with the next frame
+     * @param deltat The time since the last update in seconds
+     */
+    void update(double deltat) {
+        pending += deltat;
+        time += deltat;
+    }
+
+    /**
+     * Kills every particle with the next frame and drops queued emitters
+     */
+    void clear(void);
+
+    /**
+     * @return Whether any particle could still be alive, or is about to spawn
+     */
+    bool isActive(void) const {
+        return spawnCount > 0 || time < aliveUntil;
+    }
+
+    uint32_t getCapacity(void) const {
+        return capacity;
+    }
+
+    int getOrder(void) const {
+        return order;
+    }
+
+    bool isTransparent(void) const {
+        return material && material->isTransparent();
+    }
+
+    vk::DescriptorSetLayout getSetLayout(void) {
+        return layout;
+    }
+
+    /**
+     * Spawns, integrates and culls
+     * @param buffer The frame's primary buffer, outside of the render pass
+     */
+    virtual void recordPrePass(vk::CommandBuffer buffer) override;
+
+    /**
+     * Records the particles' draw into a buffer from the current frame's pool,
+     * if any could be alive
+     * @param frame The framebuffer to draw into
+     */
+    void record(size_t frame);
+
+    /**
+     * @return The buffer last recorded
+     */
+    vk::CommandBuffer getBuffer(void) {
+        return current;
+    }
+
+private:
+
+    void createFrame(struct FrameResources & frame);
+
+    void destroyFrame(struct FrameResources & frame);
+
+};
+
+#endif /* VULKANPARTICLES_HPP */
@@ -0,0 +1,134 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   VulkanProfiler.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 4:20 PM
+ */
+
+#ifndef VULKANPROFILER_HPP
+#define VULKANPROFILER_HPP
+
+#include "VulkanDevice.hpp"
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Times regions of command buffers on the gpu with timestamp queries. Every
+// frame gets its own range of queries, which is read back when the range comes
+// around again, so reading never waits on the gpu. Regions with the same name
+// are summed per frame, then averaged over a rolling window of frames.
+// Does nothing if the device can't write timestamps.
+class VulkanGPUProfiler {
+private:
+
+    struct FrameQueries {
+        std::vector<std::string> names;
+        uint32_t used = 0;
+        bool reset = false;
+    };
+
+    struct Stats {
+        std::vector<double> samples;
+        size_t next = 0, count = 0;
+    };
+
+    VulkanDevice & device;
+
+    vk::QueryPool pool;
+    bool supported = false;
+
+    // nanoseconds per tick
+    double period = 1;
+    uint64_t validMask = ~0ull;
+
+    uint32_t queriesPerFrame;
+    size_t window;
+
+    std::vector<struct FrameQueries> frames;
+    size_t current = 0;
+
+    std::map<std::string, struct Stats> stats;
+
+    uint64_t droppedFrames = 0;
+
+public:
+
+    /**
+     * @param device The device
+     * @param framesInFlight How many frames the results are read back after
+     * @param maxRegions The most regions a frame can have
+     * @param window The number of frames the averages cover
+     */
+    VulkanGPUProfiler(VulkanDevice & device, uint32_t framesInFlight = 3, uint32_t maxRegions = 256, size_t window = 60);
+
+    VulkanGPUProfiler(const VulkanGPUProfiler & other) = delete;
+
+    ~VulkanGPUProfiler();
+
+    bool isSupported(void) const {
+        return supported;
+    }
+
+    /**
+     * Starts a new frame, and reads back the results of the oldest one. Must
+     * be called before anything is recorded for the frame.
+     */
+    void newFrame(void);
+
+    /**
+     * Resets the frame's queries. Must be recorded outside of a render pass,
+     * before any of the frame's regions execute.
+     * @param buffer The primary command buffer
+     */
+    void recordReset(vk::CommandBuffer buffer);
+
+    /**
+     * Writes the starting timestamp of a region
+     * @param buffer The command buffer
+     * @param name The region's name, regions with the same name are summed
+     * @return The region, or -1 if nothing was written
+     */
+    int begin(vk::CommandBuffer buffer, const std::string & name);
+
+    /**
+     * Writes the ending timestamp of a region
+     * @param buffer The command buffer
+     * @param region The region returned by begin
+     */
+    void end(vk::CommandBuffer buffer, int region);
+
+    /**
+     * @param name The region's name
+     * @return The average time per frame in milliseconds, 0 if it was never timed
+     */
+    double getAverage(const std::string & name) const;
+
+    /**
+     * @return Every region's average time per frame in milliseconds
+     */
+    std::map<std::string, double> getAverages(void) const;
+
+    /**
+     * @return How many frames' results weren't ready when they were read back
+     */
+    uint64_t getDroppedFrames(void) const {
+        return droppedFrames;
+    }
+
+    void report(std::ostream & out) const;
+
+private:
+
+    void readBack(struct FrameQueries & frame, uint32_t base);
+
+};
+
+#endif /* VULKANPROFILER_HPP */
@@ -19,6 +19,16 @@
 
 #include <vector>
 
+// Anything which provides framebuffers for the render pass, one per frame
+class VulkanFramebufferSource {
+public:
+
+    virtual vk::Framebuffer getFrame(size_t i) = 0;
+
+    virtual size_t frameCount() = 0;
+
+};
+
 // Controls a render pass and its attachments
 class VulkanRenderPass {
 private:
@@ -31,7 +41,20 @@ private:
 public:
 
     VulkanRenderPass(VulkanDevice & device, VulkanDepthBuffer & depthBuffer) {
-        createDefaultAttachments(device, depthBuffer);
+        createDefaultAttachments(device, depthBuffer, device.getSurfaceFormat(), vk::ImageLayout::ePresentSrcKHR);
+
+        createRenderPass(device);
+    }
+
+    /**
+     * Creates a render pass which renders to something other than the surface
+     * @param device The device
+     * @param depthBuffer The depth buffer
+     * @param colorFormat The color attachment's format
+     * @param finalLayout The color attachment's layout after the pass
+     */
+    VulkanRenderPass(VulkanDevice & device, VulkanDepthBuffer & depthBuffer, vk::Format colorFormat, vk::ImageLayout finalLayout) {
+        createDefaultAttachments(device, depthBuffer, colorFormat, finalLayout);
 
         createRenderPass(device);
     }
@@ -40,13 +63,16 @@ public:
 
     vk::AttachmentReference getAttachmentReference(std::string name, vk::ImageLayout layout);
 
+    bool hasAttachment(std::string name) const;
+
     vk::RenderPass & getRenderPass(void) {
         return renderPass.get();
     }
 
 private:
 
-    void createDefaultAttachments(VulkanDevice & device, VulkanDepthBuffer & depthBuffer);
+    void createDefaultAttachments(VulkanDevice & device, VulkanDepthBuffer & depthBuffer,
+            vk::Format colorFormat, vk::ImageLayout finalLayout);
 
     void createRenderPass(VulkanDevice & device);
 };
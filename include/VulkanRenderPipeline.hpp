@@ -25,6 +25,16 @@ public:
     VulkanPipeline(VulkanDevice & device, std::vector<vk::PushConstantRange> & pushConstants,
 			std::vector<vk::DescriptorSetLayout> & sets, vk::GraphicsPipelineCreateInfo & pipelineInfo);
 
+    /**
+     * Creates a compute pipeline
+     * @param device The owning device
+     * @param pushConstants The push constants
+     * @param sets The descriptor sets
+     * @param shader The compute shader
+     */
+    VulkanPipeline(VulkanDevice & device, std::vector<vk::PushConstantRange> & pushConstants,
+            std::vector<vk::DescriptorSetLayout> & sets, VulkanShader & shader);
+
     VulkanPipeline(const VulkanPipeline & rhs) = delete;
 
     vk::Pipeline & operator->(void) {
@@ -63,13 +73,20 @@ public:
      * @param vertexInput The vertex input
      * @param shaders The shaders
      * @param pushConstants The push constants
+     * @param transparent Whether to blend and test depth without writing it, instead of alpha testing
      * @return A vulkan pipeline
      */
     static VulkanPipeline * create(VulkanDevice & device, VulkanViewport & viewport,
 			VulkanRenderPass & renderPass, std::vector<vk::DescriptorSetLayout> & sets,
             VulkanVertexInputState & vertexInput,
 			std::vector<std::unique_ptr<VulkanShader>> & shaders,
-            std::vector<vk::PushConstantRange> & pushConstants);
+            std::vector<vk::PushConstantRange> & pushConstants, bool transparent = false);
+
+    // The fragment shaders' specialization constant for the alpha test cutoff
+    static constexpr uint32_t ALPHA_CUTOFF_CONSTANT = 0;
+
+    // Opaque fragments with less alpha than this are discarded
+    static constexpr float OPAQUE_ALPHA_CUTOFF = 0.5f;
 
 };
 
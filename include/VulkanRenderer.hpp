@@ -18,6 +18,8 @@
 #include "VulkanCommandBuffer.hpp"
 #include "VulkanImage.hpp"
 #include "VulkanSwap.hpp"
+#include "VulkanProfiler.hpp"
+#include "VulkanCamera.hpp"
 
 #include <mutex>
 
@@ -38,7 +40,8 @@ private:
         FrameInfo(VulkanDevice & device, size_t frame) {
             renderFinished = device->createSemaphore(vk::SemaphoreCreateInfo());
             imageAvailable = device->createSemaphore(vk::SemaphoreCreateInfo());
-            fence = device->createFence(vk::FenceCreateInfo());
+            // signaled, so waiting on a frame which was never submitted returns immediately
+            fence = device->createFence(vk::FenceCreateInfo(vk::FenceCreateFlagBits::eSignaled));
             index = frame;
         }
     };
@@ -50,6 +53,9 @@ private:
 
     size_t currentImage = 0, frameIndex = 0, maxFrames;
 
+    // set when the swapchain no longer matches the surface
+    bool outOfDate = false;
+
 public:
 
     VulkanScreenBufferController(VulkanDevice & device, VulkanSwapchain & swapchain,
@@ -79,6 +85,48 @@ public:
         return frameIndex;
     }
 
+    size_t getMaxFrames() {
+        return maxFrames;
+    }
+
+    /**
+     * @return Whether an acquire or present reported the swapchain as out of
+     *      date or suboptimal since the last rebuild
+     */
+    bool isOutOfDate() {
+        return outOfDate;
+    }
+
+    /**
+     * Waits for every submitted frame to finish. Unlike waitIdle, this doesn't
+     * wait for presentation or for unrelated work on other queues.
+     */
+    void waitForFrames() {
+        std::vector<vk::Fence> fences;
+
+        for (auto & frame : frames) {
+            fences.push_back(frame.second->fence);
+        }
+
+        device->waitForFences(fences, true, std::numeric_limits<uint64_t>::max());
+    }
+
+    /**
+     * Waits for the last submit of the current frame in flight, after which
+     * its command buffers can be reused
+     */
+    void waitForCurrentFrame() {
+        device->waitForFences({frames[frameIndex]->fence}, true, std::numeric_limits<uint64_t>::max());
+    }
+
+    /**
+     * Must be called after the swapchain was recreated
+     */
+    void swapchainRecreated() {
+        screen.extent = swapchain.getExtent();
+        outOfDate = false;
+    }
+
     /**
      * Acquires the next image from the swapchain
      * @param fence The fence to use
@@ -87,8 +135,18 @@ public:
     bool acquireImage(vk::Fence fence) {
 
         try {
-            currentImage = device->acquireNextImageKHR(swapchain.getSwapchain().get(),
-                    std::numeric_limits<uint64_t>::max(), frames[frameIndex]->imageAvailable, fence).value;
+            auto result = device->acquireNextImageKHR(swapchain.getSwapchain().get(),
+                    std::numeric_limits<uint64_t>::max(), frames[frameIndex]->imageAvailable, fence);
+
+            // a suboptimal image can still be drawn to, the swapchain is rebuilt next frame
+            if (result.result == vk::Result::eSuboptimalKHR) {
+                outOfDate = true;
+            }
+
+            currentImage = result.value;
+        } catch (vk::OutOfDateKHRError) {
+            outOfDate = true;
+            return false;
         } catch (std::exception) {
             return false;
         }
@@ -144,7 +202,16 @@ public:
         presentInfo.pResults = nullptr;
 
         try {
-            return queue.presentSubmit(presentInfo) == vk::Result::eSuccess;
+            vk::Result result = queue.presentSubmit(presentInfo);
+
+            if (result == vk::Result::eSuboptimalKHR) {
+                outOfDate = true;
+            }
+
+            return result == vk::Result::eSuccess;
+        } catch (vk::OutOfDateKHRError) {
+            outOfDate = true;
+            return false;
         } catch (std::exception) {
             return false;
         }
@@ -161,15 +228,17 @@ public:
      */
     bool queueDraw(VulkanQueue & queue, vk::CommandBuffer buffer, bool blocking = true) {
 
+        // the frame's semaphores can't be reused until its last submit finished
+        device->waitForFences({frames[frameIndex]->fence}, true, std::numeric_limits<uint64_t>::max());
+
         device->resetFences({frames[frameIndex]->fence});
 
         if (!submit(queue, buffer, frames[frameIndex]->fence)) {
             return false;
         }
 
-        if (!present(queue)) {
-            return false;
-        }
+        // the frame was submitted, so it has to advance even if the present failed
+        bool presented = present(queue);
 
         if (blocking) {
             device->waitForFences({frames[frameIndex]->fence}, true, std::numeric_limits<uint64_t>::max());
@@ -177,7 +246,39 @@ public:
 
         frameIndex = (frameIndex + 1) % maxFrames;
 
-        return true;
+        return presented;
+    }
+
+};
+
+// Work recorded into a frame's primary buffer before its render pass begins,
+// such as compute passes the draws depend on
+class VulkanFramePass {
+public:
+
+    virtual ~VulkanFramePass() {
+    }
+
+    /**
+     * @param buffer The frame's primary buffer, outside of any render pass
+     */
+    virtual void recordPrePass(vk::CommandBuffer buffer) = 0;
+
+};
+
+class MaterialRenderer;
+
+// An interface which builds a material renderer
+class MaterialRendererBuilder {
+public:
+
+    virtual MaterialRenderer * createRenderer(Material * material, VulkanIndexBuffer * indexbuffer = nullptr) = 0;
+
+    /**
+     * Called when a renderer this builder created is destroyed
+     * @param renderer The renderer
+     */
+    virtual void releaseRenderer(MaterialRenderer * renderer) {
     }
 
 };
@@ -187,38 +288,66 @@ class MaterialRenderer {
 private:
     VulkanQueue * queue;
 
-    VulkanSwapchain * swapchain;
+    VulkanFramebufferSource * target;
     VulkanRenderPass * renderPass;
 
-    VulkanCommandBufferGroup * buffers;
+    VulkanFrameCommandPools * pools;
+
+    // the buffer recorded this frame, it belongs to the frame's pool
+    vk::CommandBuffer current;
 
     Material * material;
 
     VulkanIndexBuffer * indexBuffer;
-    VulkanViewport * viewport;
+    VulkanCamera * camera;
 
     std::vector<vk::Buffer> vBuffers;
+    std::vector<vk::DeviceSize> vOffsets;
 
     std::set<int> recorded;
 
+    MaterialRendererBuilder * owner = nullptr;
+    VulkanGPUProfiler * profiler = nullptr;
+
 public:
 
-    MaterialRenderer(VulkanSwapchain * swapchain, VulkanRenderPass * renderPass,
-            VulkanQueue * queue, VulkanCommandBufferPool * pool, VulkanViewport * viewport,
+    MaterialRenderer(VulkanFramebufferSource * target, VulkanRenderPass * renderPass,
+            VulkanQueue * queue, VulkanFrameCommandPools * pools, VulkanCamera * camera,
             Material * material, VulkanIndexBuffer * indexBuffer = nullptr) {
-        this->swapchain = swapchain;
+        this->target = target;
         this->renderPass = renderPass;
         this->queue = queue;
         this->material = material;
         this->indexBuffer = indexBuffer;
-        this->viewport = viewport;
+        this->camera = camera;
 
-        this->vBuffers = material->getVertexBuffers();
-        this->buffers = pool->allocateGroup(2, vk::CommandBufferLevel::eSecondary);
+        this->pools = pools;
     }
 
     ~MaterialRenderer() {
-        delete buffers;
+        if (owner) {
+            owner->releaseRenderer(this);
+        }
+    }
+
+    /**
+     * Sets the builder which is told when this renderer is destroyed
+     * @param owner The builder
+     */
+    void setOwner(MaterialRendererBuilder * owner) {
+        this->owner = owner;
+    }
+
+    /**
+     * Times the material's draw on the gpu, under the material's name
+     * @param profiler The profiler, or null to stop timing
+     */
+    void setProfiler(VulkanGPUProfiler * profiler) {
+        this->profiler = profiler;
+    }
+
+    bool isTransparent(void) {
+        return material->isTransparent();
     }
 
     std::shared_ptr<char> getPushConstant(int id) {
@@ -229,6 +358,14 @@ public:
         this->indexBuffer = indexBuffer;
     }
 
+    /**
+     * Drops every recorded frame after the swapchain was recreated, since they
+     * reference the old framebuffers. The device must not be using them.
+     */
+    void swapchainRecreated() {
+        recorded.clear();
+    }
+
     /**
      * Checks for updates in the descriptor set
      * @param frame The current frame
@@ -259,23 +396,24 @@ public:
             throw std::runtime_error("Index Buffer cannot be null");
         }
 
-        vk::CommandBufferInheritanceInfo inheritance(renderPass->getRenderPass(), 0, swapchain->getFrame(frame));
+        vk::CommandBufferInheritanceInfo inheritance(renderPass->getRenderPass(), 0, target->getFrame(frame));
 
-        vk::CommandBuffer buffer = buffers->get(frame);
+        current = pools->acquire(vk::CommandBufferLevel::eSecondary);
 
-        buffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eRenderPassContinue, &inheritance));
+        vk::CommandBuffer buffer = current;
 
-        buffer.setScissor(0,{viewport->getScissor()});
-        buffer.setViewport(0,{viewport->getView()});
+        buffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eRenderPassContinue, &inheritance));
 
         if (material->hasDescriptors()) {
             buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics,
                     material->getPipeline()->getLayout(), 0, 1, &material->getDescriptorSet(), 0, nullptr);
         }
 
+        // looked up every time, a geometry store replaces its buffer when it grows
+        material->getVertexBindings(vBuffers, vOffsets);
+
         if (vBuffers.size() > 0) {
-            std::vector<vk::DeviceSize> offsets(vBuffers.size());
-            buffer.bindVertexBuffers(0, vBuffers.size(), vBuffers.data(), offsets.data());
+            buffer.bindVertexBuffers(0, vBuffers.size(), vBuffers.data(), vOffsets.data());
         }
 
         for (auto & pc : material->getPushConstants()) {
@@ -283,29 +421,41 @@ public:
                     pc.second.stages, pc.second.offset, pc.second.size, pc.second.ptr.get());
         }
 
-        indexBuffer->update((void*) &material->getDescriptorSet());
+        // host visible index buffers are copied once, store ranges are uploaded by their store
+        if (indexBuffer->needsUpdate()) {
+            indexBuffer->update(nullptr);
+            indexBuffer->markUpdated();
+        }
 
         buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, material->getPipeline()->get());
-        buffer.bindIndexBuffer(indexBuffer->getBuffer(), 0, vk::IndexType::eUint16);
+        buffer.bindIndexBuffer(indexBuffer->getBuffer(), indexBuffer->getOffset(), vk::IndexType::eUint16);
+
+        int region = profiler ? profiler->begin(buffer, material->getName().empty() ? "material" : material->getName()) : -1;
 
-        buffer.drawIndexed(indexBuffer->getObjectCount(), 1, 0, 0, 0);
+        // the same draw once for every view, the camera picks the transform
+        for (uint32_t view = 0; view < camera->viewCount(); view++) {
+            camera->bind(buffer, material->getPipeline()->getLayout(), view);
+
+            buffer.drawIndexed(indexBuffer->getObjectCount(), 1, 0, 0, 0);
+        }
+
+        if (profiler) {
+            profiler->end(buffer, region);
+        }
 
         buffer.end();
     }
 
+    /**
+     * @param frame The frame
+     * @return The buffer last recorded, which is only valid until the frame
+     *      in flight it was recorded in comes around again
+     */
     vk::CommandBuffer getBuffer(size_t frame) {
-        return buffers->get(frame);
+        return current;
     }
 
 };
 
-// An interface which builds a material renderer
-class MaterialRendererBuilder {
-public:
-
-    virtual MaterialRenderer * createRenderer(Material * material, VulkanIndexBuffer * indexbuffer = nullptr) = 0;
-
-};
-
 #endif /* VULKANRENDERER_HPP */
 
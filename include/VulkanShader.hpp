@@ -11,10 +11,15 @@
 class VulkanShader {
 private:
 
+    VulkanDevice & device;
+
     vk::ShaderModule shader;
 
     std::string name;
 
+    // the file it was loaded from, empty if it wasn't
+    std::string path;
+
     vk::ShaderStageFlagBits type;
 
     std::vector<uint32_t> data;
@@ -55,6 +60,21 @@ public:
             vk::ShaderStageFlagBits type = vk::ShaderStageFlagBits::eVertex,
             const std::string shader_name = "main");
 
+    VulkanShader(const VulkanShader & other) = delete;
+
+    ~VulkanShader() {
+        // pipelines keep their own copy, so the module can go once they're created
+        device->destroyShaderModule(shader);
+    }
+
+    const std::string & getPath(void) const {
+        return path;
+    }
+
+    vk::ShaderStageFlagBits getStage(void) const {
+        return type;
+    }
+
     operator vk::PipelineShaderStageCreateInfo() {
         return vk::PipelineShaderStageCreateInfo(vk::PipelineShaderStageCreateFlags(), type, shader, name.c_str());
     }
@@ -67,9 +87,12 @@ public:
 
 private:
 
+    // the first word of every SPIR-V module
+    static constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+
     static std::vector<uint32_t> LoadShader(const std::string & filename);
 
-    void init(VulkanDevice & device, const uint32_t * data, size_t count) {
+    void init(const uint32_t * data, size_t count) {
 
         vk::ShaderModuleCreateInfo createInfo;
         createInfo.codeSize = count;
@@ -81,6 +81,21 @@ public:
             vk::Buffer buffer,
             vk::Image image,
             int width, int height);
+
+    /**
+     * Copies an image to a buffer, tightly packed
+     * @param device The owning device
+     * @param pool A command buffer pool
+     * @param queue A valid queue
+     * @param image The image to copy from, in the transfer source layout
+     * @param buffer The buffer to copy to
+     * @param width The image's width
+     * @param height The image's height
+     */
+    static void copyImageToBuffer(VulkanDevice & device, VulkanCommandBufferPool & pool, VulkanQueue & queue,
+            vk::Image image,
+            vk::Buffer buffer,
+            int width, int height);
 };
 
 
@@ -4,6 +4,11 @@
 
 #include "VulkanDevice.hpp"
 #include "VulkanRenderPass.hpp"
+#include "VulkanDepthBuffer.hpp"
+#include "FramePacing.hpp"
+
+#include <algorithm>
+#include <array>
 
 template<class T>
 constexpr const T clamp(const T& v, const T& lo, const T& hi) {
@@ -13,7 +18,7 @@ constexpr const T clamp(const T& v, const T& lo, const T& hi) {
 // Represents the swapchain
 // Creates a double buffered swapchain by default
 // Also controls the frame buffers
-class VulkanSwapchain {
+class VulkanSwapchain : public VulkanFramebufferSource {
 private:
 
     vk::UniqueSwapchainKHR swapChain;
@@ -24,50 +29,121 @@ private:
 
     vk::Extent2D extent;
 
+    PresentSettings settings;
+    vk::PresentModeKHR presentMode;
+
+    // A replaced swapchain's resources, which the presentation engine may still be using
+    struct RetiredSwapchain {
+        vk::SwapchainKHR swapchain;
+        std::vector<vk::ImageView> imageViews;
+        std::vector<vk::Framebuffer> frameBuffers;
+        size_t framesLeft;
+    };
+
+    std::vector<struct RetiredSwapchain> retired;
+
 public:
 
-    VulkanSwapchain(VulkanDevice & device, VulkanViewport & viewport, VulkanRenderPass & renderPass) {
+    VulkanSwapchain(VulkanDevice & device, VulkanViewport & viewport, VulkanRenderPass & renderPass,
+            VulkanDepthBuffer & depthBuffer, const PresentSettings & settings = PresentSettings()) : settings(settings) {
 
         extent = getSurfaceExtent(viewport, device.getSurfaceCapabilities());
 
         createSwapchain(device.getSurface(), extent,
                 device.getSurfaceCapabilities(), device.getSurfaceFormat(), device.getGraphicsQueueIndex(),
-                device.getPresentQueueIndex(), device);
+                device.getPresentQueueIndex(), device, nullptr);
 
         createImageViews(device);
 
-        createFrameBuffers(device, renderPass);
+        createFrameBuffers(device, renderPass, depthBuffer);
     }
 
+    /**
+     * Destroys everything, including retired swapchains. The device must be idle.
+     * @param device The device
+     */
     void destroy(VulkanDevice & device) {
 
-        device->destroySwapchainKHR(swapChain.get());
-        swapChain.release();
+        releaseRetired(device, true);
 
-        for (auto & frame : frameBuffers) {
-            device->destroyFramebuffer(frame);
-            frame = nullptr;
-        }
+        destroyFrameResources(device, imageViews, frameBuffers);
 
+        swapChain.reset();
     }
 
-    void recreateSwapchain(VulkanDevice & device, VulkanViewport & viewport, VulkanRenderPass & renderPass) {
+    /**
+     * Replaces the swapchain with one that matches the viewport. The current
+     * swapchain is handed to the new one as its oldSwapchain and is only
+     * destroyed after a few more frames, so nothing has to wait for the
+     * presentation engine to let go of its images.
+     * @param device The device
+     * @param viewport The viewport, already reloaded to the new size
+     * @param renderPass The render pass for the framebuffers
+     * @param depthBuffer The depth buffer, already resized
+     * @param framesInFlight How many frames the old resources must outlive
+     */
+    void recreateSwapchain(VulkanDevice & device, VulkanViewport & viewport, VulkanRenderPass & renderPass,
+            VulkanDepthBuffer & depthBuffer, size_t framesInFlight) {
+
+        struct RetiredSwapchain old;
+        old.swapchain = swapChain.release();
+        old.imageViews = std::move(imageViews);
+        old.frameBuffers = std::move(frameBuffers);
+        old.framesLeft = framesInFlight + 1;
 
         swapChainImages.clear();
         imageViews.clear();
+        frameBuffers.clear();
 
         extent = getSurfaceExtent(viewport, device.getSurfaceCapabilities());
 
         createSwapchain(device.getSurface(), extent,
                 device.getSurfaceCapabilities(), device.getSurfaceFormat(), device.getGraphicsQueueIndex(),
-                device.getPresentQueueIndex(), device);
+                device.getPresentQueueIndex(), device, old.swapchain);
+
+        retired.push_back(std::move(old));
 
         createImageViews(device);
 
-        createFrameBuffers(device, renderPass);
+        createFrameBuffers(device, renderPass, depthBuffer);
     }
 
-    size_t frameCount() {
+    /**
+     * Counts down the retired swapchains and destroys the ones which can no
+     * longer be in use. Should be called once per frame.
+     * @param device The device
+     * @param force Destroy everything now, the device must be idle
+     */
+    void releaseRetired(VulkanDevice & device, bool force = false) {
+        for (auto it = retired.begin(); it != retired.end();) {
+            if (force || --it->framesLeft == 0) {
+                destroyFrameResources(device, it->imageViews, it->frameBuffers);
+                device->destroySwapchainKHR(it->swapchain);
+                it = retired.erase(it);
+            } else {
+                it++;
+            }
+        }
+    }
+
+    /**
+     * Changes the present settings. They take effect the next time the
+     * swapchain is recreated.
+     * @param settings The settings
+     */
+    void setPresentSettings(const PresentSettings & settings) {
+        this->settings = settings;
+    }
+
+    const PresentSettings & getPresentSettings(void) const {
+        return settings;
+    }
+
+    vk::PresentModeKHR getPresentMode(void) const {
+        return presentMode;
+    }
+
+    virtual size_t frameCount() override {
         return swapChainImages.size();
     }
 
@@ -87,7 +163,7 @@ public:
         return swapChain;
     }
 
-    vk::Framebuffer & getFrame(int i) {
+    virtual vk::Framebuffer getFrame(size_t i) override {
         return frameBuffers[i];
     }
 
@@ -105,23 +181,64 @@ private:
     }
 
     vk::PresentModeKHR findBestPresentMode(const std::vector<vk::PresentModeKHR> availablePresentModes) {
-        vk::PresentModeKHR bestMode = vk::PresentModeKHR::eFifo;
+        std::vector<vk::PresentModeKHR> preferred;
+
+        switch (settings.policy) {
+            case PresentPolicy::eLowLatency:
+                // fifo paces the cpu to vblank, so input is never sampled for a frame that gets dropped
+                return vk::PresentModeKHR::eFifo;
+            case PresentPolicy::eMaxThroughput:
+            case PresentPolicy::eCappedRate:
+                // with a cap, the cpu limiter sets the rate so presenting shouldn't also wait for vblank
+                preferred = {vk::PresentModeKHR::eMailbox, vk::PresentModeKHR::eImmediate};
+                break;
+        }
 
-        for (const auto& availablePresentMode : availablePresentModes) {
-            if (availablePresentMode == vk::PresentModeKHR::eMailbox) {
-                return availablePresentMode;
-            } else if (availablePresentMode == vk::PresentModeKHR::eImmediate) {
-                bestMode = availablePresentMode;
+        for (auto mode : preferred) {
+            if (std::find(availablePresentModes.begin(), availablePresentModes.end(), mode) != availablePresentModes.end()) {
+                return mode;
             }
         }
 
-        return bestMode;
+        // fifo is always supported
+        return vk::PresentModeKHR::eFifo;
+    }
+
+    uint32_t findImageCount(const vk::SurfaceCapabilitiesKHR & capabilities) {
+        uint32_t count = capabilities.minImageCount;
+
+        if (settings.policy == PresentPolicy::eMaxThroughput) {
+            count += settings.extraImages;
+        }
+
+        // a max of 0 means there's no limit
+        if (capabilities.maxImageCount > 0) {
+            count = std::min(count, capabilities.maxImageCount);
+        }
+
+        return count;
+    }
+
+    void destroyFrameResources(VulkanDevice & device, std::vector<vk::ImageView> & views,
+            std::vector<vk::Framebuffer> & framebuffers) {
+        for (auto & frame : framebuffers) {
+            device->destroyFramebuffer(frame);
+        }
+
+        for (auto & view : views) {
+            device->destroyImageView(view);
+        }
+
+        framebuffers.clear();
+        views.clear();
     }
 
     void createSwapchain(vk::SurfaceKHR surface, vk::Extent2D extent, vk::SurfaceCapabilitiesKHR capabilities,
-            vk::Format format, uint32_t graphicsQueueIndex, uint32_t presentQueueIndex, VulkanDevice & device) {
+            vk::Format format, uint32_t graphicsQueueIndex, uint32_t presentQueueIndex, VulkanDevice & device,
+            vk::SwapchainKHR oldSwapchain) {
 
         vk::PresentModeKHR swapchainPresentMode = findBestPresentMode(device.getSurfacePresentModes());
+        presentMode = swapchainPresentMode;
 
         vk::SurfaceTransformFlagBitsKHR preTransform = (capabilities.supportedTransforms & vk::SurfaceTransformFlagBitsKHR::eIdentity) ?
                 vk::SurfaceTransformFlagBitsKHR::eIdentity : capabilities.currentTransform;
@@ -131,9 +248,9 @@ private:
                 (capabilities.supportedCompositeAlpha & vk::CompositeAlphaFlagBitsKHR::ePostMultiplied) ? vk::CompositeAlphaFlagBitsKHR::ePostMultiplied :
                 (capabilities.supportedCompositeAlpha & vk::CompositeAlphaFlagBitsKHR::eInherit) ? vk::CompositeAlphaFlagBitsKHR::eInherit : vk::CompositeAlphaFlagBitsKHR::eOpaque;
 
-        vk::SwapchainCreateInfoKHR swapChainCreateInfo(vk::SwapchainCreateFlagsKHR(), surface, capabilities.minImageCount, format,
+        vk::SwapchainCreateInfoKHR swapChainCreateInfo(vk::SwapchainCreateFlagsKHR(), surface, findImageCount(capabilities), format,
                 vk::ColorSpaceKHR::eSrgbNonlinear, extent, 1, vk::ImageUsageFlagBits::eColorAttachment, vk::SharingMode::eExclusive, 0, nullptr,
-                preTransform, compositeAlpha, swapchainPresentMode, true);
+                preTransform, compositeAlpha, swapchainPresentMode, true, oldSwapchain);
 
         uint32_t queueFamilyIndices[2] = {graphicsQueueIndex, presentQueueIndex};
         if (queueFamilyIndices[0] != queueFamilyIndices[1]) {
@@ -144,10 +261,6 @@ private:
             swapChainCreateInfo.pQueueFamilyIndices = queueFamilyIndices;
         }
 
-        if (swapChain) {
-            device->destroySwapchainKHR(swapChain.get());
-        }
-
         swapChain = device->createSwapchainKHRUnique(swapChainCreateInfo);
 
         swapChainImages = device->getSwapchainImagesKHR(swapChain.get());
@@ -172,16 +285,17 @@ private:
         }
     }
 
-    void createFrameBuffers(VulkanDevice & device, VulkanRenderPass & renderPass) {
+    void createFrameBuffers(VulkanDevice & device, VulkanRenderPass & renderPass, VulkanDepthBuffer & depthBuffer) {
         frameBuffers.resize(imageViews.size());
-        vk::FramebufferCreateInfo createInfo(vk::FramebufferCreateFlags(), renderPass.getRenderPass(), 1, nullptr, extent.width, extent.height, 1);
 
-        for (size_t i = 0; i < imageViews.size(); i++) {
-            if (frameBuffers[i]) {
-                device->destroyFramebuffer(frameBuffers[i]);
-            }
+        // every frame shares the depth buffer, the render pass orders their writes
+        std::array<vk::ImageView, 2> attachments{{nullptr, depthBuffer.getView()}};
+        uint32_t attachmentCount = renderPass.hasAttachment("depth") ? 2 : 1;
 
-            createInfo.pAttachments = &imageViews[i];
+        vk::FramebufferCreateInfo createInfo(vk::FramebufferCreateFlags(), renderPass.getRenderPass(), attachmentCount, attachments.data(), extent.width, extent.height, 1);
+
+        for (size_t i = 0; i < imageViews.size(); i++) {
+            attachments[0] = imageViews[i];
 
             frameBuffers[i] = device->createFramebuffer(createInfo);
         }
@@ -0,0 +1,166 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   VulkanText.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 10:41 AM
+ */
+
+#ifndef VULKANTEXT_HPP
+#define VULKANTEXT_HPP
+
+#include "VulkanImage.hpp"
+#include "VulkanVertex.hpp"
+
+#include <map>
+#include <memory>
+#include <string>
+
+// Describes where a glyph is in an atlas and how it's laid out
+struct Glyph {
+    // the glyph's rectangle in the atlas, in uv coordinates
+    glm::vec2 uvmin, uvmax;
+
+    // the glyph's box in pixels, relative to the pen at the top of the line
+    glm::vec2 boxmin, boxmax;
+
+    // how far the pen moves after this glyph, in pixels
+    float advance;
+};
+
+// Holds every glyph of a font in one texture. The texture is uploaded once,
+// text only ever changes vertex data.
+class GlyphAtlas {
+private:
+
+    std::unique_ptr<Texture> texture;
+
+    std::map<int, struct Glyph> glyphs;
+
+    float lineHeight = 0;
+
+public:
+
+    /**
+     * Creates an atlas from a pixel font. The font image is uploaded as-is, and
+     * the marker row is skipped by the glyphs' uvs.
+     * @param device The device
+     * @param pool The pool for the upload commands
+     * @param queue The queue for the upload commands
+     * @param font The pixel font
+     */
+    GlyphAtlas(VulkanDevice & device, VulkanCommandBufferPool & pool, VulkanQueue & queue, const Font & font);
+
+    /**
+     * Bakes a truetype font into an atlas
+     * @param device The device
+     * @param pool The pool for the upload commands
+     * @param queue The queue for the upload commands
+     * @param ttfpath The truetype font file
+     * @param pixelHeight The height of a line, in pixels
+     * @param atlasSize The width and height of the atlas
+     * @param firstChar The first character to bake
+     * @param charCount The number of characters to bake
+     */
+    GlyphAtlas(VulkanDevice & device, VulkanCommandBufferPool & pool, VulkanQueue & queue,
+            const std::string & ttfpath, float pixelHeight, int atlasSize = 512,
+            int firstChar = 32, int charCount = 96);
+
+    GlyphAtlas(const GlyphAtlas & other) = delete;
+
+    Texture const * getTexture() const {
+        return texture.get();
+    }
+
+    float getLineHeight() const {
+        return lineHeight;
+    }
+
+    /**
+     * Finds a glyph. Falls back to the lowercase glyph, since the pixel font
+     * only has one case.
+     * @param c The character, as a byte so text outside ascii just has no glyph
+     * @return The glyph, or null if the atlas doesn't have it
+     */
+    const Glyph * getGlyph(unsigned char c) const;
+
+};
+
+// Controls the vertex data for a string. The glyph quads are laid out across
+// the same unit quad sprites use, so the owning object's size stretches the
+// text. Buffers are allocated once for the capacity; changing the text only
+// rewrites the host-side vertices.
+class TextMesh {
+private:
+
+    GlyphAtlas * atlas;
+
+    size_t capacity;
+
+    VulkanVertexBufferDefault vertices;
+    VulkanIndexBuffer indices;
+
+    std::string text;
+
+    float width = 0;
+
+public:
+
+    static constexpr int VERTICES_PER_GLYPH = 4, INDICES_PER_GLYPH = 6;
+
+    /**
+     * @param device The device
+     * @param atlas The atlas the text is rendered from
+     * @param capacity The maximum number of characters
+     * @param binding The vertex buffer binding
+     * @param text The initial text
+     */
+    TextMesh(VulkanDevice * device, GlyphAtlas * atlas, size_t capacity, int binding = 0,
+            const std::string & text = "");
+
+    TextMesh(const TextMesh & other) = delete;
+
+    /**
+     * Lays out new text. Cheap enough to call every frame.
+     * @param text The text to show
+     */
+    void setText(const std::string & text);
+
+    const std::string & getText() const {
+        return text;
+    }
+
+    VulkanVertexBufferDefault * getVertexBuffer() {
+        return &vertices;
+    }
+
+    VulkanIndexBuffer * getIndexBuffer() {
+        return &indices;
+    }
+
+    GlyphAtlas * getAtlas() {
+        return atlas;
+    }
+
+    /**
+     * @return The text's width in atlas pixels
+     */
+    float getWidth() const {
+        return width;
+    }
+
+    /**
+     * @return The text's height in atlas pixels
+     */
+    float getHeight() const {
+        return atlas->getLineHeight();
+    }
+
+};
+
+#endif /* VULKANTEXT_HPP */
@@ -118,6 +118,13 @@ public:
 
     }
 
+    VulkanVertexBuffer(VulkanBufferHolder * holder, VulkanDevice * device, vk::DeviceSize offset, int binding, int nverts,
+            vk::VertexInputRate rate = vk::VertexInputRate::eVertex) :
+    VulkanObjectBuffer<T>(holder, device, offset, nverts),
+    VulkanVertexDescriptor(binding, sizeof (T), rate) {
+
+    }
+
     std::vector<vk::VertexInputAttributeDescription> getAttributes(void) {
         return T::describe(this->binding.binding);
     }
@@ -136,6 +143,11 @@ public:
         }
     }
 
+    VulkanIndexBuffer(VulkanBufferHolder * holder, VulkanDevice * device, vk::DeviceSize offset, size_t size) :
+    VulkanObjectBuffer(holder, device, offset, size) {
+
+    }
+
 };
 
 using VulkanVertexBufferDefault = VulkanVertexBuffer<VulkanVertexObject>;
@@ -0,0 +1,125 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   WavFile.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 4:10 AM
+ */
+
+#ifndef WAVFILE_HPP
+#define WAVFILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Reads the samples of a wav file as floats, any number of frames at a time.
+// Handles 8, 16, 24 and 32 bit integer and 32 bit float PCM.
+class WavReader {
+private:
+
+    std::ifstream file;
+
+    uint32_t rate = 0;
+    uint16_t channels = 0, bits = 0;
+    bool floating = false;
+
+    std::streampos data;
+    size_t frames = 0, position = 0;
+
+    std::vector<uint8_t> raw;
+
+public:
+
+    /**
+     * Opens a file and reads its header
+     * @param path The file
+     */
+    WavReader(const std::string & path);
+
+    uint32_t getSampleRate(void) const {
+        return rate;
+    }
+
+    uint32_t getChannels(void) const {
+        return channels;
+    }
+
+    /**
+     * @return The number of frames in the file, where a frame has one sample per channel
+     */
+    size_t getFrames(void) const {
+        return frames;
+    }
+
+    /**
+     * @return The next frame read
+     */
+    size_t getPosition(void) const {
+        return position;
+    }
+
+    /**
+     * Reads frames as interleaved samples, from -1 to 1
+     * @param samples The output, with room for frames * channels samples
+     * @param frames The most frames read
+     * @return The number of frames read, which is only less than asked for at the end of the file
+     */
+    size_t read(float * samples, size_t frames);
+
+    /**
+     * Goes back to the first frame
+     */
+    void rewind(void);
+
+};
+
+// Writes interleaved 16 bit samples to a wav file. The header's sizes are
+// filled in when the writer is destroyed.
+class WavWriter {
+private:
+
+    std::ofstream file;
+
+    uint32_t rate;
+    uint16_t channels;
+
+    size_t frames = 0;
+
+public:
+
+    /**
+     * @param path The file, which is replaced
+     * @param rate The sample rate
+     * @param channels The number of channels
+     */
+    WavWriter(const std::string & path, uint32_t rate, uint16_t channels);
+
+    WavWriter(const WavWriter & other) = delete;
+
+    ~WavWriter();
+
+    /**
+     * @param samples The interleaved samples
+     * @param frames The number of frames
+     */
+    void write(const int16_t * samples, size_t frames);
+
+    size_t getFrames(void) const {
+        return frames;
+    }
+
+private:
+
+    void writeHeader(void);
+
+};
+
+#endif /* WAVFILE_HPP */
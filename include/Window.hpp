@@ -53,6 +53,11 @@ private:
 
     const char * title;
 
+    // kept up to date by the size callback, so reading them never calls into glfw
+    uint32_t width, height;
+
+    static std::map<GLFWwindow*, Window*> windows;
+
 public:
 
     Window(int width, int height, const char * title) {
@@ -60,9 +65,21 @@ public:
         wnd = glfwCreateWindow(width, height, title, nullptr, nullptr);
 
         this->title = title;
+
+        int w, h;
+
+        glfwGetWindowSize(wnd, &w, &h);
+
+        this->width = w;
+        this->height = h;
+
+        windows[wnd] = this;
+
+        glfwSetWindowSizeCallback(wnd, SizeCallback);
     }
 
     ~Window(void) {
+        windows.erase(wnd);
         glfwDestroyWindow(wnd);
     }
 
@@ -84,18 +101,25 @@ public:
         return wnd;
     }
 
-    uint32_t getWidth(void) {
-        int w, h;
+    uint32_t getWidth(void) const {
+        return width;
+    }
 
-        glfwGetWindowSize(wnd, &w, &h);
-        return w;
+    uint32_t getHeight(void) const {
+        return height;
     }
 
-    uint32_t getHeight(void) {
-        int w, h;
+private:
 
-        glfwGetWindowSize(wnd, &w, &h);
-        return h;
+    static void SizeCallback(GLFWwindow * window, int width, int height) {
+        try {
+            Window * owner = windows.at(window);
+
+            owner->width = width;
+            owner->height = height;
+        } catch (std::out_of_range) {
+            return;
+        }
     }
 
 };
@@ -15,6 +15,7 @@
 #define CONTROLLERHELPERS_HPP
 
 #include "scene.hpp"
+#include "SoundBank.hpp"
 
 /**
  * Checks if a number is within a range with a median.
@@ -82,7 +83,7 @@ struct KeyEvent {
 };
 
 struct SoundRequest {
-    std::string file;
+    SoundId sound = INVALID_SOUND;
     int loops = 1;
     glm::vec2 screen_pos = {0.0f, 0.0f};
     bool has_pos = false;
@@ -91,13 +92,13 @@ struct SoundRequest {
         
     }
     
-    SoundRequest(const std::string filename, int loops = 1) :
-    file(filename), loops(loops), has_pos(false) {
+    SoundRequest(SoundId sound, int loops = 1) :
+    sound(sound), loops(loops), has_pos(false) {
         
     }
 
-    SoundRequest(const std::string filename, int loops, const glm::vec2 & pos) :
-    file(filename), loops(loops), screen_pos(pos), has_pos(true) {
+    SoundRequest(SoundId sound, int loops, const glm::vec2 & pos) :
+    sound(sound), loops(loops), screen_pos(pos), has_pos(true) {
 
     }
 };
@@ -36,16 +36,16 @@ private:
 
     EventOut onclick;
 
-    CoordinateConverter * converter;
+    VulkanCamera * camera;
 
 public:
 
     /**
      * @param onclick Sent when a click is received. argument is a glm::vec2
-     * @param converter The world-to-screen converter
+     * @param camera The camera, which turns clicks into world space
      */
-    ClickEventDispatcher(EventOut onclick, CoordinateConverter * converter) :
-    onclick(onclick), converter(converter) {
+    ClickEventDispatcher(EventOut onclick, VulkanCamera * camera) :
+    onclick(onclick), camera(camera) {
 
     }
 
@@ -62,7 +62,11 @@ public:
             return;
         }
 
-        glm::vec2 p = glm::vec2(x, y) / converter->getScale();
+        glm::vec2 p;
+
+        if (!camera->screenToWorld(glm::vec2(x, y), p)) {
+            return;
+        }
 
         if (within_bounds(p.x, -1, 1) && within_bounds(p.y, -1, 1)) {
             clicks.push_back(p);
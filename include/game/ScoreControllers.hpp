@@ -15,12 +15,13 @@
 #define SCORECONTROLLERS_HPP
 
 #include "ControllerHelpers.hpp"
+#include "VulkanText.hpp"
 
 struct PlayerScoreControllerInfo {
     EventIn onplanetcollide, onbuttonpress;
     EventIn ondamage;
     EventOut ongameover;
-    TextImage * planet_energy_display, *planet_science_display;
+    TextMesh * planet_energy_display, *planet_science_display;
     ObjectHandle player;
 };
 
@@ -47,8 +48,8 @@ public:
      * @param buttonpress Received when a menu button is pressed
      * @param ondamage Received when the player gets damaged
      * @param gameover Sent when a hit brings the player below 0 energy
-     * @param planetinfo_energy The text sprite controller for energy info
-     * @param planetinfo_science The text sprite controller for science info
+     * @param planetinfo_energy The text mesh for energy info
+     * @param planetinfo_science The text mesh for science info
      */
     PlayerScoreController(const PlayerScoreControllerInfo & info) : info(info) {
 
@@ -218,6 +218,9 @@ private:
 
     double shoot_delay = 0;
 
+    SoundId shoot_sound = SoundNames::Intern("laser_shoot.wav"),
+            warp_sound = SoundNames::Intern("warpdrive.wav");
+
     static constexpr int TURN_LEFT = -1,
             TURN_NONE = 0,
             TURN_RIGHT = 1,
@@ -338,7 +341,7 @@ public:
             
             (*scene)[weapon].setPosition(owner.getPosition());
             
-            scene->dispatchEvent(info.onplayaudio, SoundRequest("laser_shoot.wav"));
+            scene->dispatchEvent(info.onplayaudio, SoundRequest(shoot_sound, 1, owner.getPosition()));
         }
 
         shoot_delay -= deltat;
@@ -346,7 +349,22 @@ public:
         // if the owner is outside the bounds, dispatch a world reset event and
         // reset the velocities
         if (!within_bounds(owner.getX(), -1, 1) || !within_bounds(owner.getY(), -1, 1)) {
-            scene->dispatchEvent(info.onplayaudio, SoundRequest("warpdrive.wav"));
+            ParticleEmitter warp;
+
+            warp.position = owner.getPosition();
+            warp.velocity = velocity;
+            warp.color = {0.7f, 0.9f, 1.0f, 1.0f};
+            warp.endColor = {0.3f, 0.1f, 1.0f, 0.0f};
+            warp.speed = 0.4f;
+            warp.life = 0.8f;
+            warp.size = 0.03f;
+            warp.endSize = 0.005f;
+            warp.drag = 1.5f;
+            warp.count = 256;
+
+            scene->emitParticles(warp);
+
+            scene->dispatchEvent(info.onplayaudio, SoundRequest(warp_sound));
             scene->dispatchEvent(info.onshipexit, nullptr);
             velocity = {0.0f, 0.0f};
             angular_momentum = 0;
@@ -0,0 +1,265 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   SoundBank.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 1:20 AM
+ */
+
+#ifndef SOUNDBANK_HPP
+#define SOUNDBANK_HPP
+
+#include "AudioBackend.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+typedef uint32_t SoundId;
+
+static constexpr SoundId INVALID_SOUND = UINT32_MAX;
+
+/**
+ * How a sound is loaded and competes for voices, from the manifest
+ */
+struct SoundSettings {
+
+    enum class Steal {
+        // a new instance never replaces a playing one
+        eNone,
+        eOldest,
+        eQuietest
+    };
+
+    // sounds with a higher priority replace lower ones when every voice is used
+    int priority = 0;
+
+    // the most instances playing at once, 0 for no limit
+    int max_instances = 0;
+
+    float volume = 1;
+
+    // positional sounds further than this from the listener aren't played
+    float max_distance = std::numeric_limits<float>::infinity();
+
+    // which instance of the sound is replaced when it's at max_instances
+    Steal steal = Steal::eOldest;
+
+    // sounds longer than this many seconds are streamed while they play
+    // instead of being decoded, negative for the bank's default
+    float stream_threshold = -1;
+};
+
+// The process-wide table of sound names. Names are interned once, usually
+// when a controller is created, so requests only ever carry an id.
+class SoundNames {
+private:
+
+    static std::mutex mutex;
+
+    static std::unordered_map<std::string, SoundId> ids;
+
+    static std::vector<std::string> names;
+
+public:
+
+    /**
+     * @param name The sound's file, relative to the sound directory
+     * @return The name's id, which is the same every time it's interned
+     */
+    static SoundId Intern(const std::string & name);
+
+    /**
+     * @param id An interned id
+     * @return The id's name
+     */
+    static std::string GetName(SoundId id);
+
+    /**
+     * @return The number of interned names. Ids are always below this.
+     */
+    static size_t Count();
+
+};
+
+// Keeps decoded sounds resident in the backend, so playing one never touches
+// the filesystem. Sounds are loaded from a manifest or a whole directory at
+// startup, and anything else is decoded the first time it's played. When the
+// decoded data goes over the budget, the least recently played sounds which
+// aren't pinned or playing are unloaded. Long sounds, like music and ambient
+// loops, are streamed from their file instead, and only count their buffers.
+class SoundBank {
+private:
+
+    struct Entry {
+        AudioClip * clip = nullptr;
+
+        // the decoded size, in bytes
+        size_t size = 0;
+
+        // the number of sounds playing this entry
+        int uses = 0;
+
+        // pinned entries are never evicted
+        bool pinned = false;
+
+        struct SoundSettings settings;
+
+        // the entry's place in lru, when it's loaded
+        std::list<SoundId>::iterator position;
+    };
+
+    AudioBackend * backend;
+
+    std::string directory;
+
+    size_t budget, resident = 0;
+
+    double stream_threshold = DEFAULT_STREAM_THRESHOLD;
+
+    // indexed by id, grows as names are interned
+    std::vector<struct Entry> entries;
+
+    // loaded sounds, the least recently played first
+    std::list<SoundId> lru;
+
+    size_t misses = 0, evictions = 0;
+
+public:
+
+    // a budget which never evicts anything
+    static constexpr size_t UNLIMITED = SIZE_MAX;
+
+    // in seconds, longer than any effect
+    static constexpr double DEFAULT_STREAM_THRESHOLD = 10;
+
+    /**
+     * @param backend The backend which decodes the sounds
+     * @param directory The sound directory, with a trailing slash
+     * @param budget The most decoded bytes kept resident, which pinned sounds can go over
+     */
+    SoundBank(AudioBackend * backend, const std::string & directory, size_t budget = UNLIMITED);
+
+    SoundBank(const SoundBank & other) = delete;
+
+    ~SoundBank();
+
+    /**
+     * Loads every sound listed in a manifest. The manifest maps each file in
+     * the directory to its options: 'pinned', and the SoundSettings fields
+     * ('priority', 'max instances', 'volume', 'max distance', 'steal', which
+     * is 'none', 'oldest' or 'quietest', and 'stream threshold'). A top level
+     * 'stream threshold' sets the bank's default.
+     * @param manifest The manifest's path
+     */
+    void loadManifest(const std::string & manifest);
+
+    /**
+     * Loads every wav file in the directory
+     */
+    void loadDirectory(void);
+
+    /**
+     * Loads a sound, if it isn't already
+     * @param id The sound
+     * @param pinned Whether the sound can never be evicted
+     */
+    void load(SoundId id, bool pinned = false);
+
+    /**
+     * Gets a sound's clip for playing, loading it if it isn't resident. The
+     * sound can't be evicted until it's released.
+     * @param id The sound
+     * @return The clip, or null if the sound couldn't be loaded, which
+     *      doesn't need to be released
+     */
+    AudioClip * acquire(SoundId id);
+
+    /**
+     * Marks one use of a sound as finished
+     * @param id The sound
+     */
+    void release(SoundId id);
+
+    /**
+     * @param id The sound
+     * @return Whether the sound is loaded
+     */
+    bool isResident(SoundId id) const {
+        return id < entries.size() && entries[id].clip != nullptr;
+    }
+
+    /**
+     * @param id The sound
+     * @return The sound's settings, which are the defaults if the manifest doesn't list it
+     */
+    const struct SoundSettings & getSettings(SoundId id) {
+        return getEntry(id).settings;
+    }
+
+    void setSettings(SoundId id, const struct SoundSettings & settings) {
+        getEntry(id).settings = settings;
+    }
+
+    size_t getResidentSize(void) const {
+        return resident;
+    }
+
+    double getStreamThreshold(void) const {
+        return stream_threshold;
+    }
+
+    /**
+     * Only affects sounds loaded after this
+     * @param seconds Sounds without their own threshold which are longer than
+     * this are streamed
+     */
+    void setStreamThreshold(double seconds) {
+        stream_threshold = seconds;
+    }
+
+    size_t getBudget(void) const {
+        return budget;
+    }
+
+    void setBudget(size_t budget) {
+        this->budget = budget;
+        evict();
+    }
+
+    /**
+     * @return The number of sounds which had to be loaded while being played
+     */
+    size_t getMisses(void) const {
+        return misses;
+    }
+
+    size_t getEvictions(void) const {
+        return evictions;
+    }
+
+private:
+
+    struct Entry & getEntry(SoundId id);
+
+    /**
+     * Removes the least recently played sounds until the bank fits its
+     * budget, or nothing else can be removed
+     */
+    void evict(void);
+
+    void unload(SoundId id);
+
+};
+
+#endif /* SOUNDBANK_HPP */
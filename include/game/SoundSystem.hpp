@@ -14,116 +14,172 @@
 #ifndef SOUNDSYSTEM_HPP
 #define SOUNDSYSTEM_HPP
 
+#include "AudioBackend.hpp"
 #include "ControllerHelpers.hpp"
+#include "SoundBank.hpp"
+#include "SpscQueue.hpp"
+#include "VoiceManager.hpp"
 
-#include <irrklang/irrKlang.h>
-
-struct PlayingSound {
-    SoundRequest request;
-    irrklang::ISound * sound_reference;
-    double time_left;
-    
-    PlayingSound() {
-        
-    }
-};
+#include <atomic>
+#include <list>
+#include <memory>
+#include <thread>
 
 /**
- * Manages the irrKlang sound engine and plays sounds when requested
+ * Manages the audio backend and plays sounds when requested. Requests are
+ * queued without locking, and a dedicated audio thread starts them. The
+ * backend reports when a sound stops, so nothing is polled every frame and
+ * the game thread's only cost is the enqueue. A voice manager keeps the
+ * number of sounds playing bounded.
  */
-class SoundSystem : public SceneDecorator, public EventHandler {
+class SoundSystem : public SceneDecorator, public EventHandler, public AudioStopListener {
 private:
 
-    irrklang::ISoundEngine * engine;
+    // how long the audio thread sleeps when there's nothing to do
+    static constexpr int IDLE_MILLISECONDS = 2;
+
+    static constexpr size_t QUEUE_SIZE = 256;
+
+    // voices past this couldn't have their stops queued
+    static constexpr size_t MAX_VOICES = QUEUE_SIZE;
+
+    std::unique_ptr<AudioBackend> backend;
 
     EventIn onsoundrequest;
 
     const std::string & sound_dir;
 
+    std::unique_ptr<SoundBank> bank;
+
     /**
-     * Sounds that will be played in the future
+     * Sounds that will be played in the future, from the game thread
      */
-    std::list<SoundRequest> requests;
+    SpscQueue<SoundRequest> requests;
 
     /**
-     * Sounds that are playing, but will stop in the future
+     * The ids of sounds that stopped on their own, from the backend's thread
+     */
+    SpscQueue<uint64_t> stopped;
+
+    /**
+     * Sounds that are playing, owned by the audio thread, in start order
      */
     std::list<PlayingSound> playing;
 
+    VoiceManager voices;
+
+    uint64_t next_id = 0;
+
+    // where the listener is, written by the game thread
+    ObjectHandle listener;
+    bool has_listener = false;
+
+    std::atomic<float> listener_x, listener_y;
+
+    // the listener the audio thread last gave the backend
+    glm::vec2 backend_listener = {0, 0};
+
+    std::atomic<bool> running;
+
+    std::atomic<size_t> dropped;
+
+    std::thread thread;
+
 public:
 
     static constexpr double DELAY_IMMEDIATE = 0;
 
     static constexpr int LOOP_ALWAYS = -1;
 
-    SoundSystem(EventIn onsoundrequest, const std::string & sound_directory) :
-    onsoundrequest(onsoundrequest), sound_dir(sound_directory) {
-        engine = irrklang::createIrrKlangDevice();
+    // the manifest the bank loads, in the sound directory
+    static constexpr const char * MANIFEST = "sounds.yml";
+
+    /**
+     * Decodes the sounds up front and starts the audio thread
+     * @param onsoundrequest Received with a SoundRequest to play
+     * @param sound_directory The sound directory, with a trailing slash. If
+     * it has a manifest, only the sounds in it are loaded, otherwise every wav.
+     * @param backend The backend, which the system owns, or null for the
+     * default from AudioBackend::Create
+     * @param max_voices The most sounds playing at once, up to MAX_VOICES
+     * @param budget The most decoded bytes the bank keeps resident
+     */
+    SoundSystem(EventIn onsoundrequest, const std::string & sound_directory, AudioBackend * backend = nullptr,
+            size_t max_voices = 32, size_t budget = SoundBank::UNLIMITED);
+
+    SoundSystem(const SoundSystem & other) = delete;
+
+    ~SoundSystem();
+
+    /**
+     * The bank belongs to the audio thread once it's started
+     */
+    SoundBank * getBank(void) {
+        return bank.get();
+    }
+
+    AudioBackend * getBackend(void) {
+        return backend.get();
     }
 
-    ~SoundSystem() {
-        engine->drop();
+    /**
+     * The voice manager belongs to the audio thread once it's started
+     */
+    VoiceManager * getVoices(void) {
+        return &voices;
     }
 
-    void RegisterHooks(EventManager* events) override {
-        events->addHandler(onsoundrequest, this);
+    /**
+     * Positional sounds are culled and ranked by their distance to an object
+     * @param object The object, usually the player
+     */
+    void setListener(ObjectHandle object) {
+        listener = object;
+        has_listener = true;
+    }
+
+    /**
+     * @return The number of requests dropped because the queue was full
+     */
+    size_t getDroppedRequests(void) const {
+        return dropped.load(std::memory_order_relaxed);
     }
 
-    void OnEvent(EventManager* manager, Event id, const std::shared_ptr<void> argument) override {
-        if (id == onsoundrequest) {
-            requests.push_back(*reinterpret_cast<SoundRequest*> (argument.get()));
-        }
+    void RegisterHooks(EventManager* events) override {
+        events->addHandler(onsoundrequest, this);
     }
 
-    void Apply(Scene* scene, double deltat) override {
-        auto iter = playing.begin();
-        while (iter != playing.end()) {
-            iter->time_left -= deltat;
+    void OnEvent(EventManager* manager, Event id, const std::shared_ptr<void> argument) override;
 
-            if (iter->time_left < 0) {
-                iter->sound_reference->stop();
-                iter->sound_reference->drop();
+    void Apply(Scene* scene, double deltat) override;
 
-                // automatically increments iterator to position after current
-                // and deletes the current item
-                iter = playing.erase(iter);
-            } else {
-                iter++;
-            }
-        }
+    /**
+     * Called by the backend, usually from its own thread
+     */
+    void OnVoiceStopped(uint64_t id) override;
 
-        auto req_iter = requests.begin();
+private:
 
-        while (req_iter != requests.end()) {
-            PlaySound(*req_iter);
+    void Run(void);
 
-            // always erases items from requests
-            req_iter = requests.erase(req_iter);
-        }
+    void PlaySound(const SoundRequest & req);
 
-    }
+    /**
+     * Starts a sound's next play
+     * @return Whether the backend could play it
+     */
+    bool Start(PlayingSound & sound);
 
-private:
+    /**
+     * Starts the next loop of a sound which stopped, or removes it
+     * @param id The sound's id, which may already be gone if it was stolen
+     */
+    void Finish(uint64_t id);
 
-    void PlaySound(SoundRequest req) {
-        std::string file = sound_dir + req.file;
-
-        PlayingSound playing;
-        playing.request = req;
-        
-        if (req.has_pos) {
-            irrklang::vec3df pos(req.screen_pos.x, req.screen_pos.y, 1);
-            playing.sound_reference = engine->play3D(file.c_str(), pos, req.loops > 1);
-        } else {
-            playing.sound_reference = engine->play2D(file.c_str(), req.loops > 1);
-        }
-        
-        if (playing.sound_reference) {
-            // getplaylength returns milliseconds
-            playing.time_left = playing.sound_reference->getPlayLength() / 1000.0 * req.loops;
-            this->playing.push_back(playing);
-        }
-    }
+    /**
+     * Stops a sound early and removes it
+     */
+    void Stop(PlayingSound * sound);
 
 };
 
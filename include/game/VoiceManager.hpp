@@ -0,0 +1,122 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   VoiceManager.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 2:50 AM
+ */
+
+#ifndef VOICEMANAGER_HPP
+#define VOICEMANAGER_HPP
+
+#include "ControllerHelpers.hpp"
+#include "SoundBank.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <list>
+
+/**
+ * A request which became a sound. Only the audio thread touches these.
+ */
+struct PlayingSound {
+    SoundRequest request;
+    AudioClip * clip = nullptr;
+
+    // unique for every sound, and ordered by when they started
+    uint64_t id = 0;
+
+    // plays left after the current one, which are started when it stops
+    int loops_left = 0;
+
+    int priority = 0;
+
+    // how loud the sound is at the listener, from 0 to its volume
+    float audibility = 1;
+};
+
+// Decides which sounds get a voice. There's a cap on the voices playing at
+// once, and each sound can have a cap on its own instances. A request past a
+// cap either replaces a playing sound, picked by the sound's steal mode and
+// priority, or isn't played. Positional sounds too far from the listener are
+// culled before they take a voice.
+class VoiceManager {
+private:
+
+    size_t max_voices;
+
+    glm::vec2 listener = {0, 0};
+
+    size_t culled = 0, rejected = 0, stolen = 0;
+
+public:
+
+    /**
+     * @param max_voices The most sounds playing at once
+     */
+    VoiceManager(size_t max_voices) : max_voices(max_voices) {
+
+    }
+
+    void setListener(glm::vec2 position) {
+        listener = position;
+    }
+
+    glm::vec2 getListener(void) const {
+        return listener;
+    }
+
+    size_t getMaxVoices(void) const {
+        return max_voices;
+    }
+
+    void setMaxVoices(size_t max_voices) {
+        this->max_voices = max_voices;
+    }
+
+    /**
+     * @param req The request
+     * @param settings The request's sound's settings
+     * @return How loud the request would be at the listener, or 0 if it's out of range
+     */
+    float getAudibility(const SoundRequest & req, const struct SoundSettings & settings) const;
+
+    /**
+     * Decides whether a request can play
+     * @param req The request
+     * @param settings The request's sound's settings
+     * @param playing The sounds which are playing
+     * @param victim Set to the sound the request replaces, which has to be
+     * stopped first, or null if there was a free voice
+     * @return Whether the request can play
+     */
+    bool admit(const SoundRequest & req, const struct SoundSettings & settings,
+            std::list<PlayingSound> & playing, PlayingSound *& victim);
+
+    /**
+     * @return The number of requests culled for being out of range
+     */
+    size_t getCulled(void) const {
+        return culled;
+    }
+
+    /**
+     * @return The number of requests which lost to every playing sound
+     */
+    size_t getRejected(void) const {
+        return rejected;
+    }
+
+    size_t getStolen(void) const {
+        return stolen;
+    }
+
+};
+
+#endif /* VOICEMANAGER_HPP */
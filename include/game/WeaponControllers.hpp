@@ -60,9 +60,14 @@ private:
     bool cleanup_requested = false, enemy_killed = false;
 
     double length_remaining = TRAVEL_LENGTH;
+
+    // particles owed to the trail, which spawns a whole number each frame
+    double trail = 0;
     
     static constexpr double TRAVEL_LENGTH = 0.6, RADIUS = 0.1, TRAVEL_SPEED = 0.3;
 
+    static constexpr double TRAIL_RATE = 120;
+
 public:
 
     PlasmaBallController(glm::vec2 velocity, EventOut oncleanuprequest, ObjectHandle enemy) :
@@ -82,6 +87,7 @@ public:
         if (length_remaining < 0) {
             owner.setVisible(false);
             if(!cleanup_requested) {
+                scene->emitParticles(dissipate(owner.getPosition()));
                 scene->dispatchEvent(oncleanuprequest, object);
                 cleanup_requested = true;
             }
@@ -98,6 +104,44 @@ public:
 
         length_remaining -= glm::length(delta);
 
+        trail += TRAIL_RATE * deltat;
+
+        if (trail >= 1) {
+            ParticleEmitter emitter;
+
+            emitter.position = owner.getPosition();
+            emitter.velocity = -velocity * (float) (TRAVEL_SPEED * 0.25);
+            emitter.color = {0.6f, 0.8f, 1.0f, 0.8f};
+            emitter.endColor = {0.2f, 0.3f, 1.0f, 0.0f};
+            emitter.speed = 0.02f;
+            emitter.spread = 1.0f;
+            emitter.life = 0.4f;
+            emitter.size = (float) RADIUS;
+            emitter.endSize = 0.01f;
+            emitter.count = (uint32_t) trail;
+
+            scene->emitParticles(emitter);
+
+            trail -= emitter.count;
+        }
+
+    }
+
+private:
+
+    static ParticleEmitter dissipate(glm::vec2 position) {
+        ParticleEmitter emitter;
+
+        emitter.position = position;
+        emitter.color = {0.8f, 0.9f, 1.0f, 1.0f};
+        emitter.endColor = {0.2f, 0.3f, 1.0f, 0.0f};
+        emitter.speed = 0.3f;
+        emitter.life = 0.5f;
+        emitter.size = 0.03f;
+        emitter.drag = 3.0f;
+        emitter.count = 64;
+
+        return emitter;
     }
 
 };
@@ -112,6 +156,8 @@ private:
     EventOut onplayerdamaged;
 
     EventOut onrequestsound;
+
+    SoundId launch_sound = SoundNames::Intern("missle_launch.wav");
     
     double size = MAX_SIZE;
 
@@ -142,7 +188,20 @@ public:
             size = 0;
             
             scene->dispatchEvent(onplayerdamaged, rand<int>(DMG_UPPER - DMG_LOWER) + DMG_LOWER);
-            scene->dispatchEvent(onrequestsound, SoundRequest("missle_launch.wav"));
+            scene->dispatchEvent(onrequestsound, SoundRequest(launch_sound, 1, enemyobj.getPosition()));
+
+            ParticleEmitter flash;
+
+            flash.position = enemyobj.getPosition();
+            flash.color = {1.0f, 0.9f, 0.4f, 1.0f};
+            flash.endColor = {1.0f, 0.2f, 0.0f, 0.0f};
+            flash.speed = 0.5f;
+            flash.life = 0.6f;
+            flash.size = 0.04f;
+            flash.drag = 2.0f;
+            flash.count = 128;
+
+            scene->emitParticles(flash);
         }
         
         owner.setVisible(size < MAX_SIZE);
@@ -0,0 +1,117 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   DocumentCache.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 8:25 AM
+ */
+
+#ifndef DOCUMENTCACHE_HPP
+#define DOCUMENTCACHE_HPP
+
+#include <yaml-cpp/yaml.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <experimental/filesystem>
+
+#include "ThreadPool.hpp"
+
+namespace Game {
+
+    /**
+     * A parsed game file. Documents are never changed once they're parsed, a
+     * file which changes gets a new document.
+     */
+    struct Document {
+        std::experimental::filesystem::path path;
+
+        YAML::Node node;
+
+        // the files in its references node, resolved against its own folder
+        std::vector<std::experimental::filesystem::path> references;
+
+        // fnv-1a of the file's contents
+        uint64_t hash;
+    };
+
+    // Parses game files and the files they reference, keeping every document
+    // it parsed. The reference graph is walked breadth first, and each level's
+    // files are parsed in parallel, since they don't depend on each other. A
+    // cached document is used again while its file's modification time hasn't
+    // changed, or while its contents hash the same, so only changed files are
+    // parsed again. Contexts which share files should share a cache.
+    class DocumentCache {
+    private:
+
+        struct Entry {
+            std::shared_ptr<const Document> document;
+            std::experimental::filesystem::file_time_type modified;
+        };
+
+        // the result of refreshing one file, on a worker
+        struct Refresh {
+            Entry entry;
+            bool parsed;
+        };
+
+        ThreadPool pool;
+
+        std::map<std::experimental::filesystem::path, Entry> entries;
+
+        size_t parsed = 0;
+
+        /**
+         * Checks a file against its cache entry, parsing it if it changed.
+         * Only touches its arguments, so it can run on any thread.
+         * @param path The file
+         * @param cached The file's current entry, if it has one
+         * @return The file's new entry
+         */
+        static Refresh Load(const std::experimental::filesystem::path & path, const Entry * cached);
+
+    public:
+
+        /**
+         * @param threads The number of files parsed at once, or 0 for one per hardware thread
+         */
+        DocumentCache(unsigned threads = 0);
+
+        DocumentCache(const DocumentCache & other) = delete;
+
+        /**
+         * Reads the reference tree for a file. Every file in the tree is checked
+         * for changes, and each file is only loaded once.
+         * @param file The file
+         * @return Every document in the tree, with each document after the ones
+         *         it references, and the file's own document last
+         */
+        std::vector<std::shared_ptr<const Document>> load(const std::string & file);
+
+        /**
+         * Forgets every document, so everything is parsed again
+         */
+        void clear() {
+            entries.clear();
+        }
+
+        /**
+         * @return How many times a file has been parsed
+         */
+        size_t getParseCount() const {
+            return parsed;
+        }
+
+    };
+
+}
+
+#endif /* DOCUMENTCACHE_HPP */
@@ -19,78 +19,19 @@
 #include <vulkan/vulkan.hpp>
 #include <glm/glm.hpp>
 
+#include <algorithm>
+#include <cstring>
 #include <string>
+#include <list>
 #include <map>
+#include <memory>
+#include <tuple>
 #include <vector>
 #include <exception>
 #include <iostream>
 #include <experimental/filesystem>
 
-namespace Loader {
-
-    template<typename T>
-    class DataTypeLoader {
-    public:
-        virtual T Load(unsigned char * buffer, size_t offset) = 0;
-
-    };
-
-    template<typename T>
-    class CopyLoader : DataTypeLoader<T> {
-    public:
-
-        T Load(unsigned char * buffer, size_t offset) override {
-            T value = {0};
-
-            memcpy(&value, buffer + offset, sizeof (T));
-
-            return value;
-        }
-
-    };
-
-    class StringLoader : DataTypeLoader<std::string> {
-    public:
-
-        std::string Load(unsigned char * buffer, size_t offset) override {
-            unsigned char * data = buffer + offset;
-
-            short length = data[0] << 8 | data[1];
-
-            char * cbuf = new char[length];
-
-            memcpy(cbuf, &buffer[2], length);
-
-            std::string str(cbuf, length);
-
-            delete[] cbuf;
-
-            return str;
-        }
-
-    };
-
-    class DataTypes {
-    public:
-
-        const CopyLoader<unsigned char> Byte;
-        const CopyLoader<short> Short;
-        const CopyLoader<int> Integer;
-        const CopyLoader<long long> Long;
-        const CopyLoader<float> Float;
-        const CopyLoader<double> Double;
-
-    };
-
-
-}
-
-
-
-
-
-
-
+#include "DocumentCache.hpp"
 
 namespace Game {
 
@@ -116,6 +57,30 @@ namespace Game {
         return true;
     }
 
+    /**
+     * Splits a named entry, which is a map with a single key, like the
+     * '- name: {...}' items of every list in the game files
+     * @param node The entry node
+     * @param name The entry's name
+     * @param value The entry's value
+     * @return {@code true} if the node is a named entry
+     */
+    static inline bool GetEntry(ConstNode node, std::string & name, YAML::Node & value) {
+        if (!node || !node.IsMap() || node.size() != 1) {
+            return false;
+        }
+
+        auto entry = node.begin();
+
+        if (!GetScalar(entry->first, name)) {
+            return false;
+        }
+
+        value = entry->second;
+
+        return true;
+    }
+
     enum ValueType {
         eUnknown,
         eFloat,
@@ -325,6 +290,25 @@ namespace Game {
             throw format_error("Invalid shader stages " + value);
         }
 
+        /**
+         * Parses a single stage, or a sequence of them
+         * @param node The stage or stage sequence node
+         * @return Every stage in the node
+         */
+        static vk::ShaderStageFlags ParseStages(ConstNode node) {
+            if (!node || !node.IsSequence()) {
+                return ParseStage(node);
+            }
+
+            vk::ShaderStageFlags stages;
+
+            for (ConstNode stage : node) {
+                stages |= ParseStage(stage);
+            }
+
+            return stages;
+        }
+
         /**
          * Tries to parse the node as a string sequence.
          * @param node The node to parse
@@ -353,16 +337,30 @@ namespace Game {
 
     };
 
+    // The rules a block's members are laid out by in glsl. Uniform buffers
+    // use std140, where arrays and nested blocks are aligned to 16 bytes, and
+    // push constants and storage buffers use std430, where they aren't.
+    enum class BlockLayout {
+        eStd140, eStd430
+    };
+
     class FieldList {
     public:
 
         struct Field {
         public:
             std::string name, type;
+            // components is 1 for a scalar, or 2 to 4 for a vector. array is
+            // the number of elements, or 0 if the field isn't an array
+            size_t components, array;
+            // count is the number of values, components * elements
             size_t count, offset, size;
+            // the distance between array elements, or the field's size
+            size_t stride;
 
-            Field(ConstString name, ConstString type, size_t count, size_t offset, size_t size) :
-            name(name), type(type), count(count), offset(offset), size(size) {
+            Field(ConstString name, ConstString type, size_t components, size_t array, size_t offset, size_t size, size_t stride) :
+            name(name), type(type), components(components), array(array), count(components * std::max<size_t>(array, 1)),
+            offset(offset), size(size), stride(stride) {
 
             }
         };
@@ -372,6 +370,8 @@ namespace Game {
         std::list<Field> fields;
         std::map<std::string, Field*> byname;
 
+        BlockLayout layout = BlockLayout::eStd140;
+
         size_t buffer_size = 0;
 
     public:
@@ -380,22 +380,14 @@ namespace Game {
 
         }
 
-        FieldList(ConstNode node);
-
-        template<typename T>
-        T & at(ConstString name, unsigned char * buffer, size_t len, size_t index = 0) {
-            Field* field = byname.at(name);
-
-            if (field->offset + field->size * (index + 1) >= len) {
-                throw std::out_of_range("Illegal parameters: buffer not large enough for requested object");
-            }
-
-            if (index > field->count) {
-                throw std::out_of_range("index > field count");
-            }
-
-            return *(reinterpret_cast<T*> (buffer + field->offset) + index);
-        }
+        /**
+         * Lays out the fields in the order they're listed, the way glsl lays
+         * out a block's members
+         * @param node The field sequence, where each field is either
+         *      'name: type' or 'name: {type: type, count: count, array: elements}'
+         * @param layout The rules the block's members are laid out by
+         */
+        FieldList(ConstNode node, BlockLayout layout);
 
         const struct Field * getField(ConstString field) const {
             return byname.at(field);
@@ -405,8 +397,30 @@ namespace Game {
             return fields;
         }
 
+        /**
+         * Parses a value for a field
+         * @param field The field's name
+         * @param value The value node, a sequence for fields with a count
+         * @return The value, which has the field's count
+         */
         Value parse(ConstString field, ConstNode value) const;
 
+        /**
+         * Copies a field's values into a buffer laid out by this list
+         * @param field The field
+         * @param value The field's values, packed one after another
+         * @param buffer The buffer, which is size() bytes
+         */
+        void copy(const Field & field, const void * value, void * buffer) const;
+
+        BlockLayout getLayout() const {
+            return layout;
+        }
+
+        /**
+         * @return The block's size, rounded up to its alignment so the
+         *      blocks can be put one after another
+         */
         const size_t size() const {
             return buffer_size;
         }
@@ -424,8 +438,20 @@ namespace Game {
         PushConstantInfo() {
         }
 
-        PushConstantInfo(ConstNode node) : name(node.Tag()), stages(ValueParsing::ParseStage(node["stages"])), fields(node["fields"]) {
+        PushConstantInfo(ConstString name, ConstNode node) : name(name), stages(ValueParsing::ParseStages(node["stages"])), fields(node["fields"], BlockLayout::eStd430) {
+
+        }
+
+        ConstString getName() const {
+            return name;
+        }
+
+        vk::ShaderStageFlags getStages() const {
+            return stages;
+        }
 
+        const FieldList * getFields() const {
+            return &fields;
         }
 
     };
@@ -435,7 +461,7 @@ namespace Game {
 
         FieldList fields;
 
-        size_t count;
+        size_t count = 1;
 
     public:
 
@@ -443,7 +469,7 @@ namespace Game {
 
         }
 
-        UBOPrototype(ConstNode node) : name(node.Tag()), fields(node["fields"]) {
+        UBOPrototype(ConstString name, ConstNode node) : name(name), fields(node["fields"], BlockLayout::eStd140) {
             Logger logger(name);
             logger.Log("Creating ubo prototype");
             if (node["count"]) {
@@ -456,10 +482,18 @@ namespace Game {
             }
         }
 
+        ConstString getName() const {
+            return name;
+        }
+
         const FieldList * getFields() const {
             return &fields;
         }
 
+        size_t getCount() const {
+            return count;
+        }
+
     };
 
     class UBOInstance {
@@ -480,9 +514,28 @@ namespace Game {
 
         }
 
-        UBOInstance(ConstNode node, const std::map<std::string, UBOPrototype> & prototypes);
+        UBOInstance(ConstString name, ConstNode node, const std::map<std::string, UBOPrototype> & prototypes);
+
+        ConstString getName() const {
+            return name;
+        }
+
+        /**
+         * @return The prototype, or null if the instance has its own fields
+         */
+        const UBOPrototype * getPrototype() const {
+            return prototype;
+        }
+
+        const FieldList * getFields() const {
+            return list;
+        }
 
-        std::shared_ptr<void> create();
+        /**
+         * Lays the values out as the ubo's buffer, with missing values zeroed
+         * @return The buffer, which is getFields()->size() bytes
+         */
+        std::shared_ptr<void> create() const;
 
     };
 
@@ -505,7 +558,37 @@ namespace Game {
 
         }
 
-        ShaderPrototype(ConstNode node);
+        ShaderPrototype(ConstString name, ConstNode node);
+
+        ConstString getName() const {
+            return name;
+        }
+
+        ConstString getFile() const {
+            return file;
+        }
+
+        vk::ShaderStageFlagBits getStage() const {
+            return stage;
+        }
+
+        ConstRef<std::vector<std::string>> getPushConstants() const {
+            return pushconstants;
+        }
+
+        /**
+         * @return The textures' names, which can be empty, and bindings
+         */
+        ConstRef<std::vector<std::tuple<std::string, int>>> getTextures() const {
+            return textures;
+        }
+
+        /**
+         * @return The ubos' prototypes and bindings
+         */
+        ConstRef<std::vector<std::tuple<std::string, int>>> getUBOs() const {
+            return ubos;
+        }
 
     };
 
@@ -532,7 +615,15 @@ namespace Game {
     class GameContext {
     private:
 
-        std::list<std::tuple<YAML::Node, std::experimental::filesystem::path>> document;
+        // only set when the context wasn't given a cache
+        std::unique_ptr<DocumentCache> own_cache;
+
+        DocumentCache * cache;
+
+        std::string file;
+
+        // the documents the definitions were read from, dependencies first
+        std::vector<std::shared_ptr<const Document>> document;
 
         std::map<std::string, Value> constants;
 
@@ -550,16 +641,77 @@ namespace Game {
 
     public:
 
+        /**
+         * Reads a file and the files it references, with its own cache
+         * @param file The file
+         */
         GameContext(ConstString file);
 
+        /**
+         * Reads a file and the files it references, sharing a cache with other contexts
+         * @param file The file
+         * @param cache The cache, which has to outlive the context
+         */
+        GameContext(ConstString file, DocumentCache & cache);
+
+        GameContext(const GameContext & other) = delete;
+
+        /**
+         * Checks the files for changes, reading the definitions again if
+         * any file in the reference tree changed. Only changed files are parsed.
+         * @return Whether anything changed
+         */
+        bool reload();
+
+        /**
+         * @return The files the definitions were read from, as generic paths,
+         *      each file after the ones it references
+         */
+        std::vector<std::string> getFiles() const {
+            std::vector<std::string> files;
+
+            for (auto & doc : document) {
+                files.push_back(doc->path.generic_string());
+            }
+
+            return files;
+        }
+
+        ConstRef<std::map<std::string, Value>> getConstants() const {
+            return constants;
+        }
+
+        ConstRef<std::map<std::string, UBOPrototype>> getUBOPrototypes() const {
+            return uboprototypes;
+        }
+
+        ConstRef<std::map<std::string, UBOInstance>> getUBOInstances() const {
+            return uboinstances;
+        }
+
+        ConstRef<std::map<std::string, std::vector<VertexInfo>>> getVertexBuffers() const {
+            return vertex_buffers;
+        }
+
+        ConstRef<std::map<std::string, std::vector<int>>> getIndexBuffers() const {
+            return index_buffers;
+        }
+
+        ConstRef<std::map<std::string, PushConstantInfo>> getPushConstants() const {
+            return push_constants;
+        }
+
+        ConstRef<std::map<std::string, ShaderPrototype>> getShaders() const {
+            return shaders;
+        }
+
     private:
 
         /**
-         * Reads the reference tree for the current file.
-         * Does not load the same file twice.
-         * @return The list of dependencies, with the current document last
+         * Reads every document's definitions, replacing the current ones.
+         * Later documents replace earlier documents' definitions.
          */
-        std::list<std::tuple<YAML::Node, std::experimental::filesystem::path>> CalculateDependencies(ConstString parent);
+        void ReadDocuments();
 
         /**
          * Reads the constant sequence from the node into this context's constants.
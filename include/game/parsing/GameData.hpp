@@ -0,0 +1,316 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   GameData.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 6:20 AM
+ */
+
+#ifndef GAMEDATA_HPP
+#define GAMEDATA_HPP
+
+#include "MappedFile.hpp"
+#include "Loader.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Game {
+
+    /**
+     * The compiled game data format, which is what the game files become once
+     * game_data_compiler has parsed them. Everything is a flat table of fixed
+     * size records, so the file is used straight from memory. Records refer to
+     * each other by index, to strings by their place in the string table, and
+     * to values by their offset in the data section. Named records are sorted
+     * by name, so they can be found with a binary search.
+     */
+    namespace Format {
+
+        static constexpr char MAGIC[4] = {'V', 'G', 'D', 'B'};
+
+        // bumped whenever a record changes, old files have to be recompiled
+        static constexpr uint32_t VERSION = 1;
+
+        // every record is little endian, this catches a file written on a
+        // machine where it wasn't
+        static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+        // every section starts on this
+        static constexpr size_t ALIGNMENT = 8;
+
+        // an index which doesn't refer to anything
+        static constexpr uint32_t NONE = UINT32_MAX;
+
+        enum Section : uint32_t {
+            // the strings, each followed by a null
+            eStrings,
+            // the values of constants, ubo instances and buffers
+            eData,
+            eConstants,
+            // every field list's fields, one list after another
+            eFields,
+            eUBOPrototypes,
+            eUBOInstances,
+            eVertexBuffers,
+            eIndexBuffers,
+            ePushConstants,
+            eShaders,
+            eShaderBindings,
+            eSectionCount
+        };
+
+        // the same as Game::ValueType, which the format can't change with
+        enum Type : uint32_t {
+            eUnknown,
+            eFloat,
+            eInt
+        };
+
+        enum BindingKind : uint32_t {
+            eTexture,
+            eUBO,
+            ePushConstant
+        };
+
+        struct SectionInfo {
+            uint32_t offset, size;
+        };
+
+        struct Header {
+            char magic[4];
+            uint32_t version;
+            uint32_t byte_order;
+            // the whole file's size
+            uint32_t size;
+            SectionInfo sections[eSectionCount];
+        };
+
+        struct String {
+            // in the string table, without the null
+            uint32_t offset, length;
+        };
+
+        struct Constant {
+            String name;
+            uint32_t type, count;
+            // in the data section, count values of type
+            uint32_t data;
+        };
+
+        struct Field {
+            String name;
+            uint32_t type, count;
+            // where the field goes in its buffer, and how many bytes it takes
+            uint32_t offset, size;
+        };
+
+        struct UBOPrototype {
+            String name;
+            uint32_t first_field, field_count;
+            uint32_t size, count;
+        };
+
+        struct UBOInstance {
+            String name;
+            // NONE if the instance has its own fields
+            uint32_t prototype;
+            uint32_t first_field, field_count;
+            // the instance's whole buffer, laid out by its fields
+            uint32_t data, size;
+        };
+
+        struct Vertex {
+            float position[2];
+            float color[3];
+            float uv[2];
+        };
+
+        struct VertexBuffer {
+            String name;
+            uint32_t data, count;
+        };
+
+        struct IndexBuffer {
+            String name;
+            // count 32 bit indices
+            uint32_t data, count;
+        };
+
+        struct PushConstant {
+            String name;
+            // vk::ShaderStageFlags
+            uint32_t stages;
+            uint32_t first_field, field_count, size;
+        };
+
+        struct Shader {
+            String name, file;
+            // vk::ShaderStageFlagBits
+            uint32_t stage;
+            uint32_t first_binding, binding_count;
+        };
+
+        struct ShaderBinding {
+            uint32_t kind;
+            // unused for push constants
+            uint32_t binding;
+            // the texture's name, which can be empty, the ubo's prototype,
+            // or the push constant
+            String name;
+        };
+
+    }
+
+    // Compiled game data, mapped straight from its file. The whole file is
+    // checked when it's opened, so nothing after that can read out of bounds,
+    // and every record and value is used where it is in the mapping.
+    class GameData {
+    private:
+
+        MappedFile file;
+
+        Loader::ByteView bytes;
+
+        Format::Header header;
+
+        Loader::ByteView sections[Format::eSectionCount];
+
+    public:
+
+        /**
+         * Maps and checks a compiled file
+         * @param path The file
+         */
+        GameData(const std::string & path);
+
+        GameData(const GameData & other) = delete;
+
+        Loader::Span<Format::Constant> getConstants() const {
+            return getTable<Format::Constant>(Format::eConstants);
+        }
+
+        Loader::Span<Format::UBOPrototype> getUBOPrototypes() const {
+            return getTable<Format::UBOPrototype>(Format::eUBOPrototypes);
+        }
+
+        Loader::Span<Format::UBOInstance> getUBOInstances() const {
+            return getTable<Format::UBOInstance>(Format::eUBOInstances);
+        }
+
+        Loader::Span<Format::VertexBuffer> getVertexBuffers() const {
+            return getTable<Format::VertexBuffer>(Format::eVertexBuffers);
+        }
+
+        Loader::Span<Format::IndexBuffer> getIndexBuffers() const {
+            return getTable<Format::IndexBuffer>(Format::eIndexBuffers);
+        }
+
+        Loader::Span<Format::PushConstant> getPushConstants() const {
+            return getTable<Format::PushConstant>(Format::ePushConstants);
+        }
+
+        Loader::Span<Format::Shader> getShaders() const {
+            return getTable<Format::Shader>(Format::eShaders);
+        }
+
+        /**
+         * @param str A string from any record
+         * @return The string, which is also null terminated
+         */
+        Loader::StringView getString(const Format::String & str) const {
+            return Loader::StringView(reinterpret_cast<const char*> (sections[Format::eStrings].data()) + str.offset, str.length);
+        }
+
+        /**
+         * @param first The first field
+         * @param count The number of fields
+         * @return The fields, in their buffer's order
+         */
+        Loader::Span<Format::Field> getFields(uint32_t first, uint32_t count) const {
+            return getTable<Format::Field>(Format::eFields).subspan(first, count);
+        }
+
+        Loader::Span<Format::ShaderBinding> getBindings(const Format::Shader & shader) const {
+            return getTable<Format::ShaderBinding>(Format::eShaderBindings).subspan(shader.first_binding, shader.binding_count);
+        }
+
+        /**
+         * @param offset An offset in the data section, from any record
+         * @param size The value's size
+         * @return The value, in place
+         */
+        Loader::ByteView getData(uint32_t offset, size_t size) const {
+            return sections[Format::eData].subview(offset, size);
+        }
+
+        /**
+         * @return The constant's values, which are floats or ints by its type
+         */
+        template<typename T>
+        Loader::Span<T> getValues(const Format::Constant & constant) const {
+            static_assert(sizeof (T) == 4, "Constants are 32 bit floats or ints");
+
+            return Loader::Span<T>::Of(getData(constant.data, constant.count * sizeof (T)));
+        }
+
+        /**
+         * @return The instance's buffer, ready to be uploaded
+         */
+        Loader::ByteView getBuffer(const Format::UBOInstance & instance) const {
+            return getData(instance.data, instance.size);
+        }
+
+        Loader::Span<Format::Vertex> getVertices(const Format::VertexBuffer & buffer) const {
+            return Loader::Span<Format::Vertex>::Of(getData(buffer.data, buffer.count * sizeof (Format::Vertex)));
+        }
+
+        Loader::Span<int32_t> getIndices(const Format::IndexBuffer & buffer) const {
+            return Loader::Span<int32_t>::Of(getData(buffer.data, buffer.count * sizeof (int32_t)));
+        }
+
+        /**
+         * Finds a named record
+         * @param table Any named table
+         * @param name The record's name
+         * @return The record, or null if there isn't one with the name
+         */
+        template<typename T>
+        const T * find(Loader::Span<T> table, Loader::StringView name) const {
+            // the tables are sorted by name
+            const T * record = std::lower_bound(table.begin(), table.end(), name,
+                    [this](const T & record, Loader::StringView name) {
+                        return getString(record.name) < name;
+                    });
+
+            if (record == table.end() || getString(record->name) != name) {
+                return nullptr;
+            }
+
+            return record;
+        }
+
+    private:
+
+        template<typename T>
+        Loader::Span<T> getTable(Format::Section section) const {
+            return Loader::Span<T>::Of(sections[section]);
+        }
+
+        /**
+         * Checks every record's references, throwing if anything is out of bounds
+         */
+        void validate(void) const;
+
+    };
+
+}
+
+#endif /* GAMEDATA_HPP */
@@ -0,0 +1,86 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   GameDataWriter.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 6:45 AM
+ */
+
+#ifndef GAMEDATAWRITER_HPP
+#define GAMEDATAWRITER_HPP
+
+#include "GameContext.hpp"
+#include "GameData.hpp"
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Game {
+
+    // Compiles parsed game files into the game data format. Any number of
+    // contexts can be added, and like in a context, a later definition
+    // replaces an earlier one with the same name.
+    class GameDataWriter {
+    private:
+
+        // the contexts have to outlive the writer, nothing is copied out of them
+        std::map<std::string, const Value*> constants;
+        std::map<std::string, const UBOPrototype*> uboprototypes;
+        std::map<std::string, const UBOInstance*> uboinstances;
+        std::map<std::string, const std::vector<VertexInfo>*> vertex_buffers;
+        std::map<std::string, const std::vector<int>*> index_buffers;
+        std::map<std::string, const PushConstantInfo*> push_constants;
+        std::map<std::string, const ShaderPrototype*> shaders;
+
+        std::vector<char> strings;
+        std::unordered_map<std::string, Format::String> interned;
+
+        std::vector<uint8_t> data;
+
+        std::vector<Format::Field> fields;
+
+    public:
+
+        /**
+         * @param context Parsed game files, which have to outlive the writer
+         */
+        void add(const GameContext & context);
+
+        /**
+         * Compiles everything added
+         * @param path The compiled file, which is replaced
+         * @return The compiled file's size
+         */
+        size_t write(ConstString path);
+
+    private:
+
+        /**
+         * @return The string's place in the string table, which only has one copy of each
+         */
+        Format::String intern(ConstString str);
+
+        /**
+         * Appends a value to the data section
+         * @return The value's offset
+         */
+        uint32_t append(const void * value, size_t size);
+
+        /**
+         * Appends a field list's fields
+         * @return The first field's index
+         */
+        uint32_t append(const FieldList & list);
+
+    };
+
+}
+
+#endif /* GAMEDATAWRITER_HPP */
@@ -0,0 +1,62 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   LayoutWriter.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 11:25 AM
+ */
+
+#ifndef LAYOUTWRITER_HPP
+#define LAYOUTWRITER_HPP
+
+#include "GameContext.hpp"
+
+#include <map>
+#include <string>
+
+namespace Game {
+
+    // Generates the game's ubo prototypes and push constants as C++ structs
+    // and glsl blocks, so both sides use the layouts the game files describe.
+    // The structs are padded to the glsl layout and check their offsets with
+    // static_asserts, and the glsl members are given explicit offsets, so a
+    // layout which doesn't match fails to compile on either side.
+    class LayoutWriter {
+    private:
+
+        // the contexts have to outlive the writer, like with GameDataWriter
+        std::map<std::string, const FieldList*> uboprototypes;
+        std::map<std::string, const FieldList*> push_constants;
+
+    public:
+
+        /**
+         * @param context Parsed game files, which have to outlive the writer
+         */
+        void add(const GameContext & context);
+
+        /**
+         * Writes the C++ header, with a struct for each ubo prototype and push constant
+         * @param path The header, which is only replaced if it changed
+         * @return Whether the header was replaced
+         */
+        bool writeHeader(ConstString path) const;
+
+        /**
+         * Writes the glsl include, with a block's members for each ubo prototype
+         * and push constant
+         * @param path The include, which is only replaced if it changed
+         * @return Whether the include was replaced
+         */
+        bool writeGLSL(ConstString path) const;
+
+    };
+
+}
+
+#endif /* LAYOUTWRITER_HPP */
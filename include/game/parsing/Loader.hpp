@@ -0,0 +1,400 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+/*
+ * File:   Loader.hpp
+ * Author: austin-z
+ *
+ * Created on October 18, 2026, 7:30 AM
+ */
+
+#ifndef LOADER_HPP
+#define LOADER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+// Views over binary data, usually a mapped file, which read it where it is.
+// Nothing here allocates or copies more than a scalar. Every read is bounds
+// checked and throws std::out_of_range instead of running off the end.
+namespace Loader {
+
+    enum class Endian {
+        eLittle,
+        eBig
+    };
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    static constexpr Endian NATIVE = Endian::eBig;
+#else
+    // msvc only targets little endian machines
+    static constexpr Endian NATIVE = Endian::eLittle;
+#endif
+
+    /**
+     * Reverses a scalar's bytes, which compilers turn into a single swap
+     * @param value The value
+     * @return The value in the other byte order
+     */
+    template<typename T>
+    T ByteSwap(T value) {
+        static_assert(std::is_trivially_copyable<T>::value, "Only scalars can be swapped");
+
+        uint8_t bytes[sizeof (T)];
+
+        memcpy(bytes, &value, sizeof (T));
+        std::reverse(bytes, bytes + sizeof (T));
+        memcpy(&value, bytes, sizeof (T));
+
+        return value;
+    }
+
+    /**
+     * Characters which aren't owned by the view, like std::string_view
+     */
+    class StringView {
+    private:
+        const char * first = nullptr;
+        size_t length = 0;
+
+    public:
+
+        StringView() {
+
+        }
+
+        StringView(const char * first, size_t length) : first(first), length(length) {
+
+        }
+
+        StringView(const char * str) : first(str), length(strlen(str)) {
+
+        }
+
+        StringView(const std::string & str) : first(str.data()), length(str.size()) {
+
+        }
+
+        const char * data() const {
+            return first;
+        }
+
+        size_t size() const {
+            return length;
+        }
+
+        bool empty() const {
+            return length == 0;
+        }
+
+        const char * begin() const {
+            return first;
+        }
+
+        const char * end() const {
+            return first + length;
+        }
+
+        char operator[](size_t index) const {
+            return first[index];
+        }
+
+        /**
+         * Orders views like std::string does, byte by byte
+         * @return Less than 0 if this comes first, 0 if they're equal
+         */
+        int compare(StringView other) const {
+            int order = length == 0 || other.length == 0 ? 0 : memcmp(first, other.first, std::min(length, other.length));
+
+            if (order != 0) {
+                return order;
+            }
+
+            return length < other.length ? -1 : (length > other.length ? 1 : 0);
+        }
+
+        bool operator==(StringView other) const {
+            return compare(other) == 0;
+        }
+
+        bool operator!=(StringView other) const {
+            return compare(other) != 0;
+        }
+
+        bool operator<(StringView other) const {
+            return compare(other) < 0;
+        }
+
+        /**
+         * Copies the characters, for when they have to outlive the buffer
+         */
+        std::string str() const {
+            return std::string(first, length);
+        }
+
+    };
+
+    /**
+     * Bytes which aren't owned by the view
+     */
+    class ByteView {
+    private:
+        const uint8_t * first = nullptr;
+        size_t length = 0;
+
+    public:
+
+        ByteView() {
+
+        }
+
+        ByteView(const void * data, size_t size) : first(static_cast<const uint8_t*> (data)), length(size) {
+
+        }
+
+        const uint8_t * data() const {
+            return first;
+        }
+
+        size_t size() const {
+            return length;
+        }
+
+        bool empty() const {
+            return length == 0;
+        }
+
+        /**
+         * @return Whether the range is in the view, without overflowing
+         */
+        bool contains(size_t offset, size_t count) const {
+            return offset <= length && count <= length - offset;
+        }
+
+        /**
+         * @param offset The first byte
+         * @param count The number of bytes
+         * @return The bytes, which have to be in this view
+         */
+        ByteView subview(size_t offset, size_t count) const {
+            if (!contains(offset, count)) {
+                throw std::out_of_range("Byte range " + std::to_string(offset) + "+" + std::to_string(count) +
+                        " is outside of a " + std::to_string(length) + " byte view");
+            }
+
+            return ByteView(first + offset, count);
+        }
+
+        ByteView subview(size_t offset) const {
+            return subview(offset, offset <= length ? length - offset : 0);
+        }
+
+    };
+
+    /**
+     * Records which aren't owned by the span, read in place. Only records
+     * stored in this machine's byte order can be viewed like this.
+     */
+    template<typename T>
+    class Span {
+    private:
+        static_assert(std::is_trivially_copyable<T>::value, "Only plain records can be viewed in place");
+
+        const T * first = nullptr;
+        size_t length = 0;
+
+    public:
+
+        Span() {
+
+        }
+
+        Span(const T * first, size_t length) : first(first), length(length) {
+
+        }
+
+        /**
+         * Views bytes as records
+         * @param bytes The bytes, which have to be aligned for T and a whole number of records
+         * @return The records
+         */
+        static Span<T> Of(ByteView bytes) {
+            if (bytes.size() % sizeof (T) != 0) {
+                throw std::out_of_range("View isn't a whole number of records");
+            }
+
+            if (reinterpret_cast<uintptr_t> (bytes.data()) % alignof (T) != 0) {
+                throw std::invalid_argument("View isn't aligned for its records");
+            }
+
+            return Span<T>(reinterpret_cast<const T*> (bytes.data()), bytes.size() / sizeof (T));
+        }
+
+        const T * data() const {
+            return first;
+        }
+
+        size_t size() const {
+            return length;
+        }
+
+        bool empty() const {
+            return length == 0;
+        }
+
+        const T * begin() const {
+            return first;
+        }
+
+        const T * end() const {
+            return first + length;
+        }
+
+        const T & operator[](size_t index) const {
+            return first[index];
+        }
+
+        const T & at(size_t index) const {
+            if (index >= length) {
+                throw std::out_of_range("Record " + std::to_string(index) + " is outside of a " +
+                        std::to_string(length) + " record span");
+            }
+
+            return first[index];
+        }
+
+        /**
+         * @param offset The first record
+         * @param count The number of records
+         * @return The records, which have to be in this span
+         */
+        Span<T> subspan(size_t offset, size_t count) const {
+            if (offset > length || count > length - offset) {
+                throw std::out_of_range("Record range " + std::to_string(offset) + "+" + std::to_string(count) +
+                        " is outside of a " + std::to_string(length) + " record span");
+            }
+
+            return Span<T>(first + offset, count);
+        }
+
+        ByteView bytes() const {
+            return ByteView(first, length * sizeof (T));
+        }
+
+    };
+
+    /**
+     * Reads through a view in order, in a fixed byte order
+     */
+    class Cursor {
+    private:
+        ByteView view;
+        size_t position = 0;
+        Endian endian;
+
+    public:
+
+        /**
+         * @param view The bytes
+         * @param endian The byte order scalars are stored in
+         */
+        Cursor(ByteView view, Endian endian = Endian::eLittle) : view(view), endian(endian) {
+
+        }
+
+        size_t getPosition() const {
+            return position;
+        }
+
+        size_t getRemaining() const {
+            return view.size() - position;
+        }
+
+        Endian getEndian() const {
+            return endian;
+        }
+
+        void seek(size_t position) {
+            if (position > view.size()) {
+                throw std::out_of_range("Cursor moved past the end of its view");
+            }
+
+            this->position = position;
+        }
+
+        void skip(size_t count) {
+            readBytes(count);
+        }
+
+        /**
+         * Skips to the next multiple of an alignment, from the view's start
+         */
+        void align(size_t alignment) {
+            seek((position + alignment - 1) / alignment * alignment);
+        }
+
+        /**
+         * Reads a scalar, swapping it if its byte order isn't the machine's
+         * @return The scalar
+         */
+        template<typename T>
+        T read() {
+            static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "Only scalars can be read");
+
+            T value;
+            memcpy(&value, readBytes(sizeof (T)).data(), sizeof (T));
+
+            return endian == NATIVE ? value : ByteSwap(value);
+        }
+
+        ByteView readBytes(size_t count) {
+            ByteView bytes = view.subview(position, count);
+
+            position += count;
+
+            return bytes;
+        }
+
+        /**
+         * Views the next records in place
+         * @param count The number of records
+         * @return The records, which have to be in the machine's byte order
+         */
+        template<typename T>
+        Span<T> readSpan(size_t count) {
+            if (sizeof (T) > 1 && endian != NATIVE) {
+                throw std::runtime_error("Records in another byte order can't be viewed in place");
+            }
+
+            if (count > getRemaining() / sizeof (T)) {
+                throw std::out_of_range("Span of " + std::to_string(count) + " records runs past the end of its view");
+            }
+
+            return Span<T>::Of(readBytes(count * sizeof (T)));
+        }
+
+        /**
+         * Reads a string stored as a 16 bit length and its characters
+         * @return The characters, in place
+         */
+        StringView readString() {
+            size_t length = read<uint16_t>();
+
+            ByteView chars = readBytes(length);
+
+            return StringView(reinterpret_cast<const char*> (chars.data()), length);
+        }
+
+    };
+
+}
+
+#endif /* LOADER_HPP */
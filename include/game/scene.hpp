@@ -15,73 +15,63 @@
 #define SCENE_HPP
 
 #include "VulkanRenderer.hpp"
+#include "VulkanIndirect.hpp"
+#include "VulkanParticles.hpp"
+#include "Profiler.hpp"
+#include "GameLayouts.hpp"
 
 #include <glm/glm.hpp>
 
 #include <list>
+#include <vector>
 #include <algorithm>
 
 #define _USE_MATH_DEFINES
 #include <math.h>
 
+// Used for pushing object information to the shader code. It's generated
+// from the 'game object' push constant in the game files, like the block in
+// shader.vert, so the two can't disagree on where a field goes.
+using GameLayouts::GameObjectPushConstant;
+
 /**
- * Converts from window space to game space (a centered square)
+ * Maps scene layers and mesh depths onto the depth buffer. Higher layers are
+ * closer, and within a layer so are higher mesh depths.
  */
-class CoordinateConverter {
-private:
-
-    glm::vec2 scale;
-    Window * window;
-
+class DepthLayers {
 public:
 
-    CoordinateConverter(Window & window) {
-        this->window = &window;
-        updateView();
-    }
-
-    void updateView(void) {
-        float w = (float) window->getWidth(), h = (float) window->getHeight();
-
-        float x = w - h;
-
-        float sx = x < 0 ? 1 : ((w - x) / w);
-
-        float y = h - w;
-
-        float sy = y < 0 ? 1 : ((h - y) / h);
-
-        scale = {sx, sy};
-
-    }
+    static constexpr int MESH_DEPTHS = 16, MAX_LAYERS = 64;
 
     /**
-     * Translates a point from world to screen space.
-     * @param p The point
-     * @return The screen space point
+     * @param layer The object's layer
+     * @param mesh The mesh's depth within the object
+     * @return The draw order, higher draws over lower
      */
-    glm::vec2 translatePoint(glm::vec2 p) {
-        return p * scale;
+    static int Order(int layer, int mesh) {
+        layer = std::min(std::max(layer, 0), MAX_LAYERS - 1);
+        mesh = std::min(std::max(mesh, 0), MESH_DEPTHS - 1);
+
+        return layer * MESH_DEPTHS + mesh;
     }
 
     /**
-     * Gets the calculated scaling factor
-     * @return The scaling factor
+     * @param order The draw order
+     * @return The depth, from 1 (far) to 0 (near)
      */
-    glm::vec2 getScale() {
-        return scale;
+    static float ToDepth(int order) {
+        return 1.0f - (order + 1) / (float) (MAX_LAYERS * MESH_DEPTHS + 1);
     }
 
 };
 
 /**
- * Used for pushing object information to the shader code
+ * One secondary buffer to execute, and where it sorts
  */
-struct GameObjectPushConstant {
-    glm::vec2 position;
-    glm::vec2 size;
-    float rotation;
-    glm::vec2 aspect;
+struct DrawInfo {
+    int order;
+    bool transparent;
+    vk::CommandBuffer buffer;
 };
 
 /**
@@ -110,6 +100,14 @@ struct _riproto {
     }
 };
 
+/**
+ * Internal struct for instances drawn by the gpu culling pass
+ */
+struct _iiproto {
+    int depth;
+    VulkanIndirectBatch * batch;
+};
+
 /**
  * Describes a game object
  */
@@ -119,6 +117,7 @@ struct GameObjectPrototype {
     float initRotation;
     int pcid;
     std::vector<_riproto> renderers;
+    std::vector<_iiproto> instances;
 
     GameObjectPrototype(glm::vec2 initPosition = {0, 0}, glm::vec2 initSize = {0, 0}, float initRotation = 0, int pcid = 0) :
     initPosition(initPosition), initSize(initSize), initRotation(initRotation), pcid(pcid) {
@@ -127,6 +126,16 @@ struct GameObjectPrototype {
     void addMesh(int depth, MaterialRendererBuilder * builder, Material * material, VulkanIndexBuffer * indexes) {
         renderers.push_back({depth, builder, material, indexes});
     }
+
+    /**
+     * Adds a mesh which is culled and drawn on the gpu, instead of having its
+     * own renderer
+     * @param depth The mesh's depth within the object
+     * @param batch The batch the mesh is drawn in
+     */
+    void addInstance(int depth, VulkanIndirectBatch * batch) {
+        instances.push_back({depth, batch});
+    }
 };
 
 /**
@@ -135,9 +144,18 @@ struct GameObjectPrototype {
  */
 class GameObject {
 private:
+
+    struct InstanceInfo {
+        int depth;
+        VulkanIndirectBatch * batch;
+        uint32_t slot;
+    };
+
     struct GameObjectPushConstant info;
-    std::list<struct RenderInfo> renderers;
+    std::vector<struct RenderInfo> renderers;
+    std::vector<struct InstanceInfo> instances;
     int pcid;
+    int layer = 0;
     bool visible = true;
 
     glm::vec2 position, size;
@@ -165,24 +183,41 @@ public:
         for (auto & mproto : prototype.renderers) {
             addMaterial(mproto.create());
         }
+
+        for (auto & iproto : prototype.instances) {
+            addInstance(iproto.batch, iproto.depth);
+        }
     }
 
-    void addMaterial(RenderInfo info) {
-        auto iter = renderers.begin();
-        while (iter != renderers.end() && iter->depth < info.depth) {
-            iter++;
+    GameObject(const GameObject & other) = delete;
+
+    // the batches' pass must still exist
+    ~GameObject() {
+        for (auto & e : instances) {
+            e.batch->release(e.slot);
         }
+    }
+
+    // the depth buffer orders the meshes, so they're kept in the order they were added
 
-        renderers.insert(iter, info);
+    void addMaterial(RenderInfo info) {
+        renderers.push_back(info);
     }
 
     void addMaterial(MaterialRenderer * material, int depth = 0) {
-        auto iter = renderers.begin();
-        while (iter != renderers.end() && iter->depth < depth) {
-            iter++;
-        }
+        renderers.push_back(RenderInfo(material, depth));
+    }
 
-        renderers.insert(iter, RenderInfo(material, depth));
+    void addInstance(VulkanIndirectBatch * batch, int depth = 0) {
+        instances.push_back({depth, batch, batch->acquire()});
+    }
+
+    /**
+     * Sets the layer this object is drawn in
+     * @param layer The layer
+     */
+    void setLayer(int layer) {
+        this->layer = layer;
     }
 
     /**
@@ -257,19 +292,28 @@ public:
     }
 
     /**
-     * Updates this object's push constants and descriptor sets.
+     * Updates this object's push constants and descriptor sets. Everything
+     * stays in world space, the camera moves it to the screen.
      * @param frame The current frame
-     * @param converter The coordinate converter
      */
-    void update(size_t frame, CoordinateConverter & converter) {
+    void update(size_t frame) {
+        for (auto & e : instances) {
+            struct IndirectInstance & instance = e.batch->getInstance(e.slot);
+
+            instance.position = position;
+            instance.size = size;
+            instance.rotation = rotation;
+            instance.depth = DepthLayers::ToDepth(DepthLayers::Order(layer, e.depth));
+            instance.active = visible ? 1 : 0;
+        }
+
         if (!visible) {
             return;
         }
 
-        info.position = converter.getScale() * position;
-        info.size = converter.getScale() * size;
+        info.position = position;
+        info.size = size;
         info.rotation = rotation;
-        info.aspect = converter.getScale();
 
         for (auto & e : renderers) {
             e.renderer->checkForUpdates(frame);
@@ -286,6 +330,8 @@ public:
         }
 
         for (auto & e : renderers) {
+            info.depth = DepthLayers::ToDepth(DepthLayers::Order(layer, e.depth));
+
             memcpy(e.renderer->getPushConstant(pcid).get(), &info, sizeof (info));
 
             e.renderer->recordFrame(frame);
@@ -294,16 +340,16 @@ public:
 
     /**
      * Gets the internal command buffers used in this object.
-     * @param buffers A reference to a buffer vector
+     * @param draws A reference to a draw vector
      * @param frame The current frame
      */
-    void getbuffers(std::vector<vk::CommandBuffer> & buffers, size_t frame) {
+    void getdraws(std::vector<struct DrawInfo> & draws, size_t frame) {
         if (!visible) {
             return;
         }
 
         for (auto & e : renderers) {
-            buffers.push_back(e.renderer->getBuffer(frame));
+            draws.push_back({DepthLayers::Order(layer, e.depth), e.renderer->isTransparent(), e.renderer->getBuffer(frame)});
         }
     }
 
@@ -394,6 +440,8 @@ public:
      * Handles all stored events
      */
     void handleEvents() {
+        PROFILE_SCOPE("EventManager::handleEvents");
+
         while (events.size() > 0) {
             QueuedEvent evt = events.front();
             events.pop_front();
@@ -656,12 +704,55 @@ private:
     // The next property id allocation
     PropertyHandle nextprop = 0;
 
+    // Reused by getbuffers
+    std::vector<struct DrawInfo> draws;
+
+    // Draws the objects' gpu instances, if any have them
+    VulkanCullPass * cullPass = nullptr;
+
+    // Simulates and draws the effects decorators emit, if there are any
+    VulkanParticleSystem * particles = nullptr;
+
 public:
 
     Scene() : eventmanager(this) {
 
     }
 
+    /**
+     * Sets the pass which culls and draws the objects' instances
+     * @param pass The pass, or null for none
+     */
+    void setCullPass(VulkanCullPass * pass) {
+        cullPass = pass;
+    }
+
+    /**
+     * Sets the particle system decorators emit effects into
+     * @param particles The system, or null for none
+     */
+    void setParticles(VulkanParticleSystem * particles) {
+        this->particles = particles;
+    }
+
+    /**
+     * @return The particle system, or null if effects aren't drawn
+     */
+    VulkanParticleSystem * getParticles(void) {
+        return particles;
+    }
+
+    /**
+     * Spawns particles if the scene has a particle system, and does nothing
+     * otherwise
+     * @param emitter The emitter
+     */
+    void emitParticles(const struct ParticleEmitter & emitter) {
+        if (particles) {
+            particles->emit(emitter);
+        }
+    }
+
     /**
      * Adds an object to this scene
      * @param object The object
@@ -671,7 +762,9 @@ public:
     ObjectHandle addObject(std::shared_ptr<GameObject> object, int depth = 0) {
         ObjectInfo * info = new ObjectInfo(nextid++, depth, object);
 
-        objects.insert_sorted(info);
+        object->setLayer(depth);
+
+        objects.insert(info);
 
         return info->id;
     }
@@ -963,24 +1056,37 @@ public:
     /**
      * Updates all objects
      * @param frame The current frame
-     * @param converter The world-to-screen converter
      * @param deltat The time since last frame in seconds
      */
-    void updateObjects(size_t frame, CoordinateConverter & converter, double deltat) {
-        for (auto & decorator : decorators.objects) {
-            decorator->decorator->Apply(this, deltat);
+    void updateObjects(size_t frame, double deltat) {
+        PROFILE_SCOPE("Scene::updateObjects");
+
+        {
+            PROFILE_SCOPE("scene decorators");
+
+            for (auto & decorator : decorators.objects) {
+                PROFILE_SCOPE_TYPE(*decorator->decorator);
+
+                decorator->decorator->Apply(this, deltat);
+            }
         }
 
         eventmanager.handleEvents();
-        converter.updateView();
+
+        if (particles) {
+            particles->update(deltat);
+        }
+
+        PROFILE_SCOPE("object decorators");
 
         for (auto & object : objects.objects) {
             for (auto & decorator : object.get()->decorators.objects) {
+                PROFILE_SCOPE_TYPE(*decorator->decorator);
 
                 decorator->decorator->Apply(this, object->id, deltat);
             }
 
-            object->object->update(frame, converter);
+            object->object->update(frame);
         }
 
     }
@@ -990,20 +1096,59 @@ public:
      * @param frame The frame
      */
     void record(size_t frame) {
+        PROFILE_SCOPE("Scene::record");
+
         for (auto & object : objects.objects) {
 
             object->object->record(frame);
         }
+
+        if (cullPass) {
+            cullPass->record(frame);
+        }
+
+        if (particles) {
+            particles->record(frame);
+        }
     }
 
     /**
-     * Gets all used buffers in this scene
+     * Gets all used buffers in this scene. Opaque draws come first, front to
+     * back so the depth test rejects what's hidden, then blended draws back
+     * to front.
      * @param buffers The buffer vector
      * @param frame The frame
      */
     void getbuffers(std::vector<vk::CommandBuffer> & buffers, size_t frame) {
+        draws.clear();
+
         for (auto & object : objects.objects) {
-            object->object->getbuffers(buffers, frame);
+            object->object->getdraws(draws, frame);
+        }
+
+        if (cullPass) {
+            for (auto & batch : cullPass->getBatches()) {
+                if (batch->count() > 0) {
+                    draws.push_back({batch->getOrder(), batch->isTransparent(), batch->getBuffer()});
+                }
+            }
+        }
+
+        // not recorded when no particle could be alive
+        if (particles && particles->getBuffer()) {
+            draws.push_back({particles->getOrder(), particles->isTransparent(), particles->getBuffer()});
+        }
+
+        std::stable_sort(draws.begin(), draws.end(), [](const DrawInfo & a, const DrawInfo & b) {
+            if (a.transparent != b.transparent) {
+                return !a.transparent;
+            }
+
+            return a.transparent ? a.order < b.order : a.order > b.order;
+        });
+
+        for (auto & draw : draws) {
+            buffers.push_back(draw.buffer);
         }
     }
 
@@ -1,18 +1,23 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive : require
+
+// generated from the game files by game_data_compiler
+#include "GameLayouts.glsl"
 
 layout(location = 0) in vec3 fragColor;
 
 layout(location = 0) out vec4 outColor;
 
 layout(binding = 0) uniform ChromaKey {
-    vec4 search_col;
-    vec4 replace_col;
-    float epsilon1, epsilon2;
+    CHROMA_KEY_UBO
 } key;
 
 layout(binding = 1) uniform sampler2D sprite;
 
+// opaque materials discard what they would have blended away
+layout(constant_id = 0) const float ALPHA_CUTOFF = 0.0;
+
 bool within(vec3 median, float range, vec3 x) {
     return all(greaterThanEqual(x, median - range)) && all(lessThanEqual(x, median + range));
 }
@@ -38,12 +43,15 @@ vec3 hsv2rgb(vec3 c)
 void main() {
 	vec4 tex = texture(sprite, vec2(1 - fragColor.x, fragColor.y));
     
-	float d = distance(tex, key.search_col);
+	float d = distance(tex, key.search);
 	
 	float a = max(d - key.epsilon1, 0) / (key.epsilon2 - key.epsilon1);
 	
 	a = min(a, 1);
 	
-	outColor = tex - key.search_col * (1-a);
-	
+	outColor = tex - key.search * (1-a);
+
+    if (outColor.a <= ALPHA_CUTOFF) {
+        discard;
+    }
 }
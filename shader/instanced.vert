@@ -0,0 +1,49 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec2 vertPos;
+layout(location = 1) in vec3 vertColor;
+layout(location = 2) in vec2 vertUV;
+
+layout(location = 0) out vec3 fragColor;
+
+struct Instance {
+    vec2 position;
+    vec2 size;
+    float rotation;
+    float depth;
+    uint batch;
+    uint active;
+};
+
+layout(set = 1, binding = 0) uniform Camera {
+    mat4 viewProjection;
+} camera;
+
+layout(set = 2, binding = 0) readonly buffer Instances {
+    Instance instances[];
+};
+
+layout(set = 2, binding = 1) readonly buffer Visible {
+    uint visible[];
+};
+
+layout(push_constant) uniform BatchInfo {
+    uint first;
+} batch;
+
+mat2 rotation(float a) {
+    float s = sin(a);
+    float c = cos(a);
+    mat2 m = mat2(c, s, -s, c);
+    return m;
+}
+
+void main() {
+    Instance instance = instances[visible[batch.first + gl_InstanceIndex]];
+
+    vec2 pos = rotation(instance.rotation) * vertPos * instance.size + instance.position;
+
+    gl_Position = vec4((camera.viewProjection * vec4(pos, 0.0, 1.0)).xy, instance.depth, 1.0);
+    fragColor = vec3(vertUV, 0);
+}
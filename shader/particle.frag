@@ -0,0 +1,21 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec4 fragColor;
+layout(location = 1) in vec2 fragUV;
+
+layout(location = 0) out vec4 outColor;
+
+// opaque materials discard what they would have blended away
+layout(constant_id = 0) const float ALPHA_CUTOFF = 0.0;
+
+void main() {
+    // a soft dot, fading out towards the quad's edge
+    float d = length(fragUV - vec2(0.5)) * 2;
+
+    outColor = vec4(fragColor.rgb, fragColor.a * (1 - smoothstep(0.5, 1.0, d)));
+
+    if (outColor.a <= ALPHA_CUTOFF) {
+        discard;
+    }
+}
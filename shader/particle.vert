@@ -0,0 +1,52 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec2 vertPos;
+layout(location = 1) in vec3 vertColor;
+layout(location = 2) in vec2 vertUV;
+
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec2 fragUV;
+
+struct Particle {
+    vec2 position;
+    vec2 velocity;
+    vec4 color;
+    vec4 endColor;
+    float age;
+    float life;
+    float size;
+    float endSize;
+    float drag;
+    float padding0;
+    float padding1;
+    float padding2;
+};
+
+layout(set = 1, binding = 0) uniform Camera {
+    mat4 viewProjection;
+} camera;
+
+layout(set = 2, binding = 0) readonly buffer Particles {
+    Particle particles[];
+};
+
+layout(set = 2, binding = 1) readonly buffer Visible {
+    uint visible[];
+};
+
+layout(push_constant) uniform ParticleInfo {
+    float depth;
+} info;
+
+void main() {
+    Particle particle = particles[visible[gl_InstanceIndex]];
+
+    float t = particle.age / particle.life;
+
+    vec2 pos = vertPos * mix(particle.size, particle.endSize, t) + particle.position;
+
+    gl_Position = vec4((camera.viewProjection * vec4(pos, 0.0, 1.0)).xy, info.depth, 1.0);
+    fragColor = mix(particle.color, particle.endColor, t);
+    fragUV = vertUV;
+}
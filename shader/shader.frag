@@ -7,6 +7,13 @@ layout(location = 0) out vec4 outColor;
 
 layout(binding = 1) uniform sampler2D sprite;
 
+// opaque materials discard what they would have blended away
+layout(constant_id = 0) const float ALPHA_CUTOFF = 0.0;
+
 void main() {
     outColor = texture(sprite, vec2(1 - fragColor.x, fragColor.y));
+
+    if (outColor.a <= ALPHA_CUTOFF) {
+        discard;
+    }
 }
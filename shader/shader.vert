@@ -1,5 +1,9 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive : require
+
+// generated from the game files by game_data_compiler
+#include "GameLayouts.glsl"
 
 layout(location = 0) in vec2 vertPos;
 layout(location = 1) in vec3 vertColor;
@@ -7,11 +11,13 @@ layout(location = 2) in vec2 vertUV;
 
 layout(location = 0) out vec3 fragColor;
 
+layout(set = 1, binding = 0) uniform Camera {
+    mat4 viewProjection;
+} camera;
+
+// in world space, the camera moves it to the screen
 layout(push_constant) uniform ObjectInfo {
-    vec2 position;
-    vec2 size;
-    float rotation;
-    vec2 aspect;
+    GAME_OBJECT_PUSH_CONSTANT
 } info;
 
 //https://gist.github.com/yiwenl/3f804e80d0930e34a0b33359259b556c
@@ -25,6 +31,6 @@ mat2 rotation(float a) {
 void main() {
     vec2 pos = rotation(info.rotation) * vertPos * info.size + info.position;
 
-    gl_Position = vec4(pos, 0.0, 1.0);
+    gl_Position = vec4((camera.viewProjection * vec4(pos, 0.0, 1.0)).xy, info.depth, 1.0);
     fragColor = vec3(vertUV, 0);
 }
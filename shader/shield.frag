@@ -1,5 +1,9 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive : require
+
+// generated from the game files by game_data_compiler
+#include "GameLayouts.glsl"
 
 float radius = 0.3, threshold = 0.02, post = 0.005, stability = 20.0, deviation = 0.001;
 vec3 color = vec3(0.25, 0.5, 0.75);
@@ -10,9 +14,7 @@ layout(location = 0) in vec3 fragColor;
 layout(location = 0) out vec4 outColor;
 
 layout(binding = 0) uniform ChromaKey {
-    vec4 search_col;
-    vec4 replace_col;
-    float epsilon1, epsilon2;
+    CHROMA_KEY_UBO
 } key;
 
 // 1 on edges, 0 in middle
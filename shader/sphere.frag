@@ -5,26 +5,20 @@ layout(location = 0) in vec3 fragColor;
 
 layout(location = 0) out vec4 outColor;
 
-layout(binding = 0) uniform ChromaKey {
-    vec4 search_col;
-    vec4 replace_col;
-    float epsilon1, epsilon2;
-} key;
-
 layout(binding = 1) uniform sampler2D sprite;
 
+// opaque materials discard what they would have blended away
+layout(constant_id = 0) const float ALPHA_CUTOFF = 0.0;
+
 void main() {
     vec2 uv = vec2(1 - fragColor.x, fragColor.y);
 
-    vec4 tex = texture(sprite, uv);
-
-    float d = distance(tex, key.search_col);
-
-    float a = max(d - key.epsilon1, 0) / (key.epsilon2 - key.epsilon1);
-
-    a = min(a, 1);
+    // the chroma key is already baked into the texture's alpha
+    vec4 col = texture(sprite, uv);
 
-    vec4 col = tex - key.search_col * (1-a);
+    if (col.a <= ALPHA_CUTOFF) {
+        discard;
+    }
 
     // the 0 .. 1 direction-ness of the sun
     // power of 3 to increase constrast at equator but keep the sign
@@ -12,11 +12,34 @@ list(APPEND HEADER_FILES
 "include/VulkanDepthBuffer.hpp"
 "include/VulkanInst.hpp"
 "include/VulkanImage.hpp"
+"include/VulkanText.hpp"
+"include/PixelKernels.hpp"
+"include/FramePacing.hpp"
+"include/VulkanProfiler.hpp"
+"include/Profiler.hpp"
 "include/VulkanRenderPass.hpp"
+"include/VulkanOffscreen.hpp"
+"include/VulkanHeadless.hpp"
 "include/VulkanDescriptor.hpp"
 "include/VulkanVertex.hpp"
+"include/VulkanGeometry.hpp"
+"include/VulkanCamera.hpp"
+"include/VulkanIndirect.hpp"
+"include/VulkanParticles.hpp"
 "include/VulkanBuffer.hpp"
+"include/VulkanControllerBase.hpp"
 "include/VulkanController.hpp"
+"include/VulkanHotReload.hpp"
+"include/FileWatcher.hpp"
+"include/SpscQueue.hpp"
+"include/AudioBackend.hpp"
+"include/IrrKlangBackend.hpp"
+"include/AudioMixer.hpp"
+"include/MixKernels.hpp"
+"include/WavFile.hpp"
+"include/MappedFile.hpp"
+"include/ThreadPool.hpp"
+"include/GpuStruct.hpp"
 "include/game/scene.hpp"
 "include/game/ObjectControllers.hpp"
 "include/game/Menu.hpp"
@@ -25,7 +48,15 @@ list(APPEND HEADER_FILES
 "include/game/ScoreControllers.hpp"
 "include/game/ControllerHelpers.hpp"
 "include/game/SoundSystem.hpp"
-#"include/game/parsing/GameContext.hpp"
+"include/game/SoundBank.hpp"
+"include/game/VoiceManager.hpp"
+"include/game/parsing/GameData.hpp"
+"include/game/parsing/Loader.hpp"
+# the game only parses yaml to hot reload the game files, writing is left to game_data_compiler
+"include/game/parsing/GameContext.hpp"
+"include/game/parsing/DocumentCache.hpp"
+#"include/game/parsing/GameDataWriter.hpp"
+#"include/game/parsing/LayoutWriter.hpp"
 )
 
 list(APPEND SOURCE_FILES
@@ -33,12 +64,38 @@ list(APPEND SOURCE_FILES
 "src/main.cpp"
 "src/ObjectController.cpp"
 "src/helpers/VulkanRenderPass.cpp"
+"src/helpers/VulkanOffscreen.cpp"
 "src/helpers/VulkanShader.cpp"
 "src/helpers/VulkanRenderPipeline.cpp"
 "src/helpers/VulkanCommandBuffer.cpp"
+"src/helpers/VulkanGeometry.cpp"
+"src/helpers/VulkanCamera.cpp"
+"src/helpers/VulkanIndirect.cpp"
+"src/helpers/VulkanParticles.cpp"
 "src/helpers/VulkanDescriptor.cpp"
 "src/helpers/VulkanSingleCommand.cpp"
 "src/helpers/VulkanDepthBuffer.cpp"
 "src/helpers/VulkanImage.cpp"
-#"src/helpers/GameContext.cpp"
+"src/helpers/VulkanText.cpp"
+"src/helpers/PixelKernels.cpp"
+"src/helpers/FramePacing.cpp"
+"src/helpers/VulkanProfiler.cpp"
+"src/helpers/VulkanHotReload.cpp"
+"src/helpers/FileWatcher.cpp"
+"src/helpers/Profiler.cpp"
+"src/helpers/AudioBackend.cpp"
+"src/helpers/IrrKlangBackend.cpp"
+"src/helpers/AudioMixer.cpp"
+"src/helpers/MixKernels.cpp"
+"src/helpers/WavFile.cpp"
+"src/helpers/MappedFile.cpp"
+"src/helpers/ThreadPool.cpp"
+"src/helpers/SoundBank.cpp"
+"src/helpers/SoundSystem.cpp"
+"src/helpers/VoiceManager.cpp"
+"src/helpers/GameData.cpp"
+"src/helpers/GameContext.cpp"
+"src/helpers/DocumentCache.cpp"
+#"src/helpers/GameDataWriter.cpp"
+#"src/helpers/LayoutWriter.cpp"
 )
@@ -3,4 +3,6 @@
 
 int GLFWManager::instances = 0;
 
+std::map<GLFWwindow*, Window*> Window::windows;
+
 std::map<GLFWwindow*, InputHandler*> InputHandler::handlers;
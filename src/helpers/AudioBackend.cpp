@@ -0,0 +1,52 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+#include <cstddef>
+#include <iostream>
+#include <stdexcept>
+
+#include "AudioBackend.hpp"
+#include "AudioMixer.hpp"
+#include "IrrKlangBackend.hpp"
+
+namespace {
+
+    bool EndsWith(const std::string & str, const std::string & suffix) {
+        return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    // plain new only aligns to max_align_t before C++17, the backends are made with it below
+    static_assert(alignof (MixerBackend) <= alignof (std::max_align_t), "MixerBackend can't be over-aligned");
+
+}
+
+AudioBackend * AudioBackend::Create(const std::string & name) {
+    if (name == "irrklang") {
+        return new IrrKlangBackend();
+    }
+
+    if (name == "mixer") {
+        return new MixerBackend(new NullAudioOutput());
+    }
+
+    if (EndsWith(name, ".wav")) {
+        const uint32_t rate = 48000;
+
+        return new MixerBackend(new WavAudioOutput(name, rate), rate);
+    }
+
+    if (!name.empty()) {
+        throw std::runtime_error("Unknown audio backend " + name);
+    }
+
+    try {
+        return new IrrKlangBackend();
+    } catch (std::runtime_error & e) {
+        std::cerr << e.what() << ", mixing without output instead" << std::endl;
+
+        return new MixerBackend(new NullAudioOutput());
+    }
+}
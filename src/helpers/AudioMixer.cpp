@@ -0,0 +1,560 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include "AudioMixer.hpp"
+#include "MixKernels.hpp"
+
+namespace {
+
+    const float QUARTER_PI = 0.785398163f;
+
+    // past the last frame, so interpolation never reads out of bounds
+    const size_t CLIP_PADDING = 2;
+
+    // frames decoded at once while loading
+    const size_t LOAD_FRAMES = 4096;
+
+}
+
+constexpr size_t SoftwareMixer::BLOCK_FRAMES;
+constexpr size_t MixerStream::CAPACITY;
+constexpr size_t MixerStream::CHUNK_FRAMES;
+constexpr size_t MixerStream::PADDING;
+constexpr int MixerBackend::STREAM_IDLE_MILLISECONDS;
+
+MixerClip * MixerClip::Load(const std::string & path, double streamThreshold) {
+    WavReader reader(path);
+
+    std::unique_ptr<MixerClip> clip(new MixerClip());
+
+    clip->rate = reader.getSampleRate();
+    clip->channels = std::min<uint32_t>(reader.getChannels(), 2);
+    clip->frames = reader.getFrames();
+    clip->path = path;
+
+    if (clip->rate > 0 && static_cast<double> (clip->frames) / clip->rate > streamThreshold) {
+        clip->streamed = true;
+
+        return clip.release();
+    }
+
+    clip->left.assign(clip->frames + CLIP_PADDING, 0.0f);
+
+    if (clip->isStereo()) {
+        clip->right.assign(clip->frames + CLIP_PADDING, 0.0f);
+    }
+
+    uint32_t stride = reader.getChannels();
+
+    std::vector<float> interleaved(LOAD_FRAMES * stride);
+
+    size_t position = 0, read;
+
+    while ((read = reader.read(interleaved.data(), LOAD_FRAMES)) > 0) {
+        for (size_t i = 0; i < read; i++) {
+            clip->left[position + i] = interleaved[i * stride];
+
+            if (clip->isStereo()) {
+                clip->right[position + i] = interleaved[i * stride + 1];
+            }
+        }
+
+        position += read;
+    }
+
+    // a truncated file is shorter than its header says
+    clip->frames = position;
+
+    return clip.release();
+}
+
+size_t MixerClip::getSize(void) const {
+    if (streamed) {
+        return MixerStream::CAPACITY * channels * sizeof (float);
+    }
+
+    return (left.capacity() + right.capacity()) * sizeof (float);
+}
+
+MixerStream::MixerStream(const MixerClip * clip, bool looped) :
+path(clip->path), stereo(clip->isStereo()), looped(looped), left(CAPACITY),
+written(0), released(0), ended(false), closed(false) {
+    if (stereo) {
+        right.resize(CAPACITY);
+    }
+}
+
+bool MixerStream::fill(void) {
+    if (isEnded()) {
+        return false;
+    }
+
+    if (!reader) {
+        try {
+            reader.reset(new WavReader(path));
+        } catch (std::runtime_error & e) {
+            // the voice ends without playing anything
+            ended.store(true, std::memory_order_release);
+            return false;
+        }
+
+        interleaved.resize(CHUNK_FRAMES * reader->getChannels());
+    }
+
+    uint64_t w = written.load(std::memory_order_relaxed);
+
+    // always leaves room for the padding, so the end is written in one go
+    if (CAPACITY - (w - released.load(std::memory_order_acquire)) < CHUNK_FRAMES + PADDING) {
+        return false;
+    }
+
+    size_t count = reader->read(interleaved.data(), CHUNK_FRAMES);
+
+    if (count == 0 && looped && reader->getPosition() > 0) {
+        reader->rewind();
+        count = reader->read(interleaved.data(), CHUNK_FRAMES);
+    }
+
+    uint32_t stride = reader->getChannels();
+    const size_t mask = CAPACITY - 1;
+
+    for (size_t i = 0; i < count; i++) {
+        size_t slot = (w + i) & mask;
+
+        left[slot] = interleaved[i * stride];
+
+        if (stereo) {
+            right[slot] = interleaved[i * stride + 1];
+        }
+    }
+
+    w += count;
+
+    bool end = count == 0;
+
+    if (end) {
+        for (size_t i = 0; i < PADDING; i++) {
+            left[(w + i) & mask] = 0;
+
+            if (stereo) {
+                right[(w + i) & mask] = 0;
+            }
+        }
+
+        w += PADDING;
+    }
+
+    written.store(w, std::memory_order_release);
+
+    if (end) {
+        ended.store(true, std::memory_order_release);
+    }
+
+    return true;
+}
+
+void MixerStream::copy(uint64_t first, size_t count, float * left, float * right) const {
+    size_t start = first & (CAPACITY - 1);
+
+    // the frames wrap around the end of the ring at most once
+    size_t head = std::min(count, CAPACITY - start);
+
+    memcpy(left, &this->left[start], head * sizeof (float));
+    memcpy(left + head, &this->left[0], (count - head) * sizeof (float));
+
+    if (stereo) {
+        memcpy(right, &this->right[start], head * sizeof (float));
+        memcpy(right + head, &this->right[0], (count - head) * sizeof (float));
+    }
+}
+
+SoftwareMixer::SoftwareMixer(uint32_t rate) : rate(rate), scratchLeft(BLOCK_FRAMES), scratchRight(BLOCK_FRAMES) {
+
+}
+
+SoftwareMixer::~SoftwareMixer() {
+    clear();
+}
+
+void SoftwareMixer::play(const MixerClip * clip, const struct AudioVoiceParams & params, uint64_t id,
+        MixerStream * stream) {
+    struct Voice voice;
+
+    voice.id = id;
+    voice.clip = clip;
+    voice.stream = stream;
+    voice.position = 0;
+    voice.step = static_cast<float> (clip->rate) / rate * params.pitch;
+    voice.params = params;
+
+    voices.push_back(voice);
+}
+
+bool SoftwareMixer::stop(uint64_t id) {
+    for (size_t i = 0; i < voices.size(); i++) {
+        if (voices[i].id == id) {
+            remove(i);
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void SoftwareMixer::clear(void) {
+    while (!voices.empty()) {
+        remove(voices.size() - 1);
+    }
+}
+
+void SoftwareMixer::remove(size_t index) {
+    if (voices[index].stream) {
+        voices[index].stream->close();
+    }
+
+    // the order doesn't matter, so the last voice fills the gap
+    voices[index] = voices.back();
+    voices.pop_back();
+}
+
+void SoftwareMixer::mix(float * out, size_t frames, std::vector<uint64_t> & finished) {
+    memset(out, 0, frames * 2 * sizeof (float));
+
+    size_t i = 0;
+
+    while (i < voices.size()) {
+        if (mixVoice(voices[i], out, frames)) {
+            finished.push_back(voices[i].id);
+
+            remove(i);
+        } else {
+            i++;
+        }
+    }
+}
+
+bool SoftwareMixer::mixVoice(struct Voice & voice, float * out, size_t frames) {
+    const MixerClip * clip = voice.clip;
+    const struct AudioVoiceParams & params = voice.params;
+
+    if (clip->frames == 0 || voice.step <= 0) {
+        return true;
+    }
+
+    float gain = params.volume, pan = 0;
+
+    if (params.positional) {
+        float dx = params.x - listenerX, dy = params.y - listenerY;
+
+        gain /= 1 + std::sqrt(dx * dx + dy * dy);
+        pan = std::min(std::max(dx, -1.0f), 1.0f);
+    }
+
+    // constant power panning, so a centred voice isn't louder than a panned one
+    float angle = (pan + 1) * QUARTER_PI;
+    float leftGain = gain * std::cos(angle), rightGain = gain * std::sin(angle);
+
+    if (voice.stream) {
+        return mixStream(voice, out, frames, leftGain, rightGain);
+    }
+
+    size_t done = 0;
+
+    while (done < frames) {
+        if (voice.position >= clip->frames) {
+            if (!params.looped) {
+                return true;
+            }
+
+            voice.position = std::fmod(voice.position, static_cast<double> (clip->frames));
+        }
+
+        // stops at the end of the clip, which is never 0 frames away
+        size_t remaining = static_cast<size_t> (std::ceil((clip->frames - voice.position) / voice.step));
+        size_t count = std::min(std::min(frames - done, BLOCK_FRAMES), remaining);
+
+        MixKernels::Resample(clip->left.data(), voice.position, voice.step, scratchLeft.data(), count);
+
+        if (clip->isStereo()) {
+            MixKernels::Resample(clip->right.data(), voice.position, voice.step, scratchRight.data(), count);
+        }
+
+        MixKernels::MixStereo(scratchLeft.data(), clip->isStereo() ? scratchRight.data() : scratchLeft.data(),
+                leftGain, rightGain, out + done * 2, count);
+
+        voice.position += count * static_cast<double> (voice.step);
+        done += count;
+    }
+
+    return !params.looped && voice.position >= clip->frames;
+}
+
+bool SoftwareMixer::mixStream(struct Voice & voice, float * out, size_t frames, float leftGain, float rightGain) {
+    const MixerClip * clip = voice.clip;
+    MixerStream * stream = voice.stream;
+    const bool looped = voice.params.looped;
+
+    // stays silent, without moving, until the first chunk is in
+    if (!stream->isReady()) {
+        return false;
+    }
+
+    size_t done = 0;
+
+    while (done < frames) {
+        if (!looped && voice.position >= clip->frames) {
+            return true;
+        }
+
+        size_t count = std::min(frames - done, BLOCK_FRAMES);
+
+        if (!looped) {
+            size_t remaining = static_cast<size_t> (std::ceil((clip->frames - voice.position) / voice.step));
+            count = std::min(count, remaining);
+        }
+
+        // the frames interpolated, plus one in case the last position rounds up
+        uint64_t first = static_cast<uint64_t> (voice.position);
+        double offset = voice.position - first;
+        size_t needed = static_cast<size_t> (offset + (count - 1) * static_cast<double> (voice.step)) + 3;
+
+        if (stream->getWritten() < first + needed) {
+            // a file shorter than its header just ends early
+            if (stream->isEnded()) {
+                return true;
+            }
+
+            // the rest of the block is skipped, rather than played late
+            underruns++;
+            return false;
+        }
+
+        if (windowLeft.size() < needed) {
+            windowLeft.resize(needed);
+            windowRight.resize(needed);
+        }
+
+        stream->copy(first, needed, windowLeft.data(), windowRight.data());
+
+        MixKernels::Resample(windowLeft.data(), offset, voice.step, scratchLeft.data(), count);
+
+        if (clip->isStereo()) {
+            MixKernels::Resample(windowRight.data(), offset, voice.step, scratchRight.data(), count);
+        }
+
+        MixKernels::MixStereo(scratchLeft.data(), clip->isStereo() ? scratchRight.data() : scratchLeft.data(),
+                leftGain, rightGain, out + done * 2, count);
+
+        voice.position += count * static_cast<double> (voice.step);
+        done += count;
+
+        stream->release(static_cast<uint64_t> (voice.position));
+    }
+
+    return !looped && voice.position >= clip->frames;
+}
+
+void WavAudioOutput::write(const float * samples, size_t frames) {
+    converted.resize(frames * 2);
+
+    MixKernels::ToInt16(samples, converted.data(), frames * 2);
+
+    writer.write(converted.data(), frames);
+}
+
+MixerBackend::MixerBackend(AudioOutput * output, uint32_t rate, size_t blockFrames) :
+mixer(rate), output(output), blockFrames(blockFrames), commands(COMMAND_QUEUE_SIZE), running(true),
+newStreams(COMMAND_QUEUE_SIZE), streaming(true) {
+    thread = std::thread(&MixerBackend::Run, this);
+    streamThread = std::thread(&MixerBackend::RunStreams, this);
+}
+
+MixerBackend::~MixerBackend() {
+    running = false;
+    thread.join();
+
+    // frees clips which were unloaded after the last block
+    struct Command command;
+
+    while (commands.pop(command)) {
+        execute(command);
+    }
+
+    // closes every stream, which are all freed below
+    mixer.clear();
+
+    streaming = false;
+    streamThread.join();
+
+    MixerStream * stream;
+
+    while (newStreams.pop(stream)) {
+        streams.push_back(stream);
+    }
+
+    for (MixerStream * stream : streams) {
+        delete stream;
+    }
+}
+
+AudioClip * MixerBackend::loadClip(const std::string & path, double streamThreshold) {
+    return MixerClip::Load(path, streamThreshold);
+}
+
+void MixerBackend::unloadClip(AudioClip * clip) {
+    struct Command command;
+    command.type = Command::Type::eUnload;
+    command.clip = static_cast<MixerClip*> (clip);
+
+    // freed by the mixing thread, after it's seen every stop queued before this
+    push(command);
+}
+
+bool MixerBackend::play(AudioClip * clip, const struct AudioVoiceParams & params, uint64_t id) {
+    struct Command command;
+    command.type = Command::Type::ePlay;
+    command.id = id;
+    command.clip = static_cast<MixerClip*> (clip);
+    command.stream = nullptr;
+    command.params = params;
+
+    if (!command.clip->streamed) {
+        return commands.push(command);
+    }
+
+    command.stream = new MixerStream(command.clip, params.looped);
+
+    if (!commands.push(command)) {
+        delete command.stream;
+        return false;
+    }
+
+    // the voice can start before the streaming thread has this, it's just silent until then
+    while (!newStreams.push(command.stream)) {
+        std::this_thread::yield();
+    }
+
+    return true;
+}
+
+void MixerBackend::stop(uint64_t id) {
+    struct Command command;
+    command.type = Command::Type::eStop;
+    command.id = id;
+
+    push(command);
+}
+
+void MixerBackend::setListener(float x, float y) {
+    struct Command command;
+    command.type = Command::Type::eListener;
+    command.params.x = x;
+    command.params.y = y;
+
+    push(command);
+}
+
+void MixerBackend::Run(void) {
+    const uint32_t rate = mixer.getSampleRate();
+
+    std::vector<float> block(blockFrames * 2);
+    std::vector<uint64_t> finished;
+
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(static_cast<double> (blockFrames) / rate));
+
+    auto deadline = std::chrono::steady_clock::now();
+
+    while (running.load(std::memory_order_acquire)) {
+        struct Command command;
+
+        while (commands.pop(command)) {
+            execute(command);
+        }
+
+        finished.clear();
+
+        mixer.mix(block.data(), blockFrames, finished);
+
+        AudioStopListener * listener = stopListener.load();
+
+        for (uint64_t id : finished) {
+            if (listener) {
+                listener->OnVoiceStopped(id);
+            }
+        }
+
+        output->write(block.data(), blockFrames);
+
+        deadline += period;
+
+        auto now = std::chrono::steady_clock::now();
+
+        // a thread which fell far behind starts over, instead of rushing to catch up
+        if (deadline + period < now) {
+            deadline = now;
+        } else {
+            std::this_thread::sleep_until(deadline);
+        }
+    }
+}
+
+void MixerBackend::RunStreams(void) {
+    while (streaming.load(std::memory_order_acquire)) {
+        MixerStream * stream;
+
+        while (newStreams.pop(stream)) {
+            streams.push_back(stream);
+        }
+
+        bool filled = false;
+
+        for (auto iter = streams.begin(); iter != streams.end();) {
+            if ((*iter)->isClosed()) {
+                delete *iter;
+                iter = streams.erase(iter);
+                continue;
+            }
+
+            filled |= (*iter)->fill();
+            iter++;
+        }
+
+        if (!filled) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(STREAM_IDLE_MILLISECONDS));
+        }
+    }
+}
+
+void MixerBackend::push(const struct Command & command) {
+    while (!commands.push(command)) {
+        std::this_thread::yield();
+    }
+}
+
+void MixerBackend::execute(const struct Command & command) {
+    switch (command.type) {
+        case Command::Type::ePlay:
+            mixer.play(command.clip, command.params, command.id, command.stream);
+            break;
+        case Command::Type::eStop:
+            mixer.stop(command.id);
+            break;
+        case Command::Type::eListener:
+            mixer.setListener(command.params.x, command.params.y);
+            break;
+        case Command::Type::eUnload:
+            delete command.clip;
+            break;
+    }
+}
@@ -0,0 +1,164 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <future>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+#include "game/parsing/DocumentCache.hpp"
+#include "game/parsing/GameContext.hpp"
+
+namespace Game {
+
+    using namespace std::experimental;
+
+    namespace {
+
+        uint64_t Hash(const std::string & contents) {
+            uint64_t hash = 0xcbf29ce484222325ull;
+
+            for (char c : contents) {
+                hash = (hash ^ static_cast<uint8_t> (c)) * 0x100000001b3ull;
+            }
+
+            return hash;
+        }
+
+        /**
+         * Adds a document after everything it references
+         */
+        void Order(const filesystem::path & path, const std::map<filesystem::path, std::shared_ptr<const Document>> & loaded,
+                std::set<filesystem::path> & visited, std::vector<std::shared_ptr<const Document>> & order) {
+            // files can reference each other, the first one reached wins
+            if (!visited.insert(path).second) {
+                return;
+            }
+
+            const std::shared_ptr<const Document> & document = loaded.at(path);
+
+            for (const filesystem::path & reference : document->references) {
+                Order(reference, loaded, visited, order);
+            }
+
+            order.push_back(document);
+        }
+
+    }
+
+    DocumentCache::DocumentCache(unsigned threads) : pool(threads) {
+
+    }
+
+    DocumentCache::Refresh DocumentCache::Load(const filesystem::path & path, const Entry * cached) {
+        std::error_code error;
+        filesystem::file_time_type modified = filesystem::last_write_time(path, error);
+
+        if (error) {
+            throw std::runtime_error("could not find file " + path.generic_string());
+        }
+
+        if (cached && cached->modified == modified) {
+            return Refresh{*cached, false};
+        }
+
+        std::ifstream stream(path.generic_string(), std::ios::binary);
+        std::ostringstream contents;
+        contents << stream.rdbuf();
+
+        if (!stream) {
+            throw std::runtime_error("could not read file " + path.generic_string());
+        }
+
+        uint64_t hash = Hash(contents.str());
+
+        // touched but not changed, like after a checkout
+        if (cached && cached->document->hash == hash) {
+            return Refresh{Entry{cached->document, modified}, false};
+        }
+
+        std::shared_ptr<Document> document = std::make_shared<Document>();
+        document->path = path;
+        document->node = YAML::Load(contents.str());
+        document->hash = hash;
+
+        // the const lookup doesn't add the key when it's missing
+        const YAML::Node & node = document->node;
+        YAML::Node references = node["references"];
+
+        if (references) {
+            if (!references.IsSequence()) {
+                throw format_error("references must be a sequence in " + path.generic_string());
+            }
+
+            for (const YAML::Node & reference : references) {
+                document->references.push_back(path.parent_path() / reference.Scalar());
+            }
+        }
+
+        return Refresh{Entry{document, modified}, true};
+    }
+
+    std::vector<std::shared_ptr<const Document>> DocumentCache::load(const std::string & file) {
+        std::map<filesystem::path, std::shared_ptr<const Document>> loaded;
+
+        filesystem::path root(file);
+        std::vector<filesystem::path> level{root};
+
+        while (!level.empty()) {
+            std::vector<std::future<Refresh>> refreshes;
+
+            for (const filesystem::path & path : level) {
+                auto iter = entries.find(path);
+
+                // the workers get copies, the entries are only touched here
+                std::shared_ptr<Entry> cached;
+
+                if (iter != entries.end()) {
+                    cached = std::make_shared<Entry>(iter->second);
+                }
+
+                refreshes.push_back(pool.submit([path, cached]() {
+                    return Load(path, cached.get());
+                }));
+            }
+
+            std::vector<filesystem::path> next;
+
+            for (size_t i = 0; i < level.size(); i++) {
+                // rethrows anything the worker threw
+                Refresh refresh = refreshes[i].get();
+
+                if (refresh.parsed) {
+                    parsed++;
+                }
+
+                entries[level[i]] = refresh.entry;
+                loaded[level[i]] = refresh.entry.document;
+
+                for (const filesystem::path & reference : refresh.entry.document->references) {
+                    if (loaded.find(reference) == loaded.end() &&
+                            std::find(level.begin(), level.end(), reference) == level.end() &&
+                            std::find(next.begin(), next.end(), reference) == next.end()) {
+                        next.push_back(reference);
+                    }
+                }
+            }
+
+            level = std::move(next);
+        }
+
+        std::vector<std::shared_ptr<const Document>> order;
+        std::set<filesystem::path> visited;
+
+        Order(root, loaded, visited, order);
+
+        return order;
+    }
+
+}
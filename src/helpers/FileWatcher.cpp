@@ -0,0 +1,162 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+#include <cerrno>
+#include <chrono>
+#include <stdexcept>
+#include <system_error>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "FileWatcher.hpp"
+
+using namespace std::experimental;
+
+#ifdef __linux__
+
+namespace {
+
+    /**
+     * @return The folder a generic path is in, "." for a bare file name
+     */
+    std::string FolderOf(const std::string & path) {
+        std::string folder = filesystem::path(path).parent_path().generic_string();
+
+        return folder.empty() ? "." : folder;
+    }
+
+}
+
+#endif
+
+constexpr int FileWatcher::POLL_MILLISECONDS;
+
+FileWatcher::FileWatcher() : running(true) {
+#ifdef __linux__
+    inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (inotify < 0) {
+        throw std::system_error(errno, std::system_category(), "Could not start watching files");
+    }
+#endif
+
+    thread = std::thread(Run, this);
+}
+
+FileWatcher::~FileWatcher() {
+    running = false;
+    thread.join();
+
+#ifdef __linux__
+    close(inotify);
+#endif
+}
+
+void FileWatcher::watch(const std::string & path) {
+    std::string file = filesystem::path(path).generic_string();
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    if (!files.insert(file).second) {
+        return;
+    }
+
+#ifdef __linux__
+    std::string folder = FolderOf(file);
+
+    // the folder is watched instead of the file, editors and copies replace files
+    int descriptor = inotify_add_watch(inotify, folder.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+
+    if (descriptor < 0) {
+        files.erase(file);
+        throw std::system_error(errno, std::system_category(), "Could not watch " + folder);
+    }
+
+    // adding a folder twice gives back the same descriptor
+    folders[descriptor] = folder;
+#else
+    std::error_code error;
+    modified[file] = filesystem::last_write_time(file, error);
+#endif
+}
+
+std::vector<std::string> FileWatcher::poll(void) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    std::vector<std::string> result(changed.begin(), changed.end());
+    changed.clear();
+
+    return result;
+}
+
+void FileWatcher::Run(FileWatcher * watcher) {
+    while (watcher->running) {
+        watcher->check();
+    }
+}
+
+#ifdef __linux__
+
+void FileWatcher::check(void) {
+    struct pollfd descriptor = {inotify, POLLIN, 0};
+
+    if (::poll(&descriptor, 1, POLL_MILLISECONDS) <= 0) {
+        return;
+    }
+
+    // aligned for the events, which are read straight out of it
+    alignas(struct inotify_event) char buffer[4096];
+
+    ssize_t length;
+
+    while ((length = read(inotify, buffer, sizeof (buffer))) > 0) {
+        std::lock_guard<std::mutex> guard(lock);
+
+        for (char * ptr = buffer; ptr < buffer + length;) {
+            const struct inotify_event * event = reinterpret_cast<const struct inotify_event*> (ptr);
+
+            ptr += sizeof (struct inotify_event) + event->len;
+
+            auto folder = folders.find(event->wd);
+
+            if (event->len == 0 || folder == folders.end()) {
+                continue;
+            }
+
+            std::string file = folder->second == "." ? std::string(event->name) : folder->second + "/" + event->name;
+
+            // the folders have other files in them
+            if (files.find(file) != files.end()) {
+                changed.insert(file);
+            }
+        }
+    }
+}
+
+#else
+
+void FileWatcher::check(void) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(POLL_MILLISECONDS));
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    for (auto & file : modified) {
+        std::error_code error;
+        filesystem::file_time_type time = filesystem::last_write_time(file.first, error);
+
+        // a file being replaced can be missing for a moment
+        if (!error && time != file.second) {
+            file.second = time;
+            changed.insert(file.first);
+        }
+    }
+}
+
+#endif
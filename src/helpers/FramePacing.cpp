@@ -0,0 +1,121 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+#include "FramePacing.hpp"
+
+#include <algorithm>
+#include <thread>
+
+FramePacer::FramePacer(double targetRate, std::chrono::microseconds spinThreshold) :
+spinThreshold(spinThreshold) {
+    setTargetRate(targetRate);
+}
+
+void FramePacer::setTargetRate(double targetRate) {
+    if (targetRate > 0) {
+        period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / targetRate));
+    } else {
+        period = clock::duration::zero();
+    }
+
+    started = false;
+}
+
+double FramePacer::getTargetRate() const {
+    if (period == clock::duration::zero()) {
+        return 0;
+    }
+
+    return 1.0 / std::chrono::duration<double>(period).count();
+}
+
+void FramePacer::wait() {
+    if (period == clock::duration::zero()) {
+        return;
+    }
+
+    clock::time_point now = clock::now();
+
+    if (!started) {
+        started = true;
+        deadline = now + period;
+        return;
+    }
+
+    if (deadline - now > spinThreshold) {
+        std::this_thread::sleep_for(deadline - now - spinThreshold);
+    }
+
+    while (clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+
+    now = clock::now();
+
+    deadline += period;
+
+    // a long frame shouldn't be followed by a burst of short ones
+    if (deadline < now) {
+        deadline = now + period;
+    }
+}
+
+LatencyTracker::LatencyTracker(size_t window) : samples(std::max<size_t>(window, 1)) {
+}
+
+void LatencyTracker::markInputSampled() {
+    sampled = clock::now();
+    hasSample = true;
+}
+
+void LatencyTracker::markPresented() {
+    if (!hasSample) {
+        return;
+    }
+
+    samples[next] = std::chrono::duration<double, std::milli>(clock::now() - sampled).count();
+
+    next = (next + 1) % samples.size();
+    count = std::min(count + 1, samples.size());
+
+    hasSample = false;
+}
+
+double LatencyTracker::getLatest() const {
+    if (count == 0) {
+        return 0;
+    }
+
+    return samples[(next + samples.size() - 1) % samples.size()];
+}
+
+double LatencyTracker::getAverage() const {
+    if (count == 0) {
+        return 0;
+    }
+
+    double total = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        total += samples[i];
+    }
+
+    return total / count;
+}
+
+double LatencyTracker::getPercentile(double percentile) const {
+    if (count == 0) {
+        return 0;
+    }
+
+    std::vector<double> sorted(samples.begin(), samples.begin() + count);
+
+    size_t index = static_cast<size_t> (std::min(std::max(percentile, 0.0), 1.0) * (count - 1) + 0.5);
+
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+
+    return sorted[index];
+}
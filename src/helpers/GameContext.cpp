@@ -5,7 +5,6 @@
  */
 
 #include "game/parsing/GameContext.hpp"
-#include "VulkanVertex.hpp"
 
 #include <list>
 #include <set>
@@ -114,7 +113,7 @@ namespace Game {
 
             float * fl_buf = new float[floats.size()];
             std::memcpy(fl_buf, floats.data(), sizeof (float) * floats.size());
-            return std::shared_ptr<void>(fl_buf);
+            return std::shared_ptr<void>(fl_buf, std::default_delete<float[]>());
 
         } else if (type == "vint") {
             // try to parse an int vector
@@ -131,7 +130,7 @@ namespace Game {
 
             int * int_buf = new int[ints.size()];
             std::memcpy(int_buf, ints.data(), sizeof (int) * ints.size());
-            return std::shared_ptr<void>(int_buf);
+            return std::shared_ptr<void>(int_buf, std::default_delete<int[]>());
 
         } else if (type == "float") {
             // try to parse a single float
@@ -193,69 +192,147 @@ namespace Game {
         return true;
     }
 
-    FieldList::FieldList(ConstNode node) {
+    namespace {
+
+        // how a scalar or vector of 4 byte components is laid out in a block
+        struct Alignment {
+            size_t size, alignment;
+            // the stride and alignment when it's an array's element
+            size_t stride, array;
+        };
+
+        size_t RoundUp(size_t value, size_t alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        Alignment Align(size_t components, BlockLayout layout) {
+            Alignment result;
+
+            result.size = components * 4;
+
+            // a vec3 is aligned like a vec4
+            result.alignment = components == 1 ? 4 : components == 2 ? 8 : 16;
+
+            // std140 rounds arrays up to a vec4, std430 packs them like anything else
+            result.stride = layout == BlockLayout::eStd140 ? RoundUp(result.alignment, 16) : result.alignment;
+            result.array = result.stride;
+
+            return result;
+        }
+
+    }
+
+    FieldList::FieldList(ConstNode node, BlockLayout layout) : layout(layout) {
+        // the block's alignment, the largest of its members'
+        size_t alignment = 4;
 
         if (!node || !node.IsSequence()) {
             Logger::LogTop("FieldList", "Field list node must be a sequence");
             throw std::runtime_error("Field list node must be a sequence");
         }
 
-        for (ConstNode field : node) {
+        for (ConstNode entry : node) {
 
-            std::string tag = field.Tag();
+            std::string tag;
+            YAML::Node field;
             std::string type;
-            int count = 1;
-            size_t size = 0;
+            int count = 1, array = 0;
+
+            if (!GetEntry(entry, tag, field)) {
+                Logger::LogTop("FieldList", "Field isn't a named entry");
+                throw format_error("Fields must be named entries");
+            }
 
             Logger::LogTop("FieldList", "Found field " + tag);
 
-            if (!field.IsMap()) {
-                Logger::LogTop("FieldList:" + tag, "Not a map");
-                throw format_error("Field " + tag + " must be a map");
-            }
+            // 'name: type' is short for a single value. The field is only
+            // read, assigning to it would change the document it's from
+            bool shorthand = GetScalar(field, type);
 
-            if (!GetScalar(field["type"], type)) {
+            if (shorthand) {
+                Logger::LogTop("FieldList:" + tag, "Short form");
+            } else if (!field.IsMap()) {
+                Logger::LogTop("FieldList:" + tag, "Not a map");
+                throw format_error("Field " + tag + " must be a type or a map");
+            } else if (!GetScalar(field["type"], type)) {
                 Logger::LogTop("FieldList:" + tag, "Missing type node");
                 throw format_error("Field " + tag + " is missing a type node");
             }
 
-            if (field["count"] && !ValueParsing::TryParseInt(field["count"], count)) {
+            if (!shorthand && field["count"] && !ValueParsing::TryParseInt(field["count"], count)) {
                 Logger::LogTop("FieldList:" + tag, "Invalid count node");
                 throw format_error("Invalid field count ");
             }
 
-            if (type == "float") {
-                size = sizeof (float) * count;
-            } else if (type == "int") {
-                size = sizeof (int) * count;
-            } else {
+            // a count is a vector's size, glsl has no longer vectors
+            if (count < 1 || count > 4) {
+                throw format_error("Field " + tag + " must have a count from 1 to 4, use an array for more values");
+            }
+
+            if (!shorthand && field["array"] && (!ValueParsing::TryParseInt(field["array"], array) || array < 1)) {
+                Logger::LogTop("FieldList:" + tag, "Invalid array node");
+                throw format_error("Field " + tag + " has an invalid array size");
+            }
+
+            if (type != "float" && type != "int") {
                 throw format_error("Unknown type " + type);
             }
 
-            fields.push_back(Field(tag, type, count, buffer_size, size));
+            Alignment element = Align(count, layout);
+
+            size_t offset = RoundUp(buffer_size, array ? element.array : element.alignment);
+            size_t stride = array ? element.stride : element.size;
+            size_t size = array ? stride * array : element.size;
+
+            fields.push_back(Field(tag, type, count, array, offset, size, stride));
             byname[tag] = &fields.back();
 
-            Logger::LogTop("FieldList:" + tag, "type: " + type + " count: " + std::to_string(count) + " offset: " + std::to_string(buffer_size) + " size: " + std::to_string(size));
+            alignment = std::max(alignment, array ? element.array : element.alignment);
+
+            Logger::LogTop("FieldList:" + tag, "type: " + type + " count: " + std::to_string(count) + " array: " + std::to_string(array) +
+                    " offset: " + std::to_string(offset) + " size: " + std::to_string(size));
 
-            buffer_size += size;
+            buffer_size = offset + size;
+        }
+
+        // a std140 block is aligned like a vec4, whatever it holds
+        if (layout == BlockLayout::eStd140) {
+            alignment = std::max<size_t>(alignment, 16);
+        }
+
+        buffer_size = RoundUp(buffer_size, alignment);
+    }
+
+    void FieldList::copy(const Field & field, const void * value, void * buffer) const {
+        size_t element = field.components * 4;
+
+        // an array's elements are padded out to its stride, the values aren't
+        for (size_t i = 0; i < std::max<size_t>(field.array, 1); i++) {
+            memcpy(static_cast<char*> (buffer) + field.offset + i * field.stride, static_cast<const char*> (value) + i * element, element);
         }
     }
 
     Value FieldList::parse(ConstString fieldname, ConstNode value) const {
         const Field * field = getField(fieldname);
 
+        // fields with a count take a sequence, like the vector types
+        std::string type = value.IsSequence() ? "v" + field->type : field->type;
+
         struct Value val = {0};
-        val.ptr = ValueParsing::ParseValue(field->type, value, &val.count, &val.type);
+        val.ptr = ValueParsing::ParseValue(type, value, &val.count, &val.type);
+
+        if (val.count != field->count) {
+            throw format_error("Field " + fieldname + " needs " + std::to_string(field->count) + " values, not " + std::to_string(val.count));
+        }
+
         return val;
     }
 
-    UBOInstance::UBOInstance(ConstNode node, const std::map<std::string, UBOPrototype> & prototypes) {
-        if (!node || !node.IsSequence()) {
-            throw format_error("UBO Instance node must be sequence");
+    UBOInstance::UBOInstance(ConstString name, ConstNode node, const std::map<std::string, UBOPrototype> & prototypes) : name(name) {
+        if (!node || !node.IsMap()) {
+            throw format_error("UBO Instance node must be map");
         }
 
-        name = node.Tag();
-
         std::string proto_name;
 
         if (GetScalar(node["prototype"], proto_name)) {
@@ -268,64 +345,81 @@ namespace Game {
 
             list = prototype->getFields();
         } else {
-            list_noproto = std::move(std::unique_ptr<FieldList>(new FieldList(node["fields"])));
+            list_noproto = std::move(std::unique_ptr<FieldList>(new FieldList(node["fields"], BlockLayout::eStd140)));
 
             list = list_noproto.get();
         }
 
-        for (ConstNode value : node["values"]) {
-            values[list->getField(value.Tag())] = list->parse(value.Tag(), value);
+        for (ConstNode entry : node["values"]) {
+            std::string field;
+            YAML::Node value;
+
+            if (!GetEntry(entry, field, value)) {
+                throw format_error("UBO Instance " + name + " values must be named entries");
+            }
+
+            try {
+                values[list->getField(field)] = list->parse(field, value);
+            } catch (std::out_of_range &) {
+                throw format_error("UBO Instance " + name + " has no field " + field);
+            }
         }
     }
 
-    std::shared_ptr<void> UBOInstance::create() {
+    std::shared_ptr<void> UBOInstance::create() const {
         size_t size = list->size();
 
-        std::shared_ptr<char> ptr(new char[size]);
+        std::shared_ptr<char> ptr(new char[size], std::default_delete<char[]>());
 
         memset(ptr.get(), 0, size);
 
         for (auto & field : list->getFields()) {
-            Value * value = &values[&field];
-            memcpy(ptr.get() + field.offset, value->ptr.get(), field.size);
+            auto value = values.find(&field);
+
+            if (value != values.end()) {
+                list->copy(field, value->second.ptr.get(), ptr.get());
+            }
         }
 
         return ptr;
     }
 
-    ShaderPrototype::ShaderPrototype(ConstNode node) : name(node.Tag()) {
+    ShaderPrototype::ShaderPrototype(ConstString name, ConstNode node) : name(name) {
 
         if (!GetScalar(node["file"], file)) {
             throw format_error("Shader " + name + " has invalid file");
         }
 
+        stage = ValueParsing::ParseStage(node["stage"]);
+
         if (node["push constants"] && !ValueParsing::ParseStringSequence(node["push constants"], pushconstants)) {
             throw format_error("Shader " + name + ": push constants must be sequence");
         }
 
         if (node["textures"]) {
-            for (ConstNode node : node["textures"]) {
-                std::string name;
+            for (ConstNode texture : node["textures"]) {
+                std::string texname;
                 int binding;
 
-                if (!GetScalar(node["name"], name) || !ValueParsing::TryParseInt(node["binding"], binding)) {
+                // textures are only named when a shader has more than one
+                if ((texture["name"] && !GetScalar(texture["name"], texname)) || !ValueParsing::TryParseInt(texture["binding"], binding)) {
                     throw format_error("Invalid texture in shader " + name);
                 }
 
-                textures.push_back(std::make_tuple(name, binding));
+                textures.push_back(std::make_tuple(texname, binding));
             }
         }
 
         if (node["ubos"]) {
-            for (ConstNode node : node["ubos"]) {
-                std::string name;
+            for (ConstNode ubo : node["ubos"]) {
+                std::string prototype;
                 int binding;
 
-                if (!GetScalar(node["name"], name) || !ValueParsing::TryParseInt(node["binding"], binding)) {
+                if (!GetScalar(ubo["prototype"], prototype) || !ValueParsing::TryParseInt(ubo["binding"], binding)) {
                     throw format_error("Invalid ubo in shader " + name);
                 }
 
-                ubos.push_back(std::make_tuple(name, binding));
+                ubos.push_back(std::make_tuple(prototype, binding));
             }
         }
     }
@@ -379,14 +473,48 @@ namespace Game {
 
     }
 
-    GameContext::GameContext(ConstString filename) {
-        document = CalculateDependencies(filename);
+    GameContext::GameContext(ConstString filename) : own_cache(new DocumentCache()), cache(own_cache.get()), file(filename) {
+        document = cache->load(file);
 
-        Logger logger(filesystem::path(filename).filename().generic_string());
+        ReadDocuments();
+    }
 
-        for (auto file : document) {
-            ConstNode node = std::get<0>(file);
-            std::string name = std::get<1>(file).generic_string();
+    GameContext::GameContext(ConstString filename, DocumentCache & cache) : cache(&cache), file(filename) {
+        document = cache.load(file);
+
+        ReadDocuments();
+    }
+
+    bool GameContext::reload() {
+        std::vector<std::shared_ptr<const Document>> reloaded = cache->load(file);
+
+        // unchanged files keep their documents
+        if (reloaded == document) {
+            return false;
+        }
+
+        document = std::move(reloaded);
+
+        ReadDocuments();
+
+        return true;
+    }
+
+    void GameContext::ReadDocuments() {
+        Logger logger(filesystem::path(file).filename().generic_string());
+
+        // instances point at their prototypes, so they go first
+        uboinstances.clear();
+        uboprototypes.clear();
+        constants.clear();
+        vertex_buffers.clear();
+        index_buffers.clear();
+        push_constants.clear();
+        shaders.clear();
+
+        for (auto & doc : document) {
+            ConstNode node = doc->node;
+            std::string name = doc->path.filename().generic_string();
 
             logger.Log("Reading constants in " + name);
             ReadConstants(node["constants"]);
@@ -411,60 +539,6 @@ namespace Game {
         }
     }
 
-    std::list<std::tuple<YAML::Node, filesystem::path>> GameContext::CalculateDependencies(ConstString file) {
-        std::list<std::tuple < YAML::Node, filesystem::path >> file_stack
-        {
-            std::make_tuple<YAML::Node, filesystem::path>(YAML::LoadFile(file), file)
-        };
-        std::set<filesystem::path> open_files;
-
-        Logger logger(std::get<1>(file_stack.front()).filename().generic_string());
-
-        logger.Log("Starting with file " + file);
-
-        for (auto & current : file_stack) {
-            ConstNode node = std::get<0>(current)["references"];
-            filesystem::path & file = std::get<1>(current);
-
-            std::string filename = file.filename().generic_string();
-
-            logger.Log("Checking for references in " + filename);
-
-            if (!node) {
-                logger.Log("No references node in " + filename);
-                continue;
-            }
-
-            if (!node.IsSequence()) {
-                throw format_error("references must be a sequence");
-            }
-
-            for (ConstNode reference : node) {
-                filesystem::path ref(reference.Scalar());
-
-                ref = file.parent_path() / ref;
-
-                logger.Log(filename, "Found reference " + ref.generic_string());
-
-                // if the file isn't already open, open it
-                if (open_files.find(ref) == open_files.end()) {
-                    open_files.insert(ref);
-
-                    YAML::Node dep = YAML::LoadFile(ref.generic_string());
-
-                    if (!dep) {
-                        throw std::runtime_error("could not find file " + ref.generic_string());
-                    }
-
-                    file_stack.push_front(std::make_tuple(dep, ref));
-                }
-
-            }
-        }
-
-        return file_stack;
-    }
-
     void GameContext::ReadConstants(ConstNode constants) {
         if (!constants) {
             return;
@@ -493,12 +567,15 @@ namespace Game {
             throw format_error("UBO Prototype node must be sequence or missing");
         }
 
-        for (ConstNode ubop : ubops) {
-            if (!ubop.IsMap()) {
-                throw format_error("UBO Prototype must be a map");
+        for (ConstNode entry : ubops) {
+            std::string name;
+            YAML::Node ubop;
+
+            if (!GetEntry(entry, name, ubop) || !ubop.IsMap()) {
+                throw format_error("UBO Prototype must be a named map");
             }
 
-            uboprototypes[ubop.Tag()] = UBOPrototype(ubop);
+            uboprototypes[name] = UBOPrototype(name, ubop);
         }
 
     }
@@ -512,12 +589,15 @@ namespace Game {
             throw format_error("UBO Instance node must be sequence or missing");
         }
 
-        for (ConstNode uboi : ubois) {
-            if (!uboi.IsMap()) {
-                throw format_error("UBO Instance must be a map");
+        for (ConstNode entry : ubois) {
+            std::string name;
+            YAML::Node uboi;
+
+            if (!GetEntry(entry, name, uboi)) {
+                throw format_error("UBO Instance must be a named map");
             }
 
-            uboinstances[uboi.Tag()] = UBOInstance(uboi, this->uboprototypes);
+            uboinstances[name] = UBOInstance(name, uboi, this->uboprototypes);
         }
 
     }
@@ -531,14 +611,17 @@ namespace Game {
             throw format_error("Vertex Buffers node must be sequence or missing");
         }
 
-        for (ConstNode vertexbuffer : vbs) {
-            if (!vertexbuffer.IsSequence()) {
-                throw format_error("Vertex Buffer " + vertexbuffer.Tag() + " must be sequence");
+        for (ConstNode entry : vbs) {
+            std::string name;
+            YAML::Node vertexbuffer;
+
+            if (!GetEntry(entry, name, vertexbuffer) || !vertexbuffer.IsSequence()) {
+                throw format_error("Vertex Buffer " + name + " must be sequence");
             }
 
             int i = 0;
 
-            vertex_buffers[vertexbuffer.Tag()].clear();
+            vertex_buffers[name].clear();
 
             for (ConstNode vertex : vertexbuffer) {
                 if (!vertex.IsMap()) {
@@ -561,7 +644,8 @@ namespace Game {
                     vert.position = ValueParsing::VectorToVec2(vec);
                 }
 
-                vertex_buffers[vertexbuffer.Tag()].push_back(vert);
+                vertex_buffers[name].push_back(vert);
+                i++;
             }
         }
     }
@@ -575,13 +659,16 @@ namespace Game {
             throw format_error("Vertex Buffers node must be sequence or missing");
         }
 
-        for (ConstNode indexbuffer : ibs) {
-            if (!indexbuffer.IsSequence()) {
-                throw format_error("Index Buffer " + indexbuffer.Tag() + " must be a scalar sequence");
+        for (ConstNode entry : ibs) {
+            std::string name;
+            YAML::Node indexbuffer;
+
+            if (!GetEntry(entry, name, indexbuffer) || !indexbuffer.IsSequence()) {
+                throw format_error("Index Buffer " + name + " must be a scalar sequence");
             }
 
-            if (!ValueParsing::ParseIntSequence(indexbuffer, index_buffers[indexbuffer.Tag()])) {
-                throw format_error("Index Buffer " + indexbuffer.Tag() + " must be a scalar sequence");
+            if (!ValueParsing::ParseIntSequence(indexbuffer, index_buffers[name])) {
+                throw format_error("Index Buffer " + name + " must be a scalar sequence");
             }
         }
     }
@@ -595,12 +682,15 @@ namespace Game {
             throw format_error("Push Constant list must be sequence");
         }
 
-        for (ConstNode node : pcs) {
-            if (node.IsMap()) {
-                throw format_error("Push Constant must be a map");
+        for (ConstNode entry : pcs) {
+            std::string name;
+            YAML::Node node;
+
+            if (!GetEntry(entry, name, node) || !node.IsMap()) {
+                throw format_error("Push Constant must be a named map");
             }
 
-            push_constants[node.Tag()] = PushConstantInfo(node);
+            push_constants[name] = PushConstantInfo(name, node);
         }
     }
 
@@ -613,12 +703,15 @@ namespace Game {
             throw format_error("Shader list must be sequence");
         }
 
-        for (ConstNode shader : shadernode) {
-            if (shader.IsMap()) {
-                throw format_error("Shader must be a map");
+        for (ConstNode entry : shadernode) {
+            std::string name;
+            YAML::Node shader;
+
+            if (!GetEntry(entry, name, shader) || !shader.IsMap()) {
+                throw format_error("Shader must be a named map");
             }
 
-            shaders[shader.Tag()] = ShaderPrototype(shader);
+            shaders[name] = ShaderPrototype(name, shader);
         }
     }
 
@@ -0,0 +1,178 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+#include <cstring>
+#include <stdexcept>
+
+#include "game/parsing/GameData.hpp"
+
+namespace Game {
+
+    namespace {
+
+        // the size of each section's records, strings and data are bytes
+        const size_t RECORD_SIZES[Format::eSectionCount] = {
+            1,
+            1,
+            sizeof (Format::Constant),
+            sizeof (Format::Field),
+            sizeof (Format::UBOPrototype),
+            sizeof (Format::UBOInstance),
+            sizeof (Format::VertexBuffer),
+            sizeof (Format::IndexBuffer),
+            sizeof (Format::PushConstant),
+            sizeof (Format::Shader),
+            sizeof (Format::ShaderBinding),
+        };
+
+    }
+
+    GameData::GameData(const std::string & path) : file(path), bytes(file.getData(), file.getSize()) {
+        // the header is read field by field, so a bad file is described instead of misread
+        Loader::Cursor cursor(bytes, Loader::Endian::eLittle);
+
+        try {
+            if (memcmp(cursor.readBytes(sizeof (Format::MAGIC)).data(), Format::MAGIC, sizeof (Format::MAGIC)) != 0) {
+                throw std::runtime_error(path + " isn't game data");
+            }
+
+            memcpy(header.magic, Format::MAGIC, sizeof (Format::MAGIC));
+
+            header.version = cursor.read<uint32_t>();
+            header.byte_order = cursor.read<uint32_t>();
+            header.size = cursor.read<uint32_t>();
+
+            for (Format::SectionInfo & info : header.sections) {
+                info.offset = cursor.read<uint32_t>();
+                info.size = cursor.read<uint32_t>();
+            }
+        } catch (std::out_of_range &) {
+            throw std::runtime_error(path + " is too small to be game data");
+        }
+
+        if (header.byte_order != Format::BYTE_ORDER_MARK) {
+            throw std::runtime_error(path + " wasn't written as little endian");
+        }
+
+        if (header.version != Format::VERSION) {
+            throw std::runtime_error(path + " is version " + std::to_string(header.version) +
+                    ", but the game reads version " + std::to_string(Format::VERSION) + ", it has to be recompiled");
+        }
+
+        // the records are used in place, which only works in their byte order
+        if (Loader::NATIVE != Loader::Endian::eLittle) {
+            throw std::runtime_error("Game data can only be read on little endian machines");
+        }
+
+        if (header.size != bytes.size()) {
+            throw std::runtime_error(path + " is corrupt: its size doesn't match its header");
+        }
+
+        try {
+            for (uint32_t i = 0; i < Format::eSectionCount; i++) {
+                const Format::SectionInfo & info = header.sections[i];
+
+                if (info.offset % Format::ALIGNMENT != 0 || info.offset < sizeof (Format::Header) ||
+                        info.size % RECORD_SIZES[i] != 0) {
+                    throw std::out_of_range("section " + std::to_string(i) + " is misaligned");
+                }
+
+                sections[i] = bytes.subview(info.offset, info.size);
+            }
+
+            validate();
+        } catch (std::out_of_range & e) {
+            throw std::runtime_error(path + " is corrupt: " + e.what());
+        }
+    }
+
+    void GameData::validate(void) const {
+        const Loader::ByteView & strings = sections[Format::eStrings];
+        const Loader::ByteView & data = sections[Format::eData];
+
+        auto checkString = [&](const Format::String & str) {
+            // the null has to be there too
+            if (!strings.contains(str.offset, str.length + 1ull) || strings.data()[str.offset + str.length] != 0) {
+                throw std::out_of_range("a string is out of bounds");
+            }
+        };
+
+        // values are read as 32 bit floats and ints
+        auto checkData = [&](uint32_t offset, uint64_t size) {
+            if (offset % 4 != 0 || size > SIZE_MAX || !data.contains(offset, static_cast<size_t> (size))) {
+                throw std::out_of_range("a value is out of bounds");
+            }
+        };
+
+        // the fields have to fit in their buffer
+        auto checkFields = [&](uint32_t first, uint32_t count, uint32_t size) {
+            for (const Format::Field & field : getFields(first, count)) {
+                checkString(field.name);
+
+                if (field.offset > size || field.size > size - field.offset) {
+                    throw std::out_of_range("field " + getString(field.name).str() + " is outside of its buffer");
+                }
+            }
+        };
+
+        // find() needs every named table sorted, without duplicates
+        auto checkNames = [&](auto table, const char * name) {
+            for (size_t i = 0; i < table.size(); i++) {
+                checkString(table[i].name);
+
+                if (i > 0 && !(getString(table[i - 1].name) < getString(table[i].name))) {
+                    throw std::out_of_range(std::string(name) + " aren't sorted");
+                }
+            }
+        };
+
+        checkNames(getConstants(), "constants");
+        checkNames(getUBOPrototypes(), "ubo prototypes");
+        checkNames(getUBOInstances(), "ubo instances");
+        checkNames(getVertexBuffers(), "vertex buffers");
+        checkNames(getIndexBuffers(), "index buffers");
+        checkNames(getPushConstants(), "push constants");
+        checkNames(getShaders(), "shaders");
+
+        for (const Format::Constant & constant : getConstants()) {
+            checkData(constant.data, constant.count * 4ull);
+        }
+
+        for (const Format::UBOPrototype & prototype : getUBOPrototypes()) {
+            checkFields(prototype.first_field, prototype.field_count, prototype.size);
+        }
+
+        for (const Format::UBOInstance & instance : getUBOInstances()) {
+            if (instance.prototype != Format::NONE && instance.prototype >= getUBOPrototypes().size()) {
+                throw std::out_of_range("ubo instance " + getString(instance.name).str() + " has an invalid prototype");
+            }
+
+            checkFields(instance.first_field, instance.field_count, instance.size);
+            checkData(instance.data, instance.size);
+        }
+
+        for (const Format::VertexBuffer & buffer : getVertexBuffers()) {
+            checkData(buffer.data, buffer.count * static_cast<uint64_t> (sizeof (Format::Vertex)));
+        }
+
+        for (const Format::IndexBuffer & buffer : getIndexBuffers()) {
+            checkData(buffer.data, buffer.count * 4ull);
+        }
+
+        for (const Format::PushConstant & constant : getPushConstants()) {
+            checkFields(constant.first_field, constant.field_count, constant.size);
+        }
+
+        for (const Format::Shader & shader : getShaders()) {
+            checkString(shader.file);
+
+            for (const Format::ShaderBinding & binding : getBindings(shader)) {
+                checkString(binding.name);
+            }
+        }
+    }
+
+}
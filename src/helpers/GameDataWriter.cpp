@@ -0,0 +1,292 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include "game/parsing/GameDataWriter.hpp"
+
+namespace Game {
+
+    namespace {
+
+        Format::Type ParseType(ConstString type) {
+            if (type == "float") {
+                return Format::eFloat;
+            }
+
+            if (type == "int") {
+                return Format::eInt;
+            }
+
+            throw format_error("Unknown type " + type);
+        }
+
+        uint32_t Narrow(size_t value) {
+            if (value > std::numeric_limits<uint32_t>::max()) {
+                throw std::runtime_error("Game data can't be larger than 4 GiB");
+            }
+
+            return static_cast<uint32_t> (value);
+        }
+
+        size_t Align(size_t offset) {
+            return (offset + Format::ALIGNMENT - 1) / Format::ALIGNMENT * Format::ALIGNMENT;
+        }
+
+        /**
+         * Adds a context's named definitions, replacing any with the same name
+         */
+        template<typename T, typename U>
+        void Merge(std::map<std::string, const U*> & into, const std::map<std::string, T> & from) {
+            for (auto & item : from) {
+                into[item.first] = &item.second;
+            }
+        }
+
+    }
+
+    void GameDataWriter::add(const GameContext & context) {
+        Merge(constants, context.getConstants());
+        Merge(uboprototypes, context.getUBOPrototypes());
+        Merge(uboinstances, context.getUBOInstances());
+        Merge(vertex_buffers, context.getVertexBuffers());
+        Merge(index_buffers, context.getIndexBuffers());
+        Merge(push_constants, context.getPushConstants());
+        Merge(shaders, context.getShaders());
+    }
+
+    size_t GameDataWriter::write(ConstString path) {
+        strings.clear();
+        interned.clear();
+        data.clear();
+        fields.clear();
+
+        // every table comes out sorted by name, since the maps are
+        std::vector<Format::Constant> constant_records;
+
+        for (auto & constant : constants) {
+            const Value * value = constant.second;
+
+            Format::Constant record = {intern(constant.first), static_cast<uint32_t> (value->type), Narrow(value->count),
+                append(value->ptr.get(), value->count * 4)};
+
+            constant_records.push_back(record);
+        }
+
+        std::vector<Format::UBOPrototype> prototype_records;
+        std::map<std::string, uint32_t> prototype_indices;
+
+        for (auto & prototype : uboprototypes) {
+            const FieldList * list = prototype.second->getFields();
+
+            Format::UBOPrototype record = {intern(prototype.first), append(*list), Narrow(list->getFields().size()),
+                Narrow(list->size()), Narrow(prototype.second->getCount())};
+
+            prototype_indices[prototype.first] = Narrow(prototype_records.size());
+            prototype_records.push_back(record);
+        }
+
+        std::vector<Format::UBOInstance> instance_records;
+
+        for (auto & instance : uboinstances) {
+            const FieldList * list = instance.second->getFields();
+            const UBOPrototype * prototype = instance.second->getPrototype();
+
+            Format::UBOInstance record;
+            record.name = intern(instance.first);
+            record.prototype = prototype ? prototype_indices.at(prototype->getName()) : Format::NONE;
+
+            // an instance of a prototype shares its fields
+            if (prototype) {
+                const Format::UBOPrototype & proto = prototype_records[record.prototype];
+
+                record.first_field = proto.first_field;
+                record.field_count = proto.field_count;
+            } else {
+                record.first_field = append(*list);
+                record.field_count = Narrow(list->getFields().size());
+            }
+
+            // the buffer is laid out now, so it's uploaded as is
+            record.size = Narrow(list->size());
+            record.data = append(instance.second->create().get(), list->size());
+
+            instance_records.push_back(record);
+        }
+
+        std::vector<Format::VertexBuffer> vertex_records;
+
+        for (auto & buffer : vertex_buffers) {
+            std::vector<Format::Vertex> vertices;
+
+            for (const VertexInfo & info : *buffer.second) {
+                Format::Vertex vertex = {
+                    {info.position.x, info.position.y},
+                    {info.color.x, info.color.y, info.color.z},
+                    {info.uv.x, info.uv.y}
+                };
+
+                vertices.push_back(vertex);
+            }
+
+            Format::VertexBuffer record = {intern(buffer.first),
+                append(vertices.data(), vertices.size() * sizeof (Format::Vertex)), Narrow(vertices.size())};
+
+            vertex_records.push_back(record);
+        }
+
+        std::vector<Format::IndexBuffer> index_records;
+
+        for (auto & buffer : index_buffers) {
+            std::vector<int32_t> indices(buffer.second->begin(), buffer.second->end());
+
+            Format::IndexBuffer record = {intern(buffer.first),
+                append(indices.data(), indices.size() * sizeof (int32_t)), Narrow(indices.size())};
+
+            index_records.push_back(record);
+        }
+
+        std::vector<Format::PushConstant> push_constant_records;
+
+        for (auto & constant : push_constants) {
+            const FieldList * list = constant.second->getFields();
+
+            Format::PushConstant record = {intern(constant.first),
+                static_cast<uint32_t> (constant.second->getStages()), append(*list),
+                Narrow(list->getFields().size()), Narrow(list->size())};
+
+            push_constant_records.push_back(record);
+        }
+
+        std::vector<Format::Shader> shader_records;
+        std::vector<Format::ShaderBinding> binding_records;
+
+        for (auto & shader : shaders) {
+            const ShaderPrototype * prototype = shader.second;
+
+            Format::Shader record = {intern(shader.first), intern(prototype->getFile()),
+                static_cast<uint32_t> (prototype->getStage()), Narrow(binding_records.size()), 0};
+
+            for (auto & texture : prototype->getTextures()) {
+                binding_records.push_back({Format::eTexture, static_cast<uint32_t> (std::get<1>(texture)),
+                    intern(std::get<0>(texture))});
+            }
+
+            for (auto & ubo : prototype->getUBOs()) {
+                binding_records.push_back({Format::eUBO, static_cast<uint32_t> (std::get<1>(ubo)),
+                    intern(std::get<0>(ubo))});
+            }
+
+            for (auto & constant : prototype->getPushConstants()) {
+                binding_records.push_back({Format::ePushConstant, 0, intern(constant)});
+            }
+
+            record.binding_count = Narrow(binding_records.size() - record.first_binding);
+
+            shader_records.push_back(record);
+        }
+
+        // lays the sections out after the header, in order
+        struct Format::Header header;
+        memset(&header, 0, sizeof (header));
+        memcpy(header.magic, Format::MAGIC, sizeof (header.magic));
+        header.version = Format::VERSION;
+        header.byte_order = Format::BYTE_ORDER_MARK;
+
+        const void * contents[Format::eSectionCount] = {
+            strings.data(), data.data(), constant_records.data(), fields.data(), prototype_records.data(),
+            instance_records.data(), vertex_records.data(), index_records.data(), push_constant_records.data(),
+            shader_records.data(), binding_records.data()
+        };
+
+        const size_t sizes[Format::eSectionCount] = {
+            strings.size(), data.size(), constant_records.size() * sizeof (Format::Constant),
+            fields.size() * sizeof (Format::Field), prototype_records.size() * sizeof (Format::UBOPrototype),
+            instance_records.size() * sizeof (Format::UBOInstance), vertex_records.size() * sizeof (Format::VertexBuffer),
+            index_records.size() * sizeof (Format::IndexBuffer), push_constant_records.size() * sizeof (Format::PushConstant),
+            shader_records.size() * sizeof (Format::Shader), binding_records.size() * sizeof (Format::ShaderBinding)
+        };
+
+        size_t offset = Align(sizeof (header));
+
+        for (uint32_t i = 0; i < Format::eSectionCount; i++) {
+            header.sections[i].offset = Narrow(offset);
+            header.sections[i].size = Narrow(sizes[i]);
+
+            offset = Align(offset + sizes[i]);
+        }
+
+        header.size = Narrow(offset);
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+        if (!file) {
+            throw std::runtime_error("Could not open " + path);
+        }
+
+        const char padding[Format::ALIGNMENT] = {0};
+
+        file.write(reinterpret_cast<const char*> (&header), sizeof (header));
+        file.write(padding, Align(sizeof (header)) - sizeof (header));
+
+        for (uint32_t i = 0; i < Format::eSectionCount; i++) {
+            file.write(static_cast<const char*> (contents[i]), sizes[i]);
+            file.write(padding, Align(sizes[i]) - sizes[i]);
+        }
+
+        if (!file) {
+            throw std::runtime_error("Could not write " + path);
+        }
+
+        return offset;
+    }
+
+    Format::String GameDataWriter::intern(ConstString str) {
+        auto iter = interned.find(str);
+
+        if (iter != interned.end()) {
+            return iter->second;
+        }
+
+        Format::String ref = {Narrow(strings.size()), Narrow(str.size())};
+
+        strings.insert(strings.end(), str.begin(), str.end());
+        strings.push_back(0);
+
+        interned[str] = ref;
+
+        return ref;
+    }
+
+    uint32_t GameDataWriter::append(const void * value, size_t size) {
+        // every value is aligned for any of its types
+        data.resize(Align(data.size()));
+
+        uint32_t offset = Narrow(data.size());
+
+        const uint8_t * bytes = static_cast<const uint8_t*> (value);
+        data.insert(data.end(), bytes, bytes + size);
+
+        return offset;
+    }
+
+    uint32_t GameDataWriter::append(const FieldList & list) {
+        uint32_t first = Narrow(fields.size());
+
+        for (auto & field : list.getFields()) {
+            Format::Field record = {intern(field.name), ParseType(field.type), Narrow(field.count),
+                Narrow(field.offset), Narrow(field.size)};
+
+            fields.push_back(record);
+        }
+
+        return first;
+    }
+
+}
@@ -0,0 +1,129 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+#include <stdexcept>
+
+#include "IrrKlangBackend.hpp"
+
+IrrKlangBackend::IrrKlangBackend() {
+    engine = irrklang::createIrrKlangDevice();
+
+    if (!engine) {
+        throw std::runtime_error("Could not create the sound engine");
+    }
+}
+
+IrrKlangBackend::~IrrKlangBackend() {
+    for (auto & voice : voices) {
+        voice.second->setSoundStopEventReceiver(nullptr);
+        voice.second->stop();
+        voice.second->drop();
+    }
+
+    engine->drop();
+}
+
+AudioClip * IrrKlangBackend::loadClip(const std::string & path, double streamThreshold) {
+    irrklang::ISoundSource * source = engine->addSoundSourceFromFile(path.c_str(), irrklang::ESM_AUTO_DETECT, false);
+
+    if (!source) {
+        // the engine already had the file, usually from a clip which was unloaded
+        source = engine->getSoundSource(path.c_str(), false);
+    }
+
+    if (!source) {
+        throw std::runtime_error("Could not load sound " + path);
+    }
+
+    Clip * clip = new Clip();
+    clip->source = source;
+
+    // only reads the header, getplaylength returns milliseconds
+    clip->streamed = source->getPlayLength() / 1000.0 > streamThreshold;
+
+    if (clip->streamed) {
+        // irrklang reads ahead into its own buffers, and starts once it has some
+        source->setStreamMode(irrklang::ESM_STREAMING);
+        clip->size = 0;
+    } else {
+        source->setStreamMode(irrklang::ESM_NO_STREAMING);
+
+        // decodes the whole file now, instead of on the first play
+        source->getSampleData();
+        clip->size = source->getAudioFormat().getSampleDataSize();
+    }
+
+    return clip;
+}
+
+void IrrKlangBackend::unloadClip(AudioClip * clip) {
+    Clip * irrclip = static_cast<Clip*> (clip);
+
+    engine->removeSoundSource(irrclip->source);
+
+    delete irrclip;
+}
+
+bool IrrKlangBackend::play(AudioClip * clip, const struct AudioVoiceParams & params, uint64_t id) {
+    irrklang::ISoundSource * source = static_cast<Clip*> (clip)->source;
+
+    irrklang::ISound * sound;
+
+    // tracked and paused, so the receiver is set before the sound can stop
+    if (params.positional) {
+        irrklang::vec3df pos(params.x, params.y, 1);
+        sound = engine->play3D(source, pos, params.looped, true, true);
+    } else {
+        sound = engine->play2D(source, params.looped, true, true);
+    }
+
+    if (!sound) {
+        return false;
+    }
+
+    // the id goes through the engine instead of a pointer, since a voice can
+    // be freed while its stop is still being handled
+    sound->setSoundStopEventReceiver(this, reinterpret_cast<void*> (static_cast<uintptr_t> (id)));
+    sound->setVolume(params.volume);
+    sound->setPlaybackSpeed(params.pitch);
+    sound->setIsPaused(false);
+
+    voices[id] = sound;
+
+    return true;
+}
+
+void IrrKlangBackend::stop(uint64_t id) {
+    auto iter = voices.find(id);
+
+    if (iter == voices.end()) {
+        return;
+    }
+
+    iter->second->setSoundStopEventReceiver(nullptr);
+    iter->second->stop();
+    iter->second->drop();
+
+    voices.erase(iter);
+}
+
+void IrrKlangBackend::setListener(float x, float y) {
+    // the sounds are in front of the listener, on the z = 1 plane
+    engine->setListenerPosition(irrklang::vec3df(x, y, 0), irrklang::vec3df(0, 0, 1));
+}
+
+void IrrKlangBackend::OnSoundStopped(irrklang::ISound* sound, irrklang::E_STOP_EVENT_CAUSE reason, void* userData) {
+    // stops from stop() are never reported, and this may be called from it
+    if (reason == irrklang::ESEC_SOUND_STOPPED_BY_USER) {
+        return;
+    }
+
+    AudioStopListener * listener = stopListener.load();
+
+    if (listener) {
+        listener->OnVoiceStopped(reinterpret_cast<uintptr_t> (userData));
+    }
+}
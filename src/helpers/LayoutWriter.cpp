@@ -0,0 +1,317 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+#include <cctype>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <experimental/filesystem>
+
+#include "game/parsing/LayoutWriter.hpp"
+
+namespace Game {
+
+    namespace {
+
+        /**
+         * Splits a name into its words, 'chroma key' is 'chroma' and 'key'
+         */
+        std::vector<std::string> Words(ConstString name) {
+            std::vector<std::string> words(1);
+
+            for (char c : name) {
+                if (std::isalnum(static_cast<unsigned char> (c))) {
+                    words.back() += c;
+                } else if (!words.back().empty()) {
+                    words.emplace_back();
+                }
+            }
+
+            if (words.back().empty()) {
+                words.pop_back();
+            }
+
+            if (words.empty() || std::isdigit(static_cast<unsigned char> (words[0][0]))) {
+                throw format_error("'" + name + "' can't be made into an identifier");
+            }
+
+            return words;
+        }
+
+        /**
+         * @return The name as a type, 'chroma key' is 'ChromaKey'
+         */
+        std::string TypeName(ConstString name) {
+            std::string result;
+
+            for (std::string word : Words(name)) {
+                word[0] = std::toupper(static_cast<unsigned char> (word[0]));
+                result += word;
+            }
+
+            return result;
+        }
+
+        /**
+         * @return The name as a member, 'max speed' is 'maxSpeed'
+         */
+        std::string MemberName(ConstString name) {
+            std::string result = TypeName(name);
+
+            result[0] = std::tolower(static_cast<unsigned char> (result[0]));
+
+            return result;
+        }
+
+        /**
+         * @return The name as a constant, 'chroma key' is 'CHROMA_KEY'
+         */
+        std::string ConstantName(ConstString name) {
+            std::string result;
+
+            for (std::string word : Words(name)) {
+                for (char & c : word) {
+                    c = std::toupper(static_cast<unsigned char> (c));
+                }
+
+                result += (result.empty() ? "" : "_") + word;
+            }
+
+            return result;
+        }
+
+        std::string CppType(const FieldList::Field & field) {
+            if (field.components == 1) {
+                return field.type == "int" ? "int32_t" : "float";
+            }
+
+            return std::string(field.type == "int" ? "glm::ivec" : "glm::vec") + std::to_string(field.components);
+        }
+
+        std::string GLSLType(const FieldList::Field & field) {
+            if (field.components == 1) {
+                return field.type;
+            }
+
+            return std::string(field.type == "int" ? "ivec" : "vec") + std::to_string(field.components);
+        }
+
+        const char * LayoutName(BlockLayout layout) {
+            return layout == BlockLayout::eStd140 ? "std140" : "std430";
+        }
+
+        /**
+         * Calls a function with each definition's type name, in a fixed order
+         */
+        template<typename F>
+        void ForEach(const std::map<std::string, const FieldList*> & uboprototypes,
+                const std::map<std::string, const FieldList*> & push_constants, F function) {
+            std::set<std::string> names;
+
+            auto visit = [&](const std::map<std::string, const FieldList*> & from, const char * kind, const char * suffix) {
+                for (auto & item : from) {
+                    std::string type = TypeName(item.first) + suffix;
+
+                    if (!names.insert(type).second) {
+                        throw format_error("The " + std::string(kind) + " '" + item.first + "' has the same generated name as another, " + type);
+                    }
+
+                    if (item.second->getFields().empty()) {
+                        throw format_error("The " + std::string(kind) + " '" + item.first + "' has no fields");
+                    }
+
+                    // the members go in the same namespace, so they can't collide either
+                    std::set<std::string> members;
+
+                    for (auto & field : item.second->getFields()) {
+                        if (!members.insert(MemberName(field.name)).second) {
+                            throw format_error("Field '" + field.name + "' in '" + item.first + "' has the same generated name as another");
+                        }
+                    }
+
+                    function(item.first, kind, type, *item.second);
+                }
+            };
+
+            visit(uboprototypes, "ubo prototype", "UBO");
+            visit(push_constants, "push constant", "PushConstant");
+        }
+
+        /**
+         * Replaces a file only if its contents changed, so whatever includes
+         * it isn't rebuilt for nothing
+         * @return Whether the file was replaced
+         */
+        bool Replace(ConstString path, ConstString contents) {
+            std::ifstream existing(path, std::ios::binary);
+
+            if (existing) {
+                std::stringstream current;
+                current << existing.rdbuf();
+
+                if (current.str() == contents) {
+                    return false;
+                }
+            }
+
+            existing.close();
+
+            std::string temporary = path + ".tmp";
+
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+
+            if (!file) {
+                throw std::runtime_error("Could not open " + temporary);
+            }
+
+            file << contents;
+            file.close();
+
+            if (!file) {
+                throw std::runtime_error("Could not write " + temporary);
+            }
+
+            std::error_code error;
+            std::experimental::filesystem::rename(temporary, path, error);
+
+            if (error) {
+                throw std::runtime_error("Could not replace " + path + ": " + error.message());
+            }
+
+            return true;
+        }
+
+        /**
+         * @return The include guard for a generated file, from its name
+         */
+        std::string Guard(ConstString path, const char * extension) {
+            return ConstantName(std::experimental::filesystem::path(path).stem().string()) + "_" + extension;
+        }
+
+        const char * GENERATED_NOTICE = "// Generated by game_data_compiler from the game files, don't edit it.\n";
+
+    }
+
+    void LayoutWriter::add(const GameContext & context) {
+        for (auto & prototype : context.getUBOPrototypes()) {
+            uboprototypes[prototype.first] = prototype.second.getFields();
+        }
+
+        for (auto & constant : context.getPushConstants()) {
+            push_constants[constant.first] = constant.second.getFields();
+        }
+    }
+
+    bool LayoutWriter::writeHeader(ConstString path) const {
+        std::string guard = Guard(path, "HPP");
+
+        std::ostringstream out;
+
+        out << GENERATED_NOTICE
+                << "\n#ifndef " << guard << "\n#define " << guard << "\n\n"
+                << "#include <glm/glm.hpp>\n\n"
+                << "#include <cstddef>\n#include <cstdint>\n#include <type_traits>\n\n"
+                << "#include \"GpuStruct.hpp\"\n\n"
+                << "namespace GameLayouts {\n";
+
+        ForEach(uboprototypes, push_constants, [&](ConstString name, const char * kind, ConstString type, const FieldList & list) {
+            const char * layout = LayoutName(list.getLayout());
+
+            out << "\n    // the '" << name << "' " << kind << ", laid out by " << layout << "\n"
+                    << "    struct " << type << " {\n"
+                    << "        static constexpr size_t SIZE = " << list.size() << ";\n";
+
+            for (auto & field : list.getFields()) {
+                out << "        static constexpr size_t " << ConstantName(field.name) << "_OFFSET = " << field.offset << ";\n";
+            }
+
+            out << "\n";
+
+            // glm's types are only aligned to their components, so all the padding is spelled out
+            size_t end = 0, paddings = 0;
+
+            for (auto & field : list.getFields()) {
+                if (field.offset > end) {
+                    out << "        uint8_t padding" << paddings++ << "[" << field.offset - end << "];\n";
+                }
+
+                std::string member = CppType(field);
+
+                if (field.array && field.stride != field.components * 4) {
+                    member = "Padded<" + member + ", " + std::to_string(field.stride) + ">";
+                }
+
+                out << "        " << member << " " << MemberName(field.name);
+
+                if (field.array) {
+                    out << "[" << field.array << "]";
+                }
+
+                out << ";\n";
+
+                end = field.offset + field.size;
+            }
+
+            if (list.size() > end) {
+                out << "        uint8_t padding" << paddings++ << "[" << list.size() - end << "];\n";
+            }
+
+            out << "    };\n\n"
+                    << "    static_assert(std::is_standard_layout<" << type << ">::value, \"" << type << " has to be laid out like a C struct\");\n"
+                    << "    static_assert(sizeof (" << type << ") == " << type << "::SIZE, \"" << type << " doesn't match its " << layout << " size\");\n";
+
+            for (auto & field : list.getFields()) {
+                std::string member = MemberName(field.name);
+
+                out << "    static_assert(offsetof(" << type << ", " << member << ") == " << type << "::" << ConstantName(field.name)
+                        << "_OFFSET, \"" << type << "::" << member << " doesn't match its " << layout << " offset\");\n";
+            }
+        });
+
+        out << "\n}\n\n#endif /* " << guard << " */\n";
+
+        return Replace(path, out.str());
+    }
+
+    bool LayoutWriter::writeGLSL(ConstString path) const {
+        std::string guard = Guard(path, "GLSL");
+
+        std::ostringstream out;
+
+        out << GENERATED_NOTICE
+                << "// Each block's members are a macro, which is used as the block's body:\n"
+                << "//     layout(push_constant) uniform Info { GAME_OBJECT_PUSH_CONSTANT } info;\n"
+                << "// The members are given their offsets, so glslang rejects a block whose\n"
+                << "// layout doesn't match the game's.\n"
+                << "\n#ifndef " << guard << "\n#define " << guard << "\n";
+
+        ForEach(uboprototypes, push_constants, [&](ConstString name, const char * kind, ConstString type, const FieldList & list) {
+            std::string macro = ConstantName(name) + (std::string(kind) == "ubo prototype" ? "_UBO" : "_PUSH_CONSTANT");
+
+            out << "\n// the '" << name << "' " << kind << ", laid out by " << LayoutName(list.getLayout()) << "\n"
+                    << "#define " << macro;
+
+            for (auto & field : list.getFields()) {
+                out << " \\\n    layout(offset = " << field.offset << ") " << GLSLType(field) << " " << MemberName(field.name);
+
+                if (field.array) {
+                    out << "[" << field.array << "]";
+                }
+
+                out << ";";
+            }
+
+            out << "\n\n#define " << macro << "_SIZE " << list.size() << "\n";
+        });
+
+        out << "\n#endif\n";
+
+        return Replace(path, out.str());
+    }
+
+}
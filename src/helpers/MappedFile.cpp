@@ -0,0 +1,110 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string & path) {
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE) {
+        file = nullptr;
+        throw std::runtime_error("Could not open " + path);
+    }
+
+    LARGE_INTEGER length;
+
+    if (!GetFileSizeEx(file, &length)) {
+        CloseHandle(file);
+        throw std::runtime_error("Could not get the size of " + path);
+    }
+
+    size = static_cast<size_t> (length.QuadPart);
+
+    // an empty file can't be mapped, but it's still a valid file
+    if (size == 0) {
+        return;
+    }
+
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (mapping) {
+        data = static_cast<const uint8_t*> (MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    }
+
+    if (!data) {
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+
+        CloseHandle(file);
+        throw std::runtime_error("Could not map " + path);
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (data) {
+        UnmapViewOfFile(data);
+        CloseHandle(mapping);
+    }
+
+    CloseHandle(file);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string & path) {
+    int fd = open(path.c_str(), O_RDONLY);
+
+    if (fd < 0) {
+        throw std::runtime_error("Could not open " + path);
+    }
+
+    struct stat info;
+
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw std::runtime_error("Could not get the size of " + path);
+    }
+
+    size = static_cast<size_t> (info.st_size);
+
+    // an empty file can't be mapped, but it's still a valid file
+    if (size > 0) {
+        void * mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (mapped == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Could not map " + path);
+        }
+
+        data = static_cast<const uint8_t*> (mapped);
+    }
+
+    // the mapping keeps the file open
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data) {
+        munmap(const_cast<uint8_t*> (data), size);
+    }
+}
+
+#endif
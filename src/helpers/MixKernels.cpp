@@ -0,0 +1,452 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+#include "MixKernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MIXKERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define MIXKERNELS_TARGET(arch)
+#else
+#define MIXKERNELS_TARGET(arch) __attribute__((target(arch)))
+#endif
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define MIXKERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+    using Level = MixKernels::Level;
+
+    const float INT16_SCALE = 32767.0f;
+
+    // <editor-fold defaultstate="collapsed" desc="Scalar">
+
+    // every path finds the sample positions the same way, so they agree exactly:
+    // the fractional start plus the index times the step, in single precision
+    inline float ResamplePoint(const float * src, float frac, float step, size_t i) {
+        float p = frac + static_cast<float> (i) * step;
+        int32_t index = static_cast<int32_t> (p);
+        float t = p - static_cast<float> (index);
+
+        float a = src[index], b = src[index + 1];
+
+        return a + (b - a) * t;
+    }
+
+    void ResampleScalar(const float * src, float frac, float step, float * dst, size_t count, size_t first) {
+        for (size_t i = first; i < count; i++) {
+            dst[i] = ResamplePoint(src, frac, step, i);
+        }
+    }
+
+    void MixStereoScalar(const float * left, const float * right, float leftGain, float rightGain,
+            float * dst, size_t count, size_t first) {
+        for (size_t i = first; i < count; i++) {
+            dst[i * 2] += left[i] * leftGain;
+            dst[i * 2 + 1] += right[i] * rightGain;
+        }
+    }
+
+    void ScaleScalar(float * samples, size_t count, float gain, size_t first) {
+        for (size_t i = first; i < count; i++) {
+            samples[i] *= gain;
+        }
+    }
+
+    void ToInt16Scalar(const float * src, int16_t * dst, size_t count, size_t first) {
+        for (size_t i = first; i < count; i++) {
+            float v = std::min(std::max(src[i], -1.0f), 1.0f) * INT16_SCALE;
+
+            // rounds to nearest even, like the vector conversions
+            dst[i] = static_cast<int16_t> (std::nearbyint(v));
+        }
+    }
+
+    void ResampleScalarAll(const float * src, float frac, float step, float * dst, size_t count) {
+        ResampleScalar(src, frac, step, dst, count, 0);
+    }
+
+    void MixStereoScalarAll(const float * left, const float * right, float leftGain, float rightGain,
+            float * dst, size_t count) {
+        MixStereoScalar(left, right, leftGain, rightGain, dst, count, 0);
+    }
+
+    void ScaleScalarAll(float * samples, size_t count, float gain) {
+        ScaleScalar(samples, count, gain, 0);
+    }
+
+    void ToInt16ScalarAll(const float * src, int16_t * dst, size_t count) {
+        ToInt16Scalar(src, dst, count, 0);
+    }
+
+    // </editor-fold>
+
+#ifdef MIXKERNELS_X86
+
+    // <editor-fold defaultstate="collapsed" desc="SSE2">
+
+    MIXKERNELS_TARGET("sse2")
+    void ResampleSSE2(const float * src, float frac, float step, float * dst, size_t count) {
+        const __m128 vfrac = _mm_set1_ps(frac), vstep = _mm_set1_ps(step);
+        const __m128 lanes = _mm_setr_ps(0, 1, 2, 3);
+
+        alignas(16) int32_t index[4];
+
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128 fi = _mm_add_ps(_mm_set1_ps(static_cast<float> (i)), lanes);
+            __m128 p = _mm_add_ps(vfrac, _mm_mul_ps(fi, vstep));
+
+            __m128i vindex = _mm_cvttps_epi32(p);
+            __m128 t = _mm_sub_ps(p, _mm_cvtepi32_ps(vindex));
+
+            _mm_store_si128(reinterpret_cast<__m128i*> (index), vindex);
+
+            // there's no gather before avx2
+            __m128 a = _mm_setr_ps(src[index[0]], src[index[1]], src[index[2]], src[index[3]]);
+            __m128 b = _mm_setr_ps(src[index[0] + 1], src[index[1] + 1], src[index[2] + 1], src[index[3] + 1]);
+
+            _mm_storeu_ps(dst + i, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t)));
+        }
+
+        ResampleScalar(src, frac, step, dst, count, i);
+    }
+
+    MIXKERNELS_TARGET("sse2")
+    void MixStereoSSE2(const float * left, const float * right, float leftGain, float rightGain,
+            float * dst, size_t count) {
+        const __m128 lg = _mm_set1_ps(leftGain), rg = _mm_set1_ps(rightGain);
+
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128 l = _mm_mul_ps(_mm_loadu_ps(left + i), lg);
+            __m128 r = _mm_mul_ps(_mm_loadu_ps(right + i), rg);
+
+            float * out = dst + i * 2;
+
+            _mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), _mm_unpacklo_ps(l, r)));
+            _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), _mm_unpackhi_ps(l, r)));
+        }
+
+        MixStereoScalar(left, right, leftGain, rightGain, dst, count, i);
+    }
+
+    MIXKERNELS_TARGET("sse2")
+    void ScaleSSE2(float * samples, size_t count, float gain) {
+        const __m128 g = _mm_set1_ps(gain);
+
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(samples + i), g));
+        }
+
+        ScaleScalar(samples, count, gain, i);
+    }
+
+    MIXKERNELS_TARGET("sse2")
+    void ToInt16SSE2(const float * src, int16_t * dst, size_t count) {
+        const __m128 lo = _mm_set1_ps(-1.0f), hi = _mm_set1_ps(1.0f), scale = _mm_set1_ps(INT16_SCALE);
+
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m128 a = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i), lo), hi), scale);
+            __m128 b = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 4), lo), hi), scale);
+
+            // the conversion rounds to nearest even under the default mode
+            __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*> (dst + i), packed);
+        }
+
+        ToInt16Scalar(src, dst, count, i);
+    }
+
+    // </editor-fold>
+
+    // <editor-fold defaultstate="collapsed" desc="AVX2">
+
+    MIXKERNELS_TARGET("avx2")
+    void ResampleAVX2(const float * src, float frac, float step, float * dst, size_t count) {
+        const __m256 vfrac = _mm256_set1_ps(frac), vstep = _mm256_set1_ps(step);
+        const __m256 lanes = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256 fi = _mm256_add_ps(_mm256_set1_ps(static_cast<float> (i)), lanes);
+            __m256 p = _mm256_add_ps(vfrac, _mm256_mul_ps(fi, vstep));
+
+            __m256i index = _mm256_cvttps_epi32(p);
+            __m256 t = _mm256_sub_ps(p, _mm256_cvtepi32_ps(index));
+
+            __m256 a = _mm256_i32gather_ps(src, index, 4);
+            __m256 b = _mm256_i32gather_ps(src + 1, index, 4);
+
+            _mm256_storeu_ps(dst + i, _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), t)));
+        }
+
+        ResampleScalar(src, frac, step, dst, count, i);
+    }
+
+    MIXKERNELS_TARGET("avx2")
+    void MixStereoAVX2(const float * left, const float * right, float leftGain, float rightGain,
+            float * dst, size_t count) {
+        const __m256 lg = _mm256_set1_ps(leftGain), rg = _mm256_set1_ps(rightGain);
+
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256 l = _mm256_mul_ps(_mm256_loadu_ps(left + i), lg);
+            __m256 r = _mm256_mul_ps(_mm256_loadu_ps(right + i), rg);
+
+            // unpacking works within each 128 bit half, so the halves are swapped after
+            __m256 lo = _mm256_unpacklo_ps(l, r), hi = _mm256_unpackhi_ps(l, r);
+
+            float * out = dst + i * 2;
+
+            _mm256_storeu_ps(out, _mm256_add_ps(_mm256_loadu_ps(out), _mm256_permute2f128_ps(lo, hi, 0x20)));
+            _mm256_storeu_ps(out + 8, _mm256_add_ps(_mm256_loadu_ps(out + 8), _mm256_permute2f128_ps(lo, hi, 0x31)));
+        }
+
+        MixStereoScalar(left, right, leftGain, rightGain, dst, count, i);
+    }
+
+    MIXKERNELS_TARGET("avx2")
+    void ScaleAVX2(float * samples, size_t count, float gain) {
+        const __m256 g = _mm256_set1_ps(gain);
+
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            _mm256_storeu_ps(samples + i, _mm256_mul_ps(_mm256_loadu_ps(samples + i), g));
+        }
+
+        ScaleScalar(samples, count, gain, i);
+    }
+
+    MIXKERNELS_TARGET("avx2")
+    void ToInt16AVX2(const float * src, int16_t * dst, size_t count) {
+        const __m256 lo = _mm256_set1_ps(-1.0f), hi = _mm256_set1_ps(1.0f), scale = _mm256_set1_ps(INT16_SCALE);
+
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16) {
+            __m256 a = _mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(src + i), lo), hi), scale);
+            __m256 b = _mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(src + i + 8), lo), hi), scale);
+
+            // packing interleaves the halves, so the 64 bit quarters are put back in order
+            __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+            packed = _mm256_permute4x64_epi64(packed, 0xD8);
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*> (dst + i), packed);
+        }
+
+        ToInt16Scalar(src, dst, count, i);
+    }
+
+    // </editor-fold>
+
+#endif
+
+#ifdef MIXKERNELS_NEON
+
+    // <editor-fold defaultstate="collapsed" desc="NEON">
+
+    void ResampleNEON(const float * src, float frac, float step, float * dst, size_t count) {
+        const float32x4_t vfrac = vdupq_n_f32(frac), vstep = vdupq_n_f32(step);
+        const float lanesInit[4] = {0, 1, 2, 3};
+        const float32x4_t lanes = vld1q_f32(lanesInit);
+
+        int32_t index[4];
+
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            float32x4_t fi = vaddq_f32(vdupq_n_f32(static_cast<float> (i)), lanes);
+            float32x4_t p = vaddq_f32(vfrac, vmulq_f32(fi, vstep));
+
+            int32x4_t vindex = vcvtq_s32_f32(p);
+            float32x4_t t = vsubq_f32(p, vcvtq_f32_s32(vindex));
+
+            vst1q_s32(index, vindex);
+
+            float a[4] = {src[index[0]], src[index[1]], src[index[2]], src[index[3]]};
+            float b[4] = {src[index[0] + 1], src[index[1] + 1], src[index[2] + 1], src[index[3] + 1]};
+
+            float32x4_t va = vld1q_f32(a), vb = vld1q_f32(b);
+
+            // a separate multiply and add, a fused one would round differently to the scalar path
+            vst1q_f32(dst + i, vaddq_f32(va, vmulq_f32(vsubq_f32(vb, va), t)));
+        }
+
+        ResampleScalar(src, frac, step, dst, count, i);
+    }
+
+    void MixStereoNEON(const float * left, const float * right, float leftGain, float rightGain,
+            float * dst, size_t count) {
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            float32x4x2_t out = vld2q_f32(dst + i * 2);
+
+            out.val[0] = vaddq_f32(out.val[0], vmulq_n_f32(vld1q_f32(left + i), leftGain));
+            out.val[1] = vaddq_f32(out.val[1], vmulq_n_f32(vld1q_f32(right + i), rightGain));
+
+            vst2q_f32(dst + i * 2, out);
+        }
+
+        MixStereoScalar(left, right, leftGain, rightGain, dst, count, i);
+    }
+
+    void ScaleNEON(float * samples, size_t count, float gain) {
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            vst1q_f32(samples + i, vmulq_n_f32(vld1q_f32(samples + i), gain));
+        }
+
+        ScaleScalar(samples, count, gain, i);
+    }
+
+    void ToInt16NEON(const float * src, int16_t * dst, size_t count) {
+        const float32x4_t lo = vdupq_n_f32(-1.0f), hi = vdupq_n_f32(1.0f);
+
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            float32x4_t a = vmulq_n_f32(vminq_f32(vmaxq_f32(vld1q_f32(src + i), lo), hi), INT16_SCALE);
+            float32x4_t b = vmulq_n_f32(vminq_f32(vmaxq_f32(vld1q_f32(src + i + 4), lo), hi), INT16_SCALE);
+
+            int16x8_t packed = vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(a)), vqmovn_s32(vcvtnq_s32_f32(b)));
+
+            vst1q_s16(dst + i, packed);
+        }
+
+        ToInt16Scalar(src, dst, count, i);
+    }
+
+    // </editor-fold>
+
+#endif
+
+    struct KernelTable {
+        Level level;
+        void (*resample)(const float *, float, float, float *, size_t);
+        void (*mixStereo)(const float *, const float *, float, float, float *, size_t);
+        void (*scale)(float *, size_t, float);
+        void (*toInt16)(const float *, int16_t *, size_t);
+    };
+
+    Level DetectLevel() {
+#if defined(MIXKERNELS_X86)
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        int maxLeaf = info[0];
+
+        __cpuid(info, 1);
+        bool sse2 = (info[3] & (1 << 26)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+
+        bool avx2 = false;
+        if (maxLeaf >= 7 && osxsave && (_xgetbv(0) & 0x6) == 0x6) {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0;
+        }
+#else
+        __builtin_cpu_init();
+        bool sse2 = __builtin_cpu_supports("sse2");
+        bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+        if (avx2) {
+            return Level::eAVX2;
+        }
+        if (sse2) {
+            return Level::eSSE2;
+        }
+        return Level::eScalar;
+#elif defined(MIXKERNELS_NEON)
+        // NEON is mandatory on aarch64
+        return Level::eNEON;
+#else
+        return Level::eScalar;
+#endif
+    }
+
+    KernelTable CreateTable(Level level) {
+        KernelTable table = {Level::eScalar, ResampleScalarAll, MixStereoScalarAll, ScaleScalarAll, ToInt16ScalarAll};
+
+#if defined(MIXKERNELS_X86)
+        if (level == Level::eSSE2) {
+            table = {Level::eSSE2, ResampleSSE2, MixStereoSSE2, ScaleSSE2, ToInt16SSE2};
+        }
+        if (level == Level::eAVX2) {
+            table = {Level::eAVX2, ResampleAVX2, MixStereoAVX2, ScaleAVX2, ToInt16AVX2};
+        }
+#elif defined(MIXKERNELS_NEON)
+        if (level == Level::eNEON) {
+            table = {Level::eNEON, ResampleNEON, MixStereoNEON, ScaleNEON, ToInt16NEON};
+        }
+#endif
+
+        return table;
+    }
+
+    KernelTable & Table() {
+        static KernelTable table = CreateTable(DetectLevel());
+        return table;
+    }
+
+}
+
+MixKernels::Level MixKernels::GetSupportedLevel() {
+    static Level level = DetectLevel();
+    return level;
+}
+
+MixKernels::Level MixKernels::GetLevel() {
+    return Table().level;
+}
+
+MixKernels::Level MixKernels::SetLevel(Level level) {
+    Level supported = GetSupportedLevel();
+
+    // the levels only form a chain on x86, neon is all or nothing
+    bool valid = level == Level::eScalar || level == supported ||
+            (supported != Level::eNEON && level != Level::eNEON && level < supported);
+
+    Table() = CreateTable(valid ? level : supported);
+
+    return Table().level;
+}
+
+const char * MixKernels::GetLevelName(Level level) {
+    switch (level) {
+        case Level::eSSE2: return "SSE2";
+        case Level::eAVX2: return "AVX2";
+        case Level::eNEON: return "NEON";
+        default: return "Scalar";
+    }
+}
+
+void MixKernels::Resample(const float * src, double position, float step, float * dst, size_t count) {
+    // the whole part is applied to the pointer, so the kernels only see small positions
+    double whole = std::floor(position);
+
+    Table().resample(src + static_cast<size_t> (whole), static_cast<float> (position - whole), step, dst, count);
+}
+
+void MixKernels::MixStereo(const float * left, const float * right, float leftGain, float rightGain,
+        float * dst, size_t count) {
+    Table().mixStereo(left, right, leftGain, rightGain, dst, count);
+}
+
+void MixKernels::Scale(float * samples, size_t count, float gain) {
+    Table().scale(samples, count, gain);
+}
+
+void MixKernels::ToInt16(const float * src, int16_t * dst, size_t count) {
+    Table().toInt16(src, dst, count);
+}
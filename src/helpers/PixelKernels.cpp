@@ -0,0 +1,644 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+#include "PixelKernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PIXELKERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define PIXELKERNELS_TARGET(arch)
+#else
+#define PIXELKERNELS_TARGET(arch) __attribute__((target(arch)))
+#endif
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define PIXELKERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+    using Level = PixelKernels::Level;
+
+    // The chroma key with everything the inner loop needs precomputed
+    struct PreparedKey {
+        float search[4], delta[4];
+        float epsilon1, invRange;
+
+        PreparedKey(const PixelKernels::ChromaKeyParams & key) {
+            for (int c = 0; c < 4; c++) {
+                search[c] = key.search[c];
+                delta[c] = key.replace[c] - key.search[c];
+            }
+            epsilon1 = key.epsilon1;
+            invRange = 1.0f / (key.epsilon2 - key.epsilon1);
+        }
+    };
+
+    const float INV_255 = 1.0f / 255.0f;
+
+    // <editor-fold defaultstate="collapsed" desc="Scalar">
+
+    void ExpandScalar(const uint8_t * src, uint8_t * dst, size_t count, bool swap) {
+        const int r = swap ? 2 : 0, b = swap ? 0 : 2;
+
+        for (size_t i = 0; i < count; i++, src += 3, dst += 4) {
+            dst[0] = src[r];
+            dst[1] = src[1];
+            dst[2] = src[b];
+            dst[3] = 0xFF;
+        }
+    }
+
+    void ExpandRGBScalar(const uint8_t * src, uint8_t * dst, size_t count) {
+        ExpandScalar(src, dst, count, false);
+    }
+
+    void ExpandBGRScalar(const uint8_t * src, uint8_t * dst, size_t count) {
+        ExpandScalar(src, dst, count, true);
+    }
+
+    void SwizzleScalar(uint8_t * pixels, size_t count) {
+        for (size_t i = 0; i < count; i++, pixels += 4) {
+            std::swap(pixels[0], pixels[2]);
+        }
+    }
+
+    // round(c * a / 255) without a division, the vector paths use the same trick
+    inline uint8_t MulDiv255(unsigned c, unsigned a) {
+        unsigned t = c * a + 128;
+        return static_cast<uint8_t> ((t + (t >> 8)) >> 8);
+    }
+
+    void PremultiplyScalar(uint8_t * pixels, size_t count) {
+        for (size_t i = 0; i < count; i++, pixels += 4) {
+            unsigned a = pixels[3];
+            pixels[0] = MulDiv255(pixels[0], a);
+            pixels[1] = MulDiv255(pixels[1], a);
+            pixels[2] = MulDiv255(pixels[2], a);
+        }
+    }
+
+    inline void ChromaKeyPixel(uint8_t * px, const PreparedKey & key) {
+        float c[4], d2 = 0;
+
+        for (int i = 0; i < 4; i++) {
+            c[i] = px[i] * INV_255;
+            float d = c[i] - key.search[i];
+            d2 = d2 + d * d;
+        }
+
+        float a = (std::sqrt(d2) - key.epsilon1) * key.invRange;
+        float k = 1.0f - std::min(std::max(a, 0.0f), 1.0f);
+
+        for (int i = 0; i < 4; i++) {
+            float v = std::min(std::max(c[i] + key.delta[i] * k, 0.0f), 1.0f);
+            px[i] = static_cast<uint8_t> (static_cast<int> (v * 255.0f + 0.5f));
+        }
+    }
+
+    void ChromaKeyScalar(uint8_t * pixels, size_t count, const PixelKernels::ChromaKeyParams & params) {
+        PreparedKey key(params);
+
+        for (size_t i = 0; i < count; i++) {
+            ChromaKeyPixel(pixels + i * 4, key);
+        }
+    }
+
+    // </editor-fold>
+
+#ifdef PIXELKERNELS_X86
+
+    // <editor-fold defaultstate="collapsed" desc="SSE2 / SSSE3">
+
+    PIXELKERNELS_TARGET("sse2")
+    void SwizzleSSE2(uint8_t * pixels, size_t count) {
+        const __m128i ga = _mm_set1_epi32(static_cast<int> (0xFF00FF00));
+        const __m128i low = _mm_set1_epi32(0xFF);
+
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*> (pixels + i * 4));
+
+            __m128i r = _mm_slli_epi32(_mm_and_si128(v, low), 16);
+            __m128i b = _mm_and_si128(_mm_srli_epi32(v, 16), low);
+
+            v = _mm_or_si128(_mm_and_si128(v, ga), _mm_or_si128(r, b));
+            _mm_storeu_si128(reinterpret_cast<__m128i*> (pixels + i * 4), v);
+        }
+
+        SwizzleScalar(pixels + i * 4, count - i);
+    }
+
+    PIXELKERNELS_TARGET("sse2")
+    inline __m128i PremultiplyHalfSSE2(__m128i px) {
+        // per pixel: r g b a -> a a a 255, so alpha is multiplied back to itself
+        const __m128i rgbMask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+        const __m128i alphaOne = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+        const __m128i round = _mm_set1_epi16(128);
+
+        __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(px, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        a = _mm_or_si128(_mm_and_si128(a, rgbMask), alphaOne);
+
+        __m128i t = _mm_add_epi16(_mm_mullo_epi16(px, a), round);
+        return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+    }
+
+    PIXELKERNELS_TARGET("sse2")
+    void PremultiplySSE2(uint8_t * pixels, size_t count) {
+        const __m128i zero = _mm_setzero_si128();
+
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*> (pixels + i * 4));
+
+            __m128i lo = PremultiplyHalfSSE2(_mm_unpacklo_epi8(v, zero));
+            __m128i hi = PremultiplyHalfSSE2(_mm_unpackhi_epi8(v, zero));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*> (pixels + i * 4), _mm_packus_epi16(lo, hi));
+        }
+
+        PremultiplyScalar(pixels + i * 4, count - i);
+    }
+
+    PIXELKERNELS_TARGET("sse2")
+    void ChromaKeySSE2(uint8_t * pixels, size_t count, const PixelKernels::ChromaKeyParams & params) {
+        PreparedKey key(params);
+
+        const __m128i mask = _mm_set1_epi32(0xFF);
+        const __m128 inv255 = _mm_set1_ps(INV_255), scale = _mm_set1_ps(255.0f), half = _mm_set1_ps(0.5f);
+        const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+        const __m128 eps1 = _mm_set1_ps(key.epsilon1), invRange = _mm_set1_ps(key.invRange);
+
+        __m128 search[4], delta[4];
+        for (int c = 0; c < 4; c++) {
+            search[c] = _mm_set1_ps(key.search[c]);
+            delta[c] = _mm_set1_ps(key.delta[c]);
+        }
+
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*> (pixels + i * 4));
+
+            // one register per channel, four pixels each
+            __m128 c[4];
+            c[0] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(v, mask)), inv255);
+            c[1] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 8), mask)), inv255);
+            c[2] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 16), mask)), inv255);
+            c[3] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(v, 24)), inv255);
+
+            __m128 d2 = zero;
+            for (int ch = 0; ch < 4; ch++) {
+                __m128 d = _mm_sub_ps(c[ch], search[ch]);
+                d2 = _mm_add_ps(d2, _mm_mul_ps(d, d));
+            }
+
+            __m128 a = _mm_mul_ps(_mm_sub_ps(_mm_sqrt_ps(d2), eps1), invRange);
+            __m128 k = _mm_sub_ps(one, _mm_min_ps(_mm_max_ps(a, zero), one));
+
+            __m128i out = _mm_setzero_si128();
+            for (int ch = 0; ch < 4; ch++) {
+                __m128 o = _mm_min_ps(_mm_max_ps(_mm_add_ps(c[ch], _mm_mul_ps(delta[ch], k)), zero), one);
+                __m128i oi = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(o, scale), half));
+                out = _mm_or_si128(out, _mm_slli_epi32(oi, ch * 8));
+            }
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*> (pixels + i * 4), out);
+        }
+
+        for (; i < count; i++) {
+            ChromaKeyPixel(pixels + i * 4, key);
+        }
+    }
+
+    PIXELKERNELS_TARGET("ssse3")
+    void ExpandSSSE3(const uint8_t * src, uint8_t * dst, size_t count, bool swap) {
+        const __m128i shuffle = swap ?
+                _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1) :
+                _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m128i alpha = _mm_set1_epi32(static_cast<int> (0xFF000000));
+
+        // each load reads 16 bytes but only uses 12, so stop before reading past the end
+        size_t i = 0;
+        for (; i + 6 <= count; i += 4) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*> (src + i * 3));
+            v = _mm_or_si128(_mm_shuffle_epi8(v, shuffle), alpha);
+            _mm_storeu_si128(reinterpret_cast<__m128i*> (dst + i * 4), v);
+        }
+
+        ExpandScalar(src + i * 3, dst + i * 4, count - i, swap);
+    }
+
+    void ExpandRGBSSSE3(const uint8_t * src, uint8_t * dst, size_t count) {
+        ExpandSSSE3(src, dst, count, false);
+    }
+
+    void ExpandBGRSSSE3(const uint8_t * src, uint8_t * dst, size_t count) {
+        ExpandSSSE3(src, dst, count, true);
+    }
+
+    // </editor-fold>
+
+    // <editor-fold defaultstate="collapsed" desc="AVX2">
+
+    PIXELKERNELS_TARGET("avx2")
+    void ExpandAVX2(const uint8_t * src, uint8_t * dst, size_t count, bool swap) {
+        // the shuffle works per 128 bit lane, so each lane gets 4 pixels from its own load
+        const __m256i shuffle = swap ?
+                _mm256_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+                2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1) :
+                _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m256i alpha = _mm256_set1_epi32(static_cast<int> (0xFF000000));
+
+        size_t i = 0;
+        for (; i + 10 <= count; i += 8) {
+            __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*> (src + i * 3));
+            __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*> (src + i * 3 + 12));
+
+            __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+            v = _mm256_or_si256(_mm256_shuffle_epi8(v, shuffle), alpha);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*> (dst + i * 4), v);
+        }
+
+        ExpandScalar(src + i * 3, dst + i * 4, count - i, swap);
+    }
+
+    void ExpandRGBAVX2(const uint8_t * src, uint8_t * dst, size_t count) {
+        ExpandAVX2(src, dst, count, false);
+    }
+
+    void ExpandBGRAVX2(const uint8_t * src, uint8_t * dst, size_t count) {
+        ExpandAVX2(src, dst, count, true);
+    }
+
+    PIXELKERNELS_TARGET("avx2")
+    void SwizzleAVX2(uint8_t * pixels, size_t count) {
+        const __m256i ga = _mm256_set1_epi32(static_cast<int> (0xFF00FF00));
+        const __m256i low = _mm256_set1_epi32(0xFF);
+
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*> (pixels + i * 4));
+
+            __m256i r = _mm256_slli_epi32(_mm256_and_si256(v, low), 16);
+            __m256i b = _mm256_and_si256(_mm256_srli_epi32(v, 16), low);
+
+            v = _mm256_or_si256(_mm256_and_si256(v, ga), _mm256_or_si256(r, b));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*> (pixels + i * 4), v);
+        }
+
+        SwizzleScalar(pixels + i * 4, count - i);
+    }
+
+    PIXELKERNELS_TARGET("avx2")
+    inline __m256i PremultiplyHalfAVX2(__m256i px) {
+        const __m256i rgbMask = _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1);
+        const __m256i alphaOne = _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0);
+        const __m256i round = _mm256_set1_epi16(128);
+
+        __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(px, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        a = _mm256_or_si256(_mm256_and_si256(a, rgbMask), alphaOne);
+
+        __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(px, a), round);
+        return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+    }
+
+    PIXELKERNELS_TARGET("avx2")
+    void PremultiplyAVX2(uint8_t * pixels, size_t count) {
+        const __m256i zero = _mm256_setzero_si256();
+
+        // unpack and pack are both per lane, so the pixel order survives the round trip
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*> (pixels + i * 4));
+
+            __m256i lo = PremultiplyHalfAVX2(_mm256_unpacklo_epi8(v, zero));
+            __m256i hi = PremultiplyHalfAVX2(_mm256_unpackhi_epi8(v, zero));
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*> (pixels + i * 4), _mm256_packus_epi16(lo, hi));
+        }
+
+        PremultiplyScalar(pixels + i * 4, count - i);
+    }
+
+    PIXELKERNELS_TARGET("avx2")
+    void ChromaKeyAVX2(uint8_t * pixels, size_t count, const PixelKernels::ChromaKeyParams & params) {
+        PreparedKey key(params);
+
+        const __m256i mask = _mm256_set1_epi32(0xFF);
+        const __m256 inv255 = _mm256_set1_ps(INV_255), scale = _mm256_set1_ps(255.0f), half = _mm256_set1_ps(0.5f);
+        const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+        const __m256 eps1 = _mm256_set1_ps(key.epsilon1), invRange = _mm256_set1_ps(key.invRange);
+
+        __m256 search[4], delta[4];
+        for (int c = 0; c < 4; c++) {
+            search[c] = _mm256_set1_ps(key.search[c]);
+            delta[c] = _mm256_set1_ps(key.delta[c]);
+        }
+
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*> (pixels + i * 4));
+
+            __m256 c[4];
+            c[0] = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(v, mask)), inv255);
+            c[1] = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(v, 8), mask)), inv255);
+            c[2] = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(v, 16), mask)), inv255);
+            c[3] = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(v, 24)), inv255);
+
+            __m256 d2 = zero;
+            for (int ch = 0; ch < 4; ch++) {
+                __m256 d = _mm256_sub_ps(c[ch], search[ch]);
+                d2 = _mm256_add_ps(d2, _mm256_mul_ps(d, d));
+            }
+
+            __m256 a = _mm256_mul_ps(_mm256_sub_ps(_mm256_sqrt_ps(d2), eps1), invRange);
+            __m256 k = _mm256_sub_ps(one, _mm256_min_ps(_mm256_max_ps(a, zero), one));
+
+            __m256i out = _mm256_setzero_si256();
+            for (int ch = 0; ch < 4; ch++) {
+                __m256 o = _mm256_min_ps(_mm256_max_ps(_mm256_add_ps(c[ch], _mm256_mul_ps(delta[ch], k)), zero), one);
+                __m256i oi = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(o, scale), half));
+                out = _mm256_or_si256(out, _mm256_slli_epi32(oi, ch * 8));
+            }
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*> (pixels + i * 4), out);
+        }
+
+        for (; i < count; i++) {
+            ChromaKeyPixel(pixels + i * 4, key);
+        }
+    }
+
+    // </editor-fold>
+
+#endif
+
+#ifdef PIXELKERNELS_NEON
+
+    // <editor-fold defaultstate="collapsed" desc="NEON">
+
+    void ExpandNEON(const uint8_t * src, uint8_t * dst, size_t count, bool swap) {
+        const uint8x16_t alpha = vdupq_n_u8(0xFF);
+
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16) {
+            uint8x16x3_t rgb = vld3q_u8(src + i * 3);
+            uint8x16x4_t rgba;
+
+            rgba.val[0] = swap ? rgb.val[2] : rgb.val[0];
+            rgba.val[1] = rgb.val[1];
+            rgba.val[2] = swap ? rgb.val[0] : rgb.val[2];
+            rgba.val[3] = alpha;
+
+            vst4q_u8(dst + i * 4, rgba);
+        }
+
+        ExpandScalar(src + i * 3, dst + i * 4, count - i, swap);
+    }
+
+    void ExpandRGBNEON(const uint8_t * src, uint8_t * dst, size_t count) {
+        ExpandNEON(src, dst, count, false);
+    }
+
+    void ExpandBGRNEON(const uint8_t * src, uint8_t * dst, size_t count) {
+        ExpandNEON(src, dst, count, true);
+    }
+
+    void SwizzleNEON(uint8_t * pixels, size_t count) {
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16) {
+            uint8x16x4_t v = vld4q_u8(pixels + i * 4);
+            uint8x16_t r = v.val[0];
+            v.val[0] = v.val[2];
+            v.val[2] = r;
+            vst4q_u8(pixels + i * 4, v);
+        }
+
+        SwizzleScalar(pixels + i * 4, count - i);
+    }
+
+    inline uint8x8_t MulDiv255NEON(uint8x8_t c, uint8x8_t a) {
+        uint16x8_t t = vaddq_u16(vmull_u8(c, a), vdupq_n_u16(128));
+        return vshrn_n_u16(vaddq_u16(t, vshrq_n_u16(t, 8)), 8);
+    }
+
+    void PremultiplyNEON(uint8_t * pixels, size_t count) {
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            uint8x8x4_t v = vld4_u8(pixels + i * 4);
+            v.val[0] = MulDiv255NEON(v.val[0], v.val[3]);
+            v.val[1] = MulDiv255NEON(v.val[1], v.val[3]);
+            v.val[2] = MulDiv255NEON(v.val[2], v.val[3]);
+            vst4_u8(pixels + i * 4, v);
+        }
+
+        PremultiplyScalar(pixels + i * 4, count - i);
+    }
+
+    void ChromaKeyNEON(uint8_t * pixels, size_t count, const PixelKernels::ChromaKeyParams & params) {
+        PreparedKey key(params);
+
+        const float32x4_t zero = vdupq_n_f32(0), one = vdupq_n_f32(1.0f), half = vdupq_n_f32(0.5f);
+
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            uint8x8x4_t v = vld4_u8(pixels + i * 4);
+            uint8x8x4_t out;
+
+            uint16x8_t wide[4];
+            for (int ch = 0; ch < 4; ch++) {
+                wide[ch] = vmovl_u8(v.val[ch]);
+            }
+
+            uint16x4_t packed[2][4];
+
+            // two halves of four pixels each
+            for (int h = 0; h < 2; h++) {
+                float32x4_t c[4];
+                float32x4_t d2 = zero;
+
+                for (int ch = 0; ch < 4; ch++) {
+                    uint16x4_t part = h == 0 ? vget_low_u16(wide[ch]) : vget_high_u16(wide[ch]);
+                    c[ch] = vmulq_n_f32(vcvtq_f32_u32(vmovl_u16(part)), INV_255);
+
+                    float32x4_t d = vsubq_f32(c[ch], vdupq_n_f32(key.search[ch]));
+                    d2 = vaddq_f32(d2, vmulq_f32(d, d));
+                }
+
+                float32x4_t a = vmulq_n_f32(vsubq_f32(vsqrtq_f32(d2), vdupq_n_f32(key.epsilon1)), key.invRange);
+                float32x4_t k = vsubq_f32(one, vminq_f32(vmaxq_f32(a, zero), one));
+
+                for (int ch = 0; ch < 4; ch++) {
+                    float32x4_t o = vaddq_f32(c[ch], vmulq_n_f32(k, key.delta[ch]));
+                    o = vminq_f32(vmaxq_f32(o, zero), one);
+                    packed[h][ch] = vmovn_u32(vcvtq_u32_f32(vaddq_f32(vmulq_n_f32(o, 255.0f), half)));
+                }
+            }
+
+            for (int ch = 0; ch < 4; ch++) {
+                out.val[ch] = vmovn_u16(vcombine_u16(packed[0][ch], packed[1][ch]));
+            }
+
+            vst4_u8(pixels + i * 4, out);
+        }
+
+        for (; i < count; i++) {
+            ChromaKeyPixel(pixels + i * 4, key);
+        }
+    }
+
+    // </editor-fold>
+
+#endif
+
+    struct KernelTable {
+        Level level;
+        void (*expandRGB)(const uint8_t *, uint8_t *, size_t);
+        void (*expandBGR)(const uint8_t *, uint8_t *, size_t);
+        void (*swizzle)(uint8_t *, size_t);
+        void (*premultiply)(uint8_t *, size_t);
+        void (*chromaKey)(uint8_t *, size_t, const PixelKernels::ChromaKeyParams &);
+    };
+
+    Level DetectLevel() {
+#if defined(PIXELKERNELS_X86)
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        int maxLeaf = info[0];
+
+        __cpuid(info, 1);
+        bool sse2 = (info[3] & (1 << 26)) != 0;
+        bool ssse3 = (info[2] & (1 << 9)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+
+        bool avx2 = false;
+        if (maxLeaf >= 7 && osxsave && (_xgetbv(0) & 0x6) == 0x6) {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0;
+        }
+#else
+        __builtin_cpu_init();
+        bool sse2 = __builtin_cpu_supports("sse2");
+        bool ssse3 = __builtin_cpu_supports("ssse3");
+        bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+        if (avx2) {
+            return Level::eAVX2;
+        }
+        if (ssse3) {
+            return Level::eSSSE3;
+        }
+        if (sse2) {
+            return Level::eSSE2;
+        }
+        return Level::eScalar;
+#elif defined(PIXELKERNELS_NEON)
+        // NEON is mandatory on aarch64
+        return Level::eNEON;
+#else
+        return Level::eScalar;
+#endif
+    }
+
+    KernelTable CreateTable(Level level) {
+        KernelTable table = {Level::eScalar, ExpandRGBScalar, ExpandBGRScalar,
+            SwizzleScalar, PremultiplyScalar, ChromaKeyScalar};
+
+#if defined(PIXELKERNELS_X86)
+        // each level also gets everything from the levels below it
+        if (level == Level::eSSE2 || level == Level::eSSSE3 || level == Level::eAVX2) {
+            table.swizzle = SwizzleSSE2;
+            table.premultiply = PremultiplySSE2;
+            table.chromaKey = ChromaKeySSE2;
+            table.level = Level::eSSE2;
+        }
+        if (level == Level::eSSSE3 || level == Level::eAVX2) {
+            table.expandRGB = ExpandRGBSSSE3;
+            table.expandBGR = ExpandBGRSSSE3;
+            table.level = Level::eSSSE3;
+        }
+        if (level == Level::eAVX2) {
+            table.expandRGB = ExpandRGBAVX2;
+            table.expandBGR = ExpandBGRAVX2;
+            table.swizzle = SwizzleAVX2;
+            table.premultiply = PremultiplyAVX2;
+            table.chromaKey = ChromaKeyAVX2;
+            table.level = Level::eAVX2;
+        }
+#elif defined(PIXELKERNELS_NEON)
+        if (level == Level::eNEON) {
+            table = {Level::eNEON, ExpandRGBNEON, ExpandBGRNEON,
+                SwizzleNEON, PremultiplyNEON, ChromaKeyNEON};
+        }
+#endif
+
+        return table;
+    }
+
+    KernelTable & Table() {
+        static KernelTable table = CreateTable(DetectLevel());
+        return table;
+    }
+
+}
+
+PixelKernels::Level PixelKernels::GetSupportedLevel() {
+    static Level level = DetectLevel();
+    return level;
+}
+
+PixelKernels::Level PixelKernels::GetLevel() {
+    return Table().level;
+}
+
+PixelKernels::Level PixelKernels::SetLevel(Level level) {
+    Level supported = GetSupportedLevel();
+
+    // the levels only form a chain on x86, neon is all or nothing
+    bool valid = level == Level::eScalar || level == supported ||
+            (supported != Level::eNEON && level != Level::eNEON && level < supported);
+
+    Table() = CreateTable(valid ? level : supported);
+
+    return Table().level;
+}
+
+const char * PixelKernels::GetLevelName(Level level) {
+    switch (level) {
+        case Level::eSSE2: return "SSE2";
+        case Level::eSSSE3: return "SSSE3";
+        case Level::eAVX2: return "AVX2";
+        case Level::eNEON: return "NEON";
+        default: return "Scalar";
+    }
+}
+
+void PixelKernels::ExpandRGBToRGBA(const uint8_t * src, uint8_t * dst, size_t count) {
+    Table().expandRGB(src, dst, count);
+}
+
+void PixelKernels::ExpandBGRToRGBA(const uint8_t * src, uint8_t * dst, size_t count) {
+    Table().expandBGR(src, dst, count);
+}
+
+void PixelKernels::SwizzleBGRA(uint8_t * pixels, size_t count) {
+    Table().swizzle(pixels, count);
+}
+
+void PixelKernels::PremultiplyAlpha(uint8_t * pixels, size_t count) {
+    Table().premultiply(pixels, count);
+}
+
+void PixelKernels::ChromaKeyAlpha(uint8_t * pixels, size_t count, const ChromaKeyParams & key) {
+    Table().chromaKey(pixels, count, key);
+}
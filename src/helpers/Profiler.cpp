@@ -0,0 +1,266 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+#include "Profiler.hpp"
+
+#ifdef ENABLE_PROFILER
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#if defined(__GNUC__)
+#include <cxxabi.h>
+#endif
+
+namespace {
+
+    struct ProfileEvent {
+        const char * name;
+        uint64_t start, end;
+        bool mangled;
+    };
+
+    // The zones of one thread. Only the owning thread writes, and it never
+    // waits: the oldest zones are overwritten once the ring is full. Readers
+    // copy the ring and throw away anything that was overwritten mid-copy.
+    class ThreadBuffer {
+    public:
+        static constexpr uint64_t CAPACITY = 1 << 16;
+
+        std::unique_ptr<ProfileEvent[]> events;
+        std::atomic<uint64_t> head;
+
+        uint32_t id;
+        std::string name;
+
+        ThreadBuffer(uint32_t id) : events(new ProfileEvent[CAPACITY]), head(0), id(id) {
+        }
+
+        void push(const ProfileEvent & event) {
+            uint64_t h = head.load(std::memory_order_relaxed);
+
+            events[h & (CAPACITY - 1)] = event;
+
+            head.store(h + 1, std::memory_order_release);
+        }
+
+        void snapshot(std::vector<ProfileEvent> & out) const {
+            uint64_t h = head.load(std::memory_order_acquire);
+            uint64_t first = h > CAPACITY ? h - CAPACITY : 0;
+
+            std::vector<ProfileEvent> copy;
+            copy.reserve(h - first);
+
+            for (uint64_t i = first; i < h; i++) {
+                copy.push_back(events[i & (CAPACITY - 1)]);
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            // the writer may be in the middle of overwriting the slot after its head
+            uint64_t h2 = head.load(std::memory_order_relaxed);
+            uint64_t valid = h2 + 1 > CAPACITY ? h2 + 1 - CAPACITY : 0;
+
+            for (uint64_t i = std::max(first, valid); i < h; i++) {
+                out.push_back(copy[i - first]);
+            }
+        }
+    };
+
+    struct Registry {
+        std::mutex mutex;
+
+        std::vector<std::unique_ptr<ThreadBuffer>> threads;
+        std::set<std::string> names;
+
+        std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+        double hitchThreshold = 0;
+        std::string hitchPrefix = "hitch";
+        uint64_t lastFrame = 0, lastHitch = 0;
+        int hitches = 0;
+    };
+
+    Registry & GetRegistry() {
+        static Registry registry;
+        return registry;
+    }
+
+    thread_local ThreadBuffer * localBuffer = nullptr;
+
+    ThreadBuffer * GetThreadBuffer() {
+        if (!localBuffer) {
+            Registry & registry = GetRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+
+            registry.threads.emplace_back(new ThreadBuffer(static_cast<uint32_t> (registry.threads.size())));
+            localBuffer = registry.threads.back().get();
+        }
+
+        return localBuffer;
+    }
+
+    uint64_t Now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - GetRegistry().epoch).count();
+    }
+
+    std::string Demangle(const char * name) {
+#if defined(__GNUC__)
+        int status = 0;
+        char * demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+
+        if (status == 0 && demangled) {
+            std::string result(demangled);
+            free(demangled);
+            return result;
+        }
+#endif
+        return name;
+    }
+
+    void WriteEscaped(std::ostream & out, const std::string & str) {
+        out << '"';
+
+        for (char c : str) {
+            if (c == '"' || c == '\\') {
+                out << '\\' << c;
+            } else if (static_cast<unsigned char> (c) < 0x20) {
+                char code[8];
+                snprintf(code, sizeof (code), "\\u%04x", c);
+                out << code;
+            } else {
+                out << c;
+            }
+        }
+
+        out << '"';
+    }
+
+}
+
+Profiler::Zone::Zone(const char * name, bool mangled) : name(name), start(Now()), mangled(mangled) {
+}
+
+Profiler::Zone::~Zone() {
+    GetThreadBuffer()->push({name, start, Now(), mangled});
+}
+
+const char * Profiler::Intern(const std::string & name) {
+    Registry & registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    // set nodes never move, so the pointer stays valid
+    return registry.names.insert(name).first->c_str();
+}
+
+void Profiler::SetThreadName(const std::string & name) {
+    ThreadBuffer * buffer = GetThreadBuffer();
+
+    std::lock_guard<std::mutex> lock(GetRegistry().mutex);
+    buffer->name = name;
+}
+
+void Profiler::EndFrame() {
+    Registry & registry = GetRegistry();
+
+    uint64_t now = Now();
+
+    if (registry.lastFrame > 0) {
+        GetThreadBuffer()->push({"frame", registry.lastFrame, now, false});
+
+        double milliseconds = (now - registry.lastFrame) / 1e6;
+
+        // at most one dump a second, a stall usually lasts several frames
+        if (registry.hitchThreshold > 0 && milliseconds > registry.hitchThreshold &&
+                (registry.hitches == 0 || now - registry.lastHitch > 1000000000ull)) {
+
+            registry.lastHitch = now;
+
+            std::string path = registry.hitchPrefix + "_" + std::to_string(registry.hitches++) + ".json";
+
+            if (WriteTrace(path)) {
+                fprintf(stderr, "Frame took %.2f ms, wrote %s\n", milliseconds, path.c_str());
+            }
+        }
+    }
+
+    registry.lastFrame = now;
+}
+
+void Profiler::SetHitchThreshold(double milliseconds, const std::string & prefix) {
+    Registry & registry = GetRegistry();
+
+    registry.hitchThreshold = milliseconds;
+    registry.hitchPrefix = prefix;
+}
+
+void Profiler::WriteTrace(std::ostream & out) {
+    Registry & registry = GetRegistry();
+
+    std::vector<std::pair<ThreadBuffer*, std::string>> threads;
+
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        for (auto & thread : registry.threads) {
+            threads.emplace_back(thread.get(), thread->name);
+        }
+    }
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    bool first = true;
+    std::vector<ProfileEvent> events;
+
+    for (auto & thread : threads) {
+        std::string name = thread.second.empty() ? "thread " + std::to_string(thread.first->id) : thread.second;
+
+        out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                << thread.first->id << ",\"args\":{\"name\":";
+        WriteEscaped(out, name);
+        out << "}}";
+
+        first = false;
+
+        events.clear();
+        thread.first->snapshot(events);
+
+        for (auto & event : events) {
+            out << ",\n{\"name\":";
+            WriteEscaped(out, event.mangled ? Demangle(event.name) : std::string(event.name));
+
+            char times[96];
+            snprintf(times, sizeof (times), ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                    event.start / 1e3, (event.end - event.start) / 1e3, thread.first->id);
+            out << times;
+        }
+    }
+
+    out << "\n]}" << std::endl;
+}
+
+bool Profiler::WriteTrace(const std::string & path) {
+    std::ofstream file(path);
+
+    if (!file.is_open()) {
+        return false;
+    }
+
+    WriteTrace(file);
+
+    return file.good();
+}
+
+#endif
@@ -0,0 +1,222 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+#include <experimental/filesystem>
+#include <stdexcept>
+
+#include <yaml-cpp/yaml.h>
+
+#include "game/SoundBank.hpp"
+#include "Profiler.hpp"
+
+namespace filesystem = std::experimental::filesystem;
+
+std::mutex SoundNames::mutex;
+std::unordered_map<std::string, SoundId> SoundNames::ids;
+std::vector<std::string> SoundNames::names;
+
+constexpr double SoundBank::DEFAULT_STREAM_THRESHOLD;
+
+SoundId SoundNames::Intern(const std::string & name) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto iter = ids.find(name);
+
+    if (iter != ids.end()) {
+        return iter->second;
+    }
+
+    SoundId id = static_cast<SoundId> (names.size());
+
+    names.push_back(name);
+    ids[name] = id;
+
+    return id;
+}
+
+std::string SoundNames::GetName(SoundId id) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    return names.at(id);
+}
+
+size_t SoundNames::Count() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    return names.size();
+}
+
+SoundBank::SoundBank(AudioBackend * backend, const std::string & directory, size_t budget) :
+backend(backend), directory(directory), budget(budget) {
+
+}
+
+SoundBank::~SoundBank() {
+    while (!lru.empty()) {
+        unload(lru.front());
+    }
+}
+
+void SoundBank::loadManifest(const std::string & manifest) {
+    PROFILE_FUNCTION();
+
+    YAML::Node root = YAML::LoadFile(manifest);
+
+    YAML::Node sounds = root["sounds"];
+
+    if (!sounds || !sounds.IsMap()) {
+        throw std::runtime_error("Sound manifest " + manifest + " has no 'sounds' map");
+    }
+
+    stream_threshold = root["stream threshold"].as<double>(stream_threshold);
+
+    for (auto sound : sounds) {
+        SoundId id = SoundNames::Intern(sound.first.Scalar());
+
+        YAML::Node options = sound.second;
+
+        struct SoundSettings & settings = getEntry(id).settings;
+
+        settings.priority = options["priority"].as<int>(settings.priority);
+        settings.max_instances = options["max instances"].as<int>(settings.max_instances);
+        settings.volume = options["volume"].as<float>(settings.volume);
+        settings.max_distance = options["max distance"].as<float>(settings.max_distance);
+        settings.stream_threshold = options["stream threshold"].as<float>(settings.stream_threshold);
+
+        if (options["steal"]) {
+            std::string steal = options["steal"].Scalar();
+
+            if (steal == "none") {
+                settings.steal = SoundSettings::Steal::eNone;
+            } else if (steal == "oldest") {
+                settings.steal = SoundSettings::Steal::eOldest;
+            } else if (steal == "quietest") {
+                settings.steal = SoundSettings::Steal::eQuietest;
+            } else {
+                throw std::runtime_error("Sound " + sound.first.Scalar() + " has an invalid steal mode " + steal);
+            }
+        }
+
+        load(id, options["pinned"].as<bool>(false));
+    }
+}
+
+void SoundBank::loadDirectory(void) {
+    PROFILE_FUNCTION();
+
+    for (auto & file : filesystem::directory_iterator(directory)) {
+        if (filesystem::is_regular_file(file.path()) && file.path().extension() == ".wav") {
+            load(SoundNames::Intern(file.path().filename().generic_string()));
+        }
+    }
+}
+
+void SoundBank::load(SoundId id, bool pinned) {
+    struct Entry & entry = getEntry(id);
+
+    entry.pinned = entry.pinned || pinned;
+
+    if (entry.clip) {
+        return;
+    }
+
+    std::string file = directory + SoundNames::GetName(id);
+
+    PROFILE_SCOPE_DYNAMIC("decode " + file);
+
+    double threshold = entry.settings.stream_threshold < 0 ? stream_threshold : entry.settings.stream_threshold;
+
+    entry.clip = backend->loadClip(file, threshold);
+
+    // a streamed clip only counts the buffers of one voice
+    entry.size = entry.clip->getSize();
+
+    resident += entry.size;
+
+    entry.position = lru.insert(lru.end(), id);
+
+    evict();
+}
+
+AudioClip * SoundBank::acquire(SoundId id) {
+    struct Entry & entry = getEntry(id);
+
+    // counted before loading, or the eviction at the end of load could unload it again
+    entry.uses++;
+
+    if (!entry.clip) {
+        misses++;
+
+        try {
+            load(id);
+        } catch (std::runtime_error &) {
+            entry.uses--;
+            return nullptr;
+        }
+    }
+
+    if (!entry.clip) {
+        entry.uses--;
+        return nullptr;
+    }
+
+    // the sound is now the most recently played
+    lru.splice(lru.end(), lru, entry.position);
+
+    return entry.clip;
+}
+
+void SoundBank::release(SoundId id) {
+    struct Entry & entry = getEntry(id);
+
+    if (entry.uses > 0) {
+        entry.uses--;
+    }
+
+    if (entry.uses == 0 && resident > budget) {
+        evict();
+    }
+}
+
+struct SoundBank::Entry & SoundBank::getEntry(SoundId id) {
+    if (id == INVALID_SOUND) {
+        throw std::runtime_error("Invalid sound id");
+    }
+
+    if (id >= entries.size()) {
+        entries.resize(id + 1);
+    }
+
+    return entries[id];
+}
+
+void SoundBank::evict(void) {
+    auto iter = lru.begin();
+
+    while (resident > budget && iter != lru.end()) {
+        struct Entry & entry = entries[*iter];
+
+        SoundId id = *iter++;
+
+        if (!entry.pinned && entry.uses == 0) {
+            unload(id);
+            evictions++;
+        }
+    }
+}
+
+void SoundBank::unload(SoundId id) {
+    struct Entry & entry = entries[id];
+
+    backend->unloadClip(entry.clip);
+
+    resident -= entry.size;
+
+    lru.erase(entry.position);
+
+    entry.clip = nullptr;
+    entry.size = 0;
+}
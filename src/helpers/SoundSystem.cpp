@@ -0,0 +1,204 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+#include "game/SoundSystem.hpp"
+#include "Profiler.hpp"
+
+constexpr size_t SoundSystem::MAX_VOICES;
+
+SoundSystem::SoundSystem(EventIn onsoundrequest, const std::string & sound_directory, AudioBackend * backend,
+        size_t max_voices, size_t budget) :
+backend(backend ? backend : AudioBackend::Create("")), onsoundrequest(onsoundrequest), sound_dir(sound_directory),
+requests(QUEUE_SIZE), stopped(QUEUE_SIZE), voices(std::min(max_voices, MAX_VOICES)), listener_x(0), listener_y(0),
+running(true), dropped(0) {
+
+    this->backend->setStopListener(this);
+
+    bank.reset(new SoundBank(this->backend.get(), sound_dir, budget));
+
+    if (std::ifstream(sound_dir + MANIFEST).good()) {
+        bank->loadManifest(sound_dir + MANIFEST);
+    } else {
+        bank->loadDirectory();
+    }
+
+    thread = std::thread(&SoundSystem::Run, this);
+}
+
+SoundSystem::~SoundSystem() {
+    running = false;
+    thread.join();
+
+    for (auto & sound : playing) {
+        backend->stop(sound.id);
+
+        bank->release(sound.request.sound);
+    }
+
+    playing.clear();
+
+    // the bank unloads its clips from the backend
+    bank.reset();
+
+    backend.reset();
+}
+
+void SoundSystem::OnEvent(EventManager* manager, Event id, const std::shared_ptr<void> argument) {
+    if (id == onsoundrequest) {
+        if (!requests.push(*reinterpret_cast<SoundRequest*> (argument.get()))) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void SoundSystem::Apply(Scene* scene, double deltat) {
+    // everything else happens on the audio thread
+    if (has_listener) {
+        try {
+            glm::vec2 position = (*scene)[listener].getPosition();
+
+            listener_x.store(position.x, std::memory_order_relaxed);
+            listener_y.store(position.y, std::memory_order_relaxed);
+        } catch (std::runtime_error &) {
+            has_listener = false;
+        }
+    }
+}
+
+void SoundSystem::OnVoiceStopped(uint64_t id) {
+    // the queue is sized so every playing sound fits, and stops the audio
+    // thread causes itself aren't reported, so the backend's thread is the
+    // only producer
+    stopped.push(id);
+}
+
+void SoundSystem::Run(void) {
+    Profiler::SetThreadName("audio");
+
+    while (running.load(std::memory_order_acquire)) {
+        bool busy = false;
+
+        uint64_t id;
+
+        while (stopped.pop(id)) {
+            Finish(id);
+            busy = true;
+        }
+
+        SoundRequest req;
+
+        glm::vec2 position(listener_x.load(std::memory_order_relaxed), listener_y.load(std::memory_order_relaxed));
+
+        if (position != backend_listener) {
+            voices.setListener(position);
+            backend->setListener(position.x, position.y);
+
+            backend_listener = position;
+        }
+
+        while (requests.pop(req)) {
+            PlaySound(req);
+            busy = true;
+        }
+
+        if (!busy) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(IDLE_MILLISECONDS));
+        }
+    }
+}
+
+void SoundSystem::PlaySound(const SoundRequest & req) {
+    PROFILE_FUNCTION();
+
+    const struct SoundSettings & settings = bank->getSettings(req.sound);
+
+    PlayingSound * victim;
+
+    if (!voices.admit(req, settings, playing, victim)) {
+        return;
+    }
+
+    if (victim) {
+        Stop(victim);
+    }
+
+    AudioClip * clip = bank->acquire(req.sound);
+
+    if (!clip) {
+        return;
+    }
+
+    PlayingSound sound;
+    sound.request = req;
+    sound.clip = clip;
+    sound.id = next_id++;
+    sound.loops_left = req.loops == LOOP_ALWAYS ? 0 : req.loops - 1;
+    sound.priority = settings.priority;
+    sound.audibility = voices.getAudibility(req, settings);
+
+    playing.push_back(sound);
+
+    if (!Start(playing.back())) {
+        playing.pop_back();
+        bank->release(req.sound);
+    }
+}
+
+bool SoundSystem::Start(PlayingSound & sound) {
+    const SoundRequest & req = sound.request;
+
+    struct AudioVoiceParams params;
+
+    params.volume = bank->getSettings(req.sound).volume;
+    params.looped = req.loops == LOOP_ALWAYS;
+    params.positional = req.has_pos;
+    params.x = req.screen_pos.x;
+    params.y = req.screen_pos.y;
+
+    return backend->play(sound.clip, params, sound.id);
+}
+
+void SoundSystem::Finish(uint64_t id) {
+    // the list is in id order
+    auto iter = std::lower_bound(playing.begin(), playing.end(), id, [](const PlayingSound & sound, uint64_t id) {
+        return sound.id < id;
+    });
+
+    if (iter == playing.end() || iter->id != id) {
+        return;
+    }
+
+    PlayingSound & sound = *iter;
+
+    // frees the backend's voice, the next loop reuses its id
+    backend->stop(sound.id);
+
+    if (sound.loops_left > 0) {
+        sound.loops_left--;
+
+        if (Start(sound)) {
+            return;
+        }
+    }
+
+    bank->release(sound.request.sound);
+
+    playing.erase(iter);
+}
+
+void SoundSystem::Stop(PlayingSound * sound) {
+    backend->stop(sound->id);
+
+    bank->release(sound->request.sound);
+
+    playing.remove_if([sound](const PlayingSound & other) {
+        return &other == sound;
+    });
+}
@@ -0,0 +1,58 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+#include <algorithm>
+
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) {
+        // hardware_concurrency can't always tell
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned i = 0; i < threads; i++) {
+        workers.emplace_back(Run, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+
+    available.notify_all();
+
+    for (std::thread & worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::Run(ThreadPool * pool) {
+    while (true) {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> guard(pool->lock);
+
+            pool->available.wait(guard, [pool]() {
+                return pool->stopping || !pool->tasks.empty();
+            });
+
+            // the queue is drained before stopping
+            if (pool->tasks.empty()) {
+                return;
+            }
+
+            task = std::move(pool->tasks.front());
+            pool->tasks.pop_front();
+        }
+
+        // packaged tasks keep their exceptions for the future
+        task();
+    }
+}
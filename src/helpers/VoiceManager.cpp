@@ -0,0 +1,90 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+#include <cmath>
+
+#include "game/VoiceManager.hpp"
+
+float VoiceManager::getAudibility(const SoundRequest & req, const struct SoundSettings & settings) const {
+    if (!req.has_pos) {
+        return settings.volume;
+    }
+
+    float distance = glm::distance(req.screen_pos, listener);
+
+    if (distance >= settings.max_distance) {
+        return 0;
+    }
+
+    // linear falloff to the sound's range, or a gentle rolloff if it has none
+    if (std::isinf(settings.max_distance)) {
+        return settings.volume / (1 + distance);
+    } else {
+        return settings.volume * (1 - distance / settings.max_distance);
+    }
+}
+
+bool VoiceManager::admit(const SoundRequest & req, const struct SoundSettings & settings,
+        std::list<PlayingSound> & playing, PlayingSound *& victim) {
+
+    victim = nullptr;
+
+    float audibility = getAudibility(req, settings);
+
+    if (audibility <= 0) {
+        culled++;
+        return false;
+    }
+
+    if (settings.max_instances > 0) {
+        int instances = 0;
+
+        for (auto & sound : playing) {
+            if (sound.request.sound != req.sound) {
+                continue;
+            }
+
+            instances++;
+
+            // the list is in start order, so the first instance is the oldest
+            if (!victim || (settings.steal == SoundSettings::Steal::eQuietest && sound.audibility < victim->audibility)) {
+                victim = &sound;
+            }
+        }
+
+        if (instances < settings.max_instances) {
+            victim = nullptr;
+        } else if (settings.steal == SoundSettings::Steal::eNone || !victim) {
+            victim = nullptr;
+            rejected++;
+            return false;
+        }
+    }
+
+    if (!victim && playing.size() >= max_voices) {
+        // the lowest priority loses, then the quietest, then the oldest
+        for (auto & sound : playing) {
+            if (!victim || sound.priority < victim->priority ||
+                    (sound.priority == victim->priority && sound.audibility < victim->audibility)) {
+                victim = &sound;
+            }
+        }
+
+        // a request never replaces something more important than itself
+        if (!victim || victim->priority > settings.priority ||
+                (victim->priority == settings.priority && victim->audibility > audibility)) {
+            victim = nullptr;
+            rejected++;
+            return false;
+        }
+    }
+
+    if (victim) {
+        stolen++;
+    }
+
+    return true;
+}
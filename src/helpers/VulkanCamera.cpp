@@ -0,0 +1,179 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include "VulkanCamera.hpp"
+
+VulkanCamera::VulkanCamera(VulkanDevice & device, VulkanFrameCommandPools * pools, VulkanViewport * viewport) :
+device(device), pools(pools), viewport(viewport), views(1), frames(pools->frameCount()) {
+
+    vk::DeviceSize alignment = std::max<vk::DeviceSize>(device.getProperties().limits.minUniformBufferOffsetAlignment, 1);
+
+    stride = (sizeof (struct CameraUniform) + alignment - 1) / alignment * alignment;
+
+    vk::DescriptorSetLayoutBinding binding(0, vk::DescriptorType::eUniformBufferDynamic, 1, vk::ShaderStageFlagBits::eVertex);
+
+    layout = device->createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo(vk::DescriptorSetLayoutCreateFlags(), 1, &binding));
+
+    vk::DescriptorPoolSize poolSize(vk::DescriptorType::eUniformBufferDynamic, static_cast<uint32_t> (frames.size()));
+
+    descriptorPool = device->createDescriptorPool(vk::DescriptorPoolCreateInfo(vk::DescriptorPoolCreateFlags(),
+            static_cast<uint32_t> (frames.size()), 1, &poolSize));
+
+    for (auto & frame : frames) {
+        device.createBuffer(stride * MAX_VIEWS, vk::BufferUsageFlagBits::eUniformBuffer,
+                vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+                frame.buffer, frame.memory);
+
+        // stays mapped, the memory is coherent
+        device->mapMemory(frame.memory, 0, stride * MAX_VIEWS, vk::MemoryMapFlags(), &frame.mapped);
+
+        vk::DescriptorSetAllocateInfo allocInfo(descriptorPool, 1, &layout);
+
+        frame.set = device->allocateDescriptorSets(allocInfo)[0];
+
+        vk::DescriptorBufferInfo info(frame.buffer, 0, sizeof (struct CameraUniform));
+
+        vk::WriteDescriptorSet write(frame.set, 0, 0, 1, vk::DescriptorType::eUniformBufferDynamic, nullptr, &info);
+
+        device->updateDescriptorSets(1, &write, 0, nullptr);
+    }
+}
+
+VulkanCamera::~VulkanCamera() {
+    for (auto & frame : frames) {
+        device->unmapMemory(frame.memory);
+        device->destroyBuffer(frame.buffer);
+        device->freeMemory(frame.memory);
+    }
+
+    device->destroyDescriptorPool(descriptorPool);
+    device->destroyDescriptorSetLayout(layout);
+}
+
+uint32_t VulkanCamera::addView(const struct CameraView & view) {
+    if (views.size() >= MAX_VIEWS) {
+        throw std::runtime_error("Camera can't have more than " + std::to_string(MAX_VIEWS) + " views");
+    }
+
+    views.push_back(view);
+
+    return static_cast<uint32_t> (views.size() - 1);
+}
+
+glm::vec2 VulkanCamera::getScale(uint32_t view) const {
+    vk::Viewport pixels = getPixels(view);
+
+    float w = pixels.width, h = pixels.height;
+
+    if (w <= 0 || h <= 0) {
+        return glm::vec2(0, 0);
+    }
+
+    // the shorter side spans the world square
+    glm::vec2 scale(w > h ? h / w : 1, h > w ? w / h : 1);
+
+    return scale * views.at(view).zoom;
+}
+
+glm::mat4 VulkanCamera::getViewProjection(uint32_t view) const {
+    glm::vec2 scale = getScale(view);
+    glm::vec2 pan = views.at(view).pan;
+
+    glm::mat4 transform(1.0f);
+
+    transform[0][0] = scale.x;
+    transform[1][1] = scale.y;
+    transform[3][0] = -pan.x * scale.x;
+    transform[3][1] = -pan.y * scale.y;
+
+    return transform;
+}
+
+glm::vec4 VulkanCamera::getWorldBounds(void) const {
+    float inf = std::numeric_limits<float>::infinity();
+
+    glm::vec4 bounds(inf, inf, -inf, -inf);
+
+    for (uint32_t i = 0; i < views.size(); i++) {
+        glm::vec2 scale = getScale(i);
+
+        if (scale.x <= 0 || scale.y <= 0) {
+            continue;
+        }
+
+        glm::vec2 half = 1.0f / scale, pan = views[i].pan;
+
+        bounds.x = std::min(bounds.x, pan.x - half.x);
+        bounds.y = std::min(bounds.y, pan.y - half.y);
+        bounds.z = std::max(bounds.z, pan.x + half.x);
+        bounds.w = std::max(bounds.w, pan.y + half.y);
+    }
+
+    return bounds;
+}
+
+bool VulkanCamera::screenToWorld(glm::vec2 point, glm::vec2 & world) const {
+    // later views are drawn over the earlier ones
+    for (size_t i = views.size(); i > 0; i--) {
+        const struct CameraView & view = views[i - 1];
+
+        glm::vec2 local = ((point + 1.0f) * 0.5f - glm::vec2(view.rect.x, view.rect.y)) / glm::vec2(view.rect.z, view.rect.w);
+
+        glm::vec2 scale = getScale(static_cast<uint32_t> (i - 1));
+
+        if (local.x < 0 || local.x > 1 || local.y < 0 || local.y > 1 || scale.x <= 0 || scale.y <= 0) {
+            continue;
+        }
+
+        world = (local * 2.0f - 1.0f) / scale + view.pan;
+
+        return true;
+    }
+
+    return false;
+}
+
+void VulkanCamera::update(void) {
+    char * mapped = reinterpret_cast<char*> (frames[pools->getCurrentFrame()].mapped);
+
+    for (uint32_t i = 0; i < views.size(); i++) {
+        struct CameraUniform uniform;
+        uniform.viewProjection = getViewProjection(i);
+
+        memcpy(mapped + i * stride, &uniform, sizeof (uniform));
+    }
+}
+
+void VulkanCamera::bind(vk::CommandBuffer buffer, vk::PipelineLayout layout, uint32_t view) {
+    vk::Viewport pixels = getPixels(view);
+
+    vk::Rect2D scissor(vk::Offset2D(static_cast<int32_t> (pixels.x), static_cast<int32_t> (pixels.y)),
+            vk::Extent2D(static_cast<uint32_t> (pixels.width), static_cast<uint32_t> (pixels.height)));
+
+    buffer.setViewport(0,{pixels});
+    buffer.setScissor(0,{scissor});
+
+    uint32_t offset = static_cast<uint32_t> (view * stride);
+
+    buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, layout, 1, 1, &frames[pools->getCurrentFrame()].set, 1, &offset);
+}
+
+vk::Viewport VulkanCamera::getPixels(uint32_t view) const {
+    const glm::vec4 & rect = views.at(view).rect;
+
+    float w = (float) viewport->getWidth(), h = (float) viewport->getHeight();
+
+    // each view has its own slice of the depth range, later views nearer, so
+    // nothing an earlier view draws can pass the depth test over a later view
+    float n = (float) views.size();
+
+    return vk::Viewport(rect.x * w, rect.y * h, rect.z * w, rect.w * h, (n - 1 - view) / n, (n - view) / n);
+}
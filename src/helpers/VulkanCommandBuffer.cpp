@@ -4,6 +4,8 @@
  * and open the template in the editor.
  */
 
+#include <algorithm>
+
 #include "VulkanCommandBuffer.hpp"
 
 VulkanCommandBuffer::VulkanCommandBuffer(vk::CommandBuffer buffer, bool primary) {
@@ -30,6 +32,7 @@ void VulkanCommandBuffer::allocate(int group) {
     }
 
     allocation = group;
+    uses++;
 }
 
 void VulkanCommandBuffer::deallocate(void) {
@@ -44,16 +47,19 @@ vk::CommandBuffer& VulkanCommandBuffer::get(void) {
     return buffer;
 }
 
-VulkanCommandBufferGroup::VulkanCommandBufferGroup(int id, std::vector<VulkanCommandBuffer*> buffers, bool primary) {
+VulkanCommandBufferGroup::VulkanCommandBufferGroup(int id, std::vector<VulkanCommandBuffer*> buffers, bool primary, VulkanCommandBufferPool * owner) {
     this->id = id;
     this->buffers = buffers;
     this->primary = primary;
+    this->owner = owner;
 }
 
 VulkanCommandBufferGroup::~VulkanCommandBufferGroup() {
     for (auto buffer : buffers) {
         buffer->deallocate();
     }
+
+    owner->release(buffers, primary);
 }
 
 vk::CommandBuffer VulkanCommandBufferGroup::operator[](int i) {
@@ -89,130 +95,165 @@ device(device) {
         throw std::runtime_error("Could not create command pool");
     }
 
-    allocatePrimaryBuffers(initial_buffers);
-    allocateSecondaryBuffers(initial_buffers);
+    addBuffers(initial_buffers, vk::CommandBufferLevel::ePrimary);
+    addBuffers(initial_buffers, vk::CommandBufferLevel::eSecondary);
 }
 
 VulkanCommandBufferPool::~VulkanCommandBufferPool() {
 
+    // destroying the pool frees every buffer allocated from it
     for (auto & buffer : pbuffers) {
-		device->freeCommandBuffers(pool, { buffer->get() });
+        delete buffer;
     }
 
     for (auto & buffer : sbuffers) {
-		device->freeCommandBuffers(pool, { buffer->get() });
+        delete buffer;
     }
 
+    device->destroyCommandPool(pool);
 }
 
-void VulkanCommandBufferPool::allocatePrimaryBuffers(size_t count) {
-
-    for (auto & buffer : pbuffers) {
-		device->freeCommandBuffers(pool, { buffer->get() });
-        delete buffer;
+void VulkanCommandBufferPool::addBuffers(size_t count, vk::CommandBufferLevel level) {
+    if (count == 0) {
+        return;
     }
 
+    bool primary = level == vk::CommandBufferLevel::ePrimary;
+
     vk::CommandBufferAllocateInfo allocInfo;
 
     allocInfo.commandPool = pool;
-    allocInfo.level = vk::CommandBufferLevel::ePrimary;
+    allocInfo.level = level;
     allocInfo.commandBufferCount = count;
 
     std::vector<vk::CommandBuffer> buffers = device->allocateCommandBuffers(allocInfo);
 
-    pbuffers.resize(buffers.size());
+    std::vector<VulkanCommandBuffer*> & all = primary ? pbuffers : sbuffers;
+    std::vector<VulkanCommandBuffer*> & unused = primary ? pfree : sfree;
+
+    for (auto & buffer : buffers) {
+        VulkanCommandBuffer * vcmd = new VulkanCommandBuffer(buffer, primary);
 
-    for (size_t i = 0; i < buffers.size(); i++) {
-        pbuffers[i] = new VulkanCommandBuffer(buffers[i]);
+        all.push_back(vcmd);
+        unused.push_back(vcmd);
     }
 }
 
-void VulkanCommandBufferPool::addMorePrimaryBuffers(size_t extra) {
+VulkanCommandBufferGroup * VulkanCommandBufferPool::allocateGroup(size_t count, vk::CommandBufferLevel level) {
+    bool primary = level == vk::CommandBufferLevel::ePrimary;
 
-    vk::CommandBufferAllocateInfo allocInfo;
+    std::vector<VulkanCommandBuffer*> & all = primary ? pbuffers : sbuffers;
+    std::vector<VulkanCommandBuffer*> & unused = primary ? pfree : sfree;
 
-    allocInfo.commandPool = pool;
-    allocInfo.level = vk::CommandBufferLevel::ePrimary;
-    allocInfo.commandBufferCount = extra;
+    if (unused.size() < count) {
+        // at least double, so a steady stream of new groups only allocates log(n) times
+        addBuffers(std::max(count - unused.size(), all.size()), level);
+    }
 
-    std::vector<vk::CommandBuffer> buffers = device->allocateCommandBuffers(allocInfo);
+    int group = nextgroup++;
+
+    std::vector<VulkanCommandBuffer*> buffers(unused.end() - count, unused.end());
+    unused.resize(unused.size() - count);
 
     for (auto & buffer : buffers) {
-        pbuffers.push_back(new VulkanCommandBuffer(buffer));
+        if (buffer->getUses() > 0) {
+            recycled++;
+        }
+
+        buffer->allocate(group);
     }
+
+    return new VulkanCommandBufferGroup(group, buffers, primary, this);
 }
 
-void VulkanCommandBufferPool::allocateSecondaryBuffers(size_t count) {
+void VulkanCommandBufferPool::release(std::vector<VulkanCommandBuffer*> & buffers, bool primary) {
+    std::vector<VulkanCommandBuffer*> & unused = primary ? pfree : sfree;
 
-    for (auto & buffer : pbuffers) {
-		device->freeCommandBuffers(pool, { buffer->get() });
-        delete buffer;
-    }
+    unused.insert(unused.end(), buffers.begin(), buffers.end());
+}
 
-    vk::CommandBufferAllocateInfo allocInfo;
+struct CommandBufferStats VulkanCommandBufferPool::getStats(vk::CommandBufferLevel level) const {
+    bool primary = level == vk::CommandBufferLevel::ePrimary;
 
-    allocInfo.commandPool = pool;
-    allocInfo.level = vk::CommandBufferLevel::eSecondary;
-    allocInfo.commandBufferCount = count;
+    struct CommandBufferStats stats;
 
-    std::vector<vk::CommandBuffer> buffers = device->allocateCommandBuffers(allocInfo);
+    stats.free = (primary ? pfree : sfree).size();
+    stats.live = (primary ? pbuffers : sbuffers).size() - stats.free;
+    stats.recycled = recycled;
 
-    sbuffers.resize(buffers.size());
+    return stats;
+}
 
-    for (size_t i = 0; i < buffers.size(); i++) {
-        sbuffers[i] = new VulkanCommandBuffer(buffers[i], false);
-    }
+VulkanCommandBufferPool::operator vk::CommandPool&(void) {
+    return pool;
 }
 
-void VulkanCommandBufferPool::addMoreSecondaryBuffers(size_t extra) {
+VulkanFrameCommandPools::VulkanFrameCommandPools(VulkanDevice & device, size_t framesInFlight) :
+device(device), frames(framesInFlight) {
 
-    vk::CommandBufferAllocateInfo allocInfo;
+    // transient: the buffers only live for a frame, and are only ever reset with their pool
+    vk::CommandPoolCreateInfo createInfo(vk::CommandPoolCreateFlagBits::eTransient, device.getGraphicsQueueIndex());
 
-    allocInfo.commandPool = pool;
-    allocInfo.level = vk::CommandBufferLevel::eSecondary;
-    allocInfo.commandBufferCount = extra;
+    for (auto & frame : frames) {
+        frame.pool = device->createCommandPool(createInfo);
 
-    std::vector<vk::CommandBuffer> buffers = device->allocateCommandBuffers(allocInfo);
+        if (!frame.pool) {
+            throw std::runtime_error("Could not create command pool");
+        }
+    }
+}
 
-    for (auto & buffer : buffers) {
-        sbuffers.push_back(new VulkanCommandBuffer(buffer, false));
+VulkanFrameCommandPools::~VulkanFrameCommandPools() {
+    for (auto & frame : frames) {
+        device->destroyCommandPool(frame.pool);
     }
 }
 
-VulkanCommandBufferGroup * VulkanCommandBufferPool::allocateGroup(size_t count, vk::CommandBufferLevel level) {
-    std::vector<VulkanCommandBuffer*> buffers;
-    
+void VulkanFrameCommandPools::beginFrame(size_t frame) {
+    current = frame % frames.size();
+
+    struct FramePool & fp = frames[current];
+
+    recycled += fp.nextPrimary + fp.nextSecondary;
+
+    device->resetCommandPool(fp.pool, vk::CommandPoolResetFlags());
+
+    fp.nextPrimary = 0;
+    fp.nextSecondary = 0;
+}
+
+vk::CommandBuffer VulkanFrameCommandPools::acquire(vk::CommandBufferLevel level) {
+    struct FramePool & fp = frames[current];
+
     bool primary = level == vk::CommandBufferLevel::ePrimary;
 
-    // try and find <count> unallocated buffers
-    for (auto & buffer : (primary ? pbuffers : sbuffers)) {
-        if (!buffer->allocated()) {
-            buffers.push_back(buffer);
-        }
-        if (buffers.size() == count) {
-            break;
-        }
-    }
+    std::vector<vk::CommandBuffer> & buffers = primary ? fp.primary : fp.secondary;
+    size_t & next = primary ? fp.nextPrimary : fp.nextSecondary;
 
-    if (buffers.size() != count) {
-        if (primary) {
-            addMorePrimaryBuffers(count);
-        } else {
-            addMoreSecondaryBuffers(count);
-        }
+    if (next == buffers.size()) {
+        vk::CommandBufferAllocateInfo allocInfo;
 
-        return allocateGroup(count, level);
-    }
+        allocInfo.commandPool = fp.pool;
+        allocInfo.level = level;
+        allocInfo.commandBufferCount = std::max<uint32_t>(4, static_cast<uint32_t> (buffers.size()));
 
-    int group = nextgroup++;
+        std::vector<vk::CommandBuffer> added = device->allocateCommandBuffers(allocInfo);
 
-    for (auto & buffer : buffers) {
-        buffer->allocate(group);
+        buffers.insert(buffers.end(), added.begin(), added.end());
     }
 
-    return new VulkanCommandBufferGroup(group, buffers, primary);
+    return buffers[next++];
 }
 
-VulkanCommandBufferPool::operator vk::CommandPool&(void) {
-    return pool;
+struct CommandBufferStats VulkanFrameCommandPools::getStats(void) const {
+    struct CommandBufferStats stats;
+
+    // a buffer is live until its frame's pool is reset
+    for (auto & frame : frames) {
+        stats.live += frame.nextPrimary + frame.nextSecondary;
+        stats.free += frame.primary.size() + frame.secondary.size() - frame.nextPrimary - frame.nextSecondary;
+    }
+    stats.recycled = recycled;
+
+    return stats;
 }
@@ -10,9 +10,26 @@ VulkanDepthBuffer::VulkanDepthBuffer(VulkanDevice & device, VulkanViewport & vie
 
     this->depthFormat = depthFormat;
 
-    vk::ImageTiling tiling = getImageTiling(device, depthFormat);
+    tiling = getImageTiling(device, depthFormat);
 
-    createImage(device, viewport.getWidth(), viewport.getHeight(), depthFormat, tiling);
+    resize(device, viewport.getWidth(), viewport.getHeight());
+}
+
+void VulkanDepthBuffer::resize(VulkanDevice & device, uint32_t width, uint32_t height) {
+
+    if (buffer && width == this->width && height == this->height) {
+        return;
+    }
+
+    this->width = width;
+    this->height = height;
+
+    // the view and memory belong to the image, so they go first
+    depthView.reset();
+    depthMemory.reset();
+    buffer.reset();
+
+    createImage(device, width, height, depthFormat, tiling);
 
     vk::MemoryRequirements memoryRequirements = device->getImageMemoryRequirements(buffer.get());
     vk::PhysicalDeviceMemoryProperties memoryProperties = device.getMemoryProperties();
@@ -0,0 +1,91 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+#include <cstring>
+
+#include "VulkanGeometry.hpp"
+#include "VulkanSingleCommand.hpp"
+
+VulkanGeometryStore::VulkanGeometryStore(VulkanDevice & device) : device(device) {
+}
+
+VulkanGeometryStore::~VulkanGeometryStore() {
+    if (buffer) {
+        device->destroyBuffer(buffer);
+        device->freeMemory(memory);
+    }
+}
+
+VulkanIndexBuffer * VulkanGeometryStore::addIndices(const std::vector<uint16_t> & indices) {
+    vk::DeviceSize offset = reserve(indices.data(), indices.size() * sizeof (uint16_t));
+
+    VulkanIndexBuffer * range = new VulkanIndexBuffer(new RangeHolder(this), &device, offset, indices.size());
+
+    ranges.emplace_back(range);
+
+    return range;
+}
+
+void VulkanGeometryStore::write(VulkanBuffer & range, const void * src, size_t bytes, size_t offset) {
+    if (offset + bytes > range.getSize()) {
+        throw std::runtime_error("Write is outside of the geometry range");
+    }
+
+    memcpy(data.data() + range.getOffset() + offset, src, bytes);
+}
+
+void VulkanGeometryStore::upload(VulkanCommandBufferPool & pool, VulkanQueue & queue) {
+    vk::DeviceSize size = data.size();
+
+    if (size == 0) {
+        dirty = false;
+        return;
+    }
+
+    // ranges only ever get added, so the buffer is rebuilt at most when the store grows
+    if (size > capacity) {
+        if (buffer) {
+            device->destroyBuffer(buffer);
+            device->freeMemory(memory);
+        }
+
+        device.createBuffer(size, vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer |
+                vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eDeviceLocal, buffer, memory);
+
+        capacity = size;
+    }
+
+    vk::Buffer staging;
+    vk::DeviceMemory stagingMemory;
+
+    device.createBuffer(size, vk::BufferUsageFlagBits::eTransferSrc,
+            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+            staging, stagingMemory);
+
+    void* mapped;
+    device->mapMemory(stagingMemory, 0, size, vk::MemoryMapFlags(), &mapped);
+    memcpy(mapped, data.data(), static_cast<size_t> (size));
+    device->unmapMemory(stagingMemory);
+
+    VulkanSingleCommand::copyBuffer(device, pool, queue, staging, buffer, size);
+
+    device->destroyBuffer(staging);
+    device->freeMemory(stagingMemory);
+
+    dirty = false;
+}
+
+vk::DeviceSize VulkanGeometryStore::reserve(const void * src, size_t bytes) {
+    vk::DeviceSize offset = (data.size() + RANGE_ALIGNMENT - 1) / RANGE_ALIGNMENT * RANGE_ALIGNMENT;
+
+    data.resize(offset + bytes);
+
+    memcpy(data.data() + offset, src, bytes);
+
+    dirty = true;
+
+    return offset;
+}
@@ -0,0 +1,245 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "VulkanHotReload.hpp"
+#include "Profiler.hpp"
+#include "game/parsing/GameContext.hpp"
+
+using namespace std::experimental;
+
+VulkanHotReload::VulkanHotReload(VulkanDevice & device, VulkanViewport & viewport, VulkanRenderPass & renderPass,
+        ImageManager & images) : device(device), viewport(viewport), renderPass(renderPass), images(images), pool(1) {
+
+}
+
+VulkanHotReload::~VulkanHotReload() {
+    // a batch which was never swapped in still owns device objects
+    if (building.valid()) {
+        building.wait();
+    }
+}
+
+void VulkanHotReload::addMaterial(Material * material) {
+    materials.push_back(material);
+
+    for (const std::string & path : material->getShaderPaths()) {
+        watcher.watch(path);
+    }
+}
+
+void VulkanHotReload::setGameFiles(const std::string & file) {
+    // the parser's trace is for the compiler, not the game's console
+    Game::Logger::enabled = false;
+
+    context.reset(new Game::GameContext(file));
+
+    for (const std::string & path : context->getFiles()) {
+        gameFiles.insert(path);
+        watcher.watch(path);
+    }
+
+    for (auto & instance : context->getUBOInstances()) {
+        values[instance.first] = ReadValues(instance.second);
+    }
+}
+
+void VulkanHotReload::bindUBO(const std::string & instance, VulkanUniformBuffer * buffer) {
+    buffers[instance].push_back(buffer);
+
+    write(instance);
+}
+
+bool VulkanHotReload::poll(void) {
+    // images are loaded whenever they're first used, so new ones are picked up here
+    if (images.size() != watchedImages) {
+        for (const ImageManager::Entry & entry : images.getEntries()) {
+            watcher.watch(entry.path);
+        }
+
+        watchedImages = images.size();
+    }
+
+    for (const std::string & file : watcher.poll()) {
+        changed.insert(file);
+    }
+
+    if (building.valid()) {
+        return building.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    if (changed.empty()) {
+        return false;
+    }
+
+    Request request;
+    request.width = std::max(1u, viewport.getWidth());
+    request.height = std::max(1u, viewport.getHeight());
+
+    for (Material * material : materials) {
+        for (const std::string & file : changed) {
+            if (material->usesShader(file)) {
+                request.materials.push_back(material);
+                break;
+            }
+        }
+    }
+
+    // every texture loaded from the file, they can have different chroma keys
+    for (const ImageManager::Entry & entry : images.getEntries()) {
+        if (changed.find(filesystem::path(entry.path).generic_string()) != changed.end()) {
+            request.images.push_back(entry);
+        }
+    }
+
+    for (const std::string & file : changed) {
+        if (gameFiles.find(file) != gameFiles.end()) {
+            request.context = context.get();
+            request.values = values;
+            break;
+        }
+    }
+
+    changed.clear();
+
+    building = pool.submit([this, request]() {
+        return Build(device, renderPass, request);
+    });
+
+    return false;
+}
+
+VulkanHotReload::Batch VulkanHotReload::Build(VulkanDevice & device, VulkanRenderPass & renderPass, Request request) {
+    Profiler::SetThreadName("hot reload");
+
+    PROFILE_SCOPE("VulkanHotReload::Build");
+
+    Batch batch;
+
+    VulkanViewport viewport(request.width, request.height);
+
+    for (Material * material : request.materials) {
+        try {
+            ShaderRebuild rebuild;
+            rebuild.material = material;
+            rebuild.shaders = material->loadShaders(device);
+            rebuild.pipeline.reset(material->buildPipeline(device, viewport, renderPass, rebuild.shaders));
+
+            batch.shaders.push_back(std::move(rebuild));
+        } catch (std::exception & e) {
+            printf("Warning: could not rebuild material %s: %s\n", material->getName().c_str(), e.what());
+        }
+    }
+
+    for (const ImageManager::Entry & entry : request.images) {
+        try {
+            // decoded and staged here, only the upload waits for the frame boundary
+            TextureReload reload;
+            reload.texture = entry.texture;
+            reload.replacement.reset(new Texture(device, entry.path, entry.key.get()));
+
+            batch.textures.push_back(std::move(reload));
+        } catch (std::exception & e) {
+            printf("Warning: could not reload image %s: %s\n", entry.path.c_str(), e.what());
+        }
+    }
+
+    if (request.context) {
+        try {
+            // only the documents which changed are parsed again
+            if (request.context->reload()) {
+                batch.gameFiles = request.context->getFiles();
+
+                for (auto & instance : request.context->getUBOInstances()) {
+                    std::vector<uint8_t> values = ReadValues(instance.second);
+
+                    auto current = request.values.find(instance.first);
+
+                    // only the instances whose bytes changed are written
+                    if (current == request.values.end() || current->second != values) {
+                        batch.buffers.push_back(BufferRewrite{instance.first, values});
+                    }
+                }
+            }
+        } catch (std::exception & e) {
+            printf("Warning: could not reload the game files: %s\n", e.what());
+        }
+    }
+
+    return batch;
+}
+
+std::vector<uint8_t> VulkanHotReload::ReadValues(const Game::UBOInstance & instance) {
+    std::shared_ptr<void> buffer = instance.create();
+
+    const uint8_t * bytes = static_cast<const uint8_t*> (buffer.get());
+
+    return std::vector<uint8_t>(bytes, bytes + instance.getFields()->size());
+}
+
+void VulkanHotReload::write(const std::string & instance) {
+    auto current = values.find(instance);
+
+    if (current == values.end()) {
+        printf("Warning: ubo instance %s isn't in the game files\n", instance.c_str());
+        return;
+    }
+
+    for (VulkanUniformBuffer * buffer : buffers[instance]) {
+        if (current->second.size() > buffer->objSize() * buffer->objCount()) {
+            printf("Warning: ubo instance %s doesn't fit its buffer\n", instance.c_str());
+            continue;
+        }
+
+        memcpy(buffer->data(), current->second.data(), current->second.size());
+        buffer->markNeedsUpdate();
+    }
+}
+
+void VulkanHotReload::apply(VulkanCommandBufferPool & pool, VulkanQueue & queue) {
+    PROFILE_SCOPE("VulkanHotReload::apply");
+
+    Batch batch = building.get();
+
+    // the old pipelines and shaders are freed as they're replaced
+    for (ShaderRebuild & rebuild : batch.shaders) {
+        rebuild.material->replacePipeline(std::move(rebuild.shaders), std::move(rebuild.pipeline));
+
+        printf("Reloaded material %s\n", rebuild.material->getName().c_str());
+    }
+
+    for (TextureReload & reload : batch.textures) {
+        reload.replacement->configureLayouts(pool, queue);
+
+        // everything keeps pointing at the same texture, which now has the new image
+        reload.texture->swap(*reload.replacement);
+
+        for (Material * material : materials) {
+            material->textureChanged(reload.texture);
+        }
+
+        printf("Reloaded image %s\n", reload.texture->getPath().c_str());
+    }
+
+    // a reference which was added is watched from now on
+    for (const std::string & file : batch.gameFiles) {
+        if (gameFiles.insert(file).second) {
+            watcher.watch(file);
+        }
+    }
+
+    for (BufferRewrite & rewrite : batch.buffers) {
+        values[rewrite.instance] = std::move(rewrite.values);
+
+        write(rewrite.instance);
+
+        printf("Reloaded ubo instance %s\n", rewrite.instance.c_str());
+    }
+}
@@ -16,11 +16,16 @@
 #include "VulkanImage.hpp"
 #include "VulkanCommandBuffer.hpp"
 #include "VulkanSingleCommand.hpp"
+#include "PixelKernels.hpp"
 
-Texture::Texture(VulkanDevice & device, std::string path) :
+bool ImageWriter::WritePNG(const std::string & path, const uint8_t * pixels, int width, int height, int channels) {
+    return stbi_write_png(path.c_str(), width, height, channels, pixels, width * channels) != 0;
+}
+
+Texture::Texture(VulkanDevice & device, std::string path, const ChromaKey * key) :
 device(device) {
     this->path = path;
-    loadImageData(path);
+    loadImageData(path, key);
     createImage();
     createImageView();
 }
@@ -45,14 +50,29 @@ void Texture::configureLayouts(VulkanCommandBufferPool & pool, VulkanQueue & que
             vk::ImageLayout::eShaderReadOnlyOptimal);
 }
 
-void Texture::loadImageData(std::string path) {
+void Texture::swap(Texture & other) {
+    std::swap(width, other.width);
+    std::swap(height, other.height);
+    std::swap(channels, other.channels);
+    std::swap(image, other.image);
+    std::swap(view, other.view);
+    std::swap(stagingBuffer, other.stagingBuffer);
+    std::swap(stagingMemory, other.stagingMemory);
+    std::swap(imageMemory, other.imageMemory);
+}
+
+void Texture::loadImageData(std::string path, const ChromaKey * key) {
 
     stbi_uc * pixels = stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
 
     if (!pixels) {
         throw std::runtime_error("Could not load image " + path);
     }
-    
+
+    if (key) {
+        applyChromaKey(pixels, width * height, *key);
+    }
+
     vk::DeviceSize imageSize = width * height * 4;
 
     device.createBuffer(imageSize, vk::BufferUsageFlagBits::eTransferSrc,
@@ -81,15 +101,38 @@ void Texture::loadImageData(unsigned char * buffer, int width, int height) {
 
     void* data;
     device->mapMemory(stagingMemory, 0, imageSize, vk::MemoryMapFlags(), &data);
-    
-    for(int i = 0; i < width * height; i++) {
-        memset(reinterpret_cast<unsigned char*>(data) + i * 4, 0xFF, 4);
-        memcpy(reinterpret_cast<unsigned char*>(data) + i * 4, buffer + i * channels, channels);
+
+    unsigned char * dst = reinterpret_cast<unsigned char*> (data);
+    size_t count = static_cast<size_t> (width * height);
+
+    if (channels == 4) {
+        memcpy(dst, buffer, static_cast<size_t> (imageSize));
+    } else if (channels == 3) {
+        PixelKernels::ExpandRGBToRGBA(buffer, dst, count);
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            memset(dst + i * 4, 0xFF, 4);
+            memcpy(dst + i * 4, buffer + i * channels, channels);
+        }
     }
-    
+
     device->unmapMemory(stagingMemory);
 }
 
+void Texture::applyChromaKey(unsigned char * pixels, size_t count, const ChromaKey & key) {
+    PixelKernels::ChromaKeyParams params;
+
+    for (int c = 0; c < 4; c++) {
+        params.search[c] = key.search[c];
+        params.replace[c] = key.replace[c];
+    }
+
+    params.epsilon1 = key.epsilon1;
+    params.epsilon2 = key.epsilon2;
+
+    PixelKernels::ChromaKeyAlpha(pixels, count, params);
+}
+
 void Texture::createImage(void) {
     vk::ImageCreateInfo imageInfo;
     imageInfo.imageType = vk::ImageType::e2D;
@@ -219,6 +262,9 @@ void Font::loadFontData(const char* filename, bool alpha) {
         throw std::runtime_error("Could not load image " + std::string(filename));
     }
 
+    // stb reports the file's channels, not the ones it converted to
+    channels = alpha ? 4 : 3;
+
     int current_char = 0;
     int current_index = 0;
 
@@ -226,12 +272,11 @@ void Font::loadFontData(const char* filename, bool alpha) {
 
     // for the top row, check every red channel.
     // If the red channel isn't 255, the pixel is the start of a new character
-    for (int i = 0; i < width * channels; i++) {
+    for (int index = 0; index < width; index++) {
 
-        unsigned char chr = pixels[i] & 0xFF;
+        unsigned char chr = pixels[index * channels];
 
-        if (chr != 0xFF && i % channels == 0) {
-            int index = i / channels;
+        if (chr != 0xFF) {
 
             if (character_seen) {
                 characters.push_back(Character{current_char, current_index, index - current_index});
@@ -243,47 +288,3 @@ void Font::loadFontData(const char* filename, bool alpha) {
         }
     }
 }
-
-std::shared_ptr<unsigned char> Font::RenderImage(char const * text, int * _width, int * _height, int * _channels) {
-    int width = 0;
-
-    std::vector<struct Character*> chars;
-
-    // convert the string to the character vector and calculate the image width
-    for (char const * curr = text; *curr; curr++) {
-        try {
-            int c = std::tolower(*curr);
-            for (auto & ch : characters) {
-                if (ch.c == c) {
-                    width += ch.width;
-                    chars.push_back((&ch));
-                }
-            }
-        } catch (std::out_of_range) {
-            throw std::runtime_error("Unknown character '" + std::string(1, *curr) + "'");
-        }
-    }
-    
-    size_t n = width * (height - 1) * channels;
-    std::shared_ptr<unsigned char> pixels(new unsigned char[n]);
-
-    memset(pixels.get(), 0, n);
-
-    int x = 0;
-
-    for (auto & ch : chars) {
-        for (int i = 0; i < height-1; i++) {
-            unsigned char * src = &this->pixels[channels * (this->width * (i+1) + ch->xoffset)];
-            unsigned char * dst = &pixels.get()[channels * (width * i + x)];
-            memcpy(dst, src, channels * ch->width);
-        }
-
-        x += ch->width;
-    }
-
-    *_width = width;
-    *_height = height - 1;
-    *_channels = channels;
-
-    return pixels;
-}
@@ -0,0 +1,306 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <string>
+
+#include "VulkanIndirect.hpp"
+
+namespace {
+
+    // what cull.comp reads
+    struct CullPushConstant {
+        // what the camera can see, in world space
+        glm::vec4 bounds;
+        uint32_t count;
+    };
+
+}
+
+VulkanIndirectBatch::VulkanIndirectBatch(VulkanCullPass * pass, Material * material, VulkanIndexBuffer * indexBuffer,
+        uint32_t id, uint32_t first, uint32_t capacity, int order) :
+pass(pass), material(material), indexBuffer(indexBuffer), id(id), first(first), capacity(capacity), order(order) {
+
+    // popped from the back, so the lowest slots are handed out first
+    for (uint32_t i = capacity; i > 0; i--) {
+        freeSlots.push_back(first + i - 1);
+    }
+}
+
+uint32_t VulkanIndirectBatch::acquire(void) {
+    if (freeSlots.empty()) {
+        throw std::runtime_error("Indirect batch is full");
+    }
+
+    uint32_t slot = freeSlots.back();
+    freeSlots.pop_back();
+
+    struct IndirectInstance & instance = pass->getInstance(slot);
+
+    instance = IndirectInstance();
+    instance.batch = id;
+    instance.active = 0;
+
+    return slot;
+}
+
+void VulkanIndirectBatch::release(uint32_t slot) {
+    if (slot < first || slot >= first + capacity) {
+        throw std::runtime_error("Slot " + std::to_string(slot) + " doesn't belong to this batch");
+    }
+
+    pass->getInstance(slot).active = 0;
+
+    freeSlots.push_back(slot);
+}
+
+struct IndirectInstance & VulkanIndirectBatch::getInstance(uint32_t slot) {
+    return pass->getInstance(slot);
+}
+
+void VulkanIndirectBatch::recordFrame(size_t frame) {
+    vk::CommandBufferInheritanceInfo inheritance(pass->getRenderPass()->getRenderPass(), 0, pass->getTarget()->getFrame(frame));
+
+    current = pass->getPools()->acquire(vk::CommandBufferLevel::eSecondary);
+
+    vk::CommandBuffer buffer = current;
+
+    buffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eRenderPassContinue, &inheritance));
+
+    vk::PipelineLayout layout = material->getPipeline()->getLayout();
+
+    buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, material->getPipeline()->get());
+
+    if (material->hasDescriptors()) {
+        buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, layout, 0, 1, &material->getDescriptorSet(), 0, nullptr);
+    }
+
+    vk::DescriptorSet set = pass->getSet();
+
+    buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, layout, 2, 1, &set, 0, nullptr);
+
+    material->getVertexBindings(vBuffers, vOffsets);
+
+    if (vBuffers.size() > 0) {
+        buffer.bindVertexBuffers(0, vBuffers.size(), vBuffers.data(), vOffsets.data());
+    }
+
+    buffer.bindIndexBuffer(indexBuffer->getBuffer(), indexBuffer->getOffset(), vk::IndexType::eUint16);
+
+    struct IndirectPushConstant info;
+    info.first = first;
+
+    buffer.pushConstants(layout, vk::ShaderStageFlagBits::eVertex, 0, sizeof (info), &info);
+
+    vk::DeviceSize offset = pass->getCommandOffset(*this);
+
+    VulkanCamera * camera = pass->getCamera();
+
+    for (uint32_t view = 0; view < camera->viewCount(); view++) {
+        camera->bind(buffer, layout, view);
+
+        if (pass->getDrawCountFunction()) {
+            // the count is 0 when nothing in the batch survived, so the draw is skipped on the gpu
+            pass->getDrawCountFunction()(buffer, pass->getCommandBuffer(), offset,
+                    pass->getCountBuffer(), id * sizeof (uint32_t), 1, sizeof (struct IndirectCommand));
+        } else {
+            buffer.drawIndexedIndirect(pass->getCommandBuffer(), offset, 1, sizeof (struct IndirectCommand));
+        }
+    }
+
+    buffer.end();
+}
+
+VulkanCullPass::VulkanCullPass(VulkanDevice & device, VulkanFrameCommandPools * pools, VulkanFramebufferSource * target,
+        VulkanRenderPass * renderPass, VulkanCamera * camera, uint32_t capacity, const std::string & cullShader) :
+device(device), pools(pools), target(target), renderPass(renderPass), camera(camera), capacity(capacity),
+instances(capacity), frames(pools->frameCount()) {
+
+    if (capacity == 0) {
+        throw std::runtime_error("Cull pass needs at least one instance slot");
+    }
+
+    // instances, visible lists, commands, counts
+    std::vector<vk::DescriptorSetLayoutBinding> bindings;
+
+    for (uint32_t i = 0; i < 4; i++) {
+        bindings.push_back(vk::DescriptorSetLayoutBinding(i, vk::DescriptorType::eStorageBuffer, 1,
+                vk::ShaderStageFlagBits::eCompute | vk::ShaderStageFlagBits::eVertex));
+    }
+
+    layout = device->createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo(vk::DescriptorSetLayoutCreateFlags(),
+            static_cast<uint32_t> (bindings.size()), bindings.data()));
+
+    vk::DescriptorPoolSize poolSize(vk::DescriptorType::eStorageBuffer, static_cast<uint32_t> (4 * frames.size()));
+
+    descriptorPool = device->createDescriptorPool(vk::DescriptorPoolCreateInfo(vk::DescriptorPoolCreateFlags(),
+            static_cast<uint32_t> (frames.size()), 1, &poolSize));
+
+    for (auto & frame : frames) {
+        createFrame(frame);
+    }
+
+    shader = std::unique_ptr<VulkanShader>(new VulkanShader(device, cullShader, vk::ShaderStageFlagBits::eCompute));
+
+    std::vector<vk::DescriptorSetLayout> sets{layout};
+    std::vector<vk::PushConstantRange> ranges{vk::PushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof (struct CullPushConstant))};
+
+    pipeline = std::unique_ptr<VulkanPipeline>(new VulkanPipeline(device, ranges, sets, *shader));
+
+    if (device.hasExtension("VK_KHR_draw_indirect_count")) {
+        drawIndexedIndirectCount = (PFN_vkCmdDrawIndexedIndirectCountKHR) device->getProcAddr("vkCmdDrawIndexedIndirectCountKHR");
+    }
+}
+
+VulkanCullPass::~VulkanCullPass() {
+    for (auto & frame : frames) {
+        destroyFrame(frame);
+    }
+
+    device->destroyDescriptorPool(descriptorPool);
+    device->destroyDescriptorSetLayout(layout);
+}
+
+void VulkanCullPass::prepareMaterial(MaterialPrototype & prototype, const std::string & vertexShader) {
+    prototype.extraSets.push_back(layout);
+    prototype.shaders.push_back({vertexShader, vk::ShaderStageFlagBits::eVertex});
+
+    int id = 0;
+
+    for (auto & pc : prototype.pushConstants) {
+        id = std::max(id, pc.id + 1);
+    }
+
+    prototype.pushConstants.push_back({id, 0, sizeof (struct IndirectPushConstant), vk::ShaderStageFlagBits::eVertex});
+}
+
+VulkanIndirectBatch * VulkanCullPass::addBatch(Material * material, VulkanIndexBuffer * indexBuffer, uint32_t capacity, int order) {
+    if (used + capacity > this->capacity) {
+        throw std::runtime_error("Cull pass has no room for another " + std::to_string(capacity) + " instances");
+    }
+
+    if (batches.size() >= MAX_BATCHES) {
+        throw std::runtime_error("Cull pass has too many batches");
+    }
+
+    uint32_t id = static_cast<uint32_t> (batches.size());
+
+    batches.emplace_back(new VulkanIndirectBatch(this, material, indexBuffer, id, used, capacity, order));
+
+    struct IndirectCommand command = {};
+
+    command.indexCount = static_cast<uint32_t> (indexBuffer->getObjectCount());
+    command.first = used;
+
+    commands.push_back(command);
+
+    used += capacity;
+
+    return batches.back().get();
+}
+
+void VulkanCullPass::recordPrePass(vk::CommandBuffer buffer) {
+    if (batches.empty()) {
+        return;
+    }
+
+    struct FrameResources & frame = frames[pools->getCurrentFrame()];
+
+    // one copy for every instance, whatever changed
+    memcpy(frame.mapped, instances.data(), used * sizeof (struct IndirectInstance));
+
+    // the stored commands always have no instances
+    buffer.updateBuffer(frame.commands, 0, commands.size() * sizeof (struct IndirectCommand), commands.data());
+    buffer.fillBuffer(frame.counts, 0, VK_WHOLE_SIZE, 0);
+
+    vk::MemoryBarrier reset(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+
+    buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader,
+            vk::DependencyFlags(), 1, &reset, 0, nullptr, 0, nullptr);
+
+    buffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline->get());
+    buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipeline->getLayout(), 0, 1, &frame.set, 0, nullptr);
+
+    struct CullPushConstant info;
+    info.bounds = camera->getWorldBounds();
+    info.count = used;
+
+    buffer.pushConstants(pipeline->getLayout(), vk::ShaderStageFlagBits::eCompute, 0, sizeof (info), &info);
+
+    buffer.dispatch((used + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+    vk::MemoryBarrier culled(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eShaderRead);
+
+    buffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+            vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexShader,
+            vk::DependencyFlags(), 1, &culled, 0, nullptr, 0, nullptr);
+}
+
+void VulkanCullPass::record(size_t frame) {
+    for (auto & batch : batches) {
+        if (batch->count() > 0) {
+            batch->recordFrame(frame);
+        }
+    }
+}
+
+void VulkanCullPass::createFrame(struct FrameResources & frame) {
+    vk::DeviceSize instanceSize = capacity * sizeof (struct IndirectInstance);
+    vk::DeviceSize visibleSize = capacity * sizeof (uint32_t);
+    vk::DeviceSize commandSize = MAX_BATCHES * sizeof (struct IndirectCommand);
+    vk::DeviceSize countSize = MAX_BATCHES * sizeof (uint32_t);
+
+    device.createBuffer(instanceSize, vk::BufferUsageFlagBits::eStorageBuffer,
+            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+            frame.instances, frame.instanceMemory);
+
+    device.createBuffer(visibleSize, vk::BufferUsageFlagBits::eStorageBuffer,
+            vk::MemoryPropertyFlagBits::eDeviceLocal, frame.visible, frame.visibleMemory);
+
+    vk::BufferUsageFlags indirectUsage = vk::BufferUsageFlagBits::eStorageBuffer |
+            vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst;
+
+    device.createBuffer(commandSize, indirectUsage, vk::MemoryPropertyFlagBits::eDeviceLocal, frame.commands, frame.commandMemory);
+    device.createBuffer(countSize, indirectUsage, vk::MemoryPropertyFlagBits::eDeviceLocal, frame.counts, frame.countMemory);
+
+    // stays mapped, the memory is coherent
+    device->mapMemory(frame.instanceMemory, 0, instanceSize, vk::MemoryMapFlags(), &frame.mapped);
+
+    vk::DescriptorSetAllocateInfo allocInfo(descriptorPool, 1, &layout);
+
+    frame.set = device->allocateDescriptorSets(allocInfo)[0];
+
+    std::array<vk::DescriptorBufferInfo, 4> infos = {
+        vk::DescriptorBufferInfo(frame.instances, 0, VK_WHOLE_SIZE),
+        vk::DescriptorBufferInfo(frame.visible, 0, VK_WHOLE_SIZE),
+        vk::DescriptorBufferInfo(frame.commands, 0, VK_WHOLE_SIZE),
+        vk::DescriptorBufferInfo(frame.counts, 0, VK_WHOLE_SIZE)
+    };
+
+    std::vector<vk::WriteDescriptorSet> writes;
+
+    for (uint32_t i = 0; i < infos.size(); i++) {
+        writes.push_back(vk::WriteDescriptorSet(frame.set, i, 0, 1, vk::DescriptorType::eStorageBuffer, nullptr, &infos[i]));
+    }
+
+    device->updateDescriptorSets(static_cast<uint32_t> (writes.size()), writes.data(), 0, nullptr);
+}
+
+void VulkanCullPass::destroyFrame(struct FrameResources & frame) {
+    device->unmapMemory(frame.instanceMemory);
+
+    device->destroyBuffer(frame.instances);
+    device->destroyBuffer(frame.visible);
+    device->destroyBuffer(frame.commands);
+    device->destroyBuffer(frame.counts);
+
+    device->freeMemory(frame.instanceMemory);
+    device->freeMemory(frame.visibleMemory);
+    device->freeMemory(frame.commandMemory);
+    device->freeMemory(frame.countMemory);
+}
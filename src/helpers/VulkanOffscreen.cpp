@@ -0,0 +1,70 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+#include <cstring>
+
+#include "VulkanOffscreen.hpp"
+#include "VulkanSingleCommand.hpp"
+
+VulkanOffscreenTarget::VulkanOffscreenTarget(VulkanDevice & device, VulkanRenderPass & renderPass, VulkanViewport & viewport,
+        VulkanDepthBuffer & depthBuffer, vk::Format format) :
+device(device), format(format), width(viewport.getWidth()), height(viewport.getHeight()) {
+
+    vk::ImageCreateInfo imageInfo(vk::ImageCreateFlags(), vk::ImageType::e2D, format, vk::Extent3D(width, height, 1),
+            1, 1, vk::SampleCountFlagBits::e1, vk::ImageTiling::eOptimal,
+            vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc);
+
+    image = device->createImageUnique(imageInfo);
+
+    vk::MemoryRequirements requirements = device->getImageMemoryRequirements(image.get());
+
+    memory = device->allocateMemoryUnique(vk::MemoryAllocateInfo(requirements.size,
+            device.findMemoryType(requirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal)));
+
+    device->bindImageMemory(image.get(), memory.get(), 0);
+
+    vk::ComponentMapping componentMapping(vk::ComponentSwizzle::eR, vk::ComponentSwizzle::eG, vk::ComponentSwizzle::eB, vk::ComponentSwizzle::eA);
+    vk::ImageSubresourceRange subResourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+
+    view = device->createImageViewUnique(vk::ImageViewCreateInfo(vk::ImageViewCreateFlags(), image.get(),
+            vk::ImageViewType::e2D, format, componentMapping, subResourceRange));
+
+    std::vector<vk::ImageView> attachments{view.get()};
+
+    if (renderPass.hasAttachment("depth")) {
+        attachments.push_back(depthBuffer.getView());
+    }
+
+    framebuffer = device->createFramebufferUnique(vk::FramebufferCreateInfo(vk::FramebufferCreateFlags(),
+            renderPass.getRenderPass(), static_cast<uint32_t> (attachments.size()), attachments.data(), width, height, 1));
+}
+
+VulkanOffscreenTarget::~VulkanOffscreenTarget() {
+    if (readback) {
+        device->destroyBuffer(readback);
+        device->freeMemory(readbackMemory);
+    }
+}
+
+void VulkanOffscreenTarget::readPixels(VulkanCommandBufferPool & pool, VulkanQueue & queue, std::vector<uint8_t> & pixels) {
+    // only 4 byte formats are created here
+    vk::DeviceSize size = static_cast<vk::DeviceSize> (width) * height * 4;
+
+    if (!readback) {
+        device.createBuffer(size, vk::BufferUsageFlagBits::eTransferDst,
+                vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+                readback, readbackMemory);
+    }
+
+    VulkanSingleCommand::copyImageToBuffer(device, pool, queue, image.get(), readback, width, height);
+
+    pixels.resize(size);
+
+    void* data;
+    device->mapMemory(readbackMemory, 0, size, vk::MemoryMapFlags(), &data);
+    memcpy(pixels.data(), data, static_cast<size_t> (size));
+    device->unmapMemory(readbackMemory);
+}
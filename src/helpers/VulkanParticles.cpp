@@ -0,0 +1,310 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <string>
+
+#include "VulkanParticles.hpp"
+
+namespace {
+
+    // what particles.comp reads
+    struct SimulatePushConstant {
+        float deltat;
+        uint32_t head;
+        uint32_t spawnCount;
+        uint32_t emitterCount;
+
+        // what the camera can see, in world space
+        glm::vec4 bounds;
+        uint32_t capacity;
+        uint32_t seed;
+
+        // 0 spawns, 1 integrates and culls
+        uint32_t stage;
+    };
+
+    // particles, visible list, emitters, draw command
+    const uint32_t BINDING_COUNT = 4;
+
+}
+
+VulkanParticleSystem::VulkanParticleSystem(VulkanDevice & device, VulkanFrameCommandPools * pools, VulkanFramebufferSource * target,
+        VulkanRenderPass * renderPass, VulkanCamera * camera, uint32_t capacity, const std::string & particleShader) :
+device(device), pools(pools), target(target), renderPass(renderPass), camera(camera), capacity(capacity),
+frames(pools->frameCount()) {
+
+    if (capacity == 0) {
+        throw std::runtime_error("Particle system needs room for at least one particle");
+    }
+
+    std::vector<vk::DescriptorSetLayoutBinding> bindings;
+
+    for (uint32_t i = 0; i < BINDING_COUNT; i++) {
+        bindings.push_back(vk::DescriptorSetLayoutBinding(i, vk::DescriptorType::eStorageBuffer, 1,
+                vk::ShaderStageFlagBits::eCompute | vk::ShaderStageFlagBits::eVertex));
+    }
+
+    layout = device->createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo(vk::DescriptorSetLayoutCreateFlags(),
+            static_cast<uint32_t> (bindings.size()), bindings.data()));
+
+    vk::DescriptorPoolSize poolSize(vk::DescriptorType::eStorageBuffer, static_cast<uint32_t> (BINDING_COUNT * frames.size()));
+
+    descriptorPool = device->createDescriptorPool(vk::DescriptorPoolCreateInfo(vk::DescriptorPoolCreateFlags(),
+            static_cast<uint32_t> (frames.size()), 1, &poolSize));
+
+    device.createBuffer(capacity * sizeof (struct Particle), vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+            vk::MemoryPropertyFlagBits::eDeviceLocal, particles, particleMemory);
+
+    device.createBuffer(capacity * sizeof (uint32_t), vk::BufferUsageFlagBits::eStorageBuffer,
+            vk::MemoryPropertyFlagBits::eDeviceLocal, visible, visibleMemory);
+
+    device.createBuffer(sizeof (VkDrawIndexedIndirectCommand), vk::BufferUsageFlagBits::eStorageBuffer |
+            vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst,
+            vk::MemoryPropertyFlagBits::eDeviceLocal, command, commandMemory);
+
+    for (auto & frame : frames) {
+        createFrame(frame);
+    }
+
+    shader = std::unique_ptr<VulkanShader>(new VulkanShader(device, particleShader, vk::ShaderStageFlagBits::eCompute));
+
+    std::vector<vk::DescriptorSetLayout> sets{layout};
+    std::vector<vk::PushConstantRange> ranges{vk::PushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof (struct SimulatePushConstant))};
+
+    pipeline = std::unique_ptr<VulkanPipeline>(new VulkanPipeline(device, ranges, sets, *shader));
+
+    emitters.reserve(MAX_EMITTERS);
+}
+
+VulkanParticleSystem::~VulkanParticleSystem() {
+    for (auto & frame : frames) {
+        destroyFrame(frame);
+    }
+
+    device->destroyBuffer(particles);
+    device->destroyBuffer(visible);
+    device->destroyBuffer(command);
+
+    device->freeMemory(particleMemory);
+    device->freeMemory(visibleMemory);
+    device->freeMemory(commandMemory);
+
+    device->destroyDescriptorPool(descriptorPool);
+    device->destroyDescriptorSetLayout(layout);
+}
+
+void VulkanParticleSystem::prepareMaterial(MaterialPrototype & prototype, const std::string & vertexShader,
+        const std::string & fragmentShader) {
+    prototype.extraSets.push_back(layout);
+    prototype.shaders.push_back({vertexShader, vk::ShaderStageFlagBits::eVertex});
+    prototype.shaders.push_back({fragmentShader, vk::ShaderStageFlagBits::eFragment});
+
+    int id = 0;
+
+    for (auto & pc : prototype.pushConstants) {
+        id = std::max(id, pc.id + 1);
+    }
+
+    prototype.pushConstants.push_back({id, 0, sizeof (struct ParticlePushConstant), vk::ShaderStageFlagBits::eVertex});
+
+    // particles fade out, so they always blend
+    prototype.transparent = true;
+}
+
+void VulkanParticleSystem::setMaterial(Material * material, VulkanIndexBuffer * indexBuffer, int order, float depth) {
+    this->material = material;
+    this->indexBuffer = indexBuffer;
+    this->order = order;
+    this->depth = depth;
+}
+
+void VulkanParticleSystem::emit(const struct ParticleEmitter & emitter) {
+    uint32_t count = std::min(emitter.count, capacity - spawnCount);
+
+    if (count == 0 || emitters.size() >= MAX_EMITTERS) {
+        return;
+    }
+
+    emitters.push_back(emitter);
+    emitters.back().count = count;
+    emitters.back().first = spawnCount;
+
+    spawnCount += count;
+
+    aliveUntil = std::max(aliveUntil, time + emitter.life);
+}
+
+void VulkanParticleSystem::clear(void) {
+    emitters.clear();
+    spawnCount = 0;
+    head = 0;
+    aliveUntil = 0;
+
+    cleared = false;
+}
+
+void VulkanParticleSystem::recordPrePass(vk::CommandBuffer buffer) {
+    if (!material || (cleared && !isActive())) {
+        pending = 0;
+        return;
+    }
+
+    struct FrameResources & frame = frames[pools->getCurrentFrame()];
+
+    // the last frame's draw may still be reading what's about to be written
+    buffer.pipelineBarrier(vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexShader,
+            vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eComputeShader,
+            vk::DependencyFlags(), 0, nullptr, 0, nullptr, 0, nullptr);
+
+    if (!cleared) {
+        // a zeroed particle's age has reached its life, so it's dead
+        buffer.fillBuffer(particles, 0, VK_WHOLE_SIZE, 0);
+        cleared = true;
+    }
+
+    memcpy(frame.mapped, emitters.data(), emitters.size() * sizeof (struct ParticleEmitter));
+
+    VkDrawIndexedIndirectCommand reset = {};
+    reset.indexCount = static_cast<uint32_t> (indexBuffer->getObjectCount());
+
+    buffer.updateBuffer(command, 0, sizeof (reset), &reset);
+
+    vk::MemoryBarrier written(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+
+    buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader,
+            vk::DependencyFlags(), 1, &written, 0, nullptr, 0, nullptr);
+
+    buffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline->get());
+    buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipeline->getLayout(), 0, 1, &frame.set, 0, nullptr);
+
+    struct SimulatePushConstant info;
+    info.deltat = static_cast<float> (pending);
+    info.head = head;
+    info.spawnCount = spawnCount;
+    info.emitterCount = static_cast<uint32_t> (emitters.size());
+    info.bounds = camera->getWorldBounds();
+    info.capacity = capacity;
+    info.seed = seed++;
+
+    if (spawnCount > 0) {
+        info.stage = 0;
+
+        buffer.pushConstants(pipeline->getLayout(), vk::ShaderStageFlagBits::eCompute, 0, sizeof (info), &info);
+        buffer.dispatch((spawnCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+        vk::MemoryBarrier spawned(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+
+        buffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
+                vk::DependencyFlags(), 1, &spawned, 0, nullptr, 0, nullptr);
+    }
+
+    info.stage = 1;
+
+    buffer.pushConstants(pipeline->getLayout(), vk::ShaderStageFlagBits::eCompute, 0, sizeof (info), &info);
+    buffer.dispatch((capacity + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+    vk::MemoryBarrier simulated(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eShaderRead);
+
+    buffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+            vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexShader,
+            vk::DependencyFlags(), 1, &simulated, 0, nullptr, 0, nullptr);
+
+    // the oldest particles are overwritten first
+    head = (head + spawnCount) % capacity;
+
+    emitters.clear();
+    spawnCount = 0;
+    pending = 0;
+}
+
+void VulkanParticleSystem::record(size_t frame) {
+    if (!material || !isActive()) {
+        current = nullptr;
+        return;
+    }
+
+    vk::CommandBufferInheritanceInfo inheritance(renderPass->getRenderPass(), 0, target->getFrame(frame));
+
+    current = pools->acquire(vk::CommandBufferLevel::eSecondary);
+
+    vk::CommandBuffer buffer = current;
+
+    buffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eRenderPassContinue, &inheritance));
+
+    vk::PipelineLayout pipelineLayout = material->getPipeline()->getLayout();
+
+    buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, material->getPipeline()->get());
+
+    if (material->hasDescriptors()) {
+        buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 0, 1, &material->getDescriptorSet(), 0, nullptr);
+    }
+
+    vk::DescriptorSet set = frames[pools->getCurrentFrame()].set;
+
+    buffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 2, 1, &set, 0, nullptr);
+
+    material->getVertexBindings(vBuffers, vOffsets);
+
+    if (vBuffers.size() > 0) {
+        buffer.bindVertexBuffers(0, vBuffers.size(), vBuffers.data(), vOffsets.data());
+    }
+
+    buffer.bindIndexBuffer(indexBuffer->getBuffer(), indexBuffer->getOffset(), vk::IndexType::eUint16);
+
+    struct ParticlePushConstant info;
+    info.depth = depth;
+
+    buffer.pushConstants(pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, sizeof (info), &info);
+
+    for (uint32_t view = 0; view < camera->viewCount(); view++) {
+        camera->bind(buffer, pipelineLayout, view);
+
+        // the instance count is whatever survived the cull
+        buffer.drawIndexedIndirect(command, 0, 1, sizeof (VkDrawIndexedIndirectCommand));
+    }
+
+    buffer.end();
+}
+
+void VulkanParticleSystem::createFrame(struct FrameResources & frame) {
+    vk::DeviceSize emitterSize = MAX_EMITTERS * sizeof (struct ParticleEmitter);
+
+    device.createBuffer(emitterSize, vk::BufferUsageFlagBits::eStorageBuffer,
+            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+            frame.emitters, frame.emitterMemory);
+
+    // stays mapped, the memory is coherent
+    device->mapMemory(frame.emitterMemory, 0, emitterSize, vk::MemoryMapFlags(), &frame.mapped);
+
+    vk::DescriptorSetAllocateInfo allocInfo(descriptorPool, 1, &layout);
+
+    frame.set = device->allocateDescriptorSets(allocInfo)[0];
+
+    std::array<vk::DescriptorBufferInfo, BINDING_COUNT> infos = {
+        vk::DescriptorBufferInfo(particles, 0, VK_WHOLE_SIZE),
+        vk::DescriptorBufferInfo(visible, 0, VK_WHOLE_SIZE),
+        vk::DescriptorBufferInfo(frame.emitters, 0, VK_WHOLE_SIZE),
+        vk::DescriptorBufferInfo(command, 0, VK_WHOLE_SIZE)
+    };
+
+    std::vector<vk::WriteDescriptorSet> writes;
+
+    for (uint32_t i = 0; i < infos.size(); i++) {
+        writes.push_back(vk::WriteDescriptorSet(frame.set, i, 0, 1, vk::DescriptorType::eStorageBuffer, nullptr, &infos[i]));
+    }
+
+    device->updateDescriptorSets(static_cast<uint32_t> (writes.size()), writes.data(), 0, nullptr);
+}
+
+void VulkanParticleSystem::destroyFrame(struct FrameResources & frame) {
+    device->unmapMemory(frame.emitterMemory);
+
+    device->destroyBuffer(frame.emitters);
+    device->freeMemory(frame.emitterMemory);
+}
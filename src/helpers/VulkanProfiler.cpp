@@ -0,0 +1,176 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+#include <algorithm>
+#include <iomanip>
+
+#include "VulkanProfiler.hpp"
+
+VulkanGPUProfiler::VulkanGPUProfiler(VulkanDevice & device, uint32_t framesInFlight, uint32_t maxRegions, size_t window) :
+device(device), queriesPerFrame(maxRegions * 2), window(std::max<size_t>(window, 1)), frames(framesInFlight + 1) {
+
+    vk::PhysicalDeviceProperties properties = device.getProperties();
+
+    uint32_t validBits = device.getQueueFamilyProperties()[device.getGraphicsQueueIndex()].timestampValidBits;
+
+    // timestampComputeAndGraphics only promises every queue supports it, the graphics queue is all that's used
+    supported = validBits > 0 && properties.limits.timestampPeriod > 0;
+
+    if (!supported) {
+        return;
+    }
+
+    period = properties.limits.timestampPeriod;
+    validMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+    pool = device->createQueryPool(vk::QueryPoolCreateInfo(vk::QueryPoolCreateFlags(), vk::QueryType::eTimestamp,
+            queriesPerFrame * static_cast<uint32_t> (frames.size())));
+}
+
+VulkanGPUProfiler::~VulkanGPUProfiler() {
+    if (supported) {
+        device->destroyQueryPool(pool);
+    }
+}
+
+void VulkanGPUProfiler::newFrame(void) {
+    if (!supported) {
+        return;
+    }
+
+    current = (current + 1) % frames.size();
+
+    struct FrameQueries & frame = frames[current];
+
+    if (frame.reset && frame.used > 0) {
+        readBack(frame, static_cast<uint32_t> (current) * queriesPerFrame);
+    }
+
+    frame.names.clear();
+    frame.used = 0;
+    frame.reset = false;
+}
+
+void VulkanGPUProfiler::recordReset(vk::CommandBuffer buffer) {
+    if (!supported) {
+        return;
+    }
+
+    buffer.resetQueryPool(pool, static_cast<uint32_t> (current) * queriesPerFrame, queriesPerFrame);
+
+    frames[current].reset = true;
+}
+
+int VulkanGPUProfiler::begin(vk::CommandBuffer buffer, const std::string & name) {
+    struct FrameQueries & frame = frames[current];
+
+    if (!supported || frame.used + 2 > queriesPerFrame) {
+        return -1;
+    }
+
+    int region = static_cast<int> (frame.names.size());
+
+    frame.names.push_back(name);
+    frame.used += 2;
+
+    buffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, pool,
+            static_cast<uint32_t> (current) * queriesPerFrame + region * 2);
+
+    return region;
+}
+
+void VulkanGPUProfiler::end(vk::CommandBuffer buffer, int region) {
+    if (!supported || region < 0) {
+        return;
+    }
+
+    buffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, pool,
+            static_cast<uint32_t> (current) * queriesPerFrame + region * 2 + 1);
+}
+
+void VulkanGPUProfiler::readBack(struct FrameQueries & frame, uint32_t base) {
+    // each query is followed by its availability, so regions which were never submitted are skipped
+    std::vector<uint64_t> results(frame.used * 2);
+
+    vk::Result result = device->getQueryPoolResults(pool, base, frame.used, results.size() * sizeof (uint64_t),
+            results.data(), 2 * sizeof (uint64_t), vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability);
+
+    if (result != vk::Result::eSuccess && result != vk::Result::eNotReady) {
+        droppedFrames++;
+        return;
+    }
+
+    std::map<std::string, double> totals;
+
+    for (size_t i = 0; i < frame.names.size(); i++) {
+        uint64_t * start = &results[i * 4], * end = &results[i * 4 + 2];
+
+        if (start[1] == 0 || end[1] == 0) {
+            continue;
+        }
+
+        uint64_t ticks = ((end[0] & validMask) - (start[0] & validMask)) & validMask;
+
+        totals[frame.names[i]] += ticks * period / 1e6;
+    }
+
+    if (totals.empty()) {
+        droppedFrames++;
+        return;
+    }
+
+    for (auto & total : totals) {
+        struct Stats & stat = stats[total.first];
+
+        if (stat.samples.empty()) {
+            stat.samples.resize(window);
+        }
+
+        stat.samples[stat.next] = total.second;
+        stat.next = (stat.next + 1) % stat.samples.size();
+        stat.count = std::min(stat.count + 1, stat.samples.size());
+    }
+}
+
+double VulkanGPUProfiler::getAverage(const std::string & name) const {
+    auto it = stats.find(name);
+
+    if (it == stats.end() || it->second.count == 0) {
+        return 0;
+    }
+
+    double total = 0;
+
+    for (size_t i = 0; i < it->second.count; i++) {
+        total += it->second.samples[i];
+    }
+
+    return total / it->second.count;
+}
+
+std::map<std::string, double> VulkanGPUProfiler::getAverages(void) const {
+    std::map<std::string, double> averages;
+
+    for (auto & stat : stats) {
+        averages[stat.first] = getAverage(stat.first);
+    }
+
+    return averages;
+}
+
+void VulkanGPUProfiler::report(std::ostream & out) const {
+    if (!supported) {
+        out << "GPU timestamps are not supported on this device" << std::endl;
+        return;
+    }
+
+    out << "GPU time per frame (average of " << window << " frames, " << droppedFrames << " dropped)" << std::endl;
+
+    for (auto & average : getAverages()) {
+        out << std::setw(24) << std::left << average.first << std::fixed << std::setprecision(3)
+                << average.second << " ms" << std::endl;
+    }
+}
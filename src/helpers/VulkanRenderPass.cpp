@@ -4,6 +4,8 @@
  * and open the template in the editor.
  */
 
+#include <algorithm>
+
 #include "VulkanRenderPass.hpp"
 
 void VulkanRenderPass::addAttachment(vk::AttachmentDescription attachment, std::string name) {
@@ -20,16 +22,21 @@ vk::AttachmentReference VulkanRenderPass::getAttachmentReference(std::string nam
     throw std::runtime_error("Attachment " + name + " is not defined");
 }
 
-void VulkanRenderPass::createDefaultAttachments(VulkanDevice & device, VulkanDepthBuffer & depthBuffer) {
+bool VulkanRenderPass::hasAttachment(std::string name) const {
+    return std::find(att_names.begin(), att_names.end(), name) != att_names.end();
+}
+
+void VulkanRenderPass::createDefaultAttachments(VulkanDevice & device, VulkanDepthBuffer & depthBuffer,
+        vk::Format colorFormat, vk::ImageLayout finalLayout) {
 
     vk::AttachmentDescription surfaceAttachment;
 
-    surfaceAttachment.format = device.getSurfaceFormat();
+    surfaceAttachment.format = colorFormat;
     surfaceAttachment.loadOp = vk::AttachmentLoadOp::eClear;
     surfaceAttachment.storeOp = vk::AttachmentStoreOp::eStore;
     surfaceAttachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
     surfaceAttachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
-    surfaceAttachment.finalLayout = vk::ImageLayout::ePresentSrcKHR;
+    surfaceAttachment.finalLayout = finalLayout;
 
     addAttachment(surfaceAttachment, "surface");
 
@@ -40,20 +47,21 @@ void VulkanRenderPass::createDefaultAttachments(VulkanDevice & device, VulkanDep
     depthAttachment.storeOp = vk::AttachmentStoreOp::eDontCare;
     depthAttachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
     depthAttachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+    depthAttachment.initialLayout = vk::ImageLayout::eUndefined;
     depthAttachment.finalLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
 
-    //addAttachment(depthAttachment, "depth");
+    addAttachment(depthAttachment, "depth");
 }
 
 void VulkanRenderPass::createRenderPass(VulkanDevice & device) {
     vk::AttachmentReference colorReference = getAttachmentReference("surface", vk::ImageLayout::eColorAttachmentOptimal);
-    //vk::AttachmentReference depthReference = getAttachmentReference("depth", vk::ImageLayout::eDepthStencilAttachmentOptimal);
+    vk::AttachmentReference depthReference = getAttachmentReference("depth", vk::ImageLayout::eDepthStencilAttachmentOptimal);
     vk::SubpassDescription subpass;
 
     subpass.pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
     subpass.colorAttachmentCount = 1;
     subpass.pColorAttachments = &colorReference;
-    //subpass.pDepthStencilAttachment = &depthReference;
+    subpass.pDepthStencilAttachment = &depthReference;
 
 
     vk::SubpassDependency subpassDep;
@@ -61,10 +69,14 @@ void VulkanRenderPass::createRenderPass(VulkanDevice & device) {
     subpassDep.srcSubpass = VK_SUBPASS_EXTERNAL;
     subpassDep.dstSubpass = 0;
 
-    subpassDep.srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
-    subpassDep.srcAccessMask = vk::AccessFlags();
-    subpassDep.dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
-    subpassDep.dstAccessMask = vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite;
+    vk::PipelineStageFlags depthStages = vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
+
+    // the frames share one depth buffer, so the last frame's depth writes must finish before this one clears it
+    subpassDep.srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | depthStages;
+    subpassDep.srcAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+    subpassDep.dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput | depthStages;
+    subpassDep.dstAccessMask = vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite |
+            vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
 
     vk::RenderPassCreateInfo renderPassInfo(vk::RenderPassCreateFlags(), attachments.size(), attachments.data(), 1, &subpass, 1, &subpassDep);
 
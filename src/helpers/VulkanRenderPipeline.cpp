@@ -19,6 +19,18 @@ VulkanPipeline::VulkanPipeline(VulkanDevice & device, std::vector<vk::PushConsta
     pipeline = device->createGraphicsPipelineUnique(cache, pipelineInfo);
 }
 
+VulkanPipeline::VulkanPipeline(VulkanDevice & device, std::vector<vk::PushConstantRange> & pushConstants,
+        std::vector<vk::DescriptorSetLayout> & sets, VulkanShader & shader) {
+
+    createLayout(device, sets, pushConstants);
+
+    vk::ComputePipelineCreateInfo pipelineInfo(vk::PipelineCreateFlags(), shader, pipelineLayout.get());
+
+    cache = device->createPipelineCache(vk::PipelineCacheCreateInfo());
+
+    pipeline = device->createComputePipelineUnique(cache, pipelineInfo);
+}
+
 void VulkanPipeline::createLayout(VulkanDevice & device,
         std::vector<vk::DescriptorSetLayout> & sets,
         std::vector<vk::PushConstantRange> & pushConstants) {
@@ -40,7 +52,7 @@ void VulkanPipeline::createLayout(VulkanDevice & device,
 VulkanPipeline * VulkanPipelineFactory::create(VulkanDevice & device, VulkanViewport & viewport,
         VulkanRenderPass & renderPass, std::vector<vk::DescriptorSetLayout> & sets,
         VulkanVertexInputState & vertexInput, std::vector<std::unique_ptr<VulkanShader>> & shaders,
-        std::vector<vk::PushConstantRange> & pushConstants) {
+        std::vector<vk::PushConstantRange> & pushConstants, bool transparent) {
 
     // STATIC SHADER MODULES START
 
@@ -66,7 +78,8 @@ VulkanPipeline * VulkanPipelineFactory::create(VulkanDevice & device, VulkanView
 
     vk::PipelineColorBlendAttachmentState colorBlendAttachment;
     colorBlendAttachment.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
-    colorBlendAttachment.blendEnable = true;
+    // opaque sprites are alpha tested instead, so they can be drawn in any order
+    colorBlendAttachment.blendEnable = transparent;
     colorBlendAttachment.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
     colorBlendAttachment.dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
     colorBlendAttachment.colorBlendOp = vk::BlendOp::eAdd;
@@ -84,6 +97,19 @@ VulkanPipeline * VulkanPipelineFactory::create(VulkanDevice & device, VulkanView
     colorBlending.blendConstants[2] = 0.0f;
     colorBlending.blendConstants[3] = 0.0f;
 
+    // later layers are closer, equal depths keep their draw order
+    vk::PipelineDepthStencilStateCreateInfo depthStencil;
+    depthStencil.depthTestEnable = renderPass.hasAttachment("depth");
+    depthStencil.depthWriteEnable = renderPass.hasAttachment("depth") && !transparent;
+    depthStencil.depthCompareOp = vk::CompareOp::eLessOrEqual;
+    depthStencil.depthBoundsTestEnable = false;
+    depthStencil.stencilTestEnable = false;
+
+    float alphaCutoff = transparent ? 0.0f : OPAQUE_ALPHA_CUTOFF;
+
+    vk::SpecializationMapEntry cutoffEntry(ALPHA_CUTOFF_CONSTANT, 0, sizeof (float));
+    vk::SpecializationInfo specialization(1, &cutoffEntry, sizeof (float), &alphaCutoff);
+
 	vk::DynamicState dStates[] = {
 		vk::DynamicState::eViewport,
 		vk::DynamicState::eScissor
@@ -102,14 +128,20 @@ VulkanPipeline * VulkanPipelineFactory::create(VulkanDevice & device, VulkanView
     pipelineInfo.pViewportState = &viewportstate;
     pipelineInfo.pRasterizationState = &rasterizer;
     pipelineInfo.pMultisampleState = &multisampling;
-    pipelineInfo.pDepthStencilState = nullptr; // Optional
+    pipelineInfo.pDepthStencilState = &depthStencil;
     pipelineInfo.pColorBlendState = &colorBlending;
     pipelineInfo.pDynamicState = &dynamicState; // Optional
 
     std::vector<vk::PipelineShaderStageCreateInfo> shader_data;
 
     for (auto & shader : shaders) {
-        shader_data.push_back(*shader);
+        vk::PipelineShaderStageCreateInfo stage = *shader;
+
+        if (stage.stage == vk::ShaderStageFlagBits::eFragment) {
+            stage.pSpecializationInfo = &specialization;
+        }
+
+        shader_data.push_back(stage);
     }
 
     pipelineInfo.stageCount = shader_data.size();
@@ -5,34 +5,35 @@
  */
 
 #include "VulkanShader.hpp"
+#include "Profiler.hpp"
 
 #include <inttypes.h>
 #include <fstream>
 
 VulkanShader::VulkanShader(VulkanDevice & device, const std::string & filename,
         vk::ShaderStageFlagBits type, const std::string shader_name) :
-name(shader_name), type(type), data(LoadShader(filename)) {
+device(device), name(shader_name), path(filename), type(type), data(LoadShader(filename)) {
 
-    init(device, data.data(), data.size() * sizeof(uint32_t));
+    init(data.data(), data.size() * sizeof(uint32_t));
 }
 
 VulkanShader::VulkanShader(VulkanDevice & device, std::vector<uint32_t> data,
         vk::ShaderStageFlagBits type, const std::string shader_name) :
-name(shader_name), type(type) {
+device(device), name(shader_name), type(type) {
 
     this->data = data;
-    init(device, data.data(), data.size() * sizeof(uint32_t));
+    init(data.data(), data.size() * sizeof(uint32_t));
 }
 
 VulkanShader::VulkanShader(VulkanDevice & device, const uint32_t * data, size_t count,
         vk::ShaderStageFlagBits type, const std::string shader_name) :
-name(shader_name), type(type) {
+device(device), name(shader_name), type(type) {
 
     this->data.resize(count / sizeof(uint32_t));
 
 	memcpy(this->data.data(), data, count);
 
-    init(device, data, count);
+    init(data, count);
 }
 
 void VulkanShader::dumpBytecode(int words_per_row) {
@@ -50,6 +51,8 @@ void VulkanShader::dumpBytecode(int words_per_row) {
 }
 
 std::vector<uint32_t> VulkanShader::LoadShader(const std::string & filename) {
+    PROFILE_SCOPE_DYNAMIC("load " + filename);
+
     std::ifstream file(filename, std::ifstream::ate | std::ifstream::binary);
 
     if (!file.is_open()) {
@@ -59,6 +62,15 @@ std::vector<uint32_t> VulkanShader::LoadShader(const std::string & filename) {
     size_t size = (size_t)file.tellg();
     file.seekg(0, std::ios::beg);
 
+    // a bad module can take the driver down with it, so it's checked first
+    uint32_t magic = 0;
+
+    if (size % sizeof(uint32_t) != 0 || !file.read(reinterpret_cast<char*>(&magic), sizeof(magic)) || magic != SPIRV_MAGIC) {
+        throw std::runtime_error(filename + " isn't SPIR-V");
+    }
+
+    file.seekg(0, std::ios::beg);
+
     char * buffer = new char[size];
     
     if (!file.read(buffer, size)) {
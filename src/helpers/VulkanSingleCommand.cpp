@@ -127,4 +127,46 @@ void VulkanSingleCommand::copyBufferToImage(VulkanDevice & device, VulkanCommand
             &region);
 
     cmd.end();
-}
\ No newline at end of file
+}
+
+void VulkanSingleCommand::copyImageToBuffer(VulkanDevice & device, VulkanCommandBufferPool & pool, VulkanQueue & queue,
+        vk::Image image, vk::Buffer buffer, int width, int height) {
+    VulkanSingleCommand cmd(device, pool, queue);
+
+    vk::BufferImageCopy region;
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+
+    region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+
+    region.imageOffset = vk::Offset3D(0, 0, 0);
+    region.imageExtent = vk::Extent3D(width, height, 1);
+
+    // the image was last written as a color attachment
+    vk::ImageMemoryBarrier barrier(vk::AccessFlagBits::eColorAttachmentWrite, vk::AccessFlagBits::eTransferRead,
+            vk::ImageLayout::eTransferSrcOptimal, vk::ImageLayout::eTransferSrcOptimal,
+            VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, image,
+            vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1));
+
+    cmd->pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eTransfer,
+            vk::DependencyFlags(), 0, nullptr, 0, nullptr, 1, &barrier);
+
+    cmd->copyImageToBuffer(image,
+            vk::ImageLayout::eTransferSrcOptimal,
+            buffer,
+            1,
+            &region);
+
+    // and the buffer is read by the host afterwards
+    vk::BufferMemoryBarrier hostBarrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead,
+            VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, buffer, 0, VK_WHOLE_SIZE);
+
+    cmd->pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost,
+            vk::DependencyFlags(), 0, nullptr, 1, &hostBarrier, 0, nullptr);
+
+    cmd.end();
+}
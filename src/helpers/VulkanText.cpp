@@ -0,0 +1,186 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+#include <cctype>
+#include <fstream>
+#include <iterator>
+
+#include "VulkanText.hpp"
+
+GlyphAtlas::GlyphAtlas(VulkanDevice & device, VulkanCommandBufferPool & pool, VulkanQueue & queue, const Font & font) {
+
+    int width = font.getWidth(), height = font.getHeight();
+
+    texture = std::unique_ptr<Texture>(new Texture(device, font.getPixels(), width, height, font.getChannels()));
+    texture->configureLayouts(pool, queue);
+
+    // the top row only marks where characters are
+    lineHeight = static_cast<float> (height - 1);
+
+    for (auto & ch : font.getCharacters()) {
+        struct Glyph glyph;
+
+        glyph.uvmin = glm::vec2(ch.xoffset / (float) width, 1.0f / height);
+        glyph.uvmax = glm::vec2((ch.xoffset + ch.width) / (float) width, 1.0f);
+
+        glyph.boxmin = glm::vec2(0, 0);
+        glyph.boxmax = glm::vec2(ch.width, lineHeight);
+
+        glyph.advance = static_cast<float> (ch.width);
+
+        glyphs[ch.c] = glyph;
+    }
+}
+
+GlyphAtlas::GlyphAtlas(VulkanDevice & device, VulkanCommandBufferPool & pool, VulkanQueue & queue,
+        const std::string & ttfpath, float pixelHeight, int atlasSize, int firstChar, int charCount) {
+
+    PROFILE_SCOPE_DYNAMIC("load " + ttfpath);
+
+    std::ifstream file(ttfpath, std::ios::binary);
+
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open font " + ttfpath);
+    }
+
+    std::vector<unsigned char> ttf((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    stbtt_fontinfo info;
+
+    if (!stbtt_InitFont(&info, ttf.data(), stbtt_GetFontOffsetForIndex(ttf.data(), 0))) {
+        throw std::runtime_error("Could not read font " + ttfpath);
+    }
+
+    std::vector<unsigned char> coverage(atlasSize * atlasSize);
+    std::vector<stbtt_bakedchar> baked(charCount);
+
+    if (stbtt_BakeFontBitmap(ttf.data(), 0, pixelHeight, coverage.data(), atlasSize, atlasSize,
+            firstChar, charCount, baked.data()) <= 0) {
+        throw std::runtime_error("Font atlas is too small for " + ttfpath);
+    }
+
+    int ascent, descent, lineGap;
+    stbtt_GetFontVMetrics(&info, &ascent, &descent, &lineGap);
+
+    float scale = stbtt_ScaleForPixelHeight(&info, pixelHeight);
+    float baseline = ascent * scale;
+
+    lineHeight = (ascent - descent) * scale;
+
+    // white glyphs, the coverage goes in the alpha channel
+    std::vector<unsigned char> rgba(coverage.size() * 4, 0xFF);
+
+    for (size_t i = 0; i < coverage.size(); i++) {
+        rgba[i * 4 + 3] = coverage[i];
+    }
+
+    texture = std::unique_ptr<Texture>(new Texture(device, rgba.data(), atlasSize, atlasSize, 4));
+    texture->configureLayouts(pool, queue);
+
+    for (int i = 0; i < charCount; i++) {
+        stbtt_bakedchar & bc = baked[i];
+        struct Glyph glyph;
+
+        glyph.uvmin = glm::vec2(bc.x0, bc.y0) / (float) atlasSize;
+        glyph.uvmax = glm::vec2(bc.x1, bc.y1) / (float) atlasSize;
+
+        glyph.boxmin = glm::vec2(bc.xoff, baseline + bc.yoff);
+        glyph.boxmax = glyph.boxmin + glm::vec2(bc.x1 - bc.x0, bc.y1 - bc.y0);
+
+        glyph.advance = bc.xadvance;
+
+        glyphs[firstChar + i] = glyph;
+    }
+}
+
+const Glyph * GlyphAtlas::getGlyph(unsigned char c) const {
+    auto it = glyphs.find(c);
+
+    if (it == glyphs.end()) {
+        it = glyphs.find(std::tolower(c));
+    }
+
+    return it == glyphs.end() ? nullptr : &it->second;
+}
+
+TextMesh::TextMesh(VulkanDevice * device, GlyphAtlas * atlas, size_t capacity, int binding, const std::string & text) :
+atlas(atlas), capacity(capacity),
+vertices(device, binding, capacity * VERTICES_PER_GLYPH),
+indices(device, capacity * INDICES_PER_GLYPH) {
+
+    if (capacity * VERTICES_PER_GLYPH > 0xFFFF) {
+        throw std::runtime_error("Text capacity is too large for 16 bit indices");
+    }
+
+    // the quads never change order, so the indices are only written once
+    for (size_t i = 0; i < capacity; i++) {
+        uint16_t base = static_cast<uint16_t> (i * VERTICES_PER_GLYPH);
+        size_t j = i * INDICES_PER_GLYPH;
+
+        indices[j + 0] = base + 0;
+        indices[j + 1] = base + 1;
+        indices[j + 2] = base + 2;
+        indices[j + 3] = base + 3;
+        indices[j + 4] = base + 2;
+        indices[j + 5] = base + 0;
+    }
+
+    setText(text);
+}
+
+void TextMesh::setText(const std::string & text) {
+    if (text.size() > capacity) {
+        throw std::runtime_error("Text '" + text + "' is longer than the mesh's capacity");
+    }
+
+    this->text = text;
+
+    // the text is stretched across the quad, so the layout needs the total width first
+    width = 0;
+
+    for (char c : text) {
+        const Glyph * glyph = atlas->getGlyph(c);
+        if (glyph) {
+            width += glyph->advance;
+        }
+    }
+
+    float height = atlas->getLineHeight();
+
+    size_t quad = 0;
+    float pen = 0;
+
+    for (char c : text) {
+        const Glyph * glyph = atlas->getGlyph(c);
+
+        if (!glyph) {
+            continue;
+        }
+
+        glm::vec2 min = (glm::vec2(pen, 0) + glyph->boxmin) / glm::vec2(width, height) - 0.5f;
+        glm::vec2 max = (glm::vec2(pen, 0) + glyph->boxmax) / glm::vec2(width, height) - 0.5f;
+
+        // the fragment shaders flip u, so it's stored flipped here
+        float u0 = 1 - glyph->uvmin.x, u1 = 1 - glyph->uvmax.x;
+
+        size_t v = quad * VERTICES_PER_GLYPH;
+
+        vertices[v + 0] = {glm::vec2(min.x, min.y), glm::vec3(1), glm::vec2(u0, glyph->uvmin.y)};
+        vertices[v + 1] = {glm::vec2(max.x, min.y), glm::vec3(1), glm::vec2(u1, glyph->uvmin.y)};
+        vertices[v + 2] = {glm::vec2(max.x, max.y), glm::vec3(1), glm::vec2(u1, glyph->uvmax.y)};
+        vertices[v + 3] = {glm::vec2(min.x, max.y), glm::vec3(1), glm::vec2(u0, glyph->uvmax.y)};
+
+        pen += glyph->advance;
+        quad++;
+    }
+
+    // collapse the unused quads so they don't rasterize anything
+    for (size_t v = quad * VERTICES_PER_GLYPH; v < capacity * VERTICES_PER_GLYPH; v++) {
+        vertices[v] = {glm::vec2(0), glm::vec3(0), glm::vec2(0)};
+    }
+
+    vertices.markNeedsUpdate();
+}
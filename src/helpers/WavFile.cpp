@@ -0,0 +1,217 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "WavFile.hpp"
+
+namespace {
+
+    const uint16_t FORMAT_PCM = 1, FORMAT_FLOAT = 3, FORMAT_EXTENSIBLE = 0xFFFE;
+
+    // wav files are little endian, whatever the host is
+    uint32_t ReadU32(const uint8_t * bytes) {
+        return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t> (bytes[3]) << 24);
+    }
+
+    uint16_t ReadU16(const uint8_t * bytes) {
+        return static_cast<uint16_t> (bytes[0] | (bytes[1] << 8));
+    }
+
+    void WriteU32(std::ofstream & file, uint32_t value) {
+        uint8_t bytes[4] = {
+            static_cast<uint8_t> (value), static_cast<uint8_t> (value >> 8),
+            static_cast<uint8_t> (value >> 16), static_cast<uint8_t> (value >> 24)
+        };
+
+        file.write(reinterpret_cast<char*> (bytes), 4);
+    }
+
+    void WriteU16(std::ofstream & file, uint16_t value) {
+        uint8_t bytes[2] = {static_cast<uint8_t> (value), static_cast<uint8_t> (value >> 8)};
+
+        file.write(reinterpret_cast<char*> (bytes), 2);
+    }
+
+}
+
+WavReader::WavReader(const std::string & path) : file(path, std::ios::binary) {
+    if (!file) {
+        throw std::runtime_error("Could not open " + path);
+    }
+
+    uint8_t header[12];
+
+    if (!file.read(reinterpret_cast<char*> (header), 12) || memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) {
+        throw std::runtime_error(path + " isn't a wav file");
+    }
+
+    bool hasFormat = false;
+
+    uint8_t chunk[8];
+
+    while (file.read(reinterpret_cast<char*> (chunk), 8)) {
+        uint32_t size = ReadU32(chunk + 4);
+
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            std::vector<uint8_t> fmt(std::max<uint32_t>(size, 16));
+
+            if (!file.read(reinterpret_cast<char*> (fmt.data()), size)) {
+                break;
+            }
+
+            uint16_t format = ReadU16(&fmt[0]);
+
+            channels = ReadU16(&fmt[2]);
+            rate = ReadU32(&fmt[4]);
+            bits = ReadU16(&fmt[14]);
+
+            // the real format is the start of the sub format guid
+            if (format == FORMAT_EXTENSIBLE && size >= 26) {
+                format = ReadU16(&fmt[24]);
+            }
+
+            if (format != FORMAT_PCM && format != FORMAT_FLOAT) {
+                throw std::runtime_error(path + " isn't PCM");
+            }
+
+            floating = format == FORMAT_FLOAT;
+
+            if (floating ? bits != 32 : (bits != 8 && bits != 16 && bits != 24 && bits != 32)) {
+                throw std::runtime_error(path + " has an unsupported sample size of " + std::to_string(bits));
+            }
+
+            if (channels == 0 || rate == 0) {
+                throw std::runtime_error(path + " has no channels");
+            }
+
+            hasFormat = true;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (!hasFormat) {
+                throw std::runtime_error(path + " has data before its format");
+            }
+
+            data = file.tellg();
+            frames = size / (channels * (bits / 8));
+
+            return;
+        } else {
+            file.seekg(size, std::ios::cur);
+        }
+
+        // chunks are padded to an even size
+        if (size & 1) {
+            file.seekg(1, std::ios::cur);
+        }
+    }
+
+    throw std::runtime_error(path + " has no data");
+}
+
+size_t WavReader::read(float * samples, size_t count) {
+    count = std::min(count, frames - position);
+
+    size_t bytes = bits / 8, values = count * channels;
+
+    raw.resize(values * bytes);
+
+    if (!file.read(reinterpret_cast<char*> (raw.data()), raw.size())) {
+        // a truncated file ends where the data does
+        values = static_cast<size_t> (file.gcount()) / bytes / channels * channels;
+        count = values / channels;
+        frames = position + count;
+
+        file.clear();
+    }
+
+    const uint8_t * in = raw.data();
+
+    for (size_t i = 0; i < values; i++, in += bytes) {
+        switch (bits) {
+            case 8:
+                samples[i] = (in[0] - 128) / 128.0f;
+                break;
+            case 16:
+                samples[i] = static_cast<int16_t> (ReadU16(in)) / 32768.0f;
+                break;
+            case 24:
+                // shifted to the top so the sign is right
+                samples[i] = static_cast<int32_t> ((in[0] << 8) | (in[1] << 16) | (static_cast<uint32_t> (in[2]) << 24)) / 2147483648.0f;
+                break;
+            default:
+                if (floating) {
+                    uint32_t value = ReadU32(in);
+                    memcpy(&samples[i], &value, 4);
+                } else {
+                    samples[i] = static_cast<int32_t> (ReadU32(in)) / 2147483648.0f;
+                }
+                break;
+        }
+    }
+
+    position += count;
+
+    return count;
+}
+
+void WavReader::rewind(void) {
+    file.clear();
+    file.seekg(data);
+
+    position = 0;
+}
+
+WavWriter::WavWriter(const std::string & path, uint32_t rate, uint16_t channels) :
+file(path, std::ios::binary | std::ios::trunc), rate(rate), channels(channels) {
+    if (!file) {
+        throw std::runtime_error("Could not create " + path);
+    }
+
+    // written again with the real sizes at the end
+    writeHeader();
+}
+
+WavWriter::~WavWriter() {
+    file.seekp(0);
+    writeHeader();
+}
+
+void WavWriter::write(const int16_t * samples, size_t count) {
+    std::vector<uint8_t> bytes(count * channels * 2);
+
+    for (size_t i = 0; i < count * channels; i++) {
+        uint16_t value = static_cast<uint16_t> (samples[i]);
+
+        bytes[i * 2] = static_cast<uint8_t> (value);
+        bytes[i * 2 + 1] = static_cast<uint8_t> (value >> 8);
+    }
+
+    file.write(reinterpret_cast<char*> (bytes.data()), bytes.size());
+
+    frames += count;
+}
+
+void WavWriter::writeHeader(void) {
+    uint32_t dataSize = static_cast<uint32_t> (frames * channels * 2);
+
+    file.write("RIFF", 4);
+    WriteU32(file, 36 + dataSize);
+    file.write("WAVE", 4);
+
+    file.write("fmt ", 4);
+    WriteU32(file, 16);
+    WriteU16(file, FORMAT_PCM);
+    WriteU16(file, channels);
+    WriteU32(file, rate);
+    WriteU32(file, rate * channels * 2);
+    WriteU16(file, static_cast<uint16_t> (channels * 2));
+    WriteU16(file, 16);
+
+    file.write("data", 4);
+    WriteU32(file, dataSize);
+}
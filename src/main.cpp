@@ -3,12 +3,15 @@
 #include <exception>
 
 #include "VulkanController.hpp"
+#include "VulkanText.hpp"
 
 #include "game/scene.hpp"
 #include "game/ObjectControllers.hpp"
 #include "game/Menu.hpp"
+#include "game/parsing/GameData.hpp"
 
 #include <chrono>
+#include <cstring>
 
 const int WIDTH = 1024;
 const int HEIGHT = WIDTH * 9 / 16;
@@ -24,14 +27,9 @@ const glm::vec2 CELL_SIZE(0.2f, 0.2f), BUTTON_SIZE(0.3f, 0.1f);
 
 const std::string SOUNDS_DIRECTORY = "./sounds/";
 
-struct Color {
-    float r, g, b, a;
-};
-
-struct ChromaKey {
-    struct Color search, replace;
-    float epsilon1, epsilon2;
-};
+// the compiled game data, and the game file hot reloading reads the ubo instances from
+const std::string GAME_DATA = "game/game.gdb";
+const std::string GAME_FILES = "game/glob.yml";
 
 struct Events {
     Event mouseclick;
@@ -66,10 +64,11 @@ struct MaterialInfo : public MaterialRendererBuilder {
 
     VulkanController * controller;
 
-    MaterialInfo(VulkanController * controller, UBOMap * globals = nullptr) :
+    MaterialInfo(VulkanController * controller, const std::string & name, UBOMap * globals = nullptr) :
     texture(0, nullptr, 1, vk::ShaderStageFlagBits::eFragment) {
         this->globals = globals;
         this->controller = controller;
+        prototype.name = name;
     }
 
     void finalize(VulkanController * controller, bool use_texture = true) {
@@ -85,112 +84,127 @@ struct MaterialInfo : public MaterialRendererBuilder {
 
 };
 
-int run() {
-    Window window(WIDTH, HEIGHT, "Vulkan Test");
+/**
+ * Copies a ubo instance's values from the compiled game data into a buffer
+ * @param path The game data
+ * @param instance The ubo instance's name
+ * @param buffer The buffer, which has to hold the instance
+ */
+void LoadUBOInstance(const std::string & path, const std::string & instance, VulkanUniformBuffer * buffer) {
+    Game::GameData data(path);
 
-    InputHandler input(window);
+    const Game::Format::UBOInstance * record = data.find(data.getUBOInstances(), instance);
 
-    VulkanController * controller = new VulkanController(window);
+    if (!record) {
+        throw std::runtime_error("Ubo instance " + instance + " isn't in " + path);
+    }
 
-    controller->getDevice()->printExtensions();
+    Loader::ByteView bytes = data.getBuffer(*record);
 
-    glfwSetWindowUserPointer(window.getWindow(), controller);
-    glfwSetFramebufferSizeCallback(window.getWindow(), [](GLFWwindow * wnd, int width, int height) {
-        VulkanController * controller = (VulkanController*) glfwGetWindowUserPointer(wnd);
+    if (bytes.size() > buffer->objSize() * buffer->objCount()) {
+        throw std::runtime_error("Ubo instance " + instance + " doesn't fit its buffer");
+    }
 
-        controller->recreateSwapchain();
-    });
+    memcpy(buffer->data(), bytes.data(), bytes.size());
+    buffer->markNeedsUpdate();
+}
 
-    // <editor-fold defaultstate="collapsed" desc="Material Setup">
+/**
+ * @param audio The audio backend's name, for AudioBackend::Create
+ * @param hotReload Whether shaders, sprites and game files are reloaded when they change
+ */
+int run(const std::string & audio, bool hotReload) {
+    Window window(WIDTH, HEIGHT, "Vulkan Test");
 
-    // green chroma key
-    UniformBufferPrototype chromaKeyDescriptor(0, 0, sizeof (struct ChromaKey), 1, vk::ShaderStageFlagBits::eFragment);
+    InputHandler input(window);
 
-    UBOMap globals = Material::createubos(*controller->getDevice(), std::vector<UniformBufferPrototype> {
-        chromaKeyDescriptor });
+    VulkanController * controller = new VulkanController(window);
 
-    VulkanBufferView<struct ChromaKey> chromaKeyView(*globals[chromaKeyDescriptor.id]);
+    controller->getDevice()->printExtensions();
 
-    chromaKeyView->search = {0, 1.0f, 0, 1.0f};
-    chromaKeyView->replace = {0, 0, 0, 0};
-    chromaKeyView->epsilon1 = 0.25f;
-    chromaKeyView->epsilon2 = 0.75f;
+    controller->setMaterialProfiling(true);
 
-    // blue chroma key
-    UniformBufferPrototype chromaKeyBlueDescriptor(0, 0, sizeof (struct ChromaKey), 1, vk::ShaderStageFlagBits::eFragment);
+    if (hotReload) {
+        controller->enableHotReload(GAME_FILES);
+    }
 
-    UBOMap globals2 = Material::createubos(*controller->getDevice(), std::vector<UniformBufferPrototype> {
-        chromaKeyBlueDescriptor });
+#ifdef ENABLE_PROFILER
+    // frames this slow write a trace of what led up to them
+    Profiler::SetHitchThreshold(100);
+#endif
 
-    VulkanBufferView<struct ChromaKey> chromaKey2View(*globals2[chromaKeyBlueDescriptor.id]);
+    glfwSetWindowUserPointer(window.getWindow(), controller);
+    glfwSetFramebufferSizeCallback(window.getWindow(), [](GLFWwindow * wnd, int width, int height) {
+        VulkanController * controller = (VulkanController*) glfwGetWindowUserPointer(wnd);
 
-    chromaKey2View->search = {0, 0, 1.0f, 1.0f};
-    chromaKey2View->replace = {0, 0, 0, 0};
-    chromaKey2View->epsilon1 = 0.25f;
-    chromaKey2View->epsilon2 = 0.75f;
+        controller->requestResize();
+    });
 
-    // black chroma key
-    UniformBufferPrototype chromaKeyBlackDescriptor(0, 0, sizeof (struct ChromaKey), 1, vk::ShaderStageFlagBits::eFragment);
+    // <editor-fold defaultstate="collapsed" desc="Material Setup">
 
-    UBOMap globals3 = Material::createubos(*controller->getDevice(), std::vector<UniformBufferPrototype> {
-        chromaKeyBlackDescriptor });
+    // chroma keys are baked into the textures' alpha when they're loaded
+    const ChromaKey greenKey(glm::vec4(0, 1.0f, 0, 1.0f));
+    const ChromaKey blueKey(glm::vec4(0, 0, 1.0f, 1.0f));
+    const ChromaKey blackKey(glm::vec4(0, 0, 0, 1.0f));
 
-    VulkanBufferView<struct ChromaKey> chromaKey3View(*globals3[chromaKeyBlackDescriptor.id]);
+    // every sprite is the same quad, stored once in device local memory
+    VulkanGeometryStore * geometry = controller->getGeometry();
 
-    chromaKey3View->search = {0, 0, 0.0f, 1.0f};
-    chromaKey3View->replace = {0, 0, 0, 0};
-    chromaKey3View->epsilon1 = 0.25f;
-    chromaKey3View->epsilon2 = 0.75f;
+    VulkanIndexBuffer & indices = *geometry->addIndices({0, 1, 2, 3, 2, 0});
 
+    // the background is keyed on the gpu instead, by the 'green chroma key' ubo
+    // instance, so its key can be tuned in the game files while the game runs
+    UniformBufferPrototype chromaKeyDescriptor(0, 0, sizeof (GameLayouts::ChromaKeyUBO), 1, vk::ShaderStageFlagBits::eFragment);
 
+    UBOMap backgroundGlobals = Material::createubos(*controller->getDevice(), std::vector<UniformBufferPrototype> {
+        chromaKeyDescriptor });
 
-    VulkanIndexBuffer indices(controller->getDevice(), 6);
+    VulkanUniformBuffer * backgroundKey = backgroundGlobals[chromaKeyDescriptor.id].get();
 
-    indices[0] = 0;
-    indices[1] = 1;
-    indices[2] = 2;
-    indices[3] = 3;
-    indices[4] = 2;
-    indices[5] = 0;
+    LoadUBOInstance(GAME_DATA, "green chroma key", backgroundKey);
 
+    if (controller->getHotReload()) {
+        controller->getHotReload()->bindUBO("green chroma key", backgroundKey);
+    }
 
-    MaterialInfo shipbase(controller, &globals),
-            shipdetail(controller, &globals),
-            background(controller, &globals),
-            planet1(controller, &globals),
-            planet2(controller, &globals),
-            planet3(controller, &globals),
-            enemyship(controller, &globals2),
-            menubackground(controller),
-            menu_planetinfo_energy(controller),
-            menu_planetinfo_science(controller),
-            menu_getenergy(controller),
-            menu_getscience(controller),
-            menu_leave(controller),
-            menuplanet(controller, &globals),
-            enemyweapon(controller, &globals),
-            playerweapon(controller, &globals3);
 
-    shipbase.texture.texture = controller->getImageManager()->getImage("sprites/ShipBase.bmp");
-    shipdetail.texture.texture = controller->getImageManager()->getImage("sprites/ShipDetail.bmp");
+    MaterialInfo shipbase(controller, "shipbase"),
+            shipdetail(controller, "shipdetail"),
+            background(controller, "background", &backgroundGlobals),
+            planet1(controller, "planet1"),
+            planet2(controller, "planet2"),
+            planet3(controller, "planet3"),
+            enemyship(controller, "enemyship"),
+            menubackground(controller, "menubackground"),
+            menu_planetinfo_energy(controller, "menu_planetinfo_energy"),
+            menu_planetinfo_science(controller, "menu_planetinfo_science"),
+            menu_getenergy(controller, "menu_getenergy"),
+            menu_getscience(controller, "menu_getscience"),
+            menu_leave(controller, "menu_leave"),
+            menuplanet(controller, "menuplanet"),
+            enemyweapon(controller, "enemyweapon"),
+            playerweapon(controller, "playerweapon"),
+            particles(controller, "particles");
+
+    shipbase.texture.texture = controller->getImageManager()->getImage("sprites/ShipBase.bmp", &greenKey);
+    shipdetail.texture.texture = controller->getImageManager()->getImage("sprites/ShipDetail.bmp", &greenKey);
     background.texture.texture = controller->getImageManager()->getImage("sprites/SectorBackground.bmp");
-    planet1.texture.texture = controller->getImageManager()->getImage("sprites/Planet1.bmp");
-    planet2.texture.texture = controller->getImageManager()->getImage("sprites/Planet2.bmp");
-    planet3.texture.texture = controller->getImageManager()->getImage("sprites/Planet3.bmp");
-    enemyship.texture.texture = controller->getImageManager()->getImage("sprites/EnemyShip.bmp");
+    planet1.texture.texture = controller->getImageManager()->getImage("sprites/Planet1.bmp", &greenKey);
+    planet2.texture.texture = controller->getImageManager()->getImage("sprites/Planet2.bmp", &greenKey);
+    planet3.texture.texture = controller->getImageManager()->getImage("sprites/Planet3.bmp", &greenKey);
+    enemyship.texture.texture = controller->getImageManager()->getImage("sprites/EnemyShip.bmp", &blueKey);
     menubackground.texture.texture = controller->getImageManager()->getImage("sprites/MenuButton.bmp");
-    menu_planetinfo_energy.texture.texture = controller->getImageManager()->getImage("sprites/MenuButton.bmp");
-    menu_planetinfo_science.texture.texture = controller->getImageManager()->getImage("sprites/MenuButton.bmp");
-    menu_getenergy.texture.texture = controller->getImageManager()->getImage("sprites/MenuButton.bmp");
-    menu_getscience.texture.texture = controller->getImageManager()->getImage("sprites/MenuButton.bmp");
-    menu_leave.texture.texture = controller->getImageManager()->getImage("sprites/MenuButton.bmp");
-    menuplanet.texture.texture = controller->getImageManager()->getImage("sprites/MenuButton.bmp");
-    enemyweapon.texture.texture = controller->getImageManager()->getImage("sprites/enemy_attack.png");
-    playerweapon.texture.texture = controller->getImageManager()->getImage("sprites/player_attack.png");
+    menuplanet.texture.texture = controller->getImageManager()->getImage("sprites/MenuButton.bmp", &greenKey);
+    enemyweapon.texture.texture = controller->getImageManager()->getImage("sprites/enemy_attack.png", &greenKey);
+    playerweapon.texture.texture = controller->getImageManager()->getImage("sprites/player_attack.png", &blackKey);
 
 
-    ShaderPrototype chromakey = {"shader/chromakey.frag.spv", vk::ShaderStageFlagBits::eFragment};
+    // the weapon effects fade out at their edges, so they're blended instead of alpha tested
+    enemyweapon.prototype.transparent = true;
+    playerweapon.prototype.transparent = true;
+
     ShaderPrototype sphere = {"shader/sphere.frag.spv", vk::ShaderStageFlagBits::eFragment};
+    ShaderPrototype chromakey = {"shader/chromakey.frag.spv", vk::ShaderStageFlagBits::eFragment};
     ShaderPrototype frag = {"shader/shader.frag.spv", vk::ShaderStageFlagBits::eFragment};
     ShaderPrototype vert = {"shader/shader.vert.spv", vk::ShaderStageFlagBits::eVertex};
 
@@ -199,50 +213,81 @@ int run() {
 
 
 
-    std::vector<MaterialPrototype*> prototypes{ &shipbase.prototype, &shipdetail.prototype,
-        &background.prototype, &planet1.prototype, &planet2.prototype, &planet3.prototype,
-        &enemyship.prototype, &enemyweapon.prototype, &playerweapon.prototype};
+    std::vector<VulkanVertexObject> quad(4);
 
-    // menu buttons have a different fragment shader than sprites
-    std::vector<MaterialPrototype*> menuprotos{&menubackground.prototype,
-        &menu_planetinfo_energy.prototype, &menu_getenergy.prototype, &menu_getscience.prototype,
-        &menu_leave.prototype, &menu_planetinfo_science.prototype};
+    quad[0].position = {-0.5, -0.5};
+    quad[1].position = {0.5, -0.5};
+    quad[2].position = {0.5, 0.5};
+    quad[3].position = {-0.5, 0.5};
 
-    MaterialPrototypeHelpers::AddShaderToMany(menuprotos, frag);
-    MaterialPrototypeHelpers::AddShaderToMany(prototypes, chromakey);
+    quad[0].uv = {1.0, 0.0};
+    quad[1].uv = {0.0, 0.0};
+    quad[2].uv = {0.0, 1.0};
+    quad[3].uv = {1.0, 1.0};
 
+    VulkanVertexBufferDefault & vertexBuffer = *geometry->addVertices(0, quad);
 
-    for (auto & proto : menuprotos) {
-        prototypes.push_back(proto);
-    }
 
+    std::vector<MaterialPrototype*> prototypes{ &shipbase.prototype, &shipdetail.prototype,
+        &planet1.prototype, &planet2.prototype, &planet3.prototype,
+        &enemyship.prototype, &enemyweapon.prototype, &playerweapon.prototype,
+        &menubackground.prototype};
+
+    MaterialPrototypeHelpers::AddVertexDescriptorToMany(prototypes,{&vertexBuffer, &vertexBuffer});
 
     // menu planet view has a special 3d effect
     menuplanet.prototype.shaders.push_back(sphere);
-    prototypes.push_back(&menuplanet.prototype);
+    menuplanet.prototype.vertexDescriptors.push_back({&vertexBuffer, &vertexBuffer});
 
-    MaterialPrototypeHelpers::AddShaderToMany(prototypes, vert);
+    background.prototype.shaders.push_back(chromakey);
+    background.prototype.vertexDescriptors.push_back({&vertexBuffer, &vertexBuffer});
 
-    MaterialPrototypeHelpers::AddPushConstantToMany(prototypes, pcproto);
+    // weapon and warp effects are simulated on the gpu, the particles are the same quad
+    VulkanParticleSystem * particleSystem = controller->createParticleSystem(16384);
 
+    particles.prototype.vertexDescriptors.push_back({&vertexBuffer, &vertexBuffer});
+    particleSystem->prepareMaterial(particles.prototype);
 
 
-    VulkanVertexBufferDefault vertexBuffer(controller->getDevice(), 0, 4);
+    // menu text comes from the glyph atlas, each string has its own quads
+    Font font("sprites/pixel_font.png");
 
-    vertexBuffer[0].position = {-0.5, -0.5};
-    vertexBuffer[1].position = {0.5, -0.5};
-    vertexBuffer[2].position = {0.5, 0.5};
-    vertexBuffer[3].position = {-0.5, 0.5};
+    GlyphAtlas atlas(*controller->getDevice(), *controller->getBufferPool(), *controller->getQueue(), font);
 
-    vertexBuffer[0].uv = {1.0, 0.0};
-    vertexBuffer[1].uv = {0.0, 0.0};
-    vertexBuffer[2].uv = {0.0, 1.0};
-    vertexBuffer[3].uv = {1.0, 1.0};
+    TextMesh text_planetinfo_energy(controller->getDevice(), &atlas, 32, 0, "Hello World"),
+            text_planetinfo_science(controller->getDevice(), &atlas, 32, 0, "Hello World"),
+            text_getenergy(controller->getDevice(), &atlas, 32, 0, "GET ENERGY"),
+            text_getscience(controller->getDevice(), &atlas, 32, 0, "GET SCIENCE"),
+            text_leave(controller->getDevice(), &atlas, 32, 0, "LEAVE");
 
+    std::vector<MaterialInfo*> textmaterials{&menu_planetinfo_energy, &menu_planetinfo_science,
+        &menu_getenergy, &menu_getscience, &menu_leave};
 
-    MaterialPrototypeHelpers::AddVertexDescriptorToMany(prototypes,{&vertexBuffer, &vertexBuffer});
+    std::vector<TextMesh*> textmeshes{&text_planetinfo_energy, &text_planetinfo_science,
+        &text_getenergy, &text_getscience, &text_leave};
+
+    for (size_t i = 0; i < textmaterials.size(); i++) {
+        MaterialInfo * info = textmaterials[i];
 
+        // the pixel font would bleed into its neighbours with linear filtering
+        info->texture.texture = atlas.getTexture();
+        info->texture.magnified = vk::Filter::eNearest;
+        info->texture.minimized = vk::Filter::eNearest;
 
+        info->prototype.vertexDescriptors.push_back({textmeshes[i]->getVertexBuffer(), textmeshes[i]->getVertexBuffer()});
+
+        prototypes.push_back(&info->prototype);
+    }
+
+    // sprites and menu text share the passthrough shader, their transparency is in the texture
+    MaterialPrototypeHelpers::AddShaderToMany(prototypes, frag);
+
+    prototypes.push_back(&menuplanet.prototype);
+    prototypes.push_back(&background.prototype);
+
+    MaterialPrototypeHelpers::AddShaderToMany(prototypes, vert);
+
+    MaterialPrototypeHelpers::AddPushConstantToMany(prototypes, pcproto);
 
 
     shipbase.finalize(controller);
@@ -261,6 +306,11 @@ int run() {
     menuplanet.finalize(controller);
     enemyweapon.finalize(controller);
     playerweapon.finalize(controller);
+    particles.finalize(controller, false);
+
+    int effectOrder = DepthLayers::Order(SHIP_EFFECT_LAYER, 0);
+
+    particleSystem->setMaterial(particles.material, &indices, effectOrder, DepthLayers::ToDepth(effectOrder));
     
     // </editor-fold>
 
@@ -302,19 +352,19 @@ int run() {
     menubackgroundproto.addMesh(0, &menubackground, menubackground.material, &indices);
 
     GameObjectPrototype menu_planetinfo_energy_proto(glm::vec2(0.5f, -0.6f), BUTTON_SIZE, 0, pcproto.id);
-    menu_planetinfo_energy_proto.addMesh(0, &menu_planetinfo_energy, menu_planetinfo_energy.material, &indices);
+    menu_planetinfo_energy_proto.addMesh(0, &menu_planetinfo_energy, menu_planetinfo_energy.material, text_planetinfo_energy.getIndexBuffer());
 
     GameObjectPrototype menu_planetinfo_science_proto(glm::vec2(0.5f, -0.4f), BUTTON_SIZE, 0, pcproto.id);
-    menu_planetinfo_science_proto.addMesh(1, &menu_planetinfo_science, menu_planetinfo_science.material, &indices);
+    menu_planetinfo_science_proto.addMesh(1, &menu_planetinfo_science, menu_planetinfo_science.material, text_planetinfo_science.getIndexBuffer());
 
     GameObjectPrototype menu_getenergy_proto(glm::vec2(0, 0.1f), BUTTON_SIZE, 0, pcproto.id);
-    menu_getenergy_proto.addMesh(0, &menu_getenergy, menu_getenergy.material, &indices);
+    menu_getenergy_proto.addMesh(0, &menu_getenergy, menu_getenergy.material, text_getenergy.getIndexBuffer());
 
     GameObjectPrototype menu_getscience_proto(glm::vec2(0, 0.3f), BUTTON_SIZE, 0, pcproto.id);
-    menu_getscience_proto.addMesh(0, &menu_getscience, menu_getscience.material, &indices);
+    menu_getscience_proto.addMesh(0, &menu_getscience, menu_getscience.material, text_getscience.getIndexBuffer());
 
     GameObjectPrototype menu_leave_proto(glm::vec2(0, 0.5f), BUTTON_SIZE, 0, pcproto.id);
-    menu_leave_proto.addMesh(0, &menu_leave, menu_leave.material, &indices);
+    menu_leave_proto.addMesh(0, &menu_leave, menu_leave.material, text_leave.getIndexBuffer());
 
     GameObjectPrototype menu_planet_proto(glm::vec2(-0.4f, -0.4f), CELL_SIZE + CELL_SIZE + CELL_SIZE, 0, pcproto.id);
     menu_planet_proto.addMesh(0, &menuplanet, menuplanet.material, &indices);
@@ -327,24 +377,6 @@ int run() {
 
     Scene scene;
 
-    Font font("sprites/pixel_font.png");
-
-    TextImage text_planetinfo_energy(*controller->getDevice(), menu_planetinfo_energy.material->getSampler(0), &font,
-            *controller->getBufferPool(), *controller->getQueue(), "Hello World");
-
-    TextImage text_planetinfo_science(*controller->getDevice(), menu_planetinfo_science.material->getSampler(0), &font,
-            *controller->getBufferPool(), *controller->getQueue(), "Hello World");
-
-    TextImage text_getenergy(*controller->getDevice(), menu_getenergy.material->getSampler(0), &font,
-            *controller->getBufferPool(), *controller->getQueue(), "GET ENERGY");
-
-    TextImage text_getscience(*controller->getDevice(), menu_getscience.material->getSampler(0), &font,
-            *controller->getBufferPool(), *controller->getQueue(), "GET SCIENCE");
-
-    TextImage text_leave(*controller->getDevice(), menu_leave.material->getSampler(0), &font,
-            *controller->getBufferPool(), *controller->getQueue(), "LEAVE");
-
-
     ObjectHandle shiphandle = scene.addObject(shipProto, SHIP_LAYER),
             enemyhandle = scene.addObject(enemyproto, SHIP_LAYER),
             enemyweaponhandle = scene.addObject(enemyweaponproto, SHIP_EFFECT_LAYER),
@@ -357,13 +389,13 @@ int run() {
             menu_planet_handle = scene.addObject(menu_planet_proto, MENU_BUTTON_LAYER);
 
     scene.addObject(backgroundProto, BACKGROUND_LAYER);
+
+    scene.setParticles(particleSystem);
     // </editor-fold>
 
     // <editor-fold defaultstate="collapsed" desc="Decorators">
 
 
-    CoordinateConverter spaceconverter(window);
-
     Events events(&scene);
 
     PlayerShipControllerInfo playerShipInfo;
@@ -429,7 +461,10 @@ int run() {
     scene.getObjectProperty<double>(shiphandle, acceleration) = 0.1;
     scene.getObjectProperty<double>(shiphandle, shoot_period) = 1;
 
-    scene.addDecorator(new SoundSystem(events.soundrequest, SOUNDS_DIRECTORY));
+    SoundSystem * sounds = new SoundSystem(events.soundrequest, SOUNDS_DIRECTORY, AudioBackend::Create(audio));
+    sounds->setListener(shiphandle);
+
+    scene.addDecorator(sounds);
 
     scene.addDecorator(enemyweaponhandle, new EnemyWeaponController(shiphandle, enemyhandle,
             events.playerdamaged, events.soundrequest));
@@ -440,7 +475,7 @@ int run() {
                 planet1.material, planet2.material, planet3.material
             }));
 
-    std::shared_ptr<ClickEventDispatcher> mouseclick(new ClickEventDispatcher(events.mouseclick, &spaceconverter));
+    std::shared_ptr<ClickEventDispatcher> mouseclick(new ClickEventDispatcher(events.mouseclick, controller->getCamera()));
 
     scene.addDecorator(mouseclick);
     input.addMouseHandler(GLFW_MOUSE_BUTTON_1, mouseclick.get());
@@ -457,17 +492,19 @@ int run() {
     auto start = std::chrono::high_resolution_clock::now();
 
     while (!window.shouldClose()) {
-        window.pollEvents();
+        controller->pollEvents();
 
         auto now = std::chrono::high_resolution_clock::now();
         double delta = std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count() / 1e9;
         start = now;
 
-        controller->startRender();
+        if (!controller->startRender()) {
+            continue;
+        }
 
         size_t frame = controller->getFrameIndex();
 
-        scene.updateObjects(frame, spaceconverter, delta);
+        scene.updateObjects(frame, delta);
 
         scene.record(frame);
 
@@ -476,16 +513,42 @@ int run() {
         scene.getbuffers(buffers, frame);
 
         controller->submitSecondaries(buffers);
+
+        PROFILE_FRAME();
     }
 
+    controller->getProfiler()->report(std::cout);
+
+#ifdef ENABLE_PROFILER
+    Profiler::WriteTrace(std::string("profile.json"));
+#endif
+
+    // the buffers have to go before the device, once no frame uses them
+    (*controller->getDevice())->waitIdle();
+    backgroundGlobals.clear();
+
     delete controller;
 
     return EXIT_SUCCESS;
 }
 
-int main() {
+int main(int argc, char ** argv) {
+    // --audio picks the backend, such as 'mixer' on machines without sound
+    std::string audio;
+
+    // --hot-reload rebuilds whatever uses a shader, sprite or game file when the file is saved
+    bool hotReload = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--audio" && i + 1 < argc) {
+            audio = argv[++i];
+        } else if (std::string(argv[i]) == "--hot-reload") {
+            hotReload = true;
+        }
+    }
+
     try {
-        return run();
+        return run(audio, hotReload);
     } catch (std::exception & ex) {
         std::cerr << ex.what() << std::endl;
         throw ex;
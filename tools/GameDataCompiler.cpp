@@ -0,0 +1,92 @@
+/*
+ * To change this license header, choose License Headers in Project Properties.
+ * To change this template file, choose Tools | Templates
+ * and open the template in the editor.
+ */
+
+// Compiles the game files into the game data the game loads, so it never has
+// to parse yaml itself. Every file is read with its references, and the
+// compiled file is read back to check it. The files are parsed in parallel,
+// and files shared between them are only parsed once. With -l, the ubo
+// prototypes and push constants are also generated as C++ structs and glsl
+// blocks, see LayoutWriter.
+//
+// usage: game_data_compiler [-v] [-l <layouts.hpp> <layouts.glsl>] <output> <file.yml>...
+
+#include "game/parsing/GameContext.hpp"
+#include "game/parsing/GameData.hpp"
+#include "game/parsing/GameDataWriter.hpp"
+#include "game/parsing/LayoutWriter.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+int main(int argc, char ** argv) {
+    int arg = 1;
+
+    // the contexts log every node they read, which is only useful when a file won't parse
+    Game::Logger::enabled = false;
+
+    if (arg < argc && strcmp(argv[arg], "-v") == 0) {
+        Game::Logger::enabled = true;
+        arg++;
+    }
+
+    std::string header, glsl;
+
+    if (arg + 2 < argc && strcmp(argv[arg], "-l") == 0) {
+        header = argv[arg + 1];
+        glsl = argv[arg + 2];
+        arg += 3;
+    }
+
+    if (argc - arg < 2) {
+        fprintf(stderr, "usage: %s [-v] [-l <layouts.hpp> <layouts.glsl>] <output> <file.yml>...\n", argv[0]);
+        return 2;
+    }
+
+    std::string output = argv[arg++];
+
+    try {
+        // the files reference the same few files, which are only parsed once
+        Game::DocumentCache cache;
+
+        std::vector<std::unique_ptr<Game::GameContext>> contexts;
+        Game::GameDataWriter writer;
+        Game::LayoutWriter layouts;
+
+        for (; arg < argc; arg++) {
+            contexts.emplace_back(new Game::GameContext(argv[arg], cache));
+            writer.add(*contexts.back());
+            layouts.add(*contexts.back());
+        }
+
+        if (Game::Logger::enabled) {
+            printf("parsed %zu files\n", cache.getParseCount());
+        }
+
+        size_t size = writer.write(output);
+
+        Game::GameData data(output);
+
+        printf("%s: %zu bytes, %zu constants, %zu ubo prototypes, %zu ubo instances, %zu vertex buffers, "
+                "%zu index buffers, %zu push constants, %zu shaders\n", output.c_str(), size,
+                data.getConstants().size(), data.getUBOPrototypes().size(), data.getUBOInstances().size(),
+                data.getVertexBuffers().size(), data.getIndexBuffers().size(), data.getPushConstants().size(),
+                data.getShaders().size());
+
+        // the layouts are only replaced when they change, or everything using them would be rebuilt
+        if (!header.empty()) {
+            printf("%s: %s\n", header.c_str(), layouts.writeHeader(header) ? "updated" : "unchanged");
+            printf("%s: %s\n", glsl.c_str(), layouts.writeGLSL(glsl) ? "updated" : "unchanged");
+        }
+    } catch (std::exception & e) {
+        fprintf(stderr, "%s: %s\n", output.c_str(), e.what());
+        return 1;
+    }
+
+    return 0;
+}